@@ -0,0 +1,179 @@
+/**
+ * This file contains the implementation of the AdaptiveIntegrator class, the shared adaptive step controller
+ *
+ * every thread works out the smallest step its share of the bodies asks for, one thread then picks the next step,
+ * the step itself is whatever the wrapped scheme does with it
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "AdaptiveIntegrator.h"
+using namespace std;
+
+AdaptiveIntegrator::AdaptiveIntegrator(unique_ptr<SteppingIntegrator> scheme, double timestep, StepCriterion criterion, double accuracy, SimdLevel level)
+    : scheme(move(scheme)), timestep(timestep), criterion(criterion), accuracy(accuracy), jerkKernel(jerkKernelFor(level))
+{
+    if (timestep <= 0.0)
+    {
+        throw invalid_argument("Adaptive steps need a positive Timestep");
+    }
+    if (accuracy <= 0.0)
+    {
+        throw invalid_argument("TimestepAccuracy must be positive");
+    }
+    label = string("adaptive ") + this->scheme->name();
+}
+
+static inline double norm(double x, double y, double z)
+{
+    return sqrt(x * x + y * y + z * z);
+}
+
+/**
+ * @brief starts the scheme and sizes the first step, the Aarseth criterion from the jerk kernel's exact jerks
+ * @param store the bodies
+ * @param solver the force solver of the run
+ */
+void AdaptiveIntegrator::start(BodyStore &store, ForceSolver &solver)
+{
+    const size_t n = store.size();
+    scheme->start(store, solver);
+    const bool computed = scheme->startsWithAccelerations(); // kick first schemes have just summed them
+    if (!computed)
+    {
+        solver.computeAccelerations(store);
+    }
+    #pragma omp single
+    {
+        previousX.resize(n);
+        previousY.resize(n);
+        previousZ.resize(n);
+        evaluations += computed ? 0 : n;
+        proposed = timestep;
+        elapsed = 0.0;
+        smallest = timestep;
+    }
+
+    double local = timestep;
+    if (criterion == StepCriterion::Aarseth)
+    {
+        #pragma omp for schedule(dynamic, 16) nowait
+        for (size_t i = 0; i < n; i++)
+        {
+            double acceleration[3] = {0.0, 0.0, 0.0}, jerk[3] = {0.0, 0.0, 0.0};
+            jerkKernel(store.x.data(), store.y.data(), store.z.data(), store.vx.data(), store.vy.data(), store.vz.data(), store.mass.data(), n,
+                       store.x[i], store.y[i], store.z[i], store.vx[i], store.vy[i], store.vz[i], acceleration, jerk);
+            const double j = norm(jerk[0], jerk[1], jerk[2]);
+            if (j > 0.0)
+            {
+                local = min(local, accuracy * norm(acceleration[0], acceleration[1], acceleration[2]) / j);
+            }
+            previousX[i] = store.ax[i];
+            previousY[i] = store.ay[i];
+            previousZ[i] = store.az[i];
+        }
+    }
+    else
+    {
+        local = freeFallStep(store);
+    }
+    propose(local);
+}
+
+/**
+ * @brief steps every body to the end of the next Timestep, as many steps as the criterion asks for
+ * @param store the bodies
+ * @param solver the force solver of the run
+ */
+void AdaptiveIntegrator::advance(BodyStore &store, ForceSolver &solver)
+{
+    for (;;)
+    {
+        #pragma omp single
+        {
+            const double remaining = timestep - elapsed;
+            lastStep = proposed >= remaining;
+            step = lastStep ? remaining : proposed;
+            elapsed = lastStep ? 0.0 : elapsed + step;
+            smallest = min(smallest, step);
+            steps++;
+            proposed = timestep;
+        }
+        const double dt = step;
+        const bool last = lastStep;
+
+        scheme->step(store, solver, dt);
+        propose(criterion == StepCriterion::Aarseth ? aarsethStep(store, dt) : freeFallStep(store));
+
+        if (last)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief this thread's smallest accuracy * |a| / |da/dt|, the jerk from the change of the accelerations over the step dt
+ */
+double AdaptiveIntegrator::aarsethStep(const BodyStore &store, double dt)
+{
+    double local = timestep;
+    #pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const double jerk = norm(store.ax[i] - previousX[i], store.ay[i] - previousY[i], store.az[i] - previousZ[i]) / dt;
+        if (jerk > 0.0)
+        {
+            local = min(local, accuracy * norm(store.ax[i], store.ay[i], store.az[i]) / jerk);
+        }
+        previousX[i] = store.ax[i];
+        previousY[i] = store.ay[i];
+        previousZ[i] = store.az[i];
+    }
+    return local;
+}
+
+/**
+ * @brief this thread's smallest accuracy * sqrt(r^3 / (G (m1 + m2))), over the pairs of its share of the bodies
+ *
+ * the pairs are compared through r^6 / (m1 + m2)^2, which needs neither a square root nor a cube root per pair
+ */
+double AdaptiveIntegrator::freeFallStep(const BodyStore &store) const
+{
+    const size_t n = store.size();
+    const double *x = store.x.data(), *y = store.y.data(), *z = store.z.data(), *mass = store.mass.data();
+    double local = timestep;
+    #pragma omp for schedule(dynamic, 16) nowait
+    for (size_t i = 0; i < n; i++)
+    {
+        double closest = INFINITY;
+        #pragma omp simd reduction(min : closest)
+        for (size_t j = 0; j < n; j++)
+        {
+            const double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+            const double r2 = dx * dx + dy * dy + dz * dz;
+            const double total = mass[i] + mass[j];
+            const double measure = r2 * r2 * r2 / (total * total);
+            closest = (r2 > 0.0 && total > 0.0) ? min(closest, measure) : closest;
+        }
+        if (closest < INFINITY)
+        {
+            // (r^6 / M^2)^(1/4) = r^(3/2) / M^(1/2)
+            local = min(local, accuracy * sqrt(sqrt(closest)) / sqrt(GRAVITY_CONSTANT * store.gravitationalMultiplier[i]));
+        }
+    }
+    return local;
+}
+
+/**
+ * @brief folds one thread's smallest step into the shared one, the barrier leaves it complete for the next single
+ */
+void AdaptiveIntegrator::propose(double local)
+{
+    #pragma omp critical(adaptiveStep)
+    proposed = min(proposed, local);
+    #pragma omp barrier
+}
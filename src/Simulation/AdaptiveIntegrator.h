@@ -0,0 +1,62 @@
+#ifndef ADAPTIVE_INTEGRATOR_H
+#define ADAPTIVE_INTEGRATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Integrator.h"
+#include "SimdKernels.h"
+
+// what the adaptive controller sizes the shared step from
+enum class StepCriterion
+{
+        Aarseth,  // accuracy * min |a| / |da/dt|, the jerk from the change of every acceleration over the last step
+        FreeFall  // accuracy * min sqrt(r^3 / (G (m1 + m2))) over every pair, one extra O(N^2) pass per step
+};
+
+/*
+    AdaptiveIntegrator class:
+        drives a SteppingIntegrator with a shared step sized from the bodies every step, so calm phases take long steps
+        and close approaches short ones, the step never exceeds the Timestep and the last one of every Timestep is
+        cut short to end on it, so the Timestep is the output interval and the trajectories are sampled in time
+
+    the Aarseth criterion costs one pass over the bodies after the step's last force evaluation,
+    its first step takes the jerk from the jerk kernel instead
+*/
+class AdaptiveIntegrator : public Integrator
+{
+public:
+        AdaptiveIntegrator(std::unique_ptr<SteppingIntegrator> scheme, double timestep, StepCriterion criterion, double accuracy,
+                           SimdLevel level = detectSimdLevel());
+
+        const char *name() const override { return label.c_str(); }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void advance(BodyStore &store, ForceSolver &solver) override;
+        std::uint64_t forceEvaluations() const override { return evaluations + scheme->forceEvaluations(); }
+
+        std::uint64_t stepsTaken() const { return steps; }
+        double smallestStep() const { return smallest; }
+
+private:
+        std::unique_ptr<SteppingIntegrator> scheme;
+        std::string label;                     // "adaptive " and the scheme's name
+        double timestep;                       // the longest step, and the interval every advance ends on
+        StepCriterion criterion;
+        double accuracy;
+        JerkKernel jerkKernel;
+
+        std::vector<double> previousX, previousY, previousZ; // accelerations after the last step
+        double proposed = 0.0;                 // the criterion's next step, folded together by the threads
+        double step = 0.0;                     // the step being taken
+        double elapsed = 0.0;                  // time taken so far of the current Timestep
+        bool lastStep = false;
+        std::uint64_t steps = 0;
+        double smallest = 0.0;
+
+        double aarsethStep(const BodyStore &store, double dt);
+        double freeFallStep(const BodyStore &store) const;
+        void propose(double local);
+};
+
+#endif
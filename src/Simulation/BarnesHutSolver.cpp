@@ -0,0 +1,89 @@
+/**
+ * This file contains the implementation of the BarnesHutSolver class, the octree force walk
+ *
+ * opening criterion: a cell is used whole when  d > s / theta + delta,
+ * d the distance from the body to the cell's centre of mass, s the cell edge and delta the distance between
+ * the centre of mass and the cube's center, the delta term keeps lopsided cells from being accepted too early
+ * and guarantees a body is never approximated by a cell it sits inside of (for theta below 1)
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <cmath>
+#include <limits>
+#include "BarnesHutSolver.h"
+using namespace std;
+
+const int WALK_STACK_SIZE = 512; // 21 levels of at most 8 children, with room to spare
+const size_t WALKS_PER_CHUNK = 16; // consecutive Morton order walks taken at a time, they share most of their nodes
+
+BarnesHutSolver::BarnesHutSolver(double theta, size_t leafCapacity, SimdLevel level)
+    : theta(theta), tree(leafCapacity), kernel(sourceKernelFor(level))
+{
+}
+
+/**
+ * @brief rebuilds the octree and walks it once for every body
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void BarnesHutSolver::computeAccelerations(BodyStore &store)
+{
+    tree.build(store);
+
+    const size_t n = store.size();
+    const double softening2 = SOFTENING_LENGTH * SOFTENING_LENGTH;
+    const double inverseTheta = theta > 0.0 ? 1.0 / theta : numeric_limits<double>::infinity();
+    const vector<OctreeNode> &nodes = tree.nodes;
+
+    // walking in Morton order keeps consecutive walks on one thread nearly identical, so the touched nodes stay in cache
+    loop.run(n, WALKS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            const double xi = tree.x[k], yi = tree.y[k], zi = tree.z[k];
+            double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+            int stack[WALK_STACK_SIZE];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0)
+            {
+                const OctreeNode &node = nodes[stack[--top]];
+                if (node.firstChild < 0)
+                {
+                    kernel(&tree.x[node.begin], &tree.y[node.begin], &tree.z[node.begin], &tree.mass[node.begin],
+                           node.end - node.begin, xi, yi, zi, sumX, sumY, sumZ);
+                    continue;
+                }
+
+                const double dx = node.comX - xi, dy = node.comY - yi, dz = node.comZ - zi;
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                const double offX = node.comX - node.centerX, offY = node.comY - node.centerY, offZ = node.comZ - node.centerZ;
+                const double openingDistance = node.size * inverseTheta + sqrt(offX * offX + offY * offY + offZ * offZ);
+
+                if (r2 > openingDistance * openingDistance)
+                {
+                    // same law as the pair kernel, with the cell's mass at its centre of mass
+                    const double r = sqrt(r2);
+                    const double dist2 = r2 < softening2 ? softening2 : r2;
+                    const double s = node.mass / ((dist2 + softening2) * r);
+                    sumX += s * dx;
+                    sumY += s * dy;
+                    sumZ += s * dz;
+                }
+                else
+                {
+                    for (int c = 0; c < node.childCount; c++)
+                    {
+                        stack[top++] = node.firstChild + c;
+                    }
+                }
+            }
+
+            const uint32_t i = tree.order[k];
+            const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+            store.ax[i] = scale * sumX;
+            store.ay[i] = scale * sumY;
+            store.az[i] = scale * sumZ;
+        }
+    });
+}
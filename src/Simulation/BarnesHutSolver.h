@@ -0,0 +1,35 @@
+#ifndef BARNES_HUT_SOLVER_H
+#define BARNES_HUT_SOLVER_H
+
+#include <cstddef>
+#include "ForceSolver.h"
+#include "Octree.h"
+#include "SimdKernels.h"
+
+/*
+    BarnesHutSolver class:
+        O(N log N) tree code
+        the octree is rebuilt in parallel every step, then every body walks it from the root:
+        a cell far enough away pulls as a single body at its centre of mass, a close one is opened,
+        and the bodies of the leaves that still have to be opened are summed directly with the SIMD kernel
+
+    theta is the opening angle, a cell of edge s whose centre of mass sits d away is used whole when s / d < theta,
+    theta 0 opens everything and reproduces the direct sum
+*/
+class BarnesHutSolver : public ForceSolver
+{
+public:
+        explicit BarnesHutSolver(double theta = 0.5, std::size_t leafCapacity = 16, SimdLevel level = detectSimdLevel());
+
+        const char *name() const override { return "barneshut"; }
+        void computeAccelerations(BodyStore &store) override;
+
+        const Octree &octree() const { return tree; }
+
+private:
+        double theta;
+        Octree tree;
+        SourceKernel kernel;
+};
+
+#endif
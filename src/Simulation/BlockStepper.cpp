@@ -0,0 +1,242 @@
+/**
+ * This file contains the implementation of the BlockStepper class, the individual block timestep integrator
+ *
+ * time is counted in ticks of the finest level, so a level l step is 2^(maxLevel - l) ticks and a body is due when
+ * the tick is a multiple of its step, one thread plans each substep (where the finest level in use next ends,
+ * and who is due there), the drift, the forces and the kicks are shared out between the threads
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "BlockStepper.h"
+using namespace std;
+
+const int MAX_BLOCK_LEVEL = 30; // keeps every step a whole number of ticks in 64 bits with room to count Timesteps
+
+BlockStepper::BlockStepper(double timestep, int maxLevel, double accuracy) : timestep(timestep), maxLevel(maxLevel), accuracy(accuracy)
+{
+    if (timestep <= 0.0)
+    {
+        throw invalid_argument("Block timesteps need a positive Timestep");
+    }
+    if (maxLevel < 1 || maxLevel > MAX_BLOCK_LEVEL)
+    {
+        throw invalid_argument("BlockLevels must be between 1 and " + to_string(MAX_BLOCK_LEVEL));
+    }
+    if (accuracy <= 0.0)
+    {
+        throw invalid_argument("TimestepAccuracy must be positive");
+    }
+}
+
+/**
+ * @brief computes every acceleration and jerk, picks the first levels and gives every body its opening half kick
+ * @param store the bodies, velocities synchronized with the positions
+ * @param solver the force solver of the run
+ */
+void BlockStepper::start(BodyStore &store, ForceSolver &solver)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    {
+        level.assign(n, 0);
+        previousX.resize(n);
+        previousY.resize(n);
+        previousZ.resize(n);
+        tick = 0;
+        evaluations += n;
+        synchronized = false;
+    }
+
+    solver.computeAccelerations(store);
+
+    loop.run(n, TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            double jx, jy, jz;
+            sumJerks(store, i, jx, jy, jz);
+            level[i] = levelFor(store.ax[i] * store.ax[i] + store.ay[i] * store.ay[i] + store.az[i] * store.az[i], jx * jx + jy * jy + jz * jz);
+            previousX[i] = store.ax[i];
+            previousY[i] = store.ay[i];
+            previousZ[i] = store.az[i];
+        }
+    });
+
+    // the jerks read every body's velocity, so no body is kicked before every level is chosen
+    loop.run(n, BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            kick(store, i, 0.5 * stepOf(level[i]));
+        }
+    });
+}
+
+/**
+ * @brief moves every body forward by one Timestep, substep by substep of the finest level in use
+ * @param store the bodies
+ * @param solver the force solver of the run, asked only for the bodies due at each substep
+ */
+void BlockStepper::advance(BodyStore &store, ForceSolver &solver)
+{
+    const bool resume = synchronized;
+    if (resume)
+    {
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            kick(store, i, 0.5 * stepOf(level[i]));
+        }
+        #pragma omp single
+        synchronized = false;
+    }
+
+    for (;;)
+    {
+        #pragma omp single
+        planSubstep();
+        const double drift = driftTime;
+        const bool last = lastSubstep;
+
+        loop.run(store.size(), BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                store.x[i] += store.vx[i] * drift;
+                store.y[i] += store.vy[i] * drift;
+                store.z[i] += store.vz[i] * drift;
+            }
+        });
+
+        solver.computeAccelerationsOf(store, active);
+
+        loop.run(active.size(), BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++)
+            {
+                const size_t i = active[k];
+                const double step = stepOf(level[i]);
+                kick(store, i, 0.5 * step); // closes the step just ended
+
+                const double jx = (store.ax[i] - previousX[i]) / step, jy = (store.ay[i] - previousY[i]) / step, jz = (store.az[i] - previousZ[i]) / step;
+                const int wanted = levelFor(store.ax[i] * store.ax[i] + store.ay[i] * store.ay[i] + store.az[i] * store.az[i], jx * jx + jy * jy + jz * jz);
+                if (wanted > level[i])
+                {
+                    level[i] = wanted;
+                }
+                else if (wanted < level[i] && tick % (uint64_t(1) << (maxLevel - level[i] + 1)) == 0)
+                {
+                    level[i]--; // one level at a time, and only where the coarser step starts
+                }
+                previousX[i] = store.ax[i];
+                previousY[i] = store.ay[i];
+                previousZ[i] = store.az[i];
+                kick(store, i, 0.5 * stepOf(level[i])); // opens the next one
+            }
+        });
+
+        if (last)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief takes back the opening half kick of every body so the velocities match the positions, called by one thread
+ *
+ * only valid between Timesteps, where every body has just been kicked with a fresh acceleration
+ */
+void BlockStepper::synchronize(BodyStore &store)
+{
+    if (synchronized)
+    {
+        return;
+    }
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        kick(store, i, -0.5 * stepOf(level[i]));
+    }
+    synchronized = true;
+}
+
+double BlockStepper::stepOf(int bodyLevel) const
+{
+    return ldexp(timestep, -bodyLevel);
+}
+
+/**
+ * @brief the coarsest level whose step is no longer than accuracy * |a| / |j|
+ */
+int BlockStepper::levelFor(double acceleration2, double jerk2) const
+{
+    if (!(jerk2 > 0.0))
+    {
+        return 0;
+    }
+    const double wanted = accuracy * sqrt(acceleration2 / jerk2);
+    int bodyLevel = 0;
+    while (bodyLevel < maxLevel && stepOf(bodyLevel) > wanted)
+    {
+        bodyLevel++;
+    }
+    return bodyLevel;
+}
+
+void BlockStepper::kick(BodyStore &store, size_t i, double time) const
+{
+    store.vx[i] += store.ax[i] * time;
+    store.vy[i] += store.ay[i] * time;
+    store.vz[i] += store.az[i] * time;
+}
+
+/**
+ * @brief the time derivative of body i's acceleration, G m (v / r^3 - 3 (r.v) r / r^5) summed over every other body
+ */
+void BlockStepper::sumJerks(const BodyStore &store, size_t i, double &jx, double &jy, double &jz) const
+{
+    jx = jy = jz = 0.0;
+    for (size_t j = 0; j < store.size(); j++)
+    {
+        const double dx = store.x[j] - store.x[i], dy = store.y[j] - store.y[i], dz = store.z[j] - store.z[i];
+        const double r2 = dx * dx + dy * dy + dz * dz;
+        if (r2 == 0.0)
+        {
+            continue;
+        }
+        const double dvx = store.vx[j] - store.vx[i], dvy = store.vy[j] - store.vy[i], dvz = store.vz[j] - store.vz[i];
+        const double clamped = max(r2, SOFTENING_LENGTH * SOFTENING_LENGTH);
+        const double inverse3 = store.mass[j] / (clamped * sqrt(clamped));
+        const double radial = 3.0 * (dx * dvx + dy * dvy + dz * dvz) / clamped;
+        jx += inverse3 * (dvx - radial * dx);
+        jy += inverse3 * (dvy - radial * dy);
+        jz += inverse3 * (dvz - radial * dz);
+    }
+    const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+    jx *= scale;
+    jy *= scale;
+    jz *= scale;
+}
+
+/**
+ * @brief moves the tick to where the finest level in use next ends and lists the bodies due there, called by one thread
+ */
+void BlockStepper::planSubstep()
+{
+    const int deepest = level.empty() ? 0 : *max_element(level.begin(), level.end());
+    const uint64_t stride = uint64_t(1) << (maxLevel - deepest);
+    const uint64_t next = (tick / stride + 1) * stride;
+    driftTime = ldexp(timestep, -maxLevel) * double(next - tick);
+    tick = next;
+    lastSubstep = tick % (uint64_t(1) << maxLevel) == 0;
+
+    active.clear();
+    for (size_t i = 0; i < level.size(); i++)
+    {
+        if (tick % (uint64_t(1) << (maxLevel - level[i])) == 0)
+        {
+            active.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    evaluations += active.size();
+}
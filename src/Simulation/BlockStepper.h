@@ -0,0 +1,59 @@
+#ifndef BLOCK_STEPPER_H
+#define BLOCK_STEPPER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BodyStore.h"
+#include "ForceSolver.h"
+#include "Integrator.h"
+
+/*
+    BlockStepper class:
+        kick-drift-kick leapfrog with individual power of two timesteps
+        body i steps by timestep / 2^level[i], level 0 is the Timestep of the input file and maxLevel the finest,
+        every body drifts together at the pace of the finest level in use, but only the bodies whose own step ends
+        at that moment are kicked, so only they need new accelerations from the solver
+
+    the level comes from the Aarseth style criterion dt = accuracy * |a| / |da/dt|, with the jerk da/dt
+    taken from the change of a body's acceleration over its last step (summed explicitly at the start)
+    a body may move to a finer level whenever it is kicked, and to the next coarser one when its current step
+    ends on a boundary of the coarser level, so every body always starts and ends its steps on the shared grid
+
+    advance moves every body by one full Timestep
+    between steps the velocities are half a kick ahead of the positions, synchronize takes the half kick back
+    for output, the next advance puts it back on
+*/
+class BlockStepper : public Integrator
+{
+public:
+        BlockStepper(double timestep, int maxLevel, double accuracy);
+
+        const char *name() const override { return "block"; }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void advance(BodyStore &store, ForceSolver &solver) override;
+        void synchronize(BodyStore &store) override;
+
+        int levelOf(std::size_t i) const { return level[i]; }
+
+private:
+        double timestep;                       // step of level 0
+        int maxLevel;                          // finest level, its step is timestep / 2^maxLevel
+        double accuracy;                       // accuracy parameter of the timestep criterion
+        std::uint64_t tick = 0;                // current time in steps of the finest level
+        bool synchronized = false;             // velocities are at the positions' time
+
+        std::vector<int> level;                // level of every body
+        std::vector<double> previousX, previousY, previousZ; // acceleration at every body's last kick
+        std::vector<std::uint32_t> active;     // bodies whose step ends at the current tick
+        double driftTime = 0.0;                // the drift of the substep being taken
+        bool lastSubstep = false;              // the substep ends the Timestep
+
+        double stepOf(int bodyLevel) const;
+        int levelFor(double acceleration2, double jerk2) const;
+        void kick(BodyStore &store, std::size_t i, double time) const;
+        void sumJerks(const BodyStore &store, std::size_t i, double &jx, double &jy, double &jz) const;
+        void planSubstep();
+};
+
+#endif
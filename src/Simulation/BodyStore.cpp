@@ -0,0 +1,156 @@
+/**
+ * This file contains the implementation of the BodyStore class, the structure-of-arrays layout used by the step loop
+ *
+ * each Body interleaves its vectors with a type string, a children list and a growing trajectory, so walking
+ * std::vector<Body> in the force loop strides across hundreds of bytes per body, the store keeps only the
+ * fields the force and update passes read, each in its own contiguous array
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <vector>
+#include "BodyStore.h"
+#include "body.h"
+#include "vec3.h"
+using namespace std;
+
+/**
+ * @brief builds the store from the parsed bodies
+ * @param bodies the bodies read by FileManager
+ */
+BodyStore::BodyStore(const vector<Body> &bodies)
+{
+    load(bodies);
+}
+
+/**
+ * @brief resizes every array to hold n bodies
+ * @param n the number of bodies
+ */
+void BodyStore::resize(size_t n)
+{
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    vz.resize(n);
+    ax.resize(n);
+    ay.resize(n);
+    az.resize(n);
+    mass.resize(n);
+    gravitationalMultiplier.resize(n);
+    radius.resize(n);
+    id.resize(n);
+}
+
+/**
+ * @brief copies the hot state of every body into the arrays
+ * @param bodies the bodies to copy from
+ */
+void BodyStore::load(const vector<Body> &bodies)
+{
+    resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        x[i] = bodies[i].position.x;
+        y[i] = bodies[i].position.y;
+        z[i] = bodies[i].position.z;
+        vx[i] = bodies[i].velocity.x;
+        vy[i] = bodies[i].velocity.y;
+        vz[i] = bodies[i].velocity.z;
+        ax[i] = bodies[i].acceleration.x;
+        ay[i] = bodies[i].acceleration.y;
+        az[i] = bodies[i].acceleration.z;
+        mass[i] = bodies[i].mass;
+        gravitationalMultiplier[i] = bodies[i].gravitationalMultiplier;
+        radius[i] = bodies[i].radius;
+        id[i] = static_cast<uint32_t>(i);
+    }
+}
+
+/**
+ * @brief copies position, velocity and acceleration back into the bodies, used before outputting results,
+ * and the mass and radius, which merging changes
+ * @param bodies the bodies the store was loaded from
+ */
+void BodyStore::writeBack(vector<Body> &bodies) const
+{
+    for (size_t i = 0; i < size(); i++)
+    {
+        Body &body = bodies[id[i]];
+        body.position = Vec3(x[i], y[i], z[i]);
+        body.velocity = Vec3(vx[i], vy[i], vz[i]);
+        body.acceleration = Vec3(ax[i], ay[i], az[i]);
+        body.mass = mass[i];
+        body.radius = radius[i];
+    }
+}
+
+/**
+ * @brief drops the removed slots, the others keep their order and move down over the gaps
+ * @param removed one flag per slot
+ */
+void BodyStore::compact(const vector<bool> &removed)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < size(); i++)
+    {
+        if (removed[i])
+        {
+            continue;
+        }
+        x[kept] = x[i];
+        y[kept] = y[i];
+        z[kept] = z[i];
+        vx[kept] = vx[i];
+        vy[kept] = vy[i];
+        vz[kept] = vz[i];
+        ax[kept] = ax[i];
+        ay[kept] = ay[i];
+        az[kept] = az[i];
+        mass[kept] = mass[i];
+        gravitationalMultiplier[kept] = gravitationalMultiplier[i];
+        radius[kept] = radius[i];
+        id[kept] = id[i];
+        kept++;
+    }
+    resize(kept);
+}
+
+/**
+ * @brief appends the current position of body i to its trajectory
+ * @param i the index of the body in the store
+ * @param body the body record holding the trajectory
+ */
+void BodyStore::recordTrajectory(size_t i, Body &body) const
+{
+    body.trajectory.push_back(Vec3(x[i], y[i], z[i]));
+}
+
+/**
+ * @brief update the velocity and position of body i, mirrors Body::update
+ * @param i the index of the body
+ * @param timestep the amount of time to update the body over
+ * @param isHalfStep true for the half-step velocity update, false for the position update
+ */
+void BodyStore::update(size_t i, double timestep, bool isHalfStep)
+{
+    if (isHalfStep) {
+        // Half-step: Update velocity using acceleration
+        vx[i] += ax[i] * (timestep * 0.5);
+        vy[i] += ay[i] * (timestep * 0.5);
+        vz[i] += az[i] * (timestep * 0.5);
+        ax[i] = 0.0; // Reset acceleration after use
+        ay[i] = 0.0;
+        az[i] = 0.0;
+    } else {
+        // Full-step: Update position and finalize velocity
+        x[i] += vx[i] * timestep;
+        y[i] += vy[i] * timestep;
+        z[i] += vz[i] * timestep;
+        vx[i] += ax[i] * (timestep * 0.5);
+        vy[i] += ay[i] * (timestep * 0.5);
+        vz[i] += az[i] * (timestep * 0.5);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body.h"
+
+/*
+    BodyStore class:
+        Structure-of-arrays copy of the state the step loop touches every iteration
+            double[] x, y, z        positions
+            double[] vx, vy, vz     velocities
+            double[] ax, ay, az     accelerations
+            double[] mass
+            double[] gravitationalMultiplier
+            double[] radius         radii, read by the collision stage only
+            uint32[] id             the Body record of every slot, slots move down when merged bodies are compacted away
+
+    Body stays the record used by FileManager and HeavenScapeBuilder (type, radius, children, trajectory),
+    the store is loaded from those records once, owns the hot state while the simulation runs,
+    and is written back into them when results are output
+*/
+class BodyStore
+{
+public:
+        std::vector<double> x, y, z;                   // positions
+        std::vector<double> vx, vy, vz;                // velocities
+        std::vector<double> ax, ay, az;                // accelerations
+        std::vector<double> mass;                      // masses
+        std::vector<double> gravitationalMultiplier;   // per body gravity scaling
+        std::vector<double> radius;                    // radii, for collisions
+        std::vector<std::uint32_t> id;                 // index of every slot's Body record
+
+        BodyStore() = default;
+        explicit BodyStore(const std::vector<Body> &bodies);
+
+        std::size_t size() const { return mass.size(); }
+        void resize(std::size_t n);
+        void load(const std::vector<Body> &bodies);
+        void writeBack(std::vector<Body> &bodies) const;
+        void compact(const std::vector<bool> &removed);
+        void recordTrajectory(std::size_t i, Body &body) const;
+
+        void update(std::size_t i, double timestep, bool isHalfStep);
+};
+
+#endif
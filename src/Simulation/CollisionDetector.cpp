@@ -0,0 +1,329 @@
+/**
+ * This file contains the implementation of the CollisionDetector class, the collision and merging stage
+ *
+ * with p the separation of two bodies at the snapshot, d the change of it over the step and R the sum of their radii,
+ * the spheres touch at the first t in [0, 1] with |p + t d| = R, the smaller root of
+ *      |d|^2 t^2 + 2 (p.d) t + |p|^2 - R^2 = 0
+ * which exists when the bodies approach (p.d < 0) and the discriminant is not negative, spheres that already
+ * overlap at the snapshot touch at t = 0
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <omp.h>
+#include "CollisionDetector.h"
+using namespace std;
+
+CollisionDetector::CollisionDetector(size_t bodyCount) : mergedInto(bodyCount), slots(bodyCount)
+{
+    for (size_t b = 0; b < bodyCount; b++)
+    {
+        mergedInto[b] = static_cast<uint32_t>(b);
+        slots[b] = static_cast<uint32_t>(b);
+    }
+}
+
+/**
+ * @brief keeps the positions at the start of the step, the start of every body's swept path
+ * @param store the bodies
+ */
+void CollisionDetector::snapshot(const BodyStore &store)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    {
+        startX.resize(n);
+        startY.resize(n);
+        startZ.resize(n);
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        startX[i] = store.x[i];
+        startY[i] = store.y[i];
+        startZ[i] = store.z[i];
+    }
+}
+
+static inline int64_t cellCoordinate(double position, double width)
+{
+    return static_cast<int64_t>(floor(max(-1e15, min(1e15, position / width))));
+}
+
+static inline uint64_t cellKey(int64_t cx, int64_t cy, int64_t cz)
+{
+    return static_cast<uint64_t>(cx) * 73856093u ^ static_cast<uint64_t>(cy) * 19349663u ^ static_cast<uint64_t>(cz) * 83492791u;
+}
+
+/**
+ * @brief finds the bodies that touched since the snapshot, merges them and compacts the store
+ * @param store the bodies, after the step
+ * @param beforeMerge called with the store by one thread once collisions were found, before they are merged
+ * @return the number of bodies absorbed, the same on every thread
+ */
+size_t CollisionDetector::resolve(BodyStore &store, const function<void(BodyStore &)> &beforeMerge)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    {
+        absorbed = 0;
+        collisions.clear();
+        extents.resize(n);
+        cells.resize(n);
+        found.assign(omp_get_num_threads(), vector<Collision>());
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        const double extent = max({fabs(store.x[i] - startX[i]), fabs(store.y[i] - startY[i]), fabs(store.z[i] - startZ[i])});
+        extents[i] = extent + 2.0 * store.radius[i];
+    }
+
+    // the cells as wide as all but the largest few boxes, one star or fast body does not widen them for everyone
+    #pragma omp single
+    {
+        // of the boxes with a size, points at rest fit any cell
+        vector<double> sized;
+        copy_if(extents.begin(), extents.end(), back_inserter(sized), [](double extent) { return extent > 0.0; });
+        cellSize = 0.0;
+        if (!sized.empty())
+        {
+            const auto typical = sized.begin() + static_cast<ptrdiff_t>(CELL_SIZE_QUANTILE * (sized.size() - 1));
+            nth_element(sized.begin(), typical, sized.end());
+            cellSize = *typical;
+        }
+    }
+
+    const double width = cellSize;
+    if (!(width > 0.0))
+    {
+        return 0; // nothing has a size or moved
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        const double midX = 0.5 * (startX[i] + store.x[i]), midY = 0.5 * (startY[i] + store.y[i]), midZ = 0.5 * (startZ[i] + store.z[i]);
+        cells[i] = make_pair(cellKey(cellCoordinate(midX, width), cellCoordinate(midY, width), cellCoordinate(midZ, width)), static_cast<uint32_t>(i));
+    }
+    #pragma omp single
+    {
+        cells.erase(remove_if(cells.begin(), cells.end(), [&](const pair<uint64_t, uint32_t> &cell) { return extents[cell.second] > width; }), cells.end());
+        sort(cells.begin(), cells.end());
+    }
+
+    vector<Collision> &mine = found[omp_get_thread_num()];
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < n; i++)
+    {
+        collect(store, i, mine);
+    }
+
+    #pragma omp single
+    merge(store, beforeMerge);
+    return absorbed;
+}
+
+/**
+ * @brief the swept sphere test of bodies i < j, adds their collision to out when they touched
+ */
+void CollisionDetector::sweep(const BodyStore &store, size_t i, size_t j, vector<Collision> &out) const
+{
+    const double px = startX[j] - startX[i], py = startY[j] - startY[i], pz = startZ[j] - startZ[i];
+    const double dx = store.x[j] - store.x[i] - px, dy = store.y[j] - store.y[i] - py, dz = store.z[j] - store.z[i] - pz;
+    const double reach = store.radius[i] + store.radius[j];
+    const double c = px * px + py * py + pz * pz - reach * reach;
+    if (c < 0.0)
+    {
+        out.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j), 0.0});
+        return;
+    }
+    const double a = dx * dx + dy * dy + dz * dz, b = px * dx + py * dy + pz * dz;
+    const double discriminant = b * b - a * c;
+    if (b >= 0.0 || discriminant < 0.0)
+    {
+        return;
+    }
+    const double t = (-b - sqrt(discriminant)) / a;
+    if (t <= 1.0)
+    {
+        out.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j), t});
+    }
+}
+
+/**
+ * @brief the swept sphere test of body i against every later body in the 27 cells around its own,
+ *        a body with a box wider than the cells is kept out of the grid and tested against every other body instead
+ */
+void CollisionDetector::collect(const BodyStore &store, size_t i, vector<Collision> &out) const
+{
+    const double width = cellSize;
+    if (extents[i] > width)
+    {
+        for (size_t j = 0; j < store.size(); j++)
+        {
+            if (j != i)
+            {
+                sweep(store, min(i, j), max(i, j), out); // two oversized bodies find each other twice
+            }
+        }
+        return;
+    }
+
+    const int64_t cx = cellCoordinate(0.5 * (startX[i] + store.x[i]), width);
+    const int64_t cy = cellCoordinate(0.5 * (startY[i] + store.y[i]), width);
+    const int64_t cz = cellCoordinate(0.5 * (startZ[i] + store.z[i]), width);
+    const auto byKey = [](const pair<uint64_t, uint32_t> &cell, uint64_t key) { return cell.first < key; };
+
+    for (int64_t ox = -1; ox <= 1; ox++)
+    {
+        for (int64_t oy = -1; oy <= 1; oy++)
+        {
+            for (int64_t oz = -1; oz <= 1; oz++)
+            {
+                const uint64_t key = cellKey(cx + ox, cy + oy, cz + oz);
+                for (auto cell = lower_bound(cells.begin(), cells.end(), key, byKey); cell != cells.end() && cell->first == key; ++cell)
+                {
+                    const size_t j = cell->second;
+                    if (j > i)
+                    {
+                        sweep(store, i, j, out);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief merges every cluster of touching bodies into its heaviest member and drops the others from the store
+ */
+void CollisionDetector::merge(BodyStore &store, const function<void(BodyStore &)> &beforeMerge)
+{
+    for (vector<Collision> &list : found)
+    {
+        collisions.insert(collisions.end(), list.begin(), list.end());
+        list.clear();
+    }
+    // two neighbouring cells can share a key and two oversized bodies test each other, so a pair can be found twice
+    sort(collisions.begin(), collisions.end(), [](const Collision &a, const Collision &b)
+         { return a.first != b.first ? a.first < b.first : a.second < b.second; });
+    collisions.erase(unique(collisions.begin(), collisions.end(), [](const Collision &a, const Collision &b)
+                            { return a.first == b.first && a.second == b.second; }),
+                     collisions.end());
+    stable_sort(collisions.begin(), collisions.end(), [](const Collision &a, const Collision &b) { return a.time < b.time; });
+    if (collisions.empty())
+    {
+        return;
+    }
+    if (beforeMerge)
+    {
+        beforeMerge(store);
+    }
+
+    const size_t n = store.size();
+    vector<uint32_t> root(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        root[i] = static_cast<uint32_t>(i);
+    }
+    auto find = [&](uint32_t i)
+    {
+        while (root[i] != i)
+        {
+            root[i] = root[root[i]];
+            i = root[i];
+        }
+        return i;
+    };
+    for (const Collision &collision : collisions)
+    {
+        const uint32_t a = find(collision.first), b = find(collision.second);
+        root[max(a, b)] = min(a, b);
+    }
+
+    // the heaviest member of every cluster survives, the lowest slot among equals
+    vector<uint32_t> survivor(n);
+    vector<size_t> members(n, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint32_t r = find(static_cast<uint32_t>(i));
+        if (members[r]++ == 0 || store.mass[i] > store.mass[survivor[r]])
+        {
+            survivor[r] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // mass weighted sums over every cluster, equal weights for a cluster without mass
+    vector<double> total(n, 0.0), volume(n, 0.0), sums(6 * n, 0.0), weights(n, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        total[find(static_cast<uint32_t>(i))] += store.mass[i];
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint32_t r = find(static_cast<uint32_t>(i));
+        if (members[r] < 2)
+        {
+            continue;
+        }
+        const double w = total[r] > 0.0 ? store.mass[i] : 1.0;
+        weights[r] += w;
+        double *sum = &sums[6 * r];
+        sum[0] += w * store.x[i];
+        sum[1] += w * store.y[i];
+        sum[2] += w * store.z[i];
+        sum[3] += w * store.vx[i];
+        sum[4] += w * store.vy[i];
+        sum[5] += w * store.vz[i];
+        volume[r] += store.radius[i] * store.radius[i] * store.radius[i];
+    }
+
+    vector<bool> removed(n, false);
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint32_t r = find(static_cast<uint32_t>(i));
+        if (members[r] < 2)
+        {
+            continue;
+        }
+        const size_t s = survivor[r];
+        if (i != s)
+        {
+            removed[i] = true;
+            mergedInto[store.id[i]] = store.id[s];
+            absorbed++;
+            continue;
+        }
+        const double *sum = &sums[6 * r];
+        store.x[s] = sum[0] / weights[r];
+        store.y[s] = sum[1] / weights[r];
+        store.z[s] = sum[2] / weights[r];
+        store.vx[s] = sum[3] / weights[r];
+        store.vy[s] = sum[4] / weights[r];
+        store.vz[s] = sum[5] / weights[r];
+        store.mass[s] = total[r];
+        store.radius[s] = cbrt(volume[r]);
+    }
+    store.compact(removed);
+    merged += absorbed;
+
+    for (size_t s = 0; s < store.size(); s++)
+    {
+        slots[store.id[s]] = static_cast<uint32_t>(s);
+    }
+    for (size_t b = 0; b < slots.size(); b++)
+    {
+        uint32_t live = static_cast<uint32_t>(b);
+        while (mergedInto[live] != live)
+        {
+            live = mergedInto[live];
+        }
+        slots[b] = slots[live];
+    }
+}
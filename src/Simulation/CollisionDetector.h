@@ -0,0 +1,70 @@
+#ifndef COLLISION_DETECTOR_H
+#define COLLISION_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "BodyStore.h"
+
+// two slots whose spheres touched during the step, numbered before the compaction, and when, as a fraction of the step
+struct Collision
+{
+        std::uint32_t first, second;
+        double time;
+};
+
+/*
+    CollisionDetector class:
+        merges the bodies whose spheres touched during a step, Simulation::run takes a snapshot of the positions
+        before the integrator's step and resolves the collisions after it
+            broad phase    every body keyed by the grid cell of its swept bounding box's centre, the cells as wide as
+                           the CELL_SIZE_QUANTILE of the boxes, so two boxes that fit a cell and overlap sit in
+                           neighbouring cells, the keys sorted once and every body's 27 neighbouring cells looked up
+                           in parallel, the few wider boxes, a star or a fast body, are left out of the grid and
+                           tested against every body
+            narrow phase   the two spheres swept along the straight lines from their snapshot to their new positions,
+                           they touch if the closest approach of the relative line is under the sum of the radii
+            merge          every cluster of touching bodies becomes its heaviest member, with the total mass,
+                           the centre of mass and its velocity, so momentum is conserved, and the volume of the members
+            compaction     the absorbed slots are dropped from the store, so the later steps run on fewer bodies
+
+    snapshot and resolve are called by every thread of the parallel region, like the integrators,
+    the merge and compaction are done by one thread, collisions are rare
+    beforeMerge is run by that thread when there is something to merge, before the store changes, Simulation::run
+    synchronizes the integrator there, the merge then sees the velocities at the positions' time and the restart
+    after it gives no body a second opening half kick
+*/
+class CollisionDetector
+{
+public:
+        explicit CollisionDetector(std::size_t bodyCount);
+
+        void snapshot(const BodyStore &store);
+        std::size_t resolve(BodyStore &store, const std::function<void(BodyStore &)> &beforeMerge = nullptr);
+
+        std::uint32_t slotOf(std::size_t body) const { return slots[body]; } // the slot of the body, or of the one it merged into
+        const std::vector<Collision> &lastCollisions() const { return collisions; }
+        std::uint64_t mergedBodies() const { return merged; }
+
+private:
+        static constexpr double CELL_SIZE_QUANTILE = 0.99;   // fraction of the swept boxes the cells are as wide as
+
+        std::vector<double> startX, startY, startZ;          // positions at the snapshot
+        std::vector<double> extents;                         // widest side of every body's swept box, with its diameter
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> cells; // cell key and slot of every body, sorted by key
+        std::vector<std::vector<Collision>> found;           // the collisions every thread found
+        std::vector<Collision> collisions;                   // the collisions of the last step, ordered by time
+        std::vector<std::uint32_t> mergedInto;               // body every body merged into, itself while it survives
+        std::vector<std::uint32_t> slots;                    // slot of every body, of its survivor once merged
+        double cellSize = 0.0;
+        std::size_t absorbed = 0;                            // bodies absorbed in the last resolve
+        std::uint64_t merged = 0;                            // bodies absorbed so far
+
+        void sweep(const BodyStore &store, std::size_t i, std::size_t j, std::vector<Collision> &out) const;
+        void collect(const BodyStore &store, std::size_t i, std::vector<Collision> &out) const;
+        void merge(BodyStore &store, const std::function<void(BodyStore &)> &beforeMerge);
+};
+
+#endif
@@ -0,0 +1,299 @@
+/**
+ * This file contains the implementation of the Diagnostics class, the conserved quantities of a run
+ *
+ * the pair potential is the one whose gradient is the clamped force G m / (max(r, e)^2 + e^2) of the solvers,
+ * -G m_i m_j phi(r) with
+ *      phi(r) = atan(e / r) / e                          r >= e
+ *      phi(r) = pi / (4 e) + (e - r) / (2 e^2)           r < e, where the force stays at its value at e
+ * atan(e / r) / e is 1 / r to the last bit once r is 1e8 e, so the 1 / r of the tree's far cells is the same law,
+ * their quadrupole Q_ab = sum m (3 d_a d_b - d^2 delta_ab) adds x Q x / (2 r^5), which brings the walk from several 1e-6
+ * of the direct sum to below TREE_POTENTIAL_FLOOR
+ * with per body multipliers, a pair counts half of G (g_i + g_j) m_i m_j phi, what the per body potentials of the walk add up to
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <omp.h>
+#include "Diagnostics.h"
+#include "ForceSolver.h"
+#include "Reduction.h"
+using namespace std;
+
+const int DIAGNOSTICS_STACK_SIZE = 512; // 21 levels of at most 8 children, with room to spare
+const size_t SUM_COUNT = 12;            // kinetic, potential, momentum, angular momentum, mass moment, mass
+
+/**
+ * @brief phi(r) of the clamped force law, the potential of a pair is -G m_i m_j phi(r)
+ */
+static inline double pairPotential(double r)
+{
+    const double e = SOFTENING_LENGTH;
+    if (r < e)
+    {
+        return M_PI / (4.0 * e) + (e - r) / (2.0 * e * e);
+    }
+    return r < 1e8 * e ? atan(e / r) / e : 1.0 / r;
+}
+
+/**
+ * @param path the time series file, none when empty
+ * @param interval steps between two records, 0 never records
+ */
+Diagnostics::Diagnostics(const string &path, int interval) : interval(interval)
+{
+    if (path.empty())
+    {
+        return;
+    }
+    file.open(path);
+    if (!file.is_open())
+    {
+        throw runtime_error("Unable to open file: " + path);
+    }
+    file << "# step time N kinetic potential energy energyError px py pz Lx Ly Lz comX comY comZ"
+         << " (from " << TREE_POTENTIAL_THRESHOLD << " bodies on the potential comes from an octree walk, theta " << DIAGNOSTICS_THETA
+         << " with quadrupoles, good to about " << TREE_POTENTIAL_FLOOR << " relative, the floor of energyError)" << endl;
+    file << setprecision(15);
+}
+
+/**
+ * @brief measures the energies, momenta and centre of mass of the bodies, last() holds them on every thread afterwards
+ * @param store the bodies, velocities at the positions' time
+ */
+void Diagnostics::measure(const BodyStore &store)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    blockSums.assign(DETERMINISTIC_BLOCKS * SUM_COUNT, 0.0);
+
+    #pragma omp for schedule(static) nowait
+    for (size_t b = 0; b < DETERMINISTIC_BLOCKS; b++)
+    {
+        double *sums = &blockSums[b * SUM_COUNT];
+        for (size_t i = blockBegin(n, b, DETERMINISTIC_BLOCKS); i < blockBegin(n, b + 1, DETERMINISTIC_BLOCKS); i++)
+        {
+            const double m = store.mass[i];
+            const double x = store.x[i], y = store.y[i], z = store.z[i];
+            const double vx = store.vx[i], vy = store.vy[i], vz = store.vz[i];
+            sums[0] += 0.5 * m * (vx * vx + vy * vy + vz * vz);
+            sums[2] += m * vx;
+            sums[3] += m * vy;
+            sums[4] += m * vz;
+            sums[5] += m * (y * vz - z * vy);
+            sums[6] += m * (z * vx - x * vz);
+            sums[7] += m * (x * vy - y * vx);
+            sums[8] += m * x;
+            sums[9] += m * y;
+            sums[10] += m * z;
+            sums[11] += m;
+        }
+    }
+
+    if (n < TREE_POTENTIAL_THRESHOLD)
+    {
+        directPotential(store);
+    }
+    else
+    {
+        treePotential(store);
+    }
+    #pragma omp barrier
+
+    // the blocks are fixed by the number of bodies, so every thread count reports the same numbers
+    #pragma omp single
+    {
+        double total[SUM_COUNT];
+        for (size_t k = 0; k < SUM_COUNT; k++)
+        {
+            total[k] = pairwiseSum(&blockSums[k], DETERMINISTIC_BLOCKS, SUM_COUNT);
+        }
+        current.kinetic = total[0];
+        current.potential = total[1];
+        current.mass = total[11];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            current.momentum[axis] = total[2 + axis];
+            current.angularMomentum[axis] = total[5 + axis];
+            current.centreOfMass[axis] = current.mass > 0.0 ? total[8 + axis] / current.mass : 0.0;
+        }
+        if (!started)
+        {
+            initial = current;
+            started = true;
+        }
+    }
+}
+
+/**
+ * @brief measures the bodies and appends the line of the time series
+ * @param store the bodies, velocities at the positions' time
+ * @param step the steps taken so far
+ * @param time the simulated seconds so far
+ */
+void Diagnostics::record(const BodyStore &store, int step, double time)
+{
+    measure(store);
+    #pragma omp single
+    {
+        if (file.is_open())
+        {
+            const DiagnosticsSample &s = current;
+            file << step << ' ' << time << ' ' << store.size() << ' ' << s.kinetic << ' ' << s.potential << ' ' << s.energy() << ' ' << energyError()
+                 << ' ' << s.momentum[0] << ' ' << s.momentum[1] << ' ' << s.momentum[2]
+                 << ' ' << s.angularMomentum[0] << ' ' << s.angularMomentum[1] << ' ' << s.angularMomentum[2]
+                 << ' ' << s.centreOfMass[0] << ' ' << s.centreOfMass[1] << ' ' << s.centreOfMass[2] << '\n';
+            file.flush(); // the series can be watched while the run goes on
+        }
+    }
+}
+
+double Diagnostics::energyError() const
+{
+    const double reference = initial.energy();
+    return reference != 0.0 ? (current.energy() - reference) / fabs(reference) : 0.0;
+}
+
+/**
+ * @brief adds the potential energy of every pair to the block sums, the triangle split into blocks of equal pair counts
+ */
+void Diagnostics::directPotential(const BodyStore &store)
+{
+    const size_t n = store.size();
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (size_t b = 0; b < DETERMINISTIC_BLOCKS; b++)
+    {
+        for (size_t i = triangleBlockBegin(n, b, DETERMINISTIC_BLOCKS); i < triangleBlockBegin(n, b + 1, DETERMINISTIC_BLOCKS); i++)
+        {
+            blockSums[b * SUM_COUNT + 1] -= 0.5 * GRAVITY_CONSTANT * store.mass[i] * rowPotential(store, i);
+        }
+    }
+}
+
+/**
+ * @brief the sum of (g_i + g_j) m_j phi(r_ij) over the bodies j after i
+ */
+double Diagnostics::rowPotential(const BodyStore &store, size_t i) const
+{
+    const double xi = store.x[i], yi = store.y[i], zi = store.z[i], gi = store.gravitationalMultiplier[i];
+    double row = 0.0;
+    for (size_t j = i + 1; j < store.size(); j++)
+    {
+        const double dx = store.x[j] - xi, dy = store.y[j] - yi, dz = store.z[j] - zi;
+        row += (gi + store.gravitationalMultiplier[j]) * store.mass[j] * pairPotential(sqrt(dx * dx + dy * dy + dz * dz));
+    }
+    return row;
+}
+
+/**
+ * @brief adds half of every body's potential energy in the field of the others to the block sums, the blocks runs
+ * of the Morton order, from a walk of the octree with the opening criterion of BarnesHutSolver,
+ * a far cell counts as its mass and quadrupole at its centre of mass
+ */
+void Diagnostics::treePotential(const BodyStore &store)
+{
+    tree.build(store);
+
+    const size_t nodeCount = tree.nodeCount();
+    #pragma omp single
+    quadrupoles.resize(6 * nodeCount);
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t index = 0; index < nodeCount; index++)
+    {
+        nodeQuadrupole(index);
+    }
+
+    const size_t n = store.size();
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (size_t b = 0; b < DETERMINISTIC_BLOCKS; b++)
+    {
+        for (size_t k = blockBegin(n, b, DETERMINISTIC_BLOCKS); k < blockBegin(n, b + 1, DETERMINISTIC_BLOCKS); k++)
+        {
+            const uint32_t i = tree.order[k];
+            blockSums[b * SUM_COUNT + 1] -= 0.5 * GRAVITY_CONSTANT * store.gravitationalMultiplier[i] * tree.mass[k] * walkPotential(k);
+        }
+    }
+}
+
+/**
+ * @brief the quadrupole of one node about its centre of mass, summed over its bodies in Morton order, the leaves are
+ * never taken as a whole and are skipped
+ */
+void Diagnostics::nodeQuadrupole(size_t index)
+{
+    const OctreeNode &node = tree.nodes[index];
+    double *q = &quadrupoles[6 * index];
+    fill(q, q + 6, 0.0);
+    if (node.firstChild < 0)
+    {
+        return;
+    }
+    for (uint32_t j = node.begin; j < node.end; j++)
+    {
+        const double dx = tree.x[j] - node.comX, dy = tree.y[j] - node.comY, dz = tree.z[j] - node.comZ, m = tree.mass[j];
+        const double d2 = dx * dx + dy * dy + dz * dz;
+        q[0] += m * (3.0 * dx * dx - d2);
+        q[1] += m * (3.0 * dy * dy - d2);
+        q[2] += m * (3.0 * dz * dz - d2);
+        q[3] += m * 3.0 * dx * dy;
+        q[4] += m * 3.0 * dx * dz;
+        q[5] += m * 3.0 * dy * dz;
+    }
+}
+
+/**
+ * @brief the sum of m_j phi(r_kj) over every other body, for the k-th body in Morton order
+ */
+double Diagnostics::walkPotential(size_t k) const
+{
+    const double inverseTheta = 1.0 / DIAGNOSTICS_THETA;
+    const vector<OctreeNode> &nodes = tree.nodes;
+    const double xi = tree.x[k], yi = tree.y[k], zi = tree.z[k];
+    double phi = 0.0;
+
+    int stack[DIAGNOSTICS_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const int index = stack[--top];
+        const OctreeNode &node = nodes[index];
+        if (node.firstChild < 0)
+        {
+            for (uint32_t j = node.begin; j < node.end; j++)
+            {
+                if (j == k)
+                {
+                    continue;
+                }
+                const double dx = tree.x[j] - xi, dy = tree.y[j] - yi, dz = tree.z[j] - zi;
+                phi += tree.mass[j] * pairPotential(sqrt(dx * dx + dy * dy + dz * dz));
+            }
+            continue;
+        }
+
+        const double dx = node.comX - xi, dy = node.comY - yi, dz = node.comZ - zi;
+        const double r2 = dx * dx + dy * dy + dz * dz;
+        const double offX = node.comX - node.centerX, offY = node.comY - node.centerY, offZ = node.comZ - node.centerZ;
+        const double openingDistance = node.size * inverseTheta + sqrt(offX * offX + offY * offY + offZ * offZ);
+        if (r2 > openingDistance * openingDistance)
+        {
+            const double *q = &quadrupoles[6 * index];
+            const double form = q[0] * dx * dx + q[1] * dy * dy + q[2] * dz * dz + 2.0 * (q[3] * dx * dy + q[4] * dx * dz + q[5] * dy * dz);
+            const double r = sqrt(r2);
+            phi += node.mass / r + 0.5 * form / (r2 * r2 * r);
+        }
+        else
+        {
+            for (int c = 0; c < node.childCount; c++)
+            {
+                stack[top++] = node.firstChild + c;
+            }
+        }
+    }
+    return phi;
+}
@@ -0,0 +1,71 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "BodyStore.h"
+#include "Octree.h"
+
+const std::size_t TREE_POTENTIAL_THRESHOLD = 4096; // from this many bodies on the potential energy comes from an octree walk
+const double DIAGNOSTICS_THETA = 0.3;              // opening angle of that walk, tighter than the solvers' default
+const double TREE_POTENTIAL_FLOOR = 1e-6;          // relative error of the walk's potential, and so of energyError, to expect
+
+// the conserved quantities of the bodies at one instant, SI units, angular momentum about the origin
+struct DiagnosticsSample
+{
+        double kinetic = 0.0, potential = 0.0;
+        double momentum[3] = {0.0, 0.0, 0.0};
+        double angularMomentum[3] = {0.0, 0.0, 0.0};
+        double centreOfMass[3] = {0.0, 0.0, 0.0};
+        double mass = 0.0;
+
+        double energy() const { return kinetic + potential; }
+};
+
+/*
+    Diagnostics class:
+        measures the kinetic and potential energy, the momentum, the angular momentum and the centre of mass
+        of the bodies, Simulation::run records them every DiagnosticsInterval steps as one line of a time series
+            kinetic, momenta, centre   one parallel pass over the bodies, in the fixed blocks of Reduction.h added pairwise
+            potential                  the direct sum over pairs below TREE_POTENTIAL_THRESHOLD bodies,
+                                       above it every body's potential from a walk of an octree, O(N log N),
+                                       a far cell counts as its mass and quadrupole at its centre of mass, so the
+                                       potential is good to about TREE_POTENTIAL_FLOOR and the energy error of a run
+                                       measured this way has that floor, a drift below it cannot be told from the walk
+        the pair potential is the one of the clamped force law, so a leapfrog on the default solvers conserves it,
+        and the energy error of every line is relative to the first sample
+
+    measure and record are called by every thread of the parallel region, like the integrators,
+    the velocities have to be at the positions' time, Integrator::synchronize brings them there
+*/
+class Diagnostics
+{
+public:
+        explicit Diagnostics(const std::string &path = "", int interval = 0);
+
+        bool due(int step) const { return interval > 0 && step % interval == 0; }
+        void measure(const BodyStore &store);
+        void record(const BodyStore &store, int step, double time);
+
+        const DiagnosticsSample &last() const { return current; }
+        double energyError() const; // relative change of the energy since the first sample
+
+private:
+        std::ofstream file; // the time series, not written when the path is empty
+        int interval;
+        Octree tree;
+        std::vector<double> quadrupoles; // xx, yy, zz, xy, xz, yz of every node, about its centre of mass, traceless
+        std::vector<double> blockSums; // the sums of every fixed block, so the thread count never changes a record
+        DiagnosticsSample current, initial;
+        bool started = false;
+
+        void directPotential(const BodyStore &store);
+        void treePotential(const BodyStore &store);
+        void nodeQuadrupole(std::size_t index);
+        double rowPotential(const BodyStore &store, std::size_t i) const;
+        double walkPotential(std::size_t k) const;
+};
+
+#endif
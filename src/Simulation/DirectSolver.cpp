@@ -0,0 +1,84 @@
+/**
+ * This file contains the implementation of the DirectSolver class, the per-target O(N^2) force sum
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <cmath>
+#include "DirectSolver.h"
+using namespace std;
+
+/**
+ * @brief computes the acceleration of every body, shares the targets between the threads of the enclosing region
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void DirectSolver::computeAccelerations(BodyStore &store)
+{
+    loop.run(store.size(), TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            store.ax[i] = 0.0;
+            store.ay[i] = 0.0;
+            store.az[i] = 0.0;
+            accumulateAcceleration(store, i);
+        }
+    });
+}
+
+/**
+ * @brief computes the acceleration of the listed bodies only
+ * @param store the bodies, ax/ay/az of the targets are overwritten
+ * @param targets indices of the bodies to accelerate
+ */
+void DirectSolver::computeAccelerationsOf(BodyStore &store, const vector<uint32_t> &targets)
+{
+    loop.run(targets.size(), TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            const size_t i = targets[k];
+            store.ax[i] = 0.0;
+            store.ay[i] = 0.0;
+            store.az[i] = 0.0;
+            accumulateAcceleration(store, i);
+        }
+    });
+}
+
+/**
+ * @brief adds the gravitational acceleration of every other body to body i
+ *
+ * same force law as Body::gravForce, divided by the mass of body i:
+ * a = G * multiplier * m2 / ((r*r) + (e*e)) along the unit distance vector, with r clamped to e
+ * coincident bodies have no direction to pull along and are skipped instead of throwing
+ *
+ * @param store the bodies
+ * @param i the index of the body to accelerate
+ */
+void DirectSolver::accumulateAcceleration(BodyStore &store, size_t i)
+{
+    const double xi = store.x[i], yi = store.y[i], zi = store.z[i];
+    const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+    for (size_t j = 0; j < store.size(); j++)
+    {
+        const double dx = store.x[j] - xi;
+        const double dy = store.y[j] - yi;
+        const double dz = store.z[j] - zi;
+        const double r2 = dx * dx + dy * dy + dz * dz;
+        if (j == i || r2 == 0.0)
+        {
+            continue;
+        }
+        const double r = sqrt(r2);
+        const double dist = r < SOFTENING_LENGTH ? SOFTENING_LENGTH : r;
+        const double accelMag = scale * store.mass[j] / ((dist * dist) + (SOFTENING_LENGTH * SOFTENING_LENGTH));
+        sumX += dx / r * accelMag;
+        sumY += dy / r * accelMag;
+        sumZ += dz / r * accelMag;
+    }
+
+    store.ax[i] += sumX;
+    store.ay[i] += sumY;
+    store.az[i] += sumZ;
+}
@@ -0,0 +1,22 @@
+#ifndef DIRECT_SOLVER_H
+#define DIRECT_SOLVER_H
+
+#include <cstddef>
+#include "ForceSolver.h"
+
+/*
+    DirectSolver class:
+        the plain O(N^2) sum, every body loops over every other body
+        each pair is evaluated twice, once from each side, but no thread ever writes another body's acceleration
+*/
+class DirectSolver : public ForceSolver
+{
+public:
+        const char *name() const override { return "direct"; }
+        void computeAccelerations(BodyStore &store) override;
+        void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) override;
+
+        static void accumulateAcceleration(BodyStore &store, std::size_t i);
+};
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * This file contains the implementation of the Fft class, the in-tree FFT used by the mesh solvers
+ *
+ * the butterflies multiply by hand rather than through std::complex, whose operator* checks for infinities
+ * and NaNs and stays a library call unless the whole program is built with -ffast-math
+ *
+ * lines along y and z are strided, they are gathered LINE_BLOCK at a time from neighbouring x,
+ * so every cache line read or written carries data of several lines
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "Fft.h"
+using namespace std;
+
+const size_t LINE_BLOCK = 8; // strided lines gathered together, 8 complex doubles are two cache lines
+
+Fft::Fft(size_t length) : length(length)
+{
+    if (length < 2 || (length & (length - 1)) != 0)
+    {
+        throw invalid_argument("FFT length must be a power of two");
+    }
+
+    twiddles.resize(length / 2);
+    for (size_t k = 0; k < length / 2; k++)
+    {
+        const double angle = -2.0 * M_PI * double(k) / double(length);
+        twiddles[k] = complex<double>(cos(angle), sin(angle));
+    }
+
+    int bits = 0;
+    while ((size_t(1) << bits) < length)
+    {
+        bits++;
+    }
+    reversed.resize(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++)
+        {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        reversed[i] = r;
+    }
+}
+
+/**
+ * @brief transforms one contiguous line in place
+ * @param line length values
+ * @param inverse true for the exp(+2 pi i / length) direction
+ */
+void Fft::transform(complex<double> *line, bool inverse) const
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        const size_t j = reversed[i];
+        if (i < j)
+        {
+            swap(line[i], line[j]);
+        }
+    }
+
+    double *values = reinterpret_cast<double *>(line); // complex<double> is guaranteed to be laid out as re, im
+    const double sign = inverse ? -1.0 : 1.0;
+    for (size_t half = 1; half < length; half *= 2)
+    {
+        const size_t step = length / (2 * half);
+        for (size_t start = 0; start < length; start += 2 * half)
+        {
+            for (size_t k = 0; k < half; k++)
+            {
+                const double wRe = twiddles[k * step].real(), wIm = sign * twiddles[k * step].imag();
+                double *u = values + 2 * (start + k);
+                double *v = values + 2 * (start + k + half);
+                const double tRe = v[0] * wRe - v[1] * wIm;
+                const double tIm = v[0] * wIm + v[1] * wRe;
+                v[0] = u[0] - tRe;
+                v[1] = u[1] - tIm;
+                u[0] += tRe;
+                u[1] += tIm;
+            }
+        }
+    }
+}
+
+/**
+ * @brief transforms the lines starting at a * strideA + b * strideB for a < countA, b < countB,
+ * consecutive values of a line stride apart
+ */
+void Fft::transformAxis(complex<double> *cube, bool inverse, size_t stride,
+                        size_t strideA, size_t countA, size_t strideB, size_t countB) const
+{
+    if (stride == 1)
+    {
+        #pragma omp for schedule(static)
+        for (size_t line = 0; line < countA * countB; line++)
+        {
+            transform(cube + (line % countA) * strideA + (line / countA) * strideB, inverse);
+        }
+        return;
+    }
+
+    // strided lines, strideA is 1 here, so a block of neighbouring a shares its cache lines
+    vector<complex<double>> scratch(LINE_BLOCK * length);
+    const size_t blocks = (countA + LINE_BLOCK - 1) / LINE_BLOCK;
+    #pragma omp for schedule(static)
+    for (size_t block = 0; block < blocks * countB; block++)
+    {
+        const size_t firstA = (block % blocks) * LINE_BLOCK, b = block / blocks;
+        const size_t width = min(LINE_BLOCK, countA - firstA);
+        complex<double> *base = cube + firstA * strideA + b * strideB;
+        for (size_t i = 0; i < length; i++)
+        {
+            for (size_t w = 0; w < width; w++)
+            {
+                scratch[w * length + i] = base[i * stride + w * strideA];
+            }
+        }
+        for (size_t w = 0; w < width; w++)
+        {
+            transform(&scratch[w * length], inverse);
+        }
+        for (size_t i = 0; i < length; i++)
+        {
+            for (size_t w = 0; w < width; w++)
+            {
+                base[i * stride + w * strideA] = scratch[w * length + i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief transforms a cube, x fastest, along all three axes, every thread of the enclosing region must call it
+ * @param cube length^3 values
+ * @param inverse false: the data is zero outside the first dataExtent planes of every axis,
+ *                true: only the first dataExtent planes of every axis are read afterwards
+ * @param dataExtent length for a full transform
+ */
+void Fft::transform3d(complex<double> *cube, bool inverse, size_t dataExtent) const
+{
+    const size_t n = length, plane = length * length;
+    if (!inverse)
+    {
+        transformAxis(cube, false, 1, n, dataExtent, plane, dataExtent); // x lines of the nonzero y, z
+        transformAxis(cube, false, n, 1, n, plane, dataExtent);          // y lines of the nonzero z
+        transformAxis(cube, false, plane, 1, n, n, n);                   // every z line
+    }
+    else
+    {
+        transformAxis(cube, true, plane, 1, n, n, n);                    // every z line
+        transformAxis(cube, true, n, 1, n, plane, dataExtent);           // y lines of the z read afterwards
+        transformAxis(cube, true, 1, n, dataExtent, plane, dataExtent);  // x lines of the y, z read afterwards
+    }
+}
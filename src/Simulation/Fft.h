@@ -0,0 +1,42 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+    Fft class:
+        in place complex FFT of power of two length, iterative radix 2, twiddles and bit reversal built once
+            transform       one contiguous line
+            transform3d     a cube of length^3 values, x fastest, every line along every axis in turn
+
+    transforms are unnormalized, a forward and an inverse transform scale the data by length (length^3 for the cube)
+
+    transform3d is collective like ForceSolver::computeAccelerations, every thread of the enclosing region calls it,
+    and it skips the lines that are known to be zero going in or not needed coming out:
+    a forward transform is told the data sits in the first dataExtent planes of every axis,
+    an inverse transform is told only the first dataExtent planes of every axis are read afterwards,
+    which is what a zero padded convolution needs and saves close to half of its work
+*/
+class Fft
+{
+public:
+        explicit Fft(std::size_t length);
+
+        std::size_t size() const { return length; }
+
+        void transform(std::complex<double> *line, bool inverse) const;
+        void transform3d(std::complex<double> *cube, bool inverse, std::size_t dataExtent) const;
+
+private:
+        std::size_t length;
+        std::vector<std::complex<double>> twiddles; // exp(-2 pi i k / length), k < length / 2
+        std::vector<std::uint32_t> reversed;        // bit reversed index of every position
+
+        void transformAxis(std::complex<double> *cube, bool inverse, std::size_t stride,
+                           std::size_t strideA, std::size_t countA, std::size_t strideB, std::size_t countB) const;
+};
+
+#endif
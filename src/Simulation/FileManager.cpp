@@ -30,6 +30,7 @@ const int TRAJECTORY_SCALE_FACTOR = 1000000000; // scale factor for trajectories
  * @param timestep: the timestep of the simulation
  * @param iterations: the number of iterations of the simulation
  * @param bodyCount: an array of integers that store the number of bodies of each type
+ * @param config: the optional solver settings, fields not present in the file keep their defaults
  */
 FileManager::FileManager(const string fileName) : fileName(fileName) {}
 void FileManager::loadConfig(
@@ -38,7 +39,8 @@ void FileManager::loadConfig(
     double &timestep,
     double &gravitationalMultiplier,
     int &iterations,
-    int bodyCount[5])
+    int bodyCount[5],
+    SimulationConfig &config)
 {
     // Open the input file
     ifstream file(filePath);
@@ -88,17 +90,109 @@ void FileManager::loadConfig(
         {
             StringFileReader >> gravitationalMultiplier;
         }
+        else if (keyword == "Solver")
+        {
+            StringFileReader >> config.solver; // which ForceSolver computes the accelerations
+        }
+        else if (keyword == "Theta")
+        {
+            StringFileReader >> config.theta; // Barnes-Hut opening angle
+        }
+        else if (keyword == "ExpansionOrder")
+        {
+            StringFileReader >> config.expansionOrder; // order of the fmm expansions
+        }
+        else if (keyword == "TileTargets")
+        {
+            StringFileReader >> config.tileTargets; // targets per tile of the tiled solver
+        }
+        else if (keyword == "TileSources")
+        {
+            StringFileReader >> config.tileSources; // sources per packed block of the tiled solver
+        }
+        else if (keyword == "GridSize")
+        {
+            StringFileReader >> config.gridSize; // mesh points per axis of the pm solver
+        }
+        else if (keyword == "Assignment")
+        {
+            StringFileReader >> config.assignment; // mass assignment scheme of the pm solver
+        }
+        else if (keyword == "SplitScale")
+        {
+            StringFileReader >> config.splitScale; // p3m split scale in mesh cells
+        }
+        else if (keyword == "Cutoff")
+        {
+            StringFileReader >> config.cutoff; // p3m short range cutoff in split scales
+        }
+        else if (keyword == "Softening")
+        {
+            StringFileReader >> config.softening; // how the direct-sum kernels soften close pairs
+        }
+        else if (keyword == "Precision")
+        {
+            StringFileReader >> config.precision; // what the direct-sum pair terms are computed in
+        }
+        else if (keyword == "Deterministic")
+        {
+            StringFileReader >> config.deterministic; // on for forces that do not depend on the thread count
+        }
+        else if (keyword == "Integrator")
+        {
+            StringFileReader >> config.integrator; // which Integrator advances the bodies
+        }
+        else if (keyword == "BlockLevels")
+        {
+            StringFileReader >> config.blockLevels; // finest block timestep level, 0 for one shared timestep
+        }
+        else if (keyword == "AdaptiveTimestep")
+        {
+            StringFileReader >> config.adaptiveTimestep; // criterion of the adaptive shared step, off for a fixed Timestep
+        }
+        else if (keyword == "EndTime")
+        {
+            StringFileReader >> config.endTime; // simulated seconds to run instead of Iterations
+        }
+        else if (keyword == "RegularizationRadius")
+        {
+            StringFileReader >> config.regularizationRadius; // separation under which bodies are regularized as a group, 0 for none
+        }
+        else if (keyword == "Collisions")
+        {
+            StringFileReader >> config.collisions; // off, or merge the bodies that touch
+        }
+        else if (keyword == "DiagnosticsInterval")
+        {
+            StringFileReader >> config.diagnosticsInterval; // steps between two diagnostics records, 0 for none
+        }
+        else if (keyword == "DiagnosticsFile")
+        {
+            StringFileReader >> config.diagnosticsFile; // where the diagnostics time series goes
+        }
+        else if (keyword == "FixedSize")
+        {
+            StringFileReader >> config.fixedSize; // auto or off, whether tiny runs use the compile-time N engine
+        }
+        else if (keyword == "NumaReplicas")
+        {
+            StringFileReader >> config.numaReplicas; // on or off, whether the direct sums read a copy of the sources on their own node
+        }
+        else if (keyword == "TimestepAccuracy")
+        {
+            StringFileReader >> config.timestepAccuracy; // accuracy parameter of the block, hermite and adaptive step criteria
+        }
         else if (keyword == "body")
         {
             // Parse body information
             int id;
             StringFileReader >> id;
 
-            Vector position, velocity, accel, net_force = Vector(0, 0, 0);
+            Vec3 position{}, velocity{}, accel{}, net_force{};
             double mass, radius = 0.0;
             string type = "";
             vector<int> children;
-            vector<Vector> trajectory;
+            vector<Vec3> trajectory;
 
             // Read subsequent lines for body details
             while (getline(file, line) && !line.empty())
@@ -204,18 +298,19 @@ vector<string> thread_outputs(omp_get_max_threads());
             {   
                 // output the trajectory of the body
                 if (j % SLICING_FACTOR == 0) {
-                    Vector scaledPosition = bodies[i].trajectory[j] / TRAJECTORY_SCALE_FACTOR;
+                    Vec3 scaledPosition = bodies[i].trajectory[j] / TRAJECTORY_SCALE_FACTOR;
                     local_stream << scaledPosition; // Using the overloaded << operator
                 }
             }
         }
         thread_outputs[omp_get_thread_num()] = local_stream.str();
     }   
-    // output the trajectories of the bodies to the file sequentially
+    // output the trajectories of the bodies to the file sequentially, one line break at the end whatever the thread count
     for (const string& thread_output : thread_outputs)
     {
-        file << thread_output << endl;
+        file << thread_output;
     }
+    file << endl;
 
 // output the locations of the bodies to the file
 file.close();
@@ -7,8 +7,9 @@
 
 #include "vector.h"
 #include "body.h"
+#include "SimulationConfig.h"
 
-struct Vector;
+struct Vec3;
 class Body;
 
 class FileManager
@@ -24,7 +25,8 @@ class FileManager
                         double &timestep,
                         double &gravitationalMultiplier,
                         int &iterations,
-                        int bodyCount[5]);
+                        int bodyCount[5],
+                        SimulationConfig &config);
 
         void outputResults(const std::string &filePath,
                            const std::vector<Body> &bodies, 
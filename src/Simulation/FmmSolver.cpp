@@ -0,0 +1,437 @@
+/**
+ * This file contains the implementation of the FmmSolver class, the fast multipole method on the shared octree
+ *
+ * expansions are Cartesian Taylor series about each cell's centre of mass, indexed by multi-indices a = (a1, a2, a3)
+ *      multipole       M_a = sum over the cell's bodies of m d^a, d the offset of the body from the centre
+ *      local           L_b, the potential near the centre is phi(c + e) = sum over b of L_b e^b
+ *      derivatives     D_g(R) = (d/dR)^g (1 / |R|) / g!, from the recurrence
+ *                      n |R|^2 D_g + (2n - 1) sum_i R_i D_(g - e_i) + (n - 1) sum_i D_(g - 2e_i) = 0, n = |g|
+ * with every binomial over multi-indices the product of the per axis binomials
+ *      M2M     M_a(parent) += C(a, k) s^(a - k) M_k(child),            s = child centre - parent centre
+ *      M2L     L_b(target) += (-1)^|a| C(a + b, a) D_(a + b)(R) M_a,   R = target centre - source centre
+ *      L2L     L_b(child)  += C(g, b) s^(g - b) L_g(parent),           s = child centre - parent centre
+ *      L2P     a = G * multiplier * grad phi
+ * all terms with a total degree above the order are dropped, the tables of surviving terms are built once
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "FmmSolver.h"
+using namespace std;
+
+const int MAX_ORDER = 12;                                            // (MAX_ORDER + 1)(MAX_ORDER + 2)(MAX_ORDER + 3) / 6 terms
+const size_t MAX_TERMS = (MAX_ORDER + 1) * (MAX_ORDER + 2) * (MAX_ORDER + 3) / 6;
+const uint32_t TASK_THRESHOLD = 1024;                                // cells with more bodies than this are worked on as their own task
+const double DIRECT_PAIRS_PER_M2L_TERM = 2.0;                        // below this many body pairs per M2L term a cell pair is cheaper summed directly
+
+/**
+ * @brief binomial coefficient n over k, exact in a double for the orders used here
+ */
+static double binomial(int n, int k)
+{
+    double result = 1.0;
+    for (int i = 1; i <= k; i++)
+    {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+FmmSolver::FmmSolver(int order, double theta, size_t leafCapacity, SimdLevel level)
+    : order(order), theta(theta), tree(leafCapacity), kernel(sourceKernelFor(level))
+{
+    if (order < 1 || order > MAX_ORDER)
+    {
+        throw invalid_argument("Expansion order must be between 1 and " + to_string(MAX_ORDER));
+    }
+    if (theta <= 0.0 || theta >= 1.0)
+    {
+        throw invalid_argument("The multipole method needs a theta between 0 and 1");
+    }
+    buildTables();
+    directPairLimit = DIRECT_PAIRS_PER_M2L_TERM * m2lTerms.size();
+}
+
+/**
+ * @brief lists the multi-indices up to the order and the surviving terms of every translation
+ */
+void FmmSolver::buildTables()
+{
+    vector<int> indexOf((order + 1) * (order + 1) * (order + 1), -1);
+    auto at = [this](int a, int b, int c) { return (a * (order + 1) + b) * (order + 1) + c; };
+
+    for (int degree = 0; degree <= order; degree++)
+    {
+        for (int a = degree; a >= 0; a--)
+        {
+            for (int b = degree - a; b >= 0; b--)
+            {
+                indexOf[at(a, b, degree - a - b)] = static_cast<int>(exponents.size());
+                exponents.push_back({a, b, degree - a - b});
+            }
+        }
+    }
+    termCount = exponents.size();
+
+    lowerX.assign(termCount, -1);
+    lowerY.assign(termCount, -1);
+    lowerZ.assign(termCount, -1);
+    for (size_t k = 0; k < termCount; k++)
+    {
+        const array<int, 3> &e = exponents[k];
+        if (e[0] > 0) lowerX[k] = indexOf[at(e[0] - 1, e[1], e[2])];
+        if (e[1] > 0) lowerY[k] = indexOf[at(e[0], e[1] - 1, e[2])];
+        if (e[2] > 0) lowerZ[k] = indexOf[at(e[0], e[1], e[2] - 1)];
+    }
+
+    // every pair lower <= upper of multi-indices, with C(upper, lower)
+    for (size_t u = 0; u < termCount; u++)
+    {
+        const array<int, 3> &upper = exponents[u];
+        for (size_t l = 0; l < termCount; l++)
+        {
+            const array<int, 3> &lower = exponents[l];
+            if (lower[0] > upper[0] || lower[1] > upper[1] || lower[2] > upper[2])
+            {
+                continue;
+            }
+            const int difference = indexOf[at(upper[0] - lower[0], upper[1] - lower[1], upper[2] - lower[2])];
+            const double c = binomial(upper[0], lower[0]) * binomial(upper[1], lower[1]) * binomial(upper[2], lower[2]);
+            m2mTerms.push_back({static_cast<int>(u), static_cast<int>(l), difference, c});
+            l2lTerms.push_back({static_cast<int>(l), static_cast<int>(u), difference, c});
+        }
+    }
+
+    // every pair a, b whose sum stays within the order
+    for (size_t b = 0; b < termCount; b++)
+    {
+        for (size_t a = 0; a < termCount; a++)
+        {
+            const array<int, 3> &ea = exponents[a], &eb = exponents[b];
+            const int degree = ea[0] + ea[1] + ea[2] + eb[0] + eb[1] + eb[2];
+            if (degree > order)
+            {
+                continue;
+            }
+            const int sum = indexOf[at(ea[0] + eb[0], ea[1] + eb[1], ea[2] + eb[2])];
+            const double sign = (ea[0] + ea[1] + ea[2]) % 2 ? -1.0 : 1.0;
+            const double c = binomial(ea[0] + eb[0], ea[0]) * binomial(ea[1] + eb[1], ea[1]) * binomial(ea[2] + eb[2], ea[2]);
+            m2lTerms.push_back({static_cast<int>(b), static_cast<int>(a), sum, sign * c});
+        }
+    }
+}
+
+/**
+ * @brief out[k] = d^k for every multi-index k up to the order
+ */
+void FmmSolver::powers(double dx, double dy, double dz, double *out) const
+{
+    out[0] = 1.0;
+    for (size_t k = 1; k < termCount; k++)
+    {
+        if (lowerX[k] >= 0) out[k] = out[lowerX[k]] * dx;
+        else if (lowerY[k] >= 0) out[k] = out[lowerY[k]] * dy;
+        else out[k] = out[lowerZ[k]] * dz;
+    }
+}
+
+/**
+ * @brief out[k] = D_k(R), the Taylor coefficients of 1 / |R|, lower degrees first so the recurrence finds its inputs
+ */
+void FmmSolver::derivatives(double dx, double dy, double dz, double *out) const
+{
+    const double r2 = dx * dx + dy * dy + dz * dz;
+    const double inverseR2 = 1.0 / r2;
+    out[0] = sqrt(inverseR2);
+    for (size_t k = 1; k < termCount; k++)
+    {
+        const array<int, 3> &e = exponents[k];
+        const int n = e[0] + e[1] + e[2];
+        double first = 0.0, second = 0.0;
+        if (lowerX[k] >= 0)
+        {
+            first += dx * out[lowerX[k]];
+            if (e[0] > 1) second += out[lowerX[lowerX[k]]];
+        }
+        if (lowerY[k] >= 0)
+        {
+            first += dy * out[lowerY[k]];
+            if (e[1] > 1) second += out[lowerY[lowerY[k]]];
+        }
+        if (lowerZ[k] >= 0)
+        {
+            first += dz * out[lowerZ[k]];
+            if (e[2] > 1) second += out[lowerZ[lowerZ[k]]];
+        }
+        out[k] = -((2 * n - 1) * first + (n - 1) * second) * inverseR2 / n;
+    }
+}
+
+/**
+ * @brief rebuilds the octree, runs the three passes and scatters the accelerations back into the store
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void FmmSolver::computeAccelerations(BodyStore &store)
+{
+    tree.build(store);
+
+    const size_t n = store.size();
+    if (n == 0)
+    {
+        return;
+    }
+
+    #pragma omp single
+    {
+        multipoles.resize(tree.nodeCount() * termCount);
+        locals.resize(tree.nodeCount() * termCount);
+        sumX.resize(n);
+        sumY.resize(n);
+        sumZ.resize(n);
+
+        // the passes spread themselves over the region's threads as tasks
+        upward(0);
+        interact(0, 0);
+        downward(0);
+    }
+    // the barrier closing the single also waits for every task it spawned
+
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < n; k++)
+    {
+        const uint32_t i = tree.order[k];
+        const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+        store.ax[i] = scale * sumX[k];
+        store.ay[i] = scale * sumY[k];
+        store.az[i] = scale * sumZ[k];
+    }
+}
+
+/**
+ * @brief P2M at the leaves and M2M on the way back up, clears the node's local expansion and its bodies' sums as it goes
+ */
+void FmmSolver::upward(int nodeIndex)
+{
+    const OctreeNode &node = tree.nodes[nodeIndex];
+    double *multipole = &multipoles[nodeIndex * termCount];
+    fill(multipole, multipole + termCount, 0.0);
+    fill(&locals[nodeIndex * termCount], &locals[nodeIndex * termCount] + termCount, 0.0);
+
+    double power[MAX_TERMS];
+    if (node.firstChild < 0)
+    {
+        for (uint32_t k = node.begin; k < node.end; k++)
+        {
+            powers(tree.x[k] - node.comX, tree.y[k] - node.comY, tree.z[k] - node.comZ, power);
+            for (size_t t = 0; t < termCount; t++)
+            {
+                multipole[t] += tree.mass[k] * power[t];
+            }
+            sumX[k] = sumY[k] = sumZ[k] = 0.0;
+        }
+        return;
+    }
+
+    for (int c = 0; c < node.childCount; c++)
+    {
+        const OctreeNode &child = tree.nodes[node.firstChild + c];
+        if (child.end - child.begin > TASK_THRESHOLD)
+        {
+            #pragma omp task firstprivate(c)
+            upward(node.firstChild + c);
+        }
+        else
+        {
+            upward(node.firstChild + c);
+        }
+    }
+    #pragma omp taskwait
+
+    for (int c = 0; c < node.childCount; c++)
+    {
+        const int childIndex = node.firstChild + c;
+        const OctreeNode &child = tree.nodes[childIndex];
+        const double *childMultipole = &multipoles[childIndex * termCount];
+        powers(child.comX - node.comX, child.comY - node.comY, child.comZ - node.comZ, power);
+        for (const Term &term : m2mTerms)
+        {
+            multipole[term.target] += term.coefficient * power[term.factor] * childMultipole[term.source];
+        }
+    }
+}
+
+/**
+ * @brief adds the field of the source cell's bodies to the target cell, splitting until the pair is well separated
+ *
+ * only the target cell is written, so work on different target cells can run side by side, splitting the target
+ * spawns tasks and waits for them before the next source is handed to the same cells
+ */
+void FmmSolver::interact(int targetIndex, int sourceIndex)
+{
+    const OctreeNode &target = tree.nodes[targetIndex];
+    const OctreeNode &source = tree.nodes[sourceIndex];
+    const bool targetLeaf = target.firstChild < 0, sourceLeaf = source.firstChild < 0;
+
+    if (targetIndex == sourceIndex)
+    {
+        if (targetLeaf)
+        {
+            directLeaves(target, target);
+            return;
+        }
+        for (int c = 0; c < target.childCount; c++)
+        {
+            const OctreeNode &child = tree.nodes[target.firstChild + c];
+            if (child.end - child.begin > TASK_THRESHOLD)
+            {
+                #pragma omp task firstprivate(c)
+                for (int s = 0; s < target.childCount; s++)
+                {
+                    interact(target.firstChild + c, target.firstChild + s);
+                }
+            }
+            else
+            {
+                for (int s = 0; s < target.childCount; s++)
+                {
+                    interact(target.firstChild + c, target.firstChild + s);
+                }
+            }
+        }
+        #pragma omp taskwait
+        return;
+    }
+
+    // few enough pairs are cheaper summed directly than through an expansion, any cell's bodies are one contiguous run
+    const double pairs = double(target.end - target.begin) * double(source.end - source.begin);
+    if (pairs <= directPairLimit)
+    {
+        directLeaves(target, source);
+        return;
+    }
+    const double dx = target.comX - source.comX, dy = target.comY - source.comY, dz = target.comZ - source.comZ;
+    const double reach = target.radius + source.radius;
+    if (reach * reach < theta * theta * (dx * dx + dy * dy + dz * dz))
+    {
+        multipoleToLocal(targetIndex, sourceIndex);
+        return;
+    }
+    if (targetLeaf && sourceLeaf)
+    {
+        directLeaves(target, source);
+        return;
+    }
+
+    // split the larger cell, a leaf can't be split
+    if (sourceLeaf || (!targetLeaf && target.radius >= source.radius))
+    {
+        for (int c = 0; c < target.childCount; c++)
+        {
+            const OctreeNode &child = tree.nodes[target.firstChild + c];
+            if (child.end - child.begin > TASK_THRESHOLD)
+            {
+                #pragma omp task firstprivate(c)
+                interact(target.firstChild + c, sourceIndex);
+            }
+            else
+            {
+                interact(target.firstChild + c, sourceIndex);
+            }
+        }
+        #pragma omp taskwait
+    }
+    else
+    {
+        for (int s = 0; s < source.childCount; s++)
+        {
+            interact(targetIndex, source.firstChild + s);
+        }
+    }
+}
+
+/**
+ * @brief P2P, every body of the target leaf against every body of the source leaf with the softened pair kernel
+ */
+void FmmSolver::directLeaves(const OctreeNode &target, const OctreeNode &source)
+{
+    for (uint32_t k = target.begin; k < target.end; k++)
+    {
+        kernel(&tree.x[source.begin], &tree.y[source.begin], &tree.z[source.begin], &tree.mass[source.begin],
+               source.end - source.begin, tree.x[k], tree.y[k], tree.z[k], sumX[k], sumY[k], sumZ[k]);
+    }
+}
+
+/**
+ * @brief M2L, adds the source cell's multipole to the target cell's local expansion
+ */
+void FmmSolver::multipoleToLocal(int targetIndex, int sourceIndex)
+{
+    const OctreeNode &target = tree.nodes[targetIndex];
+    const OctreeNode &source = tree.nodes[sourceIndex];
+    const double *multipole = &multipoles[sourceIndex * termCount];
+    double *local = &locals[targetIndex * termCount];
+
+    double derivative[MAX_TERMS];
+    derivatives(target.comX - source.comX, target.comY - source.comY, target.comZ - source.comZ, derivative);
+    for (const Term &term : m2lTerms)
+    {
+        local[term.target] += term.coefficient * derivative[term.factor] * multipole[term.source];
+    }
+}
+
+/**
+ * @brief L2L into the children on the way down, L2P at the leaves
+ */
+void FmmSolver::downward(int nodeIndex)
+{
+    const OctreeNode &node = tree.nodes[nodeIndex];
+    const double *local = &locals[nodeIndex * termCount];
+
+    double power[MAX_TERMS];
+    if (node.firstChild < 0)
+    {
+        for (uint32_t k = node.begin; k < node.end; k++)
+        {
+            powers(tree.x[k] - node.comX, tree.y[k] - node.comY, tree.z[k] - node.comZ, power);
+            double gradX = 0.0, gradY = 0.0, gradZ = 0.0;
+            for (size_t t = 1; t < termCount; t++)
+            {
+                const array<int, 3> &e = exponents[t];
+                if (lowerX[t] >= 0) gradX += e[0] * local[t] * power[lowerX[t]];
+                if (lowerY[t] >= 0) gradY += e[1] * local[t] * power[lowerY[t]];
+                if (lowerZ[t] >= 0) gradZ += e[2] * local[t] * power[lowerZ[t]];
+            }
+            sumX[k] += gradX;
+            sumY[k] += gradY;
+            sumZ[k] += gradZ;
+        }
+        return;
+    }
+
+    for (int c = 0; c < node.childCount; c++)
+    {
+        const int childIndex = node.firstChild + c;
+        const OctreeNode &child = tree.nodes[childIndex];
+        double *childLocal = &locals[childIndex * termCount];
+        powers(child.comX - node.comX, child.comY - node.comY, child.comZ - node.comZ, power);
+        for (const Term &term : l2lTerms)
+        {
+            childLocal[term.target] += term.coefficient * power[term.factor] * local[term.source];
+        }
+
+        if (child.end - child.begin > TASK_THRESHOLD)
+        {
+            #pragma omp task firstprivate(childIndex)
+            downward(childIndex);
+        }
+        else
+        {
+            downward(childIndex);
+        }
+    }
+    #pragma omp taskwait
+}
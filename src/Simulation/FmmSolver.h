@@ -0,0 +1,67 @@
+#ifndef FMM_SOLVER_H
+#define FMM_SOLVER_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "ForceSolver.h"
+#include "Octree.h"
+#include "SimdKernels.h"
+
+/*
+    FmmSolver class:
+        O(N) fast multipole method on the adaptive octree, Cartesian Taylor expansions of a configurable order p
+            upward pass     P2M at the leaves, M2M into the parents, every cell gets a multipole about its centre of mass
+            interactions    dual tree traversal: well separated cell pairs add M2L into the target's local expansion,
+                            pairs of leaves that are too close, and cell pairs with fewer body pairs than an M2L has terms,
+                            are summed directly with the SIMD kernel (P2P)
+            downward pass   L2L pushes every local expansion into the children, L2P evaluates it at the bodies
+
+    two cells are well separated when (r1 + r2) / d < theta, r the radius around the centre of mass holding every body,
+    a higher order buys accuracy for cost, theta trades near field work for far field work
+    the softening length only matters in the near field, which is summed directly, so the expansions ignore it
+*/
+class FmmSolver : public ForceSolver
+{
+public:
+        explicit FmmSolver(int order = 4, double theta = 0.5, std::size_t leafCapacity = 32, SimdLevel level = detectSimdLevel());
+
+        const char *name() const override { return "fmm"; }
+        void computeAccelerations(BodyStore &store) override;
+
+        int expansionOrder() const { return order; }
+
+private:
+        // one term of a translation: out[target] += coefficient * in[source] * (other factor)[factor]
+        struct Term
+        {
+                int target, source, factor;
+                double coefficient;
+        };
+
+        int order;
+        double theta;
+        double directPairLimit;                      // cell pairs with fewer body pairs than this are summed directly
+        Octree tree;
+        SourceKernel kernel;
+
+        std::size_t termCount;                       // multi-indices (a, b, c) with a + b + c <= order
+        std::vector<std::array<int, 3>> exponents;   // the multi-indices, by increasing degree
+        std::vector<int> lowerX, lowerY, lowerZ;     // index of the multi-index with one less x, y or z, -1 if none
+        std::vector<Term> m2mTerms, m2lTerms, l2lTerms;
+
+        std::vector<double> multipoles, locals;      // termCount values per node
+        std::vector<double> sumX, sumY, sumZ;        // unscaled accelerations in Morton order
+
+        void buildTables();
+        void powers(double dx, double dy, double dz, double *out) const;
+        void derivatives(double dx, double dy, double dz, double *out) const;
+
+        void upward(int nodeIndex);
+        void interact(int targetIndex, int sourceIndex);
+        void downward(int nodeIndex);
+        void directLeaves(const OctreeNode &target, const OctreeNode &source);
+        void multipoleToLocal(int targetIndex, int sourceIndex);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FORCE_POLICY_H
+#define FORCE_POLICY_H
+
+#include <algorithm>
+#include <cmath>
+
+// how the pull of two close bodies is kept finite
+enum class Softening
+{
+        Clamped, // as Body::gravForce, m / ((max(r*r, e*e) + e*e) * r) along the offset
+        Plummer, // m / (r*r + e*e)^(3/2), one reciprocal square root per pair instead of two
+        None     // m / r^3, for runs whose bodies never come close, coincident bodies still contribute nothing
+};
+
+// how G is scaled per body, only the symmetric solver reads a multiplier per pair, the others scale each target once
+enum class Scaling
+{
+        PerBody, // every body's own gravitationalMultiplier
+        Uniform  // all multipliers are equal, applied once to the finished sums
+};
+
+// what the pair terms are computed in
+enum class Precision
+{
+        Double,
+        Mixed // float pair terms summed in double, see MixedSolver
+};
+
+/*
+    ForcePolicy struct:
+        the choices the direct-sum kernels are compiled for, every combination is its own instantiation
+        with the choice made at compile time inside the inner loop, the solver picks one when it is built
+*/
+struct ForcePolicy
+{
+        Softening softening = Softening::Clamped;
+        Scaling scaling = Scaling::PerBody;
+        Precision precision = Precision::Double;
+};
+
+const char *softeningName(Softening softening);
+
+/**
+ * @brief the scalar pair term, m * pairScale * offset is the pull of a source of mass m, left without G
+ * @param r2 squared distance, 0 for a body and itself, which contributes nothing
+ * @param softening2 squared softening length in the units of r2
+ */
+template <Softening S, class Real>
+inline Real pairScale(Real r2, Real mass, Real softening2)
+{
+    if (!(r2 > Real(0)))
+    {
+        return Real(0);
+    }
+    if constexpr (S == Softening::Clamped)
+    {
+        return mass / ((std::max(r2, softening2) + softening2) * std::sqrt(r2));
+    }
+    else if constexpr (S == Softening::Plummer)
+    {
+        const Real denominator = r2 + softening2;
+        return mass / (denominator * std::sqrt(denominator));
+    }
+    else
+    {
+        return mass / (r2 * std::sqrt(r2));
+    }
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef FORCE_SOLVER_H
+#define FORCE_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "BodyStore.h"
+#include "WorkStealing.h"
+
+const double GRAVITY_CONSTANT = 6.67430e-11; // Predefined and recognized Gravitational constant
+const double SOFTENING_LENGTH = 1e-5;        // Softening parameter to limit the force at very close distances (0.00001)
+const std::size_t TARGETS_PER_CHUNK = 4;     // direct-sum targets taken at a time, each is a pass over every source
+
+/*
+    ForceSolver interface:
+        fills ax, ay, az of a BodyStore with the gravitational acceleration of every body
+
+    computeAccelerations is called by every thread of the parallel region in Simulation::run,
+    solvers split their work with orphaned omp for / omp single constructs, so no solver opens a nested
+    parallel region, and calling one outside a parallel region simply runs it on the calling thread,
+    the target loops run on the solver's WorkStealingLoop, so any thread count works with any number of bodies
+
+    computeAccelerationsOf only has to fill the listed targets, the sources are still every body,
+    the direct sums override it to skip the rest, the others compute every body and leave the extra results in place
+*/
+class ForceSolver
+{
+public:
+        virtual ~ForceSolver() = default;
+        virtual const char *name() const = 0;
+        virtual void computeAccelerations(BodyStore &store) = 0;
+        virtual void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) { computeAccelerations(store); }
+
+protected:
+        mutable WorkStealingLoop loop; // shares out the targets, scheduling state only, so const passes may use it too
+};
+
+/*
+    NoForceSolver class:
+        the solver of a run whose integrator sums its own accelerations, hermite with its jerk kernel,
+        it holds nothing and is never asked for accelerations
+*/
+class NoForceSolver : public ForceSolver
+{
+public:
+        const char *name() const override { return "none"; }
+        void computeAccelerations(BodyStore &store) override { throw std::logic_error("The integrator of this run sums its own accelerations"); }
+};
+
+#endif
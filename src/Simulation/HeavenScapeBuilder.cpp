@@ -75,13 +75,12 @@ vector<double> usedRadii;
 vector<Body> bodies;
 
 //fill in vectors for SUN constant
-const Vector SUN_POSITION(0.0, 0.0, 0.0);
-const Vector SUN_VELOCITY(0.0, 0.0, 0.0);
-const Vector SUN_ACCELERATION(0.0, 0.0, 0.0);
-const Vector SUN_NET_FORCE(0.0, 0.0, 0.0);
+const Vec3 SUN_POSITION(0.0, 0.0, 0.0);
+const Vec3 SUN_VELOCITY(0.0, 0.0, 0.0);
+const Vec3 SUN_ACCELERATION(0.0, 0.0, 0.0);
+const Vec3 SUN_NET_FORCE(0.0, 0.0, 0.0);
 
-vector<Vector> trajectory;
-trajectory.reserve(iterations);
+vector<Vec3> trajectory;
 
 //Solar System constants
 const Body SUN = Body(  SUN_POSITION, //position in center of system
@@ -178,16 +177,16 @@ const Body SUN = Body(  SUN_POSITION, //position in center of system
 //     //first generate the black holes
 //     for (int i = 0; i < N; i++) {
 //         // Default vectors factored out of the loop as every body will have the same default values
-//         Vector position(0.0, 0.0, 0.0);
-//         Vector velocity(0.0, 0.0, 0.0);
-//         Vector acceleration(0.0, 0.0, 0.0);
-//         Vector netForce(0.0, 0.0, 0.0);
+//         Vec3 position(0.0, 0.0, 0.0);
+//         Vec3 velocity(0.0, 0.0, 0.0);
+//         Vec3 acceleration(0.0, 0.0, 0.0);
+//         Vec3 netForce(0.0, 0.0, 0.0);
 
 //         //initialize the mass, radius, type, children indices, and trajectory for each body(must be local variables)
 //         double mass, radius;
 //         string type;
 //         vector<int> childrenIndices;
-//         vector<Vector> trajectory;
+//         vector<Vec3> trajectory;
 
 //         //will first do blackholes, then stars, then planets, then moons, because of the if ELSE logic
 //         if (currentBlackHoles < blackHoles) {
@@ -305,7 +304,7 @@ const Body SUN = Body(  SUN_POSITION, //position in center of system
 //         }
 
 //         // Add body to the list
-//         bodies.push_back(Body(Vector(), Vector(), Vector(), Vector(), mass, radius, gravitationalMultiplier, type, {}, {}));
+//         bodies.push_back(Body(Vec3(), Vec3(), Vec3(), Vec3(), mass, radius, gravitationalMultiplier, type, {}, {}));
 //     }
 
 //     cout << "All bodies generated. Now define child relationships..." << endl;
@@ -343,12 +342,12 @@ const Body SUN = Body(  SUN_POSITION, //position in center of system
 // }
 
 
-Vector calculateTangentialVelocity(const Vector& position, double speed) {
+Vec3 calculateTangentialVelocity(const Vec3& position, double speed) {
     // Return a tangential velocity vector given a position and speed
     double r = position.magnitude();
     double vx = -speed * (position.z / r);
     double vz = speed * (position.x / r);
-    return Vector(vx, 0, vz);
+    return Vec3(vx, 0, vz);
 }
 
 /**
@@ -394,15 +393,15 @@ void generatePresetBodies() {
     // Compute position vector in 3D space
     double x = r * cos(inclination);
     double z = r * sin(inclination);
-    Vector position(x, 0, z);
+    Vec3 position(x, 0, z);
 
     // Compute velocity relative to parent mass
     double v = sqrt(GRAVITATIONAL_CONSTANT * parentMasses[i - 1] / r);
-    Vector velocity = calculateTangentialVelocity(position, v);
+    Vec3 velocity = calculateTangentialVelocity(position, v);
 
     // Create the body
     Body planet(
-        position, velocity, Vector(0, 0, 0), Vector(0, 0, 0),
+        position, velocity, Vec3(0, 0, 0), Vec3(0, 0, 0),
         planetMassRanges[i - 1], planetRadiusRanges[i - 1],
         gravitationalMultiplier, "planet", {}, trajectory
     );
@@ -416,14 +415,14 @@ void generatePresetBodies() {
     double moonR = 3.84e8; // Moon's distance from Earth in meters
     double moonV = sqrt(GRAVITATIONAL_CONSTANT * bodies[3].mass / moonR); // Use Earth's mass for moon calculation as parent mass
 
-    Vector moonPosition(bodies[3].position.x + moonR, 0, 0); // Offset from Earth by any axis, in this case, x
-    Vector moonVelocity(0, moonV + bodies[3].velocity.y, 0); // Tangential to Earth's velocity, in this case, y, to make a perpendicular velocity vector
+    Vec3 moonPosition(bodies[3].position.x + moonR, 0, 0); // Offset from Earth by any axis, in this case, x
+    Vec3 moonVelocity(0, moonV + bodies[3].velocity.y, 0); // Tangential to Earth's velocity, in this case, y, to make a perpendicular velocity vector
 
     //acceleration and net force are zero, as the moon is not affected by any forces
-    Vector moonAcceleration(0, 0, 0);
-    Vector moonNetForce(0, 0, 0);
+    Vec3 moonAcceleration(0, 0, 0);
+    Vec3 moonNetForce(0, 0, 0);
 
-    vector<Vector> moonTrajectory;
+    vector<Vec3> moonTrajectory;
 
     Body moon(
         moonPosition, moonVelocity, moonAcceleration, moonNetForce,
@@ -497,7 +496,7 @@ void generatePresetBodies() {
  * @param orbitalRadius the orbital radius of the body(this is the distance from the parent body you want to be away from)
  * @return the orbital position of the body
  */
-// Vector calculateOrbitalPosition(const Vector &parentPos, double orbitalRadius)
+// Vec3 calculateOrbitalPosition(const Vec3 &parentPos, double orbitalRadius)
 // {
 //     double theta = ((double)rand() / RAND_MAX) * 2.0 * M_PI; // Azimuthal angle [0, 2π]
 //     double phi = ((double)rand() / RAND_MAX) * M_PI;         // Inclination angle [0, π]
@@ -506,7 +505,7 @@ void generatePresetBodies() {
 //     double y = orbitalRadius * sin(phi) * sin(theta);       // y position
 //     double z = orbitalRadius * cos(phi);                    // z position
 
-//     return Vector(parentPos.x + x, parentPos.y + y, parentPos.z + z); // return the orbital position of the body
+//     return Vec3(parentPos.x + x, parentPos.y + y, parentPos.z + z); // return the orbital position of the body
 // }
 
 /**
@@ -517,20 +516,20 @@ void generatePresetBodies() {
  * @param gravitationalMultiplier the gravitational multiplier of the simulation
  * @return the orbital velocity of the body
  */
-// Vector calculateOrbitalVelocity(const Vector &parentPos, const Vector &childPos, double parentMass, double gravitationalMultiplier)
+// Vec3 calculateOrbitalVelocity(const Vec3 &parentPos, const Vec3 &childPos, double parentMass, double gravitationalMultiplier)
 // {
 //     const double G = 6.67430e-11 * gravitationalMultiplier;
 
 //     // Calculate the distance vector and magnitude
-//     Vector r = childPos - parentPos;
+//     Vec3 r = childPos - parentPos;
 //     double distance = r.magnitude();
 
 //     // Orbital speed
 //     double speed = sqrt((G * parentMass) / distance);
 
 //     // Calculate a perpendicular velocity vector
-//     Vector unitR = r / distance;           // Unit vector of position
-//     Vector velocity(-unitR.y, unitR.x, 0); // Perpendicular in XY-plane
+//     Vec3 unitR = r / distance;           // Unit vector of position
+//     Vec3 velocity(-unitR.y, unitR.x, 0); // Perpendicular in XY-plane
 
 //     // Normalize and scale to orbital speed
 //     velocity = velocity * speed;
@@ -550,7 +549,7 @@ void generatePresetBodies() {
 //     const double MIN_DISTANCE = 1.0e10;           // Minimum separation between bodies
 
 //     // Helper function to get parent position
-//     auto getParentPosition = [&](int childIndex) -> Vector {
+//     auto getParentPosition = [&](int childIndex) -> Vec3 {
 //         for (size_t i = 0; i < bodies.size(); ++i) {
 //             for (int child : bodies[i].childrenIndices) {
 //                 if (child == childIndex) {
@@ -558,21 +557,21 @@ void generatePresetBodies() {
 //                 }
 //             }
 //         }
-//         return Vector(0, 0, 0); // Default to origin if no parent is found
+//         return Vec3(0, 0, 0); // Default to origin if no parent is found
 //     };
 
 //     // Black Holes
 //     if (bodyCount[4] > 0) {
 //         double blackHoleDistance = 1.4759e19; // Average distance between black holes
-//         Vector center(0, 0, 0);
+//         Vec3 center(0, 0, 0);
 
 //         for (int i = 0; i < bodyCount[4]; ++i) {
 //             double angle = 2.0 * M_PI * i / bodyCount[4]; // Spread black holes evenly
-//             bodies[i].position = center + Vector(
+//             bodies[i].position = center + Vec3(
 //                 blackHoleDistance * cos(angle),
 //                 blackHoleDistance * sin(angle),
 //                 0);
-//             bodies[i].velocity = Vector(0, 0, 0); // Black holes are stationary
+//             bodies[i].velocity = Vec3(0, 0, 0); // Black holes are stationary
 //         }
 //     }
 
@@ -583,7 +582,7 @@ void generatePresetBodies() {
 //         double starDistance = 3.8e16; // Average distance from black holes to stars
 
 //         for (int i = startIndex; i < endIndex; ++i) {
-//             Vector parentPos = getParentPosition(i); // Get parent position (black hole)
+//             Vec3 parentPos = getParentPosition(i); // Get parent position (black hole)
 //             double orbitalRadius = starDistance + (i - startIndex) * MIN_DISTANCE;
 
 //             // Position star in orbit around its parent (black hole)
@@ -602,7 +601,7 @@ void generatePresetBodies() {
 //         double planetDistance = 5.7e10; // Average distance between planets and stars
 
 //         for (int i = startIndex; i < endIndex; ++i) {
-//             Vector parentPos = getParentPosition(i); // Get parent position (star)
+//             Vec3 parentPos = getParentPosition(i); // Get parent position (star)
 //             double orbitalRadius = planetDistance + (i - startIndex) * MIN_DISTANCE;
 
 //             // Position planet in orbit around its parent (star)
@@ -621,7 +620,7 @@ void generatePresetBodies() {
 //         double moonDistance = 3.84e8; // Average distance between moons and planets
 
 //         for (int i = startIndex; i < endIndex; ++i) {
-//             Vector parentPos = getParentPosition(i); // Get parent position (planet)
+//             Vec3 parentPos = getParentPosition(i); // Get parent position (planet)
 //             double orbitalRadius = moonDistance + (i - startIndex) * MIN_DISTANCE;
 
 //             // Position moon in orbit around its parent (planet)
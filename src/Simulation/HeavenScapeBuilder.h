@@ -9,8 +9,8 @@
 double generateUniqueRadius(double minRadius, double maxRadius, const std::vector<double> &usedRadii);
 double generateBoundedDouble(double min, double max);
 double generateSchwarzchildRadius(double mass);
-Vector calculateOrbitalPosition(const Vector &parentPos, double orbitalRadius);
-Vector calculateOrbitalVelocity(const Vector &parentPos, const Vector &childPos, double parentMass, double gravitationalMultiplier);
+Vec3 calculateOrbitalPosition(const Vec3 &parentPos, double orbitalRadius);
+Vec3 calculateOrbitalVelocity(const Vec3 &parentPos, const Vec3 &childPos, double parentMass, double gravitationalMultiplier);
 void initiateHeavenscape(std::vector<Body> &bodies, int bodyCount[5]);
 
 
@@ -0,0 +1,175 @@
+/**
+ * This file contains the implementation of the HermiteIntegrator class, the fourth order predictor-corrector
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "HermiteIntegrator.h"
+using namespace std;
+
+HermiteIntegrator::HermiteIntegrator(double timestep, double accuracy, SimdLevel level)
+    : timestep(timestep), accuracy(accuracy), level(level), kernel(jerkKernelFor(level))
+{
+    if (timestep <= 0.0)
+    {
+        throw invalid_argument("The hermite integrator needs a positive Timestep");
+    }
+    if (accuracy <= 0.0)
+    {
+        throw invalid_argument("TimestepAccuracy must be positive");
+    }
+}
+
+static inline double norm(double x, double y, double z)
+{
+    return sqrt(x * x + y * y + z * z);
+}
+
+/**
+ * @brief accelerations and jerks of the starting state, and the first step from accuracy * |a| / |j|
+ * @param store the bodies
+ * @param solver unused, the jerk kernel sums the accelerations
+ */
+void HermiteIntegrator::start(BodyStore &store, ForceSolver &solver)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    {
+        for (vector<double> *array : {&jx, &jy, &jz, &x0, &y0, &z0, &vx0, &vy0, &vz0, &ax0, &ay0, &az0, &jx0, &jy0, &jz0})
+        {
+            array->resize(n);
+        }
+        elapsed = 0.0;
+        proposed = timestep;
+    }
+
+    evaluate(store);
+
+    double local = timestep;
+    #pragma omp for schedule(static) nowait
+    for (size_t i = 0; i < n; i++)
+    {
+        const double jerk = norm(jx[i], jy[i], jz[i]);
+        if (jerk > 0.0)
+        {
+            local = min(local, accuracy * norm(store.ax[i], store.ay[i], store.az[i]) / jerk);
+        }
+    }
+    propose(local);
+}
+
+/**
+ * @brief steps every body to the end of the next Timestep
+ * @param store the bodies, positions and velocities at the same time before and after
+ * @param solver unused, the jerk kernel sums the accelerations
+ */
+void HermiteIntegrator::advance(BodyStore &store, ForceSolver &solver)
+{
+    const size_t n = store.size();
+    for (;;)
+    {
+        #pragma omp single
+        {
+            step = proposed;
+            const double remaining = timestep - elapsed;
+            lastSubstep = step >= remaining;
+            substep = lastSubstep ? remaining : step;
+            elapsed = lastSubstep ? 0.0 : elapsed + substep;
+            proposed = timestep;
+        }
+        const double dt = substep;
+        const bool last = lastSubstep;
+
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < n; i++)
+        {
+            x0[i] = store.x[i], y0[i] = store.y[i], z0[i] = store.z[i];
+            vx0[i] = store.vx[i], vy0[i] = store.vy[i], vz0[i] = store.vz[i];
+            ax0[i] = store.ax[i], ay0[i] = store.ay[i], az0[i] = store.az[i];
+            jx0[i] = jx[i], jy0[i] = jy[i], jz0[i] = jz[i];
+            store.x[i] += dt * (store.vx[i] + dt * (0.5 * store.ax[i] + dt / 6.0 * jx[i]));
+            store.y[i] += dt * (store.vy[i] + dt * (0.5 * store.ay[i] + dt / 6.0 * jy[i]));
+            store.z[i] += dt * (store.vz[i] + dt * (0.5 * store.az[i] + dt / 6.0 * jz[i]));
+            store.vx[i] += dt * (store.ax[i] + 0.5 * dt * jx[i]);
+            store.vy[i] += dt * (store.ay[i] + 0.5 * dt * jy[i]);
+            store.vz[i] += dt * (store.az[i] + 0.5 * dt * jz[i]);
+        }
+
+        evaluate(store);
+
+        double local = timestep;
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < n; i++)
+        {
+            const double halfStep = 0.5 * dt, twelfth = dt * dt / 12.0;
+            store.vx[i] = vx0[i] + halfStep * (ax0[i] + store.ax[i]) + twelfth * (jx0[i] - jx[i]);
+            store.vy[i] = vy0[i] + halfStep * (ay0[i] + store.ay[i]) + twelfth * (jy0[i] - jy[i]);
+            store.vz[i] = vz0[i] + halfStep * (az0[i] + store.az[i]) + twelfth * (jz0[i] - jz[i]);
+            store.x[i] = x0[i] + halfStep * (vx0[i] + store.vx[i]) + twelfth * (ax0[i] - store.ax[i]);
+            store.y[i] = y0[i] + halfStep * (vy0[i] + store.vy[i]) + twelfth * (ay0[i] - store.ay[i]);
+            store.z[i] = z0[i] + halfStep * (vz0[i] + store.vz[i]) + twelfth * (az0[i] - store.az[i]);
+
+            // snap and crackle of the cubic through both ends, the snap moved to the end of the step
+            const double inverse2 = 1.0 / (dt * dt), inverse3 = inverse2 / dt;
+            double snap[3], crackle[3];
+            const double da[3] = {ax0[i] - store.ax[i], ay0[i] - store.ay[i], az0[i] - store.az[i]};
+            const double j0[3] = {jx0[i], jy0[i], jz0[i]}, j1[3] = {jx[i], jy[i], jz[i]};
+            for (int k = 0; k < 3; k++)
+            {
+                crackle[k] = (12.0 * da[k] + 6.0 * dt * (j0[k] + j1[k])) * inverse3;
+                snap[k] = (-6.0 * da[k] - dt * (4.0 * j0[k] + 2.0 * j1[k])) * inverse2 + dt * crackle[k];
+            }
+            const double a = norm(store.ax[i], store.ay[i], store.az[i]), j = norm(jx[i], jy[i], jz[i]);
+            const double s = norm(snap[0], snap[1], snap[2]), c = norm(crackle[0], crackle[1], crackle[2]);
+            const double denominator = j * c + s * s;
+            if (denominator > 0.0)
+            {
+                local = min(local, sqrt(accuracy * (a * s + j * j) / denominator));
+            }
+        }
+        propose(local);
+
+        if (last)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief acceleration and jerk of every body against every other, targets shared out between the threads
+ */
+void HermiteIntegrator::evaluate(BodyStore &store)
+{
+    const size_t n = store.size();
+    loop.run(n, TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            double acceleration[3] = {0.0, 0.0, 0.0}, jerk[3] = {0.0, 0.0, 0.0};
+            kernel(store.x.data(), store.y.data(), store.z.data(), store.vx.data(), store.vy.data(), store.vz.data(), store.mass.data(), n,
+                   store.x[i], store.y[i], store.z[i], store.vx[i], store.vy[i], store.vz[i], acceleration, jerk);
+            const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+            store.ax[i] = scale * acceleration[0];
+            store.ay[i] = scale * acceleration[1];
+            store.az[i] = scale * acceleration[2];
+            jx[i] = scale * jerk[0];
+            jy[i] = scale * jerk[1];
+            jz[i] = scale * jerk[2];
+        }
+    });
+    #pragma omp single nowait
+    evaluations += n;
+}
+
+/**
+ * @brief folds one thread's smallest step into the shared one, the barrier leaves it complete for the next single
+ */
+void HermiteIntegrator::propose(double local)
+{
+    #pragma omp critical(hermiteStep)
+    proposed = min(proposed, local);
+    #pragma omp barrier
+}
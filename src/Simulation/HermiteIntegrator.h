@@ -0,0 +1,52 @@
+#ifndef HERMITE_INTEGRATOR_H
+#define HERMITE_INTEGRATOR_H
+
+#include <vector>
+#include "Integrator.h"
+#include "SimdKernels.h"
+
+/*
+    HermiteIntegrator class:
+        fourth order Hermite predictor-corrector on a shared, adaptive step
+            predictor   x + v dt + a dt^2/2 + j dt^3/6,  v + a dt + j dt^2/2
+            evaluation  acceleration and jerk at the predicted state, both from one pass of the jerk kernel
+            corrector   v1 = v0 + (a0 + a1) dt/2 + (j0 - j1) dt^2/12,  x1 = x0 + (v0 + v1) dt/2 + (a0 - a1) dt^2/12
+        the next step is the smallest over the bodies of Aarseth's criterion
+            dt = sqrt(accuracy * (|a||a''| + |j|^2) / (|j||a'''| + |a''|^2))
+        with the snap a'' and crackle a''' interpolated from the step just taken, accuracy * |a| / |j| for the first
+
+    advance takes as many steps as the criterion asks for and ends exactly on the Timestep, the predictor and
+    corrector are shared out between the threads, the accelerations are summed directly with the widest jerk kernel,
+    the ForceSolver of the run is not used, Simulation gives it a NoForceSolver
+*/
+class HermiteIntegrator : public Integrator
+{
+public:
+        HermiteIntegrator(double timestep, double accuracy, SimdLevel level = detectSimdLevel());
+
+        const char *name() const override { return "hermite"; }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void advance(BodyStore &store, ForceSolver &solver) override;
+
+        double nextStep() const { return step; }
+        const char *kernelName() const { return simdLevelName(level); } // the instruction set of the jerk kernel
+
+private:
+        double timestep;                       // the Timestep every advance ends on
+        double accuracy;                       // accuracy parameter of the criterion
+        SimdLevel level;
+        JerkKernel kernel;
+
+        std::vector<double> jx, jy, jz;        // jerk of every body
+        std::vector<double> x0, y0, z0, vx0, vy0, vz0, ax0, ay0, az0, jx0, jy0, jz0; // state at the start of the step
+        double step = 0.0;                     // the criterion's next step
+        double elapsed = 0.0;                  // time taken so far of the current Timestep
+        double substep = 0.0;                  // the step being taken, cut short at the end of the Timestep
+        bool lastSubstep = false;
+        double proposed = 0.0;                 // smallest criterion found by the threads so far
+
+        void evaluate(BodyStore &store);
+        void propose(double local);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include "BodyStore.h"
+#include "ForceSolver.h"
+#include "WorkStealing.h"
+
+const std::size_t BODIES_PER_CHUNK = 512; // bodies kicked or drifted at a time, a few cache lines of every array
+
+/*
+    Integrator class:
+        interface of the time stepping schemes, Simulation::run calls advance once per Timestep and the
+        integrator asks the force solver for accelerations as often as its scheme needs them
+
+    start and advance are called by every thread of the parallel region in Simulation::run, like
+    ForceSolver::computeAccelerations, and share out their loops with orphaned omp constructs,
+    the kick and drift passes of the stepping schemes on a WorkStealingLoop,
+    synchronize is called by one thread before output and brings the velocities to the positions' time
+    for integrators that keep them apart between steps
+*/
+class Integrator
+{
+public:
+        virtual ~Integrator() = default;
+        virtual const char *name() const = 0;
+        virtual void start(BodyStore &store, ForceSolver &solver) {}
+        virtual void advance(BodyStore &store, ForceSolver &solver) = 0;
+        virtual void synchronize(BodyStore &store) {}
+
+        virtual std::uint64_t forceEvaluations() const { return evaluations; } // accelerations computed so far, one per body
+
+protected:
+        std::uint64_t evaluations = 0;
+        WorkStealingLoop loop;
+};
+
+/*
+    SteppingIntegrator class:
+        an integrator whose advance is a single step of its scheme, which can take a step of any length,
+        so the adaptive controller can drive it with steps of its own choosing
+*/
+class SteppingIntegrator : public Integrator
+{
+public:
+        explicit SteppingIntegrator(double timestep) : timestep(timestep) {}
+
+        void advance(BodyStore &store, ForceSolver &solver) override { step(store, solver, timestep); }
+        virtual void step(BodyStore &store, ForceSolver &solver, double dt) = 0;
+        virtual bool startsWithAccelerations() const { return false; } // start leaves the bodies' accelerations in ax/ay/az
+
+protected:
+        double timestep;
+};
+
+#endif
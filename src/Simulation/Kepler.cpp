@@ -0,0 +1,137 @@
+/**
+ * This file contains the universal variable Kepler solver behind the Wisdom-Holman drift
+ *
+ * with r0 and v0 the starting state, sigma = r0.v0 / sqrt(mu), alpha = 2 / |r0| - |v0|^2 / mu and z = alpha chi^2,
+ * the universal Kepler equation is
+ *      F(chi) = sigma chi^2 C(z) + (1 - alpha |r0|) chi^3 S(z) + |r0| chi - sqrt(mu) dt = 0
+ * where C and S are the Stumpff functions, F'(chi) is the new distance |r|, and the new state is
+ *      r = f r0 + g v0,  v = f' r0 + g' v0
+ *      f = 1 - chi^2 C / |r0|,  g = dt - chi^3 S / sqrt(mu),  f' = sqrt(mu) chi (z S - 1) / (|r| |r0|),  g' = 1 - chi^2 C / |r|
+ *
+ * bound orbits first take dt modulo the period, so chi stays within one orbit however long the drift
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "Kepler.h"
+using namespace std;
+
+const int KEPLER_ITERATIONS = 50;       // Laguerre-Conway converges in a handful, the limit only guards against NaNs
+const double KEPLER_TOLERANCE = 1e-15;  // relative change of chi that ends the iteration
+const double STUMPFF_SERIES = 0.1;      // below this |z| the Stumpff functions come from their series, free of cancellation
+const double LAGUERRE_ORDER = 5.0;
+
+/**
+ * @brief the Stumpff functions C(z) = (1 - cos sqrt z) / z and S(z) = (sqrt z - sin sqrt z) / sqrt z^3, continued to z <= 0
+ */
+static inline void stumpff(double z, double &c, double &s)
+{
+    if (fabs(z) < STUMPFF_SERIES)
+    {
+        c = 1.0 / 2 - z * (1.0 / 24 - z * (1.0 / 720 - z * (1.0 / 40320 - z * (1.0 / 3628800 - z / 479001600))));
+        s = 1.0 / 6 - z * (1.0 / 120 - z * (1.0 / 5040 - z * (1.0 / 362880 - z * (1.0 / 39916800 - z / 6227020800))));
+    }
+    else if (z > 0.0)
+    {
+        const double root = sqrt(z);
+        c = (1.0 - cos(root)) / z;
+        s = (root - sin(root)) / (z * root);
+    }
+    else
+    {
+        const double root = sqrt(-z);
+        c = (cosh(root) - 1.0) / -z;
+        s = (sinh(root) - root) / (-z * root);
+    }
+}
+
+/**
+ * @brief drifts every state along its Kepler orbit for dt, KEPLER_LANES states at a time
+ * @param x, y, z positions relative to the centre of each orbit
+ * @param vx, vy, vz velocities relative to the centre
+ * @param mu gravitational parameter of every orbit, G times the two masses
+ * @param count number of states
+ * @param dt the length of the drift, negative runs the orbits backwards
+ */
+void keplerDrift(double *x, double *y, double *z, double *vx, double *vy, double *vz, const double *mu, size_t count, double dt)
+{
+    for (size_t first = 0; first < count; first += KEPLER_LANES)
+    {
+        const size_t lanes = min(KEPLER_LANES, count - first);
+        double r0[KEPLER_LANES], sigma[KEPLER_LANES], alpha[KEPLER_LANES], rootMu[KEPLER_LANES], time[KEPLER_LANES], chi[KEPLER_LANES];
+        bool kepler[KEPLER_LANES];
+
+        #pragma omp simd
+        for (size_t l = 0; l < lanes; l++)
+        {
+            const size_t k = first + l;
+            r0[l] = sqrt(x[k] * x[k] + y[k] * y[k] + z[k] * z[k]);
+            kepler[l] = mu[k] > 0.0 && r0[l] > 0.0;
+            const double m = kepler[l] ? mu[k] : 1.0, r = kepler[l] ? r0[l] : 1.0;
+            rootMu[l] = sqrt(m);
+            // a straight line drift keeps its dummy orbit, r = mu = 1 and alpha = 0, and never iterates, see the step below
+            sigma[l] = kepler[l] ? (x[k] * vx[k] + y[k] * vy[k] + z[k] * vz[k]) / rootMu[l] : 0.0;
+            alpha[l] = kepler[l] ? 2.0 / r - (vx[k] * vx[k] + vy[k] * vy[k] + vz[k] * vz[k]) / m : 0.0;
+            const double period = alpha[l] > 0.0 ? 2.0 * M_PI / (rootMu[l] * alpha[l] * sqrt(alpha[l])) : 0.0;
+            time[l] = alpha[l] > 0.0 ? fmod(dt, period) : dt;
+            // the first guess of a hyperbola follows from its asymptotic motion (Vallado), a straight line start overshoots
+            const double semiMajor = alpha[l] < 0.0 ? 1.0 / alpha[l] : -1.0, sign = time[l] < 0.0 ? -1.0 : 1.0;
+            const double asymptotic = -2.0 * m * alpha[l] * time[l] / (sigma[l] * rootMu[l] + sign * sqrt(-m * semiMajor) * (1.0 - r * alpha[l]));
+            const double hyperbolic = asymptotic > 1.0 ? sign * sqrt(-semiMajor) * log(asymptotic) : rootMu[l] * time[l] / r;
+            chi[l] = alpha[l] > 0.0 ? rootMu[l] * alpha[l] * time[l] : alpha[l] < 0.0 ? hyperbolic : rootMu[l] * time[l] / r;
+        }
+
+        for (int iteration = 0; iteration < KEPLER_ITERATIONS; iteration++)
+        {
+            double change = 0.0;
+            #pragma omp simd reduction(max : change)
+            for (size_t l = 0; l < lanes; l++)
+            {
+                const double zeta = alpha[l] * chi[l] * chi[l];
+                double c, s;
+                stumpff(zeta, c, s);
+                const double r = kepler[l] ? r0[l] : 1.0, outer = 1.0 - alpha[l] * r;
+                const double chi2 = chi[l] * chi[l];
+                const double f = sigma[l] * chi2 * c + outer * chi2 * chi[l] * s + r * chi[l] - rootMu[l] * time[l];
+                const double df = sigma[l] * chi[l] * (1.0 - zeta * s) + outer * chi2 * c + r;
+                const double ddf = sigma[l] * (1.0 - zeta * c) + outer * chi[l] * (1.0 - zeta * s);
+                const double n = LAGUERRE_ORDER;
+                const double root = sqrt(fabs((n - 1.0) * (n - 1.0) * df * df - n * (n - 1.0) * f * ddf));
+                // the dummy orbit's residual at chi = dt is dt^3 / 6, not zero, so the lane takes no step rather than
+                // hold back the convergence of the others, its drift uses dt and not chi
+                const double step = kepler[l] ? n * f / (df + copysign(root, df)) : 0.0;
+                chi[l] -= step;
+                change = max(change, fabs(step) / (fabs(chi[l]) + 1e-300));
+            }
+            if (!(change > KEPLER_TOLERANCE))
+            {
+                break;
+            }
+        }
+
+        #pragma omp simd
+        for (size_t l = 0; l < lanes; l++)
+        {
+            const size_t k = first + l;
+            double c, s;
+            stumpff(alpha[l] * chi[l] * chi[l], c, s);
+            const double chi2 = chi[l] * chi[l];
+            const double r = kepler[l] ? r0[l] : 1.0;
+            const double f = kepler[l] ? 1.0 - chi2 * c / r : 1.0;
+            const double g = kepler[l] ? time[l] - chi2 * chi[l] * s / rootMu[l] : dt;
+            const double nx = f * x[k] + g * vx[k], ny = f * y[k] + g * vy[k], nz = f * z[k] + g * vz[k];
+            const double distance = kepler[l] ? sqrt(nx * nx + ny * ny + nz * nz) : 1.0;
+            const double df = kepler[l] ? rootMu[l] * chi[l] * (alpha[l] * chi2 * s - 1.0) / (distance * r) : 0.0;
+            const double dg = kepler[l] ? 1.0 - chi2 * c / distance : 1.0;
+            const double nvx = df * x[k] + dg * vx[k], nvy = df * y[k] + dg * vy[k], nvz = df * z[k] + dg * vz[k];
+            x[k] = nx;
+            y[k] = ny;
+            z[k] = nz;
+            vx[k] = nvx;
+            vy[k] = nvy;
+            vz[k] = nvz;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include <cstddef>
+
+/*
+    Kepler drift:
+        moves count relative states (x, y, z, vx, vy, vz) along their two body orbits for a time dt,
+        body k around a fixed centre of gravitational parameter mu[k], in place
+            elliptic, parabolic and hyperbolic orbits alike, through the universal anomaly chi and the Stumpff functions
+            Kepler's equation in chi solved by the Laguerre-Conway iteration, f and g functions for the new state
+
+    the states are worked through KEPLER_LANES at a time, every lane iterated together until the slowest converges,
+    so the lane loops are plain array arithmetic the compiler can vectorize, and there is no per body branching
+    a state with mu[k] <= 0 or at the centre drifts in a straight line
+*/
+const std::size_t KEPLER_LANES = 8;
+
+void keplerDrift(double *x, double *y, double *z, double *vx, double *vy, double *vz, const double *mu, std::size_t count, double dt);
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * This file contains the implementation of the LegacyIntegrator class, the step loop Simulation::run used to hold
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include "LegacyIntegrator.h"
+using namespace std;
+
+/**
+ * @brief one step of BodyStore::update, the half-step and then the full-step update of each body in one pass,
+ * both only touch body i, so merging the passes leaves every bit as it was
+ * @param store the bodies
+ * @param solver computes the accelerations at the start of the step
+ * @param dt the length of the step
+ */
+void LegacyIntegrator::step(BodyStore &store, ForceSolver &solver, double dt)
+{
+    solver.computeAccelerations(store); // every thread takes part, the solver shares out the work
+    #pragma omp single nowait
+    evaluations += store.size();
+
+    loop.run(store.size(), BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            store.update(i, dt, true);  // Half-step velocity update
+            store.update(i, dt, false); // Update position and finalize velocity
+        }
+    });
+}
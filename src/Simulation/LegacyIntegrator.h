@@ -0,0 +1,22 @@
+#ifndef LEGACY_INTEGRATOR_H
+#define LEGACY_INTEGRATOR_H
+
+#include "Integrator.h"
+
+/*
+    LegacyIntegrator class:
+        the original step of Body::update, kept as the default so existing runs reproduce their output
+            accelerations, then v += a dt / 2 with a cleared, then x += v dt
+        the second half kick reads the cleared acceleration, so each step kicks by half a Timestep,
+        the symplectic integrators take the full kick
+*/
+class LegacyIntegrator : public SteppingIntegrator
+{
+public:
+        explicit LegacyIntegrator(double timestep) : SteppingIntegrator(timestep) {}
+
+        const char *name() const override { return "legacy"; }
+        void step(BodyStore &store, ForceSolver &solver, double dt) override;
+};
+
+#endif
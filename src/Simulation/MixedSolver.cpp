@@ -0,0 +1,145 @@
+/**
+ * This file contains the implementation of the MixedSolver class, the mixed precision direct sum
+ *
+ * a block of MIXED_BLOCK sources costs 16 bytes per body packed, 8 KB, and stays in L1 while a tile of targets reads it,
+ * each lane of the kernel sums at most MIXED_BLOCK / 8 terms in float before the block's total goes into the double sums
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "MixedSolver.h"
+using namespace std;
+
+const size_t MIXED_BLOCK = 512;               // sources per packed block
+const size_t TARGET_TILE = 64;                // targets sharing one pass over the blocks
+const double LENGTH_FLOOR = 1.0 / (1 << 20);  // block lengths are at least this share of the largest coordinate
+
+MixedSolver::MixedSolver(SimdLevel level, Softening softening) : kernel(mixedKernelFor(level, softening))
+{
+}
+
+/**
+ * @brief packs the sources, then sums every block's pull on every target, target tiles are shared out between the threads
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void MixedSolver::computeAccelerations(BodyStore &store)
+{
+    packBlocks(store);
+    sumBlocks(store, nullptr, store.size());
+}
+
+/**
+ * @brief packs every source, then sums their pull on the listed bodies only
+ * @param store the bodies, ax/ay/az of the targets are overwritten
+ * @param targets indices of the bodies to accelerate
+ */
+void MixedSolver::computeAccelerationsOf(BodyStore &store, const vector<uint32_t> &targets)
+{
+    packBlocks(store);
+    sumBlocks(store, targets.data(), targets.size());
+}
+
+/**
+ * @brief the blocked sum over targetTotal targets, the first targetTotal bodies when targetList is null
+ */
+void MixedSolver::sumBlocks(BodyStore &store, const uint32_t *targetList, size_t targetTotal) const
+{
+    loop.run((targetTotal + TARGET_TILE - 1) / TARGET_TILE, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            const size_t targetBegin = tile * TARGET_TILE;
+            const size_t targetCount = min(TARGET_TILE, targetTotal - targetBegin);
+            double sumX[TARGET_TILE] = {}, sumY[TARGET_TILE] = {}, sumZ[TARGET_TILE] = {};
+            for (const MixedBlock &block : blocks)
+            {
+                for (size_t t = 0; t < targetCount; t++)
+                {
+                    const size_t i = targetList ? targetList[targetBegin + t] : targetBegin + t;
+                    kernel(block, store.x[i], store.y[i], store.z[i], sumX[t], sumY[t], sumZ[t]);
+                }
+            }
+
+            for (size_t t = 0; t < targetCount; t++)
+            {
+                const size_t i = targetList ? targetList[targetBegin + t] : targetBegin + t;
+                const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+                store.ax[i] = scale * sumX[t];
+                store.ay[i] = scale * sumY[t];
+                store.az[i] = scale * sumZ[t];
+            }
+        }
+    });
+}
+
+/**
+ * @brief rounds every block to float around its own centre, one thread finds the scale of the run, the blocks are packed in parallel
+ *
+ * a block's length is its radius, but never below LENGTH_FLOOR of the largest coordinate, a lone or huddled block
+ * would otherwise put far targets beyond 1e12 of its units, where float's 1 / r^3 runs out of range
+ */
+void MixedSolver::packBlocks(const BodyStore &store)
+{
+    const size_t n = store.size();
+    const size_t blockCount = (n + MIXED_BLOCK - 1) / MIXED_BLOCK;
+    #pragma omp single
+    {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        mass.resize(n);
+        blocks.resize(blockCount);
+        double largest = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            largest = max(largest, max(fabs(store.x[i]), max(fabs(store.y[i]), fabs(store.z[i]))));
+        }
+        lengthFloor = max(LENGTH_FLOOR * largest, SOFTENING_LENGTH);
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t b = 0; b < blockCount; b++)
+    {
+        const size_t begin = b * MIXED_BLOCK, end = min(n, begin + MIXED_BLOCK);
+        double lowX = store.x[begin], lowY = store.y[begin], lowZ = store.z[begin];
+        double highX = lowX, highY = lowY, highZ = lowZ, heaviest = 0.0;
+        for (size_t i = begin; i < end; i++)
+        {
+            lowX = min(lowX, store.x[i]);
+            lowY = min(lowY, store.y[i]);
+            lowZ = min(lowZ, store.z[i]);
+            highX = max(highX, store.x[i]);
+            highY = max(highY, store.y[i]);
+            highZ = max(highZ, store.z[i]);
+            heaviest = max(heaviest, store.mass[i]);
+        }
+
+        MixedBlock &block = blocks[b];
+        block.centerX = 0.5 * (lowX + highX);
+        block.centerY = 0.5 * (lowY + highY);
+        block.centerZ = 0.5 * (lowZ + highZ);
+        const double halfX = 0.5 * (highX - lowX), halfY = 0.5 * (highY - lowY), halfZ = 0.5 * (highZ - lowZ);
+        block.length = max(sqrt(halfX * halfX + halfY * halfY + halfZ * halfZ), lengthFloor);
+        block.massUnit = heaviest > 0.0 ? heaviest : 1.0;
+
+        const double inverseLength = 1.0 / block.length, inverseMass = 1.0 / block.massUnit;
+        for (size_t i = begin; i < end; i++)
+        {
+            x[i] = float((store.x[i] - block.centerX) * inverseLength);
+            y[i] = float((store.y[i] - block.centerY) * inverseLength);
+            z[i] = float((store.z[i] - block.centerZ) * inverseLength);
+            mass[i] = float(store.mass[i] * inverseMass);
+        }
+
+        block.x = x.data() + begin;
+        block.y = y.data() + begin;
+        block.z = z.data() + begin;
+        block.mass = mass.data() + begin;
+        block.count = end - begin;
+        block.exactX = store.x.data() + begin;
+        block.exactY = store.y.data() + begin;
+        block.exactZ = store.z.data() + begin;
+        block.exactMass = store.mass.data() + begin;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef MIXED_SOLVER_H
+#define MIXED_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ForceSolver.h"
+#include "SimdKernels.h"
+
+/*
+    MixedSolver class:
+        O(N^2) sum with the pair terms in float, twice the lanes of the double kernels per instruction
+        the sources are packed every step into blocks of float offsets from each block's centre, scaled to the block,
+        so float only ever holds differences of nearby coordinates and never the coordinates themselves,
+        the sums and everything the integrator sees stay double
+
+    pairs too close for float to resolve their offset go through the double pair term instead,
+    so moons beside their planets keep the direct sum's accuracy, a far pull is good to a few parts in 10^7
+*/
+class MixedSolver : public ForceSolver
+{
+public:
+        explicit MixedSolver(SimdLevel level = detectSimdLevel(), Softening softening = Softening::Clamped);
+
+        const char *name() const override { return "mixed"; }
+        void computeAccelerations(BodyStore &store) override;
+        void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) override;
+
+private:
+        MixedKernel kernel;
+        std::vector<float> x, y, z, mass;   // the packed blocks, in store order
+        std::vector<MixedBlock> blocks;
+        double lengthFloor = 0.0;            // smallest block length this step, keeps far offsets within float's range
+
+        void packBlocks(const BodyStore &store);
+        void sumBlocks(BodyStore &store, const std::uint32_t *targetList, std::size_t targetTotal) const;
+};
+
+#endif
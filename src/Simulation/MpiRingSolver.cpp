@@ -0,0 +1,168 @@
+/**
+ * This file contains the implementation of the MpiRingSolver class, the direct sum over MPI ranks with a systolic ring
+ *
+ * only built with -DUSE_MPI (make mpi), the plain build compiles it to nothing
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#ifdef USE_MPI
+
+#include <algorithm>
+#include "MpiRingSolver.h"
+using namespace std;
+
+const int RING_TAG = 1;       // the travelling source blocks
+const int TRAJECTORY_TAG = 2; // the trajectories sent to rank 0 for the output
+
+size_t rankBlockBegin(size_t n, int rank, int ranks)
+{
+    return n * rank / ranks;
+}
+
+MpiRingSolver::MpiRingSolver(MPI_Comm comm, size_t totalBodies, SimdLevel level, Softening softening)
+    : comm(comm), totalBodies(totalBodies), kernel(sourceKernelFor(level, softening))
+{
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &rankCount);
+    stride = 0;
+    for (int r = 0; r < rankCount; r++)
+    {
+        stride = max(stride, rankBlockBegin(totalBodies, r + 1, rankCount) - rankBlockBegin(totalBodies, r, rankCount));
+    }
+    blocks[0].resize(4 * stride);
+    blocks[1].resize(4 * stride);
+}
+
+/**
+ * @brief computes the acceleration of every body of this rank against the sources of every rank
+ * @param store this rank's bodies, ax/ay/az are overwritten
+ */
+void MpiRingSolver::computeAccelerations(BodyStore &store)
+{
+    sumRing(store, nullptr, store.size());
+}
+
+/**
+ * @brief computes the acceleration of the listed bodies of this rank only, every body of every rank is still a source
+ * @param store this rank's bodies, ax/ay/az of the targets are overwritten
+ * @param targets indices of the bodies to accelerate
+ */
+void MpiRingSolver::computeAccelerationsOf(BodyStore &store, const vector<uint32_t> &targets)
+{
+    sumRing(store, targets.data(), targets.size());
+}
+
+/**
+ * @brief the ring itself, rankCount rounds, each summing the block held while the next one travels
+ */
+void MpiRingSolver::sumRing(BodyStore &store, const uint32_t *targetList, size_t targetTotal)
+{
+    const size_t n = store.size();
+    const int next = (rank + 1) % rankCount, previous = (rank + rankCount - 1) % rankCount;
+
+    #pragma omp single
+    {
+        double *own = blocks[0].data();
+        copy(store.x.begin(), store.x.end(), own);
+        copy(store.y.begin(), store.y.end(), own + stride);
+        copy(store.z.begin(), store.z.end(), own + 2 * stride);
+        copy(store.mass.begin(), store.mass.end(), own + 3 * stride);
+        sumX.assign(n, 0.0);
+        sumY.assign(n, 0.0);
+        sumZ.assign(n, 0.0);
+    }
+
+    int current = 0;
+    for (int round = 0; round < rankCount; round++)
+    {
+        // the block held now started at rank - round, the one arriving at rank - round - 1
+        const int origin = (rank - round + rankCount) % rankCount;
+        const size_t count = rankBlockBegin(totalBodies, origin + 1, rankCount) - rankBlockBegin(totalBodies, origin, rankCount);
+        const bool passOn = round + 1 < rankCount;
+        MPI_Request requests[2];
+
+        // the arriving block lands in the buffer every thread finished reading at the end of the last round
+        #pragma omp master
+        if (passOn)
+        {
+            MPI_Irecv(blocks[1 - current].data(), static_cast<int>(4 * stride), MPI_DOUBLE, previous, RING_TAG, comm, &requests[0]);
+            MPI_Isend(blocks[current].data(), static_cast<int>(4 * stride), MPI_DOUBLE, next, RING_TAG, comm, &requests[1]);
+        }
+
+        const double *x = blocks[current].data(), *y = x + stride, *z = y + stride, *mass = z + stride;
+        loop.run(targetTotal, TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++)
+            {
+                const size_t i = targetList ? targetList[k] : k;
+                kernel(x, y, z, mass, count, store.x[i], store.y[i], store.z[i], sumX[i], sumY[i], sumZ[i]);
+            }
+        });
+
+        #pragma omp master
+        if (passOn)
+        {
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+        }
+        #pragma omp barrier
+        current = 1 - current;
+    }
+
+    loop.run(targetTotal, TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++)
+        {
+            const size_t i = targetList ? targetList[k] : k;
+            const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+            store.ax[i] = scale * sumX[i];
+            store.ay[i] = scale * sumY[i];
+            store.az[i] = scale * sumZ[i];
+        }
+    });
+}
+
+/**
+ * @brief sends the trajectory of every body a rank owns to rank 0, one message per body
+ * @param bodies every body of the run on every rank, each rank has only filled the trajectories of its own block
+ */
+void gatherTrajectories(vector<Body> &bodies, MPI_Comm comm)
+{
+    int rank, ranks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &ranks);
+    const size_t n = bodies.size();
+    vector<double> buffer;
+
+    if (rank != 0)
+    {
+        for (size_t i = rankBlockBegin(n, rank, ranks); i < rankBlockBegin(n, rank + 1, ranks); i++)
+        {
+            buffer.clear();
+            for (const Vec3 &point : bodies[i].trajectory)
+            {
+                buffer.insert(buffer.end(), {point.x, point.y, point.z});
+            }
+            MPI_Send(buffer.data(), static_cast<int>(buffer.size()), MPI_DOUBLE, 0, TRAJECTORY_TAG, comm);
+        }
+        return;
+    }
+
+    for (int r = 1; r < ranks; r++)
+    {
+        for (size_t i = rankBlockBegin(n, r, ranks); i < rankBlockBegin(n, r + 1, ranks); i++)
+        {
+            MPI_Status status;
+            int count;
+            MPI_Probe(r, TRAJECTORY_TAG, comm, &status);
+            MPI_Get_count(&status, MPI_DOUBLE, &count);
+            buffer.resize(count);
+            MPI_Recv(buffer.data(), count, MPI_DOUBLE, r, TRAJECTORY_TAG, comm, MPI_STATUS_IGNORE);
+            bodies[i].trajectory.clear();
+            for (int k = 0; k + 2 < count; k += 3)
+            {
+                bodies[i].trajectory.push_back(Vec3(buffer[k], buffer[k + 1], buffer[k + 2]));
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef MPI_RING_SOLVER_H
+#define MPI_RING_SOLVER_H
+
+#ifdef USE_MPI
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mpi.h>
+#include "body.h"
+#include "ForceSolver.h"
+#include "SimdKernels.h"
+
+std::size_t rankBlockBegin(std::size_t n, int rank, int ranks); // the first of the bodies rank owns, n r / P, rank P gives n
+
+/*
+    MpiRingSolver class:
+        the O(N^2) direct sum over MPI ranks, each rank holds only its own block of the bodies in its BodyStore
+            ring        the ranks form a ring, every rank starts with a copy of its own sources and, P - 1 times,
+                        passes the block it holds to the next rank while taking the previous rank's,
+                        so after P rounds every target has seen every source and each rank sent N / P sources P - 1 times
+            overlap     the send and receive of the next block are posted before the current block is summed,
+                        and waited on after, so the transfer runs behind the force tile
+        within a rank the targets are shared out over the OpenMP threads by the work stealing loop as in SimdSolver,
+        the master thread makes the ring's MPI calls while the others sum, and the output's gather runs in an
+        omp single, so MPI is initialized with MPI_THREAD_SERIALIZED
+
+    computeAccelerations is called by every thread of every rank, as a collective of both,
+    the blocks are sent at a fixed size, the largest block, so a round is one message each way
+*/
+class MpiRingSolver : public ForceSolver
+{
+public:
+        MpiRingSolver(MPI_Comm comm, std::size_t totalBodies, SimdLevel level = detectSimdLevel(), Softening softening = Softening::Clamped);
+
+        const char *name() const override { return "ring (mpi)"; }
+        void computeAccelerations(BodyStore &store) override;
+        void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) override;
+
+        int ranks() const { return rankCount; }
+
+private:
+        MPI_Comm comm;
+        int rank, rankCount;
+        std::size_t totalBodies; // over every rank
+        std::size_t stride;      // the largest block, the length of each array of a travelling block
+        SourceKernel kernel;
+
+        std::vector<double> blocks[2];                // the block summed this round and the one arriving, x, y, z, mass each stride long
+        std::vector<double> sumX, sumY, sumZ;         // the unscaled pull on every target, over the rounds so far
+
+        void sumRing(BodyStore &store, const std::uint32_t *targetList, std::size_t targetTotal);
+};
+
+/*
+    gatherTrajectories:
+        called by every rank after the run, the trajectories each rank recorded for its own block of bodies
+        are sent to rank 0, whose bodies then hold them all for FileManager::outputResults
+*/
+void gatherTrajectories(std::vector<Body> &bodies, MPI_Comm comm);
+
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * This file contains the engines over NBody, one per compiled N and integrator scheme, and the factory picking one
+ *
+ * every N from FIXED_SIZE_MIN to FIXED_SIZE_MAX is instantiated with the legacy step and the five symplectic schemes,
+ * the factory walks the sizes at compile time and stops at the run's N
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <type_traits>
+#include "NBody.h"
+using namespace std;
+
+// the step of LegacyIntegrator, as a scheme tag next to the symplectic ones
+struct LegacyStep
+{
+        static constexpr const char *name = "legacy";
+        static constexpr bool kickFirst = false;
+};
+
+template <size_t N, class Scheme>
+class FixedSizeEngineOf : public FixedSizeEngine
+{
+public:
+        explicit FixedSizeEngineOf(double timestep) : timestep(timestep) {}
+
+        size_t size() const override { return N; }
+
+        void start(const BodyStore &store) override
+        {
+            state.load(store);
+            if constexpr (Scheme::kickFirst)
+            {
+                state.accelerate();
+                evaluations += N;
+            }
+        }
+
+        void advance(vector<Body> &bodies) override
+        {
+            if constexpr (is_same_v<Scheme, LegacyStep>)
+            {
+                state.legacyStep(timestep);
+                evaluations += N;
+            }
+            else
+            {
+                state.template step<Scheme>(timestep);
+                evaluations += Scheme::weights.size() * N;
+            }
+            for (size_t i = 0; i < N; i++)
+            {
+                bodies[i].trajectory.push_back(Vec3(state.x[i], state.y[i], state.z[i]));
+            }
+        }
+
+        void save(BodyStore &store) const override { state.save(store); }
+
+private:
+        NBody<N> state;
+        double timestep;
+};
+
+/**
+ * @brief the engine of size N for the named integrator, null when the integrator has no fixed size step
+ */
+template <size_t N>
+static unique_ptr<FixedSizeEngine> engineFor(const string &integrator, double timestep)
+{
+    if (integrator == LegacyStep::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, LegacyStep>>(timestep);
+    }
+    if (integrator == LeapfrogKdk::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, LeapfrogKdk>>(timestep);
+    }
+    if (integrator == LeapfrogDkd::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, LeapfrogDkd>>(timestep);
+    }
+    if (integrator == Yoshida4::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, Yoshida4>>(timestep);
+    }
+    if (integrator == Yoshida6::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, Yoshida6>>(timestep);
+    }
+    if (integrator == ForestRuth::name)
+    {
+        return make_unique<FixedSizeEngineOf<N, ForestRuth>>(timestep);
+    }
+    return nullptr;
+}
+
+template <size_t N>
+static unique_ptr<FixedSizeEngine> engineFrom(size_t n, const string &integrator, double timestep)
+{
+    if (n == N)
+    {
+        return engineFor<N>(integrator, timestep);
+    }
+    if constexpr (N < FIXED_SIZE_MAX)
+    {
+        return engineFrom<N + 1>(n, integrator, timestep);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief the engine compiled for n bodies stepped by the named integrator
+ * @return null when n is outside FIXED_SIZE_MIN to FIXED_SIZE_MAX, or the integrator is not legacy or symplectic
+ */
+unique_ptr<FixedSizeEngine> makeFixedSizeEngine(size_t n, const string &integrator, double timestep)
+{
+    return engineFrom<FIXED_SIZE_MIN>(n, integrator, timestep);
+}
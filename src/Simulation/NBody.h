@@ -0,0 +1,251 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "body.h"
+#include "BodyStore.h"
+#include "ForceSolver.h"
+#include "SymplecticIntegrator.h"
+
+const std::size_t FIXED_SIZE_MIN = 2;  // smallest N with a compiled engine
+const std::size_t FIXED_SIZE_MAX = 16; // largest, the unrolled pair sum grows as N^2 and stops paying off beyond L1
+
+/*
+    NBody class:
+        the whole state of N bodies in std::array members, N a template parameter, for tiny systems run for a great
+        many steps, where the vectors, the virtual solver call and the barriers of the parallel step loop cost more
+        than the forces themselves
+            accelerate      every unordered pair once, the pair list is a compile-time table and the sum is a fold
+                            over it, so the pair loop is fully unrolled with the indices as constants
+            kick, drift     loops of constant trip count over the arrays, unrolled and vectorized across the bodies
+        the force law is the clamped one of the direct solvers, coincident bodies pull on nothing
+
+    one thread runs it, the state fits in a few cache lines
+*/
+template <std::size_t N>
+class NBody
+{
+public:
+        std::array<double, N> x{}, y{}, z{};
+        std::array<double, N> vx{}, vy{}, vz{};
+        std::array<double, N> ax{}, ay{}, az{};
+        std::array<double, N> mass{};
+        std::array<double, N> scale{}; // G times the body's gravitationalMultiplier
+
+        void load(const BodyStore &store);
+        void save(BodyStore &store) const;
+
+        void accelerate();
+        void kick(double time);
+        void drift(double time);
+
+        void legacyStep(double dt);
+        template <class Scheme>
+        void step(double dt);
+
+private:
+        static constexpr std::size_t PAIRS = N * (N - 1) / 2;
+
+        // the i < j pairs in row order, first and second index
+        static constexpr std::array<std::array<std::size_t, 2>, PAIRS> pairTable()
+        {
+            std::array<std::array<std::size_t, 2>, PAIRS> table{};
+            std::size_t p = 0;
+            for (std::size_t i = 0; i < N; i++)
+            {
+                for (std::size_t j = i + 1; j < N; j++)
+                {
+                    table[p++] = {i, j};
+                }
+            }
+            return table;
+        }
+        static constexpr std::array<std::array<std::size_t, 2>, PAIRS> pairs = pairTable();
+
+        template <std::size_t I, std::size_t J>
+        void pull(std::array<double, N> &sumX, std::array<double, N> &sumY, std::array<double, N> &sumZ) const;
+        template <std::size_t... P>
+        void pullAll(std::index_sequence<P...>, std::array<double, N> &sumX, std::array<double, N> &sumY, std::array<double, N> &sumZ) const
+        {
+            (pull<pairs[P][0], pairs[P][1]>(sumX, sumY, sumZ), ...);
+        }
+};
+
+/**
+ * @brief copies the first N bodies of the store in, with G folded into every multiplier
+ */
+template <std::size_t N>
+void NBody<N>::load(const BodyStore &store)
+{
+    for (std::size_t i = 0; i < N; i++)
+    {
+        x[i] = store.x[i];
+        y[i] = store.y[i];
+        z[i] = store.z[i];
+        vx[i] = store.vx[i];
+        vy[i] = store.vy[i];
+        vz[i] = store.vz[i];
+        ax[i] = store.ax[i];
+        ay[i] = store.ay[i];
+        az[i] = store.az[i];
+        mass[i] = store.mass[i];
+        scale[i] = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+    }
+}
+
+/**
+ * @brief copies the positions, velocities and accelerations back into the store
+ */
+template <std::size_t N>
+void NBody<N>::save(BodyStore &store) const
+{
+    for (std::size_t i = 0; i < N; i++)
+    {
+        store.x[i] = x[i];
+        store.y[i] = y[i];
+        store.z[i] = z[i];
+        store.vx[i] = vx[i];
+        store.vy[i] = vy[i];
+        store.vz[i] = vz[i];
+        store.ax[i] = ax[i];
+        store.ay[i] = ay[i];
+        store.az[i] = az[i];
+    }
+}
+
+/**
+ * @brief the pull of the pair (I, J) on both of its bodies, unscaled
+ */
+template <std::size_t N>
+template <std::size_t I, std::size_t J>
+void NBody<N>::pull(std::array<double, N> &sumX, std::array<double, N> &sumY, std::array<double, N> &sumZ) const
+{
+    const double softening2 = SOFTENING_LENGTH * SOFTENING_LENGTH;
+    const double dx = x[J] - x[I], dy = y[J] - y[I], dz = z[J] - z[I];
+    const double r2 = dx * dx + dy * dy + dz * dz;
+    if (r2 > 0.0)
+    {
+        const double dist2 = r2 < softening2 ? softening2 : r2;
+        const double s = 1.0 / ((dist2 + softening2) * std::sqrt(r2));
+        sumX[I] += mass[J] * s * dx;
+        sumY[I] += mass[J] * s * dy;
+        sumZ[I] += mass[J] * s * dz;
+        sumX[J] -= mass[I] * s * dx;
+        sumY[J] -= mass[I] * s * dy;
+        sumZ[J] -= mass[I] * s * dz;
+    }
+}
+
+/**
+ * @brief the acceleration of every body, each pair evaluated once
+ */
+template <std::size_t N>
+void NBody<N>::accelerate()
+{
+    std::array<double, N> sumX{}, sumY{}, sumZ{};
+    pullAll(std::make_index_sequence<PAIRS>{}, sumX, sumY, sumZ);
+    for (std::size_t i = 0; i < N; i++)
+    {
+        ax[i] = scale[i] * sumX[i];
+        ay[i] = scale[i] * sumY[i];
+        az[i] = scale[i] * sumZ[i];
+    }
+}
+
+template <std::size_t N>
+void NBody<N>::kick(double time)
+{
+    for (std::size_t i = 0; i < N; i++)
+    {
+        vx[i] += ax[i] * time;
+        vy[i] += ay[i] * time;
+        vz[i] += az[i] * time;
+    }
+}
+
+template <std::size_t N>
+void NBody<N>::drift(double time)
+{
+    for (std::size_t i = 0; i < N; i++)
+    {
+        x[i] += vx[i] * time;
+        y[i] += vy[i] * time;
+        z[i] += vz[i] * time;
+    }
+}
+
+/**
+ * @brief the step of LegacyIntegrator, a half kick with the accelerations cleared after it, then the drift
+ */
+template <std::size_t N>
+void NBody<N>::legacyStep(double dt)
+{
+    accelerate();
+    kick(dt * 0.5);
+    ax.fill(0.0);
+    ay.fill(0.0);
+    az.fill(0.0);
+    drift(dt);
+}
+
+/**
+ * @brief one step of a SymplecticIntegrator scheme, the same stages in the same order
+ */
+template <std::size_t N>
+template <class Scheme>
+void NBody<N>::step(double dt)
+{
+    constexpr std::size_t K = Scheme::weights.size();
+    constexpr std::array<double, K + 1> outer = mergedHalves(Scheme::weights);
+
+    for (std::size_t k = 0; k < K; k++)
+    {
+        if constexpr (Scheme::kickFirst)
+        {
+            kick(outer[k] * dt);
+            drift(Scheme::weights[k] * dt);
+        }
+        else
+        {
+            kick(k == 0 ? 0.0 : Scheme::weights[k - 1] * dt);
+            drift(outer[k] * dt);
+        }
+        accelerate();
+    }
+    kick((Scheme::kickFirst ? outer[K] : Scheme::weights[K - 1]) * dt);
+    if constexpr (!Scheme::kickFirst)
+    {
+        drift(outer[K] * dt);
+    }
+}
+
+/*
+    FixedSizeEngine class:
+        an NBody of the run's N stepped by the run's integrator, Simulation::run hands the whole step loop to it
+        when makeFixedSizeEngine finds one compiled for N, see there for what a run may not ask for
+*/
+class FixedSizeEngine
+{
+public:
+        virtual ~FixedSizeEngine() = default;
+        virtual std::size_t size() const = 0;
+        virtual void start(const BodyStore &store) = 0;         // loads the bodies, and the accelerations a kick first scheme starts from
+        virtual void advance(std::vector<Body> &bodies) = 0;    // one Timestep, then every body's position appended to its trajectory
+        virtual void save(BodyStore &store) const = 0;
+
+        std::uint64_t forceEvaluations() const { return evaluations; }
+
+protected:
+        std::uint64_t evaluations = 0;
+};
+
+std::unique_ptr<FixedSizeEngine> makeFixedSizeEngine(std::size_t n, const std::string &integrator, double timestep);
+
+#endif
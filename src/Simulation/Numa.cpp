@@ -0,0 +1,355 @@
+/**
+ * This file contains the NUMA support of the step loop: the topology, where the threads run, the first touch placement
+ * of the body arrays and the per node copies of the sources
+ *
+ * Linux puts a page on the node of the thread that first writes it, so an array written once by the master thread
+ * lives on the master's node and every other socket reads it remotely for the rest of the run, the pages are therefore
+ * dropped and written again by the threads whose runs of the work stealing loops cover them
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <omp.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "Numa.h"
+#include "WorkStealing.h"
+using namespace std;
+
+int NumaTopology::nodeOfCpu(int cpu) const
+{
+    for (const NumaNode &node : nodes)
+    {
+        if (find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end())
+        {
+            return node.id;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief the nodes from libnuma, loaded with dlopen so machines without it still run
+ * @return false when the library is missing or reports NUMA as unavailable
+ */
+static bool readLibnuma(NumaTopology &topology)
+{
+    void *library = dlopen("libnuma.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!library)
+    {
+        library = dlopen("libnuma.so", RTLD_NOW | RTLD_LOCAL);
+    }
+    if (!library)
+    {
+        return false;
+    }
+    typedef int (*NoArguments)();
+    typedef int (*OneArgument)(int);
+    NoArguments available = reinterpret_cast<NoArguments>(dlsym(library, "numa_available"));
+    NoArguments maxNode = reinterpret_cast<NoArguments>(dlsym(library, "numa_max_node"));
+    NoArguments configuredCpus = reinterpret_cast<NoArguments>(dlsym(library, "numa_num_configured_cpus"));
+    OneArgument nodeOfCpu = reinterpret_cast<OneArgument>(dlsym(library, "numa_node_of_cpu"));
+    bool found = false;
+    if (available && maxNode && configuredCpus && nodeOfCpu && available() >= 0)
+    {
+        vector<NumaNode> nodes(maxNode() + 1);
+        for (size_t id = 0; id < nodes.size(); id++)
+        {
+            nodes[id].id = static_cast<int>(id);
+        }
+        for (int cpu = 0; cpu < configuredCpus(); cpu++)
+        {
+            const int node = nodeOfCpu(cpu);
+            if (node >= 0 && node < static_cast<int>(nodes.size()))
+            {
+                nodes[node].cpus.push_back(cpu);
+            }
+        }
+        for (NumaNode &node : nodes)
+        {
+            if (!node.cpus.empty()) // memory only nodes run no threads
+            {
+                topology.nodes.push_back(node);
+            }
+        }
+        topology.source = "libnuma";
+        found = !topology.nodes.empty();
+    }
+    dlclose(library);
+    return found;
+}
+
+/**
+ * @brief a cpulist of /sys, "0-3,8-11"
+ */
+static vector<int> parseCpuList(const string &list)
+{
+    vector<int> cpus;
+    stringstream reader(list);
+    string range;
+    while (getline(reader, range, ','))
+    {
+        const size_t dash = range.find('-');
+        try
+        {
+            const int first = stoi(range.substr(0, dash));
+            const int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const exception &)
+        {
+            // an empty list, a node without cpus
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief the nodes from /sys/devices/system/node/node<id>/cpulist
+ * @return false when the directory is not there
+ */
+static bool readSys(NumaTopology &topology)
+{
+    const string root = "/sys/devices/system/node/";
+    DIR *directory = opendir(root.c_str());
+    if (!directory)
+    {
+        return false;
+    }
+    while (dirent *entry = readdir(directory))
+    {
+        const string name = entry->d_name;
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || name.find_first_not_of("0123456789", 4) != string::npos)
+        {
+            continue;
+        }
+        ifstream file(root + name + "/cpulist");
+        string list;
+        getline(file, list);
+        NumaNode node;
+        node.id = stoi(name.substr(4));
+        node.cpus = parseCpuList(list);
+        if (!node.cpus.empty())
+        {
+            topology.nodes.push_back(node);
+        }
+    }
+    closedir(directory);
+    sort(topology.nodes.begin(), topology.nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+    topology.source = "/sys";
+    return !topology.nodes.empty();
+}
+
+/**
+ * @brief the memory nodes and their cpus, libnuma first, /sys as a fallback, a single node as the last resort
+ */
+NumaTopology detectNumaTopology()
+{
+    NumaTopology topology;
+    if (readLibnuma(topology))
+    {
+        return topology;
+    }
+    topology = NumaTopology();
+    if (readSys(topology))
+    {
+        return topology;
+    }
+    topology = NumaTopology();
+    topology.source = "none";
+    topology.nodes.resize(1);
+    for (int cpu = 0; cpu < omp_get_num_procs(); cpu++)
+    {
+        topology.nodes[0].cpus.push_back(cpu);
+    }
+    return topology;
+}
+
+/**
+ * @brief the node every thread of the region runs on, from the cpu it is on now
+ * @param nodeOfThread shared between the threads, filled with the node of thread t at index t
+ */
+void threadPlacement(const NumaTopology &topology, vector<int> &nodeOfThread)
+{
+    #pragma omp single
+    nodeOfThread.assign(omp_get_num_threads(), 0);
+
+#ifdef __linux__
+    const int cpu = sched_getcpu();
+#else
+    const int cpu = -1; // no way to ask, every thread counts as node 0
+#endif
+    nodeOfThread[omp_get_thread_num()] = cpu < 0 ? 0 : topology.nodeOfCpu(cpu);
+    #pragma omp barrier
+}
+
+/**
+ * @brief "0-3,8,10-11" for a sorted list of numbers
+ */
+static string rangeList(const vector<int> &values)
+{
+    string list;
+    for (size_t k = 0; k < values.size();)
+    {
+        size_t last = k;
+        while (last + 1 < values.size() && values[last + 1] == values[last] + 1)
+        {
+            last++;
+        }
+        list += (list.empty() ? "" : ",") + to_string(values[k]) + (last > k ? "-" + to_string(values[last]) : "");
+        k = last + 1;
+    }
+    return list.empty() ? "none" : list;
+}
+
+/**
+ * @brief prints the nodes, their cpus, the threads running on each, and whether the sources are replicated
+ */
+void reportPlacement(ostream &out, const NumaTopology &topology, const vector<int> &nodeOfThread, bool replicated)
+{
+    out << "NUMA topology (" << topology.source << "): " << topology.nodes.size() << (topology.nodes.size() == 1 ? " node" : " nodes") << endl;
+    for (const NumaNode &node : topology.nodes)
+    {
+        vector<int> threads;
+        for (size_t t = 0; t < nodeOfThread.size(); t++)
+        {
+            if (nodeOfThread[t] == node.id)
+            {
+                threads.push_back(static_cast<int>(t));
+            }
+        }
+        out << "  node " << node.id << ": cpus " << rangeList(node.cpus) << ", threads " << rangeList(threads) << endl;
+    }
+    if (omp_get_proc_bind() == omp_proc_bind_false)
+    {
+        out << "  threads are not bound, set OMP_PROC_BIND and OMP_PLACES for the placement to hold" << endl;
+    }
+    out << "  body arrays first touched by the threads of their targets, sources " << (replicated ? "replicated on every node" : "shared") << endl << endl;
+}
+
+/**
+ * @brief gives the whole pages of a private anonymous range back to the kernel, they read as zero until written again,
+ * and the write places them on the node of the writing thread
+ */
+void discardPages(void *begin, size_t bytes)
+{
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + page - 1) / page * page;
+    const uintptr_t last = (reinterpret_cast<uintptr_t>(begin) + bytes) / page * page;
+    if (last > first)
+    {
+        madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+    }
+}
+
+/**
+ * @brief places every array of the store on the nodes of the threads whose runs cover it, the values are kept
+ *
+ * one thread copies the arrays aside and drops their pages, then every thread writes its own run back,
+ * the runs are those the work stealing loops start from, so each target's state sits on its thread's node
+ */
+void placeFirstTouch(BodyStore &store)
+{
+    static vector<double> staging; // shared by the threads of the region, empty between placements
+    static vector<uint32_t> stagingIds;
+    vector<double> *const arrays[] = {&store.x, &store.y, &store.z, &store.vx, &store.vy, &store.vz, &store.ax, &store.ay, &store.az,
+                                      &store.mass, &store.gravitationalMultiplier, &store.radius};
+    const size_t count = sizeof(arrays) / sizeof(arrays[0]);
+    const size_t n = store.size();
+
+    #pragma omp single
+    {
+        staging.resize(count * n);
+        for (size_t a = 0; a < count; a++)
+        {
+            copy(arrays[a]->begin(), arrays[a]->end(), staging.begin() + a * n);
+            discardPages(arrays[a]->data(), n * sizeof(double));
+        }
+        stagingIds = store.id;
+        discardPages(store.id.data(), n * sizeof(uint32_t));
+    }
+
+    const int threads = omp_get_num_threads(), self = omp_get_thread_num();
+    size_t begin, end;
+    WorkStealingLoop::share(n, self, threads, begin, end);
+    for (size_t a = 0; a < count; a++)
+    {
+        copy(staging.begin() + a * n + begin, staging.begin() + a * n + end, arrays[a]->begin() + begin);
+    }
+    copy(stagingIds.begin() + begin, stagingIds.begin() + end, store.id.begin() + begin);
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        vector<double>().swap(staging);
+        vector<uint32_t>().swap(stagingIds);
+    }
+}
+
+/**
+ * @brief copies the positions and masses into the replica of every node, each node's threads fill their own
+ */
+void SourceReplicas::refresh(const BodyStore &store)
+{
+    const int threads = omp_get_num_threads(), self = omp_get_thread_num();
+    const size_t n = store.size();
+    int nodes = 1;
+    for (int t = 0; t < threads; t++)
+    {
+        nodes = max(nodes, WorkStealingLoop::nodeOf(t) + 1);
+    }
+
+    #pragma omp single
+    if (static_cast<int>(copies.size()) != nodes || bodies != n)
+    {
+        copies.assign(nodes, vector<double>());
+        for (int t = 0; t < threads; t++)
+        {
+            vector<double> &copy = copies[WorkStealingLoop::nodeOf(t)];
+            if (copy.empty() && n > 0)
+            {
+                copy.resize(4 * n);
+                discardPages(copy.data(), copy.size() * sizeof(double)); // placed by the node's threads below
+            }
+        }
+        bodies = n;
+    }
+
+    // this thread's share of its node's copy, the node's threads split it in thread order
+    const int node = WorkStealingLoop::nodeOf(self);
+    int share = 0, sharers = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        if (WorkStealingLoop::nodeOf(t) == node)
+        {
+            share += t < self;
+            sharers++;
+        }
+    }
+    const size_t begin = n * share / sharers, end = n * (share + 1) / sharers;
+    double *copy = copies[node].data();
+    std::copy(store.x.begin() + begin, store.x.begin() + end, copy + begin);
+    std::copy(store.y.begin() + begin, store.y.begin() + end, copy + n + begin);
+    std::copy(store.z.begin() + begin, store.z.begin() + end, copy + 2 * n + begin);
+    std::copy(store.mass.begin() + begin, store.mass.begin() + end, copy + 3 * n + begin);
+    #pragma omp barrier
+}
+
+/**
+ * @brief the replica on the calling thread's node
+ */
+SourceReplicas::Sources SourceReplicas::local() const
+{
+    const double *copy = copies[WorkStealingLoop::nodeOf(omp_get_thread_num())].data();
+    return {copy, copy + bodies, copy + 2 * bodies, copy + 3 * bodies};
+}
@@ -0,0 +1,68 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BodyStore.h"
+
+// one memory node and the cpus attached to it
+struct NumaNode
+{
+        int id = 0;
+        std::vector<int> cpus;
+};
+
+/*
+    NumaTopology struct:
+        the memory nodes of the machine and their cpus, read from libnuma when it can be loaded and from
+        /sys/devices/system/node otherwise, one node holding every cpu when neither is there
+        libnuma is opened at run time, so the build never links against it
+*/
+struct NumaTopology
+{
+        std::vector<NumaNode> nodes;
+        std::string source; // libnuma, /sys or none
+
+        int nodeOfCpu(int cpu) const; // 0 for a cpu no node lists
+};
+
+NumaTopology detectNumaTopology();
+
+/*
+    threadPlacement and reportPlacement:
+        threadPlacement is called by every thread of the parallel region and fills the shared nodeOfThread with the node
+        each thread runs on, read from the cpu it is on, so it only means something with the threads bound
+        (OMP_PROC_BIND, OMP_PLACES), reportPlacement prints the nodes, their cpus and the threads they hold
+*/
+void threadPlacement(const NumaTopology &topology, std::vector<int> &nodeOfThread);
+void reportPlacement(std::ostream &out, const NumaTopology &topology, const std::vector<int> &nodeOfThread, bool replicated);
+
+void discardPages(void *begin, std::size_t bytes); // the whole pages inside the range read as zero and are placed by their next touch
+void placeFirstTouch(BodyStore &store);            // every thread of the region, each array's pages go to the nodes of their targets' threads
+
+/*
+    SourceReplicas class:
+        a copy of the source positions and masses on every node, for the direct sums whose every target reads every source,
+        refresh is called by every thread of the parallel region and each node's threads copy the store into
+        their node's replica, so its pages are first touched, and stay, on that node
+        local returns the replica of the calling thread's node, the rows of one node's threads never leave it
+*/
+class SourceReplicas
+{
+public:
+        struct Sources
+        {
+                const double *x, *y, *z, *mass;
+        };
+
+        void refresh(const BodyStore &store);
+        Sources local() const;
+
+private:
+        std::vector<std::vector<double>> copies; // x, y, z and mass of one node one after the other, one vector per node
+        std::size_t bodies = 0;                  // n of the copies
+};
+
+#endif
@@ -0,0 +1,372 @@
+/**
+ * This file contains the implementation of the Octree class, the parallel Morton ordered octree shared by the tree solvers
+ *
+ * a Morton key interleaves the bits of the three quantized coordinates, x in the highest bit of every triple,
+ * so sorting by key lays the bodies out in octree order: the bodies of any cube are a contiguous run of the sorted keys,
+ * and the octant of a body at level l is simply bits (60 - 3l) to (62 - 3l) of its key
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <omp.h>
+#include "Octree.h"
+using namespace std;
+
+const int MAX_LEVEL = 21;                          // bits per axis in a key
+const uint64_t CELLS_PER_AXIS = uint64_t(1) << MAX_LEVEL;
+const int RADIX_BITS = 8;                          // bits sorted per radix pass
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+const int RADIX_PASSES = 8;                        // 64 bit keys, an even count leaves the result in keys
+const uint32_t TASK_THRESHOLD = 4096;              // subtrees with more bodies than this are built as their own task
+
+/**
+ * @brief spreads the low 21 bits of v so two zero bits sit between each of them
+ */
+static inline uint64_t spreadBits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+/**
+ * @brief inverse of spreadBits, gathers every third bit of v back into the low 21 bits
+ */
+static inline uint64_t compactBits(uint64_t v)
+{
+    v &= 0x1249249249249249ULL;
+    v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3ULL;
+    v = (v ^ (v >> 4)) & 0x100f00f00f00f00fULL;
+    v = (v ^ (v >> 8)) & 0x1f0000ff0000ffULL;
+    v = (v ^ (v >> 16)) & 0x1f00000000ffffULL;
+    v = (v ^ (v >> 32)) & 0x1fffff;
+    return v;
+}
+
+/**
+ * @brief the range [begin, end) of n items that thread t of threads handles in the hand split loops
+ */
+static inline void threadRange(size_t n, int t, int threads, size_t &begin, size_t &end)
+{
+    begin = n * t / threads;
+    end = n * (t + 1) / threads;
+}
+
+Octree::Octree(size_t leafCapacity) : leafCapacity(max<size_t>(1, leafCapacity)) {}
+
+/**
+ * @brief rebuilds the tree around the current positions, every thread of the enclosing region must call it
+ * @param store the bodies
+ */
+void Octree::build(const BodyStore &store)
+{
+    const size_t n = store.size();
+    if (n == 0)
+    {
+        #pragma omp single
+        {
+            nodes.clear();
+            usedNodes = 0;
+        }
+        return;
+    }
+
+    #pragma omp single
+    {
+        keys.resize(n);
+        keyScratch.resize(n);
+        order.resize(n);
+        orderScratch.resize(n);
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        mass.resize(n);
+        nodes.resize(2 * n); // every internal node has two or more children, so 2N - 1 nodes at most
+    }
+
+    computeBounds(store);
+    computeKeys(store);
+    sortKeys();
+
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < n; k++)
+    {
+        const uint32_t i = order[k];
+        x[k] = store.x[i];
+        y[k] = store.y[i];
+        z[k] = store.z[i];
+        mass[k] = store.mass[i];
+    }
+
+    #pragma omp single
+    {
+        usedNodes = 1;
+        buildNode(0, 0, static_cast<uint32_t>(n));
+    }
+    // the barrier closing the single also waits for every task it spawned
+}
+
+/**
+ * @brief finds the cube holding every body, each thread scans its share and one thread combines them
+ */
+void Octree::computeBounds(const BodyStore &store)
+{
+    const int threads = omp_get_num_threads(), t = omp_get_thread_num();
+    size_t begin, end;
+    threadRange(store.size(), t, threads, begin, end);
+
+    #pragma omp single
+    bounds.resize(6 * threads);
+
+    double lowX = numeric_limits<double>::infinity(), lowY = lowX, lowZ = lowX;
+    double highX = -lowX, highY = -lowX, highZ = -lowX;
+    for (size_t i = begin; i < end; i++)
+    {
+        lowX = min(lowX, store.x[i]);
+        lowY = min(lowY, store.y[i]);
+        lowZ = min(lowZ, store.z[i]);
+        highX = max(highX, store.x[i]);
+        highY = max(highY, store.y[i]);
+        highZ = max(highZ, store.z[i]);
+    }
+    double *own = &bounds[6 * t];
+    own[0] = lowX;
+    own[1] = lowY;
+    own[2] = lowZ;
+    own[3] = highX;
+    own[4] = highY;
+    own[5] = highZ;
+
+    #pragma omp barrier
+    #pragma omp single
+    {
+        for (int other = 1; other < threads; other++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                bounds[axis] = min(bounds[axis], bounds[6 * other + axis]);
+                bounds[3 + axis] = max(bounds[3 + axis], bounds[6 * other + 3 + axis]);
+            }
+        }
+        rootX = bounds[0];
+        rootY = bounds[1];
+        rootZ = bounds[2];
+        rootSize = max(bounds[3] - bounds[0], max(bounds[4] - bounds[1], bounds[5] - bounds[2]));
+        // grow a little so the farthest body still quantizes inside the cube
+        rootSize = rootSize > 0.0 ? rootSize * (1.0 + 1e-9) : 1.0;
+    }
+}
+
+/**
+ * @brief quantizes every position to 21 bits per axis and interleaves them into a key
+ */
+void Octree::computeKeys(const BodyStore &store)
+{
+    const double cellsPerLength = CELLS_PER_AXIS / rootSize;
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const uint64_t cellX = min<uint64_t>(static_cast<uint64_t>((store.x[i] - rootX) * cellsPerLength), CELLS_PER_AXIS - 1);
+        const uint64_t cellY = min<uint64_t>(static_cast<uint64_t>((store.y[i] - rootY) * cellsPerLength), CELLS_PER_AXIS - 1);
+        const uint64_t cellZ = min<uint64_t>(static_cast<uint64_t>((store.z[i] - rootZ) * cellsPerLength), CELLS_PER_AXIS - 1);
+        keys[i] = (spreadBits(cellX) << 2) | (spreadBits(cellY) << 1) | spreadBits(cellZ);
+        order[i] = static_cast<uint32_t>(i);
+    }
+}
+
+/**
+ * @brief stable least significant digit radix sort of keys, carrying order along
+ *
+ * every pass: each thread counts the digits of its share, one thread turns the counts into
+ * per thread starting offsets (digit major, thread minor, so the sort stays stable), then each thread scatters its share
+ */
+void Octree::sortKeys()
+{
+    const size_t n = keys.size();
+    const int threads = omp_get_num_threads(), t = omp_get_thread_num();
+    size_t begin, end;
+    threadRange(n, t, threads, begin, end);
+
+    #pragma omp single
+    histograms.resize(RADIX_BUCKETS * threads);
+
+    uint64_t *source = keys.data(), *destination = keyScratch.data();
+    uint32_t *sourceOrder = order.data(), *destinationOrder = orderScratch.data();
+    size_t *counts = &histograms[RADIX_BUCKETS * t];
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        const int shift = pass * RADIX_BITS;
+        fill(counts, counts + RADIX_BUCKETS, 0);
+        for (size_t k = begin; k < end; k++)
+        {
+            counts[(source[k] >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            size_t offset = 0;
+            for (int digit = 0; digit < RADIX_BUCKETS; digit++)
+            {
+                for (int other = 0; other < threads; other++)
+                {
+                    const size_t count = histograms[RADIX_BUCKETS * other + digit];
+                    histograms[RADIX_BUCKETS * other + digit] = offset;
+                    offset += count;
+                }
+            }
+        }
+
+        for (size_t k = begin; k < end; k++)
+        {
+            const size_t position = counts[(source[k] >> shift) & (RADIX_BUCKETS - 1)]++;
+            destination[position] = source[k];
+            destinationOrder[position] = sourceOrder[k];
+        }
+
+        #pragma omp barrier
+        swap(source, destination);
+        swap(sourceOrder, destinationOrder);
+    }
+}
+
+/**
+ * @brief sets the cube of a node from any key inside it and the level of the cube
+ */
+void Octree::setCube(OctreeNode &node, uint64_t key, int level) const
+{
+    const int cellBits = MAX_LEVEL - level;
+    const uint64_t cellX = (compactBits(key >> 2) >> cellBits) << cellBits;
+    const uint64_t cellY = (compactBits(key >> 1) >> cellBits) << cellBits;
+    const uint64_t cellZ = (compactBits(key) >> cellBits) << cellBits;
+    const double unit = rootSize / CELLS_PER_AXIS;
+
+    node.size = rootSize / static_cast<double>(uint64_t(1) << level);
+    node.centerX = rootX + cellX * unit + 0.5 * node.size;
+    node.centerY = rootY + cellY * unit + 0.5 * node.size;
+    node.centerZ = rootZ + cellZ * unit + 0.5 * node.size;
+}
+
+/**
+ * @brief builds the subtree of the sorted bodies [begin, end) into nodes[nodeIndex] and fills in its moments
+ */
+void Octree::buildNode(int nodeIndex, uint32_t begin, uint32_t end)
+{
+    OctreeNode &node = nodes[nodeIndex];
+    const uint64_t first = keys[begin], last = keys[end - 1];
+
+    // the smallest cube holding the whole run is the level of the highest bit where its first and last keys differ
+    const int level = first == last ? MAX_LEVEL : (__builtin_clzll(first ^ last) - 1) / 3;
+    setCube(node, first, level);
+    node.begin = begin;
+    node.end = end;
+    node.firstChild = -1;
+    node.childCount = 0;
+
+    if (end - begin <= leafCapacity || first == last)
+    {
+        double totalMass = 0.0, sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+        for (uint32_t k = begin; k < end; k++)
+        {
+            totalMass += mass[k];
+            sumX += mass[k] * x[k];
+            sumY += mass[k] * y[k];
+            sumZ += mass[k] * z[k];
+        }
+        node.mass = totalMass;
+        if (totalMass > 0.0)
+        {
+            node.comX = sumX / totalMass;
+            node.comY = sumY / totalMass;
+            node.comZ = sumZ / totalMass;
+        }
+        else
+        {
+            node.comX = node.centerX;
+            node.comY = node.centerY;
+            node.comZ = node.centerZ;
+        }
+        double radius2 = 0.0;
+        for (uint32_t k = begin; k < end; k++)
+        {
+            const double dx = x[k] - node.comX, dy = y[k] - node.comY, dz = z[k] - node.comZ;
+            radius2 = max(radius2, dx * dx + dy * dy + dz * dz);
+        }
+        node.radius = sqrt(radius2);
+        return;
+    }
+
+    // the octant digits of this level rise through the run, so each child is the next run sharing a digit
+    const int shift = 3 * (MAX_LEVEL - 1 - level);
+    uint32_t childBegin[8], childEnd[8];
+    int children = 0;
+    for (uint32_t k = begin; k < end;)
+    {
+        const uint64_t digit = (keys[k] >> shift) & 7;
+        const uint64_t *next = upper_bound(&keys[k], &keys[0] + end, digit, [shift](uint64_t value, uint64_t key) {
+            return value < ((key >> shift) & 7);
+        });
+        childBegin[children] = k;
+        childEnd[children] = static_cast<uint32_t>(next - &keys[0]);
+        children++;
+        k = static_cast<uint32_t>(next - &keys[0]);
+    }
+
+    const int firstChild = usedNodes.fetch_add(children);
+    node.firstChild = firstChild;
+    node.childCount = children;
+
+    for (int c = 0; c < children; c++)
+    {
+        if (childEnd[c] - childBegin[c] > TASK_THRESHOLD)
+        {
+            #pragma omp task firstprivate(c) shared(childBegin, childEnd)
+            buildNode(firstChild + c, childBegin[c], childEnd[c]);
+        }
+        else
+        {
+            buildNode(firstChild + c, childBegin[c], childEnd[c]);
+        }
+    }
+    #pragma omp taskwait
+
+    double totalMass = 0.0, sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+    for (int c = 0; c < children; c++)
+    {
+        const OctreeNode &child = nodes[firstChild + c];
+        totalMass += child.mass;
+        sumX += child.mass * child.comX;
+        sumY += child.mass * child.comY;
+        sumZ += child.mass * child.comZ;
+    }
+    node.mass = totalMass;
+    if (totalMass > 0.0)
+    {
+        node.comX = sumX / totalMass;
+        node.comY = sumY / totalMass;
+        node.comZ = sumZ / totalMass;
+    }
+    else
+    {
+        node.comX = node.centerX;
+        node.comY = node.centerY;
+        node.comZ = node.centerZ;
+    }
+    double radius = 0.0;
+    for (int c = 0; c < children; c++)
+    {
+        const OctreeNode &child = nodes[firstChild + c];
+        const double dx = child.comX - node.comX, dy = child.comY - node.comY, dz = child.comZ - node.comZ;
+        radius = max(radius, sqrt(dx * dx + dy * dy + dz * dz) + child.radius);
+    }
+    node.radius = radius;
+}
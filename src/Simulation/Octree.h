@@ -0,0 +1,72 @@
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BodyStore.h"
+
+/*
+    OctreeNode struct:
+        one cube of the tree
+            geometric center and edge length of the cube
+            total mass and centre of mass of the bodies inside
+            radius of the smallest sphere around the centre of mass holding every body inside
+            the bodies inside, as a range of the Morton ordered arrays
+            the children, stored next to each other, firstChild is -1 for a leaf
+*/
+struct OctreeNode
+{
+        double centerX, centerY, centerZ;
+        double size;
+        double comX, comY, comZ;
+        double mass;
+        double radius;
+        std::uint32_t begin, end;
+        std::int32_t firstChild;
+        std::int32_t childCount;
+};
+
+/*
+    Octree class:
+        rebuilt from the BodyStore every step, entirely in parallel:
+            bounding box        per thread min/max, combined by one thread
+            Morton keys         21 bits per axis, one key per body
+            sort                least significant digit radix sort, per thread histograms
+            nodes               recursive split of the sorted keys, big subtrees become OpenMP tasks
+
+    levels where every body falls into the same octant are skipped, so every internal node has at least two children
+    and the tree never holds more than 2N nodes, however clustered the bodies are
+
+    build is collective like ForceSolver::computeAccelerations, every thread of the enclosing region calls it
+*/
+class Octree
+{
+public:
+        std::vector<OctreeNode> nodes;     // nodes[0] is the root
+        std::vector<std::uint32_t> order;  // order[k] is the store index of the k-th body in Morton order
+        std::vector<double> x, y, z, mass; // positions and masses in Morton order, so a leaf reads its bodies contiguously
+
+        explicit Octree(std::size_t leafCapacity = 16);
+
+        void build(const BodyStore &store);
+        std::size_t nodeCount() const { return usedNodes.load(); }
+
+private:
+        std::size_t leafCapacity;          // most bodies a leaf holds, unless they share one key
+        std::vector<std::uint64_t> keys, keyScratch;
+        std::vector<std::uint32_t> orderScratch;
+        std::vector<double> bounds;        // per thread min x, y, z and max x, y, z
+        std::vector<std::size_t> histograms;
+        double rootX = 0.0, rootY = 0.0, rootZ = 0.0, rootSize = 1.0;
+        std::atomic<int> usedNodes{0};
+
+        void computeBounds(const BodyStore &store);
+        void computeKeys(const BodyStore &store);
+        void sortKeys();
+        void buildNode(int nodeIndex, std::uint32_t begin, std::uint32_t end);
+        void setCube(OctreeNode &node, std::uint64_t key, int level) const;
+};
+
+#endif
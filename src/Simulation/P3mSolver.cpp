@@ -0,0 +1,166 @@
+/**
+ * This file contains the implementation of the P3mSolver class, the mesh plus short range direct sum
+ *
+ * the link cells cover the same cube as the mesh and are at least half a cutoff wide, so every body closer than
+ * the cutoff sits within two cells along each axis, and the five x neighbours of a row are one contiguous run
+ * of the cell ordered arrays
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "P3mSolver.h"
+using namespace std;
+
+const size_t SHORT_RANGE_TABLE_SIZE = 2048;  // linear interpolation in r^2 is good to about 1e-7 at this size, the last step falls to 0
+const int NEIGHBOUR_REACH = 2;               // cells searched on each side, cells are half a cutoff wide
+const size_t CELLS_PER_CHUNK = 2;            // target cells taken at a time, a crowded cell costs as much as many empty ones
+
+P3mSolver::P3mSolver(size_t gridSize, MassAssignment assignment, double splitScale, double cutoff, SimdLevel level, bool deterministic)
+    : mesh(gridSize, assignment, splitScale, deterministic), splitScale(splitScale), cutoffScale(cutoff), kernel(shortRangeKernelFor(level))
+{
+    if (splitScale <= 0.0)
+    {
+        throw invalid_argument("P3M needs a positive split scale");
+    }
+    if (cutoff <= 0.0)
+    {
+        throw invalid_argument("P3M needs a positive cutoff");
+    }
+
+    // the factor only depends on r / rs, so the table is built once against r^2 / cutoff^2,
+    // it ends in zeros from the cutoff on, so pairs beyond it need no branch of their own in the sum
+    shortRangeTable.assign(SHORT_RANGE_TABLE_SIZE + 1, 0.0);
+    for (size_t k = 0; k + 1 < SHORT_RANGE_TABLE_SIZE; k++)
+    {
+        const double q = cutoffScale * sqrt(double(k) / double(SHORT_RANGE_TABLE_SIZE - 1)); // r / rs
+        shortRangeTable[k] = erfc(0.5 * q) + q / sqrt(M_PI) * exp(-0.25 * q * q);
+    }
+}
+
+/**
+ * @brief long range part from the mesh, then the short range part added on top
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void P3mSolver::computeAccelerations(BodyStore &store)
+{
+    if (store.size() == 0)
+    {
+        return;
+    }
+    mesh.computeAccelerations(store);
+    buildCells(store);
+    addShortRange(store);
+}
+
+/**
+ * @brief sorts the bodies into link cells laid over the mesh, counting sort by one thread, the rest in parallel
+ */
+void P3mSolver::buildCells(const BodyStore &store)
+{
+    const size_t n = store.size();
+    #pragma omp single
+    {
+        const double rs = splitScale * mesh.meshSpacing();
+        const double cutoff = cutoffScale * rs;
+        const double extent = double(mesh.gridSize() - 1) * mesh.meshSpacing();
+        cutoff2 = cutoff * cutoff;
+        cellsPerAxis = max<size_t>(1, static_cast<size_t>(extent / (0.5 * cutoff)));
+        cellSide = extent / double(cellsPerAxis);
+        mesh.meshOrigin(cellOriginX, cellOriginY, cellOriginZ);
+
+        cellOf.resize(n);
+        order.resize(n);
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        mass.resize(n);
+    }
+
+    const double inverseSide = 1.0 / cellSide;
+    const long last = static_cast<long>(cellsPerAxis) - 1;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        const long cx = min(last, max(0L, static_cast<long>((store.x[i] - cellOriginX) * inverseSide)));
+        const long cy = min(last, max(0L, static_cast<long>((store.y[i] - cellOriginY) * inverseSide)));
+        const long cz = min(last, max(0L, static_cast<long>((store.z[i] - cellOriginZ) * inverseSide)));
+        cellOf[i] = static_cast<uint32_t>((cz * cellsPerAxis + cy) * cellsPerAxis + cx);
+    }
+
+    #pragma omp single
+    {
+        const size_t cells = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+        cellStart.assign(cells + 1, 0);
+        for (size_t i = 0; i < n; i++)
+        {
+            cellStart[cellOf[i] + 1]++;
+        }
+        for (size_t c = 0; c < cells; c++)
+        {
+            cellStart[c + 1] += cellStart[c];
+        }
+        vector<uint32_t> next(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < n; i++)
+        {
+            order[next[cellOf[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < n; k++)
+    {
+        const uint32_t i = order[k];
+        x[k] = store.x[i];
+        y[k] = store.y[i];
+        z[k] = store.z[i];
+        mass[k] = store.mass[i];
+    }
+}
+
+/**
+ * @brief adds the short range pull of every body within the cutoff, target cells are shared out between the threads
+ */
+void P3mSolver::addShortRange(BodyStore &store) const
+{
+    const double tableScale = double(SHORT_RANGE_TABLE_SIZE - 1) / cutoff2;
+    const double tableEnd = double(SHORT_RANGE_TABLE_SIZE - 1);
+    const long cells = static_cast<long>(cellsPerAxis);
+    const double *table = shortRangeTable.data();
+
+    loop.run(size_t(cells * cells * cells), CELLS_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (long c = long(begin); c < long(end); c++)
+        {
+            if (cellStart[c] == cellStart[c + 1])
+            {
+                continue;
+            }
+            const long cx = c % cells, cy = (c / cells) % cells, cz = c / (cells * cells);
+            const long lowX = max(0L, cx - NEIGHBOUR_REACH), highX = min(cells - 1, cx + NEIGHBOUR_REACH);
+
+            for (uint32_t k = cellStart[c]; k < cellStart[c + 1]; k++)
+            {
+                const double xi = x[k], yi = y[k], zi = z[k];
+                double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+                for (long nz = max(0L, cz - NEIGHBOUR_REACH); nz <= min(cells - 1, cz + NEIGHBOUR_REACH); nz++)
+                {
+                    for (long ny = max(0L, cy - NEIGHBOUR_REACH); ny <= min(cells - 1, cy + NEIGHBOUR_REACH); ny++)
+                    {
+                        const long row = (nz * cells + ny) * cells;
+                        const uint32_t first = cellStart[row + lowX], last = cellStart[row + highX + 1];
+                        kernel(x.data() + first, y.data() + first, z.data() + first, mass.data() + first, last - first, xi, yi, zi,
+                               table, tableScale, tableEnd, sumX, sumY, sumZ);
+                    }
+                }
+
+                const uint32_t i = order[k];
+                const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+                store.ax[i] += scale * sumX;
+                store.ay[i] += scale * sumY;
+                store.az[i] += scale * sumZ;
+            }
+        }
+    });
+}
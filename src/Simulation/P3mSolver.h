@@ -0,0 +1,55 @@
+#ifndef P3M_SOLVER_H
+#define P3M_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ForceSolver.h"
+#include "PmSolver.h"
+#include "SimdKernels.h"
+
+/*
+    P3mSolver class:
+        particle-particle particle-mesh gravity, the pull of every body split at the scale rs
+            long range      erf(r / 2rs) / r, smooth on the mesh scale, left to a PmSolver
+            short range     the rest, 1 / r times erfc(r / 2rs) + r / (rs sqrt(pi)) exp(-r^2 / 4rs^2) on the force,
+                            summed directly over the bodies closer than the cutoff, found through a cell linked list
+
+    rs is given in mesh cells and the cutoff in units of rs, the short range factor has fallen to 0.6% at the
+    default 5 rs, so close pairs (a moon and its planet) get the direct sum's accuracy while far pairs cost a mesh
+    a finer mesh shrinks rs with it, which keeps the short range sum cheap as N grows
+
+    the short range factor is tabulated against r^2 and the pairs are summed by the vectorized short range kernel,
+    the link cells are half a cutoff wide
+
+    the short range sum adds every target's pairs in cell order on one thread, the deterministic flag only changes the mesh deposit
+*/
+class P3mSolver : public ForceSolver
+{
+public:
+        explicit P3mSolver(std::size_t gridSize = 64, MassAssignment assignment = MassAssignment::TSC,
+                           double splitScale = 1.25, double cutoff = 5.0, SimdLevel level = detectSimdLevel(), bool deterministic = false);
+
+        const char *name() const override { return "p3m"; }
+        void computeAccelerations(BodyStore &store) override;
+
+private:
+        PmSolver mesh;
+        double splitScale;                       // rs in mesh cells
+        double cutoffScale;                      // cutoff in units of rs
+        ShortRangeKernel kernel;
+        std::vector<double> shortRangeTable;     // short range factor at r^2 = cutoff^2 * k / (SHORT_RANGE_TABLE_SIZE - 1)
+
+        double cutoff2 = 0.0;                    // this step's cutoff, squared
+        double cellOriginX = 0.0, cellOriginY = 0.0, cellOriginZ = 0.0, cellSide = 1.0;
+        std::size_t cellsPerAxis = 1;
+        std::vector<std::uint32_t> cellOf;       // link cell of every body, in store order
+        std::vector<std::uint32_t> cellStart;    // bodies of cell c are [cellStart[c], cellStart[c + 1]) in cell order
+        std::vector<std::uint32_t> order;        // order[k] is the store index of the k-th body in cell order
+        std::vector<double> x, y, z, mass;       // positions and masses in cell order
+
+        void buildCells(const BodyStore &store);
+        void addShortRange(BodyStore &store) const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * This file contains the implementation of the PairTileSolver class, the 2D tiled O(N^2) force sum for small N
+ *
+ * every thread owns exactly one tile and one column block of partials is written by exactly one tile per row block,
+ * so neither pass needs a schedule, the thread number alone says what to do
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <omp.h>
+#include "PairTileSolver.h"
+using namespace std;
+
+const size_t DOUBLES_PER_CACHE_LINE = 8;
+
+PairTileSolver::PairTileSolver(SimdLevel level, Softening softening) : kernel(sourceKernelFor(level, softening)) {}
+
+/**
+ * @brief computes the acceleration of every body, one tile of the pair matrix per thread, then one slice of the targets
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void PairTileSolver::computeAccelerations(BodyStore &store)
+{
+    const size_t n = store.size();
+    const int threads = omp_get_num_threads();
+
+    // no thread writes the layout before every thread has compared it, so all of them take the same branch
+    if (layoutBodies != n || layoutThreads != threads)
+    {
+        #pragma omp barrier
+        #pragma omp single
+        layout(n, threads);
+    }
+
+    const int self = omp_get_thread_num();
+    const int row = self / columnBlocks, column = self % columnBlocks;
+    const size_t targetBegin = n * row / rowBlocks, targetEnd = n * (row + 1) / rowBlocks;
+    const size_t sourceBegin = n * column / columnBlocks, sourceEnd = n * (column + 1) / columnBlocks;
+    const double *x = store.x.data(), *y = store.y.data(), *z = store.z.data(), *mass = store.mass.data();
+    double *partX = &partials[3 * stride * column];
+    double *partY = partX + stride;
+    double *partZ = partY + stride;
+
+    for (size_t i = targetBegin; i < targetEnd; i++)
+    {
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+        kernel(x + sourceBegin, y + sourceBegin, z + sourceBegin, mass + sourceBegin, sourceEnd - sourceBegin, x[i], y[i], z[i], sumX, sumY, sumZ);
+        partX[i] = sumX;
+        partY[i] = sumY;
+        partZ[i] = sumZ;
+    }
+    #pragma omp barrier
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+        for (int c = 0; c < columnBlocks; c++)
+        {
+            const double *block = &partials[3 * stride * c];
+            sumX += block[i];
+            sumY += block[stride + i];
+            sumZ += block[2 * stride + i];
+        }
+        const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+        store.ax[i] = scale * sumX;
+        store.ay[i] = scale * sumY;
+        store.az[i] = scale * sumZ;
+    }
+}
+
+/**
+ * @brief splits the pair matrix into as square a grid of tiles as the thread count allows and sizes the partials
+ */
+void PairTileSolver::layout(size_t n, int threads)
+{
+    rowBlocks = 1;
+    for (int r = 1; r * r <= threads; r++)
+    {
+        if (threads % r == 0)
+        {
+            rowBlocks = r;
+        }
+    }
+    columnBlocks = threads / rowBlocks;
+    stride = ((n + DOUBLES_PER_CACHE_LINE - 1) / DOUBLES_PER_CACHE_LINE + 1) * DOUBLES_PER_CACHE_LINE;
+    partials.assign(3 * stride * columnBlocks, 0.0);
+    layoutBodies = n;
+    layoutThreads = threads;
+}
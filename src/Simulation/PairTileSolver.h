@@ -0,0 +1,42 @@
+#ifndef PAIR_TILE_SOLVER_H
+#define PAIR_TILE_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+#include "ForcePolicy.h"
+#include "ForceSolver.h"
+#include "SimdKernels.h"
+
+/*
+    PairTileSolver class:
+        O(N^2) sum for runs with only a handful of bodies per thread, the N x N matrix of pairs is cut into
+        one 2D tile per thread instead of handing every thread a few whole rows
+            tiles       R x C = T tiles, R the largest divisor of T not above its square root, tile (r, c) pulls the
+                        targets of row block r towards the sources of column block c with the SIMD kernel,
+                        into its own cache line padded column of partial sums
+            reduction   after one barrier every thread adds the C partials of its share of the targets
+        a step of the force costs two barriers and no allocation, the layout is only rebuilt when N or the
+        thread count changes, so 32 bodies on 32 threads do 32 pairs each instead of one row of 32 and a wait
+
+    auto picks it when there are fewer than PAIR_TILE_BODIES_PER_THREAD bodies per thread
+*/
+class PairTileSolver : public ForceSolver
+{
+public:
+        explicit PairTileSolver(SimdLevel level = detectSimdLevel(), Softening softening = Softening::Clamped);
+
+        const char *name() const override { return "pairtiles"; }
+        void computeAccelerations(BodyStore &store) override;
+
+private:
+        SourceKernel kernel;
+        std::vector<double> partials;  // x, y, z partial accelerations of every column block, one block after the other
+        std::size_t stride = 0;        // doubles per component in a block, whole cache lines plus one line of padding
+        std::size_t layoutBodies = 0;  // the N the layout was built for
+        int layoutThreads = 0;         // the thread count it was built for
+        int rowBlocks = 1, columnBlocks = 1;
+
+        void layout(std::size_t n, int threads);
+};
+
+#endif
@@ -0,0 +1,403 @@
+/**
+ * This file contains the implementation of the PmSolver class, the particle mesh solver
+ *
+ * mesh point (i, j, k) sits at origin + spacing * (i, j, k), a body at grid coordinate u = (x - origin) / spacing,
+ * the mesh is placed so every u lies in [MESH_MARGIN, grid - 1 - MESH_MARGIN], which keeps the assignment stencil
+ * and the differences around it inside the unpadded grid^3 corner of the padded mesh
+ *
+ * the potential is psi = sum of m / r, the acceleration G * multiplier * grad psi, as for the direct sum
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <omp.h>
+#include "PmSolver.h"
+using namespace std;
+
+const int MESH_MARGIN = 3;          // a TSC point is 1 from the nearest point, the differences read 2 further
+const size_t MIN_GRID_SIZE = 16;
+
+/**
+ * @brief the first mesh point the stencil of grid coordinate u touches and the weights along one axis
+ * @return the stencil width, 2 for CIC, 3 for TSC
+ */
+static inline int stencil(MassAssignment assignment, double u, int &first, double weights[3])
+{
+    if (assignment == MassAssignment::CIC)
+    {
+        const double cell = floor(u);
+        const double f = u - cell;
+        first = static_cast<int>(cell);
+        weights[0] = 1.0 - f;
+        weights[1] = f;
+        return 2;
+    }
+    const double nearest = floor(u + 0.5);
+    const double d = u - nearest;
+    first = static_cast<int>(nearest) - 1;
+    weights[0] = 0.5 * (0.5 - d) * (0.5 - d);
+    weights[1] = 0.75 - d * d;
+    weights[2] = 0.5 * (0.5 + d) * (0.5 + d);
+    return 3;
+}
+
+PmSolver::PmSolver(size_t gridSize, MassAssignment assignment, double splitScale, bool deterministic)
+    : grid(gridSize), assignment(assignment), splitScale(splitScale), deterministic(deterministic), fft(2 * max<size_t>(gridSize, 1))
+{
+    if (grid < MIN_GRID_SIZE || (grid & (grid - 1)) != 0)
+    {
+        throw invalid_argument("Mesh grid size must be a power of two, at least " + to_string(MIN_GRID_SIZE));
+    }
+    if (splitScale < 0.0)
+    {
+        throw invalid_argument("Split scale cannot be negative");
+    }
+}
+
+/**
+ * @brief position of mesh point (0, 0, 0) in the last step
+ */
+void PmSolver::meshOrigin(double &x, double &y, double &z) const
+{
+    x = originX;
+    y = originY;
+    z = originZ;
+}
+
+/**
+ * @brief deposits the masses, solves for the potential and sets every body's acceleration from its gradient
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void PmSolver::computeAccelerations(BodyStore &store)
+{
+    if (store.size() == 0)
+    {
+        return;
+    }
+
+    const size_t padded = 2 * grid;
+    #pragma omp single
+    {
+        density.resize(padded * padded * padded);
+        forceX.resize(grid * grid * grid);
+        forceY.resize(grid * grid * grid);
+        forceZ.resize(grid * grid * grid);
+    }
+
+    if (!greenReady)
+    {
+        buildGreen();
+    }
+    placeMesh(store);
+    if (deterministic)
+    {
+        depositByPlanes(store);
+    }
+    else
+    {
+        deposit(store);
+    }
+    convolve();
+    differentiate();
+    interpolate(store);
+}
+
+/**
+ * @brief transforms 1 / r at unit spacing over the padded mesh, r measured to the nearest periodic copy of the origin
+ * so the transform is real, done once as the mesh spacing only scales it, the split scale is in cells for the same reason
+ */
+void PmSolver::buildGreen()
+{
+    const size_t padded = 2 * grid;
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < padded; k++)
+    {
+        const double dz = double(min(k, padded - k));
+        for (size_t j = 0; j < padded; j++)
+        {
+            const double dy = double(min(j, padded - j));
+            for (size_t i = 0; i < padded; i++)
+            {
+                const double dx = double(min(i, padded - i));
+                const double r = sqrt(dx * dx + dy * dy + dz * dz);
+                double value;
+                if (splitScale > 0.0)
+                {
+                    value = r > 0.0 ? erf(0.5 * r / splitScale) / r : 1.0 / (splitScale * sqrt(M_PI)); // the limit at 0
+                }
+                else
+                {
+                    value = r > 0.0 ? 1.0 / r : 1.0; // a body's own point, only shifts the potential, forces come from differences
+                }
+                density[(k * padded + j) * padded + i] = value;
+            }
+        }
+    }
+    fft.transform3d(density.data(), false, padded);
+
+    #pragma omp single
+    green.resize(density.size());
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < density.size(); k++)
+    {
+        green[k] = density[k].real();
+    }
+    #pragma omp single
+    greenReady = true;
+}
+
+/**
+ * @brief lays the mesh over the bounding cube of the bodies, each thread scans its share and one thread combines them
+ */
+void PmSolver::placeMesh(const BodyStore &store)
+{
+    const int threads = omp_get_num_threads(), t = omp_get_thread_num();
+    const size_t begin = store.size() * t / threads, end = store.size() * (t + 1) / threads;
+
+    #pragma omp single
+    bounds.resize(6 * threads);
+
+    double lowX = numeric_limits<double>::infinity(), lowY = lowX, lowZ = lowX;
+    double highX = -lowX, highY = -lowX, highZ = -lowX;
+    for (size_t i = begin; i < end; i++)
+    {
+        lowX = min(lowX, store.x[i]);
+        lowY = min(lowY, store.y[i]);
+        lowZ = min(lowZ, store.z[i]);
+        highX = max(highX, store.x[i]);
+        highY = max(highY, store.y[i]);
+        highZ = max(highZ, store.z[i]);
+    }
+    double *own = &bounds[6 * t];
+    own[0] = lowX;
+    own[1] = lowY;
+    own[2] = lowZ;
+    own[3] = highX;
+    own[4] = highY;
+    own[5] = highZ;
+
+    #pragma omp barrier
+    #pragma omp single
+    {
+        for (int other = 1; other < threads; other++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                bounds[axis] = min(bounds[axis], bounds[6 * other + axis]);
+                bounds[3 + axis] = max(bounds[3 + axis], bounds[6 * other + 3 + axis]);
+            }
+        }
+        double extent = max(bounds[3] - bounds[0], max(bounds[4] - bounds[1], bounds[5] - bounds[2]));
+        if (!(extent > 0.0))
+        {
+            extent = 1.0; // a single body or all of them in one spot, any spacing will do
+        }
+        // the last usable point is grid - 1 - MESH_MARGIN, with a little slack so rounding never pushes a body past it
+        spacing = extent / (double(grid - 1 - 2 * MESH_MARGIN) - 0.5);
+        originX = bounds[0] - MESH_MARGIN * spacing;
+        originY = bounds[1] - MESH_MARGIN * spacing;
+        originZ = bounds[2] - MESH_MARGIN * spacing;
+    }
+}
+
+/**
+ * @brief clears the padded mesh and spreads every body's mass onto it, bodies whose stencils overlap add atomically
+ */
+void PmSolver::deposit(const BodyStore &store)
+{
+    const size_t padded = 2 * grid;
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < density.size(); k++)
+    {
+        density[k] = 0.0;
+    }
+
+    double *values = reinterpret_cast<double *>(density.data()); // real parts at even offsets
+    const double inverseSpacing = 1.0 / spacing;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        int firstX, firstY, firstZ;
+        double weightX[3], weightY[3], weightZ[3];
+        const int width = stencil(assignment, (store.x[i] - originX) * inverseSpacing, firstX, weightX);
+        stencil(assignment, (store.y[i] - originY) * inverseSpacing, firstY, weightY);
+        stencil(assignment, (store.z[i] - originZ) * inverseSpacing, firstZ, weightZ);
+
+        for (int c = 0; c < width; c++)
+        {
+            for (int b = 0; b < width; b++)
+            {
+                const double massYZ = store.mass[i] * weightZ[c] * weightY[b];
+                const size_t row = ((firstZ + c) * padded + (firstY + b)) * padded + firstX;
+                for (int a = 0; a < width; a++)
+                {
+                    #pragma omp atomic
+                    values[2 * (row + a)] += massYZ * weightX[a];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief deposit of the deterministic mode, the bodies are sorted by the first plane of their stencil by one thread,
+ * then every plane is filled by one thread, stencil row by stencil row, each in body order
+ */
+void PmSolver::depositByPlanes(const BodyStore &store)
+{
+    const size_t n = store.size(), padded = 2 * grid;
+    #pragma omp single
+    {
+        firstPlane.resize(n);
+        planeBodies.resize(n);
+    }
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < density.size(); k++)
+    {
+        density[k] = 0.0;
+    }
+
+    const double inverseSpacing = 1.0 / spacing;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        double weightZ[3];
+        stencil(assignment, (store.z[i] - originZ) * inverseSpacing, firstPlane[i], weightZ);
+    }
+
+    #pragma omp single
+    {
+        planeStart.assign(grid + 1, 0);
+        for (size_t i = 0; i < n; i++)
+        {
+            planeStart[firstPlane[i] + 1]++;
+        }
+        for (size_t p = 0; p < grid; p++)
+        {
+            planeStart[p + 1] += planeStart[p];
+        }
+        vector<uint32_t> next(planeStart.begin(), planeStart.end() - 1);
+        for (size_t i = 0; i < n; i++)
+        {
+            planeBodies[next[firstPlane[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    double *values = reinterpret_cast<double *>(density.data()); // real parts at even offsets
+    const int width = assignment == MassAssignment::CIC ? 2 : 3;
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t plane = 0; plane < grid; plane++)
+    {
+        for (int c = 0; c < width && size_t(c) <= plane; c++)
+        {
+            const size_t from = plane - c; // bodies whose stencil row c lies in this plane
+            for (size_t k = planeStart[from]; k < planeStart[from + 1]; k++)
+            {
+                const uint32_t i = planeBodies[k];
+                int firstX, firstY, firstZ;
+                double weightX[3], weightY[3], weightZ[3];
+                stencil(assignment, (store.x[i] - originX) * inverseSpacing, firstX, weightX);
+                stencil(assignment, (store.y[i] - originY) * inverseSpacing, firstY, weightY);
+                stencil(assignment, (store.z[i] - originZ) * inverseSpacing, firstZ, weightZ);
+
+                for (int b = 0; b < width; b++)
+                {
+                    const double massYZ = store.mass[i] * weightZ[c] * weightY[b];
+                    const size_t row = (plane * padded + (firstY + b)) * padded + firstX;
+                    for (int a = 0; a < width; a++)
+                    {
+                        values[2 * (row + a)] += massYZ * weightX[a];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief turns the density into the potential, psi = sum of m / r
+ */
+void PmSolver::convolve()
+{
+    const size_t padded = 2 * grid;
+    fft.transform3d(density.data(), false, grid);
+
+    // 1 / r at this spacing is green / spacing, the forward and inverse transforms scale by padded^3
+    const double scale = 1.0 / (spacing * double(padded) * double(padded) * double(padded));
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < density.size(); k++)
+    {
+        density[k] *= green[k] * scale;
+    }
+
+    fft.transform3d(density.data(), true, grid);
+}
+
+/**
+ * @brief four point central differences of the potential at every point a stencil can reach
+ */
+void PmSolver::differentiate()
+{
+    const size_t padded = 2 * grid;
+    const double inverse12 = 1.0 / (12.0 * spacing);
+    auto psi = [this, padded](size_t i, size_t j, size_t k) { return density[(k * padded + j) * padded + i].real(); };
+
+    #pragma omp for schedule(static)
+    for (size_t k = 2; k < grid - 2; k++)
+    {
+        for (size_t j = 2; j < grid - 2; j++)
+        {
+            for (size_t i = 2; i < grid - 2; i++)
+            {
+                const size_t point = (k * grid + j) * grid + i;
+                forceX[point] = (8.0 * (psi(i + 1, j, k) - psi(i - 1, j, k)) - (psi(i + 2, j, k) - psi(i - 2, j, k))) * inverse12;
+                forceY[point] = (8.0 * (psi(i, j + 1, k) - psi(i, j - 1, k)) - (psi(i, j + 2, k) - psi(i, j - 2, k))) * inverse12;
+                forceZ[point] = (8.0 * (psi(i, j, k + 1) - psi(i, j, k - 1)) - (psi(i, j, k + 2) - psi(i, j, k - 2))) * inverse12;
+            }
+        }
+    }
+}
+
+/**
+ * @brief reads the mesh force back at every body with its deposit stencil
+ */
+void PmSolver::interpolate(BodyStore &store) const
+{
+    const double inverseSpacing = 1.0 / spacing;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        int firstX, firstY, firstZ;
+        double weightX[3], weightY[3], weightZ[3];
+        const int width = stencil(assignment, (store.x[i] - originX) * inverseSpacing, firstX, weightX);
+        stencil(assignment, (store.y[i] - originY) * inverseSpacing, firstY, weightY);
+        stencil(assignment, (store.z[i] - originZ) * inverseSpacing, firstZ, weightZ);
+
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+        for (int c = 0; c < width; c++)
+        {
+            for (int b = 0; b < width; b++)
+            {
+                const double weightYZ = weightZ[c] * weightY[b];
+                const size_t row = ((firstZ + c) * grid + (firstY + b)) * grid + firstX;
+                for (int a = 0; a < width; a++)
+                {
+                    const double w = weightYZ * weightX[a];
+                    sumX += w * forceX[row + a];
+                    sumY += w * forceY[row + a];
+                    sumZ += w * forceZ[row + a];
+                }
+            }
+        }
+
+        const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+        store.ax[i] = scale * sumX;
+        store.ay[i] = scale * sumY;
+        store.az[i] = scale * sumZ;
+    }
+}
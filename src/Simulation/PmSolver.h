@@ -0,0 +1,77 @@
+#ifndef PM_SOLVER_H
+#define PM_SOLVER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Fft.h"
+#include "ForceSolver.h"
+
+// how a body's mass is spread onto the mesh points around it, and how the mesh force is read back
+enum class MassAssignment
+{
+        CIC, // cloud in cell, the 2 x 2 x 2 points around the body, linear weights
+        TSC  // triangular shaped cloud, the 3 x 3 x 3 points around the nearest one, quadratic weights
+};
+
+/*
+    PmSolver class:
+        particle mesh gravity, O(N + G^3 log G) for a G^3 mesh laid over the bodies every step
+            deposit         the masses are spread onto the mesh with the assignment scheme
+            convolution     the density is zero padded to (2G)^3 and multiplied in Fourier space with the transform of 1 / r,
+                            so the potential is the isolated one, without the periodic images a plain mesh would add
+            differentiation four point central differences give the mesh force
+            interpolation   the mesh force is read back with the same assignment scheme, so pair forces stay antisymmetric
+                            and the mesh conserves momentum
+
+    forces are smoothed over a couple of mesh cells, so the solver is meant for large smooth distributions,
+    a lone planet next to its star sees a far weaker pull than the direct sum gives it
+
+    with a split scale s (in mesh cells) the mesh only carries the long range part erf(r / 2s) / r of the potential,
+    which is smooth on the mesh scale, and P3mSolver adds the short range rest
+
+    deterministic runs deposit by mesh plane instead of with atomics, each plane written by one thread from the bodies
+    whose stencils reach it, in body order, so the density and the forces do not depend on the thread count
+
+    the padded mesh costs 16 bytes per point, (2G)^3 points, 128 MB at G = 128
+*/
+class PmSolver : public ForceSolver
+{
+public:
+        explicit PmSolver(std::size_t gridSize = 64, MassAssignment assignment = MassAssignment::CIC, double splitScale = 0.0, bool deterministic = false);
+
+        const char *name() const override { return assignment == MassAssignment::CIC ? "pm (cic)" : "pm (tsc)"; }
+        void computeAccelerations(BodyStore &store) override;
+
+        std::size_t gridSize() const { return grid; }
+        double meshSpacing() const { return spacing; }
+        void meshOrigin(double &x, double &y, double &z) const;
+
+private:
+        std::size_t grid;                          // mesh points per axis
+        MassAssignment assignment;
+        double splitScale;                         // in mesh cells, 0 for the whole 1 / r
+        bool deterministic;                        // deposit plane by plane
+        Fft fft;                                   // length 2 * grid
+        bool greenReady = false;
+
+        std::vector<std::complex<double>> density; // the padded mesh, turned into the potential in place
+        std::vector<double> green;                 // transform of 1 / r (or its long range part) at unit spacing, real as it is even
+        std::vector<double> forceX, forceY, forceZ; // gradient of the potential at the grid^3 unpadded points
+        std::vector<double> bounds;                // per thread min x, y, z and max x, y, z
+        std::vector<int> firstPlane;               // first mesh plane of every body's stencil, deterministic deposit only
+        std::vector<std::uint32_t> planeStart;     // bodies whose stencils start at plane p are planeBodies[planeStart[p] .. planeStart[p + 1])
+        std::vector<std::uint32_t> planeBodies;    // the bodies by first plane, in store order within a plane
+        double originX = 0.0, originY = 0.0, originZ = 0.0, spacing = 1.0;
+
+        void buildGreen();
+        void placeMesh(const BodyStore &store);
+        void deposit(const BodyStore &store);
+        void depositByPlanes(const BodyStore &store);
+        void convolve();
+        void differentiate();
+        void interpolate(BodyStore &store) const;
+};
+
+#endif
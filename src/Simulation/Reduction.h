@@ -0,0 +1,54 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <cmath>
+#include <cstddef>
+
+const std::size_t DETERMINISTIC_BLOCKS = 64; // blocks a deterministic sum is split into, whatever the thread count
+
+/*
+    fixed order reductions:
+        a sum whose terms are shared out between threads is added in an order that depends on the thread count,
+        so runs on different counts drift apart in the last bits, the deterministic mode splits the terms into
+        DETERMINISTIC_BLOCKS blocks fixed by the number of terms only, any thread sums a whole block in order,
+        and the block sums are added pairwise in a fixed tree, the same on one thread as on sixty four
+*/
+
+/**
+ * @brief the first of n items in block b of blocks equal runs
+ */
+inline std::size_t blockBegin(std::size_t n, std::size_t b, std::size_t blocks)
+{
+    return n * b / blocks;
+}
+
+/**
+ * @brief the first row of block b when the rows i of the triangle {(i, j) : i < j < n} are split into blocks of equal pair counts
+ *
+ * rows before r hold n r - r (r + 1) / 2 pairs, so block b starts where that reaches b / blocks of the n (n - 1) / 2 pairs
+ */
+inline std::size_t triangleBlockBegin(std::size_t n, std::size_t b, std::size_t blocks)
+{
+    if (b >= blocks)
+    {
+        return n;
+    }
+    const double half = double(n) - 0.5, share = double(b) / double(blocks);
+    const double row = half - std::sqrt(half * half - share * double(n) * (double(n) - 1.0));
+    return row <= 0.0 ? 0 : (row >= double(n) ? n : static_cast<std::size_t>(row));
+}
+
+/**
+ * @brief values[0], values[stride], ... values[(count - 1) stride] added pairwise, halves first, a fixed tree for every count
+ */
+inline double pairwiseSum(const double *values, std::size_t count, std::size_t stride = 1)
+{
+    if (count <= 2)
+    {
+        return count == 0 ? 0.0 : (count == 1 ? values[0] : values[0] + values[stride]);
+    }
+    const std::size_t half = count / 2;
+    return pairwiseSum(values, half, stride) + pairwiseSum(values + half * stride, count - half, stride);
+}
+
+#endif
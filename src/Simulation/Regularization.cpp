@@ -0,0 +1,498 @@
+/**
+ * This file contains the Kustaanheimo-Stiefel pair drift and the algorithmic chain drift of the regularized groups
+ *
+ * KS: with L(u) the KS matrix, R = L(u) u and u' = L(u)^T V / 2, an unperturbed pair of energy h = V^2 / 2 - mu / r
+ * moves as u(s) = u0 C(s) + u0' S(s), u'(s) = u0' C(s) - k u0 S(s), k = -h / 2, C and S the cosine and sine of
+ * sqrt(k) s (hyperbolic for k < 0, S divided by sqrt(k)), and the physical time is
+ *      t(s) = |u0|^2 (s + S C) / 2 + (u0.u0') S^2 + |u0'|^2 (s - S C) / (2 k)
+ * whose derivative is |u(s)|^2 = r > 0, so Newton's method on t(s) = dt always has a bracket to fall back on
+ *
+ * chain: with T the kinetic energy, U = sum G m_i m_j / r_ij and B = U - T the binding energy of the group, one step of
+ * length h in the fictitious time is a drift of h / 2 / (T + B), a kick of h / U, and a drift of h / 2 / (T + B),
+ * three of them make a fourth order step, a group that has not reached dt after CHAIN_STEP_LIMIT of them goes the rest
+ * of the way by the plain leapfrog in the physical time, in as many steps again at most
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Regularization.h"
+using namespace std;
+
+const double KS_SERIES = 0.1;               // below this |k s^2| the oscillator functions come from their series
+const int KS_ITERATIONS = 100;              // Newton with bisection, the limit only guards against NaNs
+const double CHAIN_STEPS_PER_ORBIT = 200.0; // fourth order fictitious time steps per orbit of the group's closest pair
+const long CHAIN_STEP_LIMIT = 10000000;     // a group that has not reached dt after this many steps finishes it unregularized
+const int CHAIN_LAST_STEP_ITERATIONS = 40;  // secant iterations that land the last step on dt
+
+/**
+ * @brief C(s), S(s) and Q(s) = (s - S C) / (2 k) of the KS oscillator with k = -h / 2
+ */
+static void oscillator(double k, double s, double &c, double &sine, double &q)
+{
+    const double x = k * s * s;
+    if (fabs(x) < KS_SERIES)
+    {
+        c = 1.0 - x / 2 * (1.0 - x / 12 * (1.0 - x / 30 * (1.0 - x / 56 * (1.0 - x / 90))));
+        sine = s * (1.0 - x / 6 * (1.0 - x / 20 * (1.0 - x / 42 * (1.0 - x / 72 * (1.0 - x / 110)))));
+        q = s * s * s * (1.0 / 3 - x * (1.0 / 15 - x * (2.0 / 315 - x * (1.0 / 2835 - x * (2.0 / 155925 - x / 3040538.0)))));
+        return;
+    }
+    if (k > 0.0)
+    {
+        const double omega = sqrt(k);
+        c = cos(omega * s);
+        sine = sin(omega * s) / omega;
+    }
+    else
+    {
+        const double omega = sqrt(-k);
+        c = cosh(omega * s);
+        sine = sinh(omega * s) / omega;
+    }
+    q = (s - sine * c) / (2.0 * k);
+}
+
+/**
+ * @brief moves an unperturbed pair along its orbit for dt, through its KS harmonic oscillator
+ * @param relative the second body's position relative to the first, in place
+ * @param velocity the second body's velocity relative to the first, in place
+ * @param mu G times the two masses
+ * @param dt the length of the drift
+ */
+void ksDrift(double relative[3], double velocity[3], double mu, double dt)
+{
+    const double x = relative[0], y = relative[1], z = relative[2];
+    const double r = sqrt(x * x + y * y + z * z);
+    if (!(dt > 0.0))
+    {
+        return;
+    }
+    if (r == 0.0 || !(mu > 0.0))
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            relative[d] += velocity[d] * dt; // nothing to orbit
+        }
+        return;
+    }
+
+    // the u with L(u) u = R, the branch that avoids dividing by a small component
+    double u[4];
+    if (x >= 0.0)
+    {
+        u[0] = sqrt(0.5 * (r + x));
+        u[1] = 0.5 * y / u[0];
+        u[2] = 0.5 * z / u[0];
+        u[3] = 0.0;
+    }
+    else
+    {
+        u[1] = sqrt(0.5 * (r - x));
+        u[0] = 0.5 * y / u[1];
+        u[3] = 0.5 * z / u[1];
+        u[2] = 0.0;
+    }
+    const double vx = velocity[0], vy = velocity[1], vz = velocity[2];
+    const double du[4] = {0.5 * (u[0] * vx + u[1] * vy + u[2] * vz), 0.5 * (-u[1] * vx + u[0] * vy + u[3] * vz),
+                          0.5 * (-u[2] * vx - u[3] * vy + u[0] * vz), 0.5 * (u[3] * vx - u[2] * vy + u[1] * vz)};
+
+    const double energy = 0.5 * (vx * vx + vy * vy + vz * vz) - mu / r, k = -0.5 * energy;
+    const double u2 = r, du2 = du[0] * du[0] + du[1] * du[1] + du[2] * du[2] + du[3] * du[3];
+    const double mixed = u[0] * du[0] + u[1] * du[1] + u[2] * du[2] + u[3] * du[3];
+    auto timeAt = [&](double s, double &c, double &sine)
+    {
+        double q;
+        oscillator(k, s, c, sine, q);
+        return u2 * 0.5 * (s + sine * c) + mixed * sine * sine + du2 * q;
+    };
+
+    // a bound pair repeats every period, pi / sqrt(k) in s
+    double time = dt, low = 0.0, high;
+    if (k > 0.0)
+    {
+        const double period = 2.0 * M_PI * mu / pow(-2.0 * energy, 1.5);
+        time = fmod(dt, period);
+        high = M_PI / sqrt(k);
+    }
+    else
+    {
+        // t(s) grows exponentially on a hyperbola, a bracket found from a few e-foldings keeps cosh finite
+        double c, sine;
+        high = k < 0.0 ? min(time / r, 10.0 / sqrt(-k)) : time / r;
+        while (timeAt(high, c, sine) < time)
+        {
+            low = high;
+            high *= 2.0;
+        }
+    }
+
+    // Newton's method, bisecting whenever a Newton step would leave the bracket or not halve the error
+    double s = min(max(time / r, low), high), c = 1.0, sine = 0.0, width = high - low, last = width;
+    for (int iteration = 0; iteration < KS_ITERATIONS; iteration++)
+    {
+        const double error = timeAt(s, c, sine) - time;
+        (error > 0.0 ? high : low) = s;
+        double ux = 0.0;
+        for (int d = 0; d < 4; d++)
+        {
+            const double ud = u[d] * c + du[d] * sine;
+            ux += ud * ud;
+        }
+        double next = s - error / ux;
+        if (!(next > low && next < high) || fabs(2.0 * error) > fabs(last * ux))
+        {
+            next = 0.5 * (low + high);
+        }
+        last = width;
+        width = fabs(next - s);
+        s = next;
+        if (width <= 1e-15 * s)
+        {
+            break;
+        }
+    }
+    timeAt(s, c, sine);
+
+    double un[4], dun[4];
+    for (int d = 0; d < 4; d++)
+    {
+        un[d] = u[d] * c + du[d] * sine;
+        dun[d] = du[d] * c - k * u[d] * sine;
+    }
+    const double rn = un[0] * un[0] + un[1] * un[1] + un[2] * un[2] + un[3] * un[3];
+    relative[0] = un[0] * un[0] - un[1] * un[1] - un[2] * un[2] + un[3] * un[3];
+    relative[1] = 2.0 * (un[0] * un[1] - un[2] * un[3]);
+    relative[2] = 2.0 * (un[0] * un[2] + un[1] * un[3]);
+    velocity[0] = 2.0 / rn * (un[0] * dun[0] - un[1] * dun[1] - un[2] * dun[2] + un[3] * dun[3]);
+    velocity[1] = 2.0 / rn * (un[1] * dun[0] + un[0] * dun[1] - un[3] * dun[2] - un[2] * dun[3]);
+    velocity[2] = 2.0 / rn * (un[2] * dun[0] + un[3] * dun[1] + un[0] * dun[2] + un[1] * dun[3]);
+}
+
+/*
+    the state of one chain drift, the bodies in chain order, chain vectors X_k = q_(k+1) - q_k and W_k = v_(k+1) - v_k
+*/
+struct Chain
+{
+    size_t n;
+    double gm;
+    vector<double> mass;
+    vector<double> X, W;         // 3 (n - 1) chain vectors of positions and velocities
+    vector<double> q, v, a;      // 3 n positions and velocities relative to the centre of mass, accelerations
+    double binding = 0.0;        // U - T, constant without outside forces
+
+    void positions()
+    {
+        unfold(X, q);
+    }
+
+    void velocities()
+    {
+        unfold(W, v);
+    }
+
+    // positions (or velocities) from the chain vectors, with the centre of mass at rest at the origin
+    void unfold(const vector<double> &chain, vector<double> &out) const
+    {
+        double total = 0.0, centre[3] = {0.0, 0.0, 0.0};
+        out[0] = out[1] = out[2] = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (int d = 0; d < 3; d++)
+            {
+                if (i > 0)
+                {
+                    out[3 * i + d] = out[3 * (i - 1) + d] + chain[3 * (i - 1) + d];
+                }
+                centre[d] += mass[i] * out[3 * i + d];
+            }
+            total += mass[i];
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            for (int d = 0; d < 3; d++)
+            {
+                out[3 * i + d] -= centre[d] / total;
+            }
+        }
+    }
+
+    double kinetic() const
+    {
+        double t = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            t += 0.5 * mass[i] * (v[3 * i] * v[3 * i] + v[3 * i + 1] * v[3 * i + 1] + v[3 * i + 2] * v[3 * i + 2]);
+        }
+        return t;
+    }
+
+    // the potential U, and the accelerations with neighbours along the chain taken from the chain vectors
+    double potential()
+    {
+        positions();
+        fill(a.begin(), a.end(), 0.0);
+        double u = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = i + 1; j < n; j++)
+            {
+                double d[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    d[c] = j == i + 1 ? X[3 * i + c] : j == i + 2 ? X[3 * i + c] + X[3 * (i + 1) + c] : q[3 * j + c] - q[3 * i + c];
+                }
+                const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2], r = sqrt(r2);
+                u += gm * mass[i] * mass[j] / r;
+                const double inverse3 = gm / (r2 * r);
+                for (int c = 0; c < 3; c++)
+                {
+                    a[3 * i + c] += inverse3 * mass[j] * d[c];
+                    a[3 * j + c] -= inverse3 * mass[i] * d[c];
+                }
+            }
+        }
+        return u;
+    }
+
+    // one logarithmic Hamiltonian leapfrog step of length h in the fictitious time, returns the physical time taken
+    double step(double h)
+    {
+        velocities();
+        const double first = 0.5 * h / (kinetic() + binding);
+        for (size_t k = 0; k < X.size(); k++)
+        {
+            X[k] += first * W[k];
+        }
+        const double kick = h / potential();
+        for (size_t k = 0; k + 1 < n; k++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                W[3 * k + c] += kick * (a[3 * (k + 1) + c] - a[3 * k + c]);
+            }
+        }
+        velocities();
+        const double second = 0.5 * h / (kinetic() + binding);
+        for (size_t k = 0; k < X.size(); k++)
+        {
+            X[k] += second * W[k];
+        }
+        return first + second;
+    }
+
+    // one plain drift-kick-drift leapfrog step of length tau in the physical time, the fallback past CHAIN_STEP_LIMIT
+    void physicalStep(double tau)
+    {
+        for (size_t k = 0; k < X.size(); k++)
+        {
+            X[k] += 0.5 * tau * W[k];
+        }
+        potential();
+        for (size_t k = 0; k + 1 < n; k++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                W[3 * k + c] += tau * (a[3 * (k + 1) + c] - a[3 * k + c]);
+            }
+        }
+        for (size_t k = 0; k < X.size(); k++)
+        {
+            X[k] += 0.5 * tau * W[k];
+        }
+    }
+
+    // the physical time in which the closest pair goes round 1 / CHAIN_STEPS_PER_ORBIT of its orbit, q must be current
+    double orbitStep() const
+    {
+        double shortest = INFINITY;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = i + 1; j < n; j++)
+            {
+                const double dx = q[3 * j] - q[3 * i], dy = q[3 * j + 1] - q[3 * i + 1], dz = q[3 * j + 2] - q[3 * i + 2];
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                shortest = min(shortest, sqrt(r2 * sqrt(r2) / (gm * (mass[i] + mass[j]))));
+            }
+        }
+        return 2.0 * M_PI * shortest / CHAIN_STEPS_PER_ORBIT;
+    }
+
+    // the step in fictitious time that would take the closest pair round in CHAIN_STEPS_PER_ORBIT steps, h / U being the time,
+    // sized afresh every step, a constant one is too long for the close approach of a third body, and none longer than
+    // the time left, a loose group would otherwise take one step far past it
+    double naturalStep(double remaining)
+    {
+        const double u = potential();
+        return min(orbitStep(), remaining) * u;
+    }
+
+    // the leapfrog is time symmetric, so Yoshida's triple jump of it is fourth order
+    double fourthOrderStep(double h)
+    {
+        const double outer = 1.0 / (2.0 - cbrt(2.0)), inner = 1.0 - 2.0 * outer;
+        return step(outer * h) + step(inner * h) + step(outer * h);
+    }
+};
+
+/**
+ * @brief moves a small unperturbed group along its orbits for dt, through the chain regularized leapfrog
+ * @param count the number of bodies
+ * @param mass the masses of the bodies
+ * @param gm G times the gravitational multiplier of the group
+ * @param x, y, z positions relative to the centre of mass, in place
+ * @param vx, vy, vz velocities relative to the centre of mass, in place
+ * @param dt the length of the drift
+ * @return the time the regularized steps reached, dt unless CHAIN_STEP_LIMIT cut them short and the leapfrog did the rest
+ */
+double chainDrift(size_t count, const double *mass, double gm, double *x, double *y, double *z, double *vx, double *vy, double *vz, double dt)
+{
+    if (count < 2 || !(dt > 0.0))
+    {
+        return dt;
+    }
+
+    // the chain, from the closest pair outwards, each end extended to its nearest body not yet in the chain
+    auto distance2 = [&](size_t i, size_t j)
+    {
+        const double dx = x[j] - x[i], dy = y[j] - y[i], dz = z[j] - z[i];
+        return dx * dx + dy * dy + dz * dz;
+    };
+    vector<size_t> order;
+    vector<bool> used(count, false);
+    size_t first = 0, second = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = i + 1; j < count; j++)
+        {
+            if (distance2(i, j) < distance2(first, second))
+            {
+                first = i;
+                second = j;
+            }
+        }
+    }
+    order = {first, second};
+    used[first] = used[second] = true;
+    while (order.size() < count)
+    {
+        size_t best = count;
+        bool front = false;
+        double closest = INFINITY;
+        for (size_t j = 0; j < count; j++)
+        {
+            if (used[j])
+            {
+                continue;
+            }
+            const double back = distance2(order.back(), j), ahead = distance2(order.front(), j);
+            if (min(back, ahead) < closest)
+            {
+                closest = min(back, ahead);
+                best = j;
+                front = ahead < back;
+            }
+        }
+        used[best] = true;
+        if (front)
+        {
+            order.insert(order.begin(), best);
+        }
+        else
+        {
+            order.push_back(best);
+        }
+    }
+
+    Chain chain;
+    chain.n = count;
+    chain.gm = gm;
+    chain.mass.resize(count);
+    chain.X.resize(3 * (count - 1));
+    chain.W.resize(3 * (count - 1));
+    chain.q.resize(3 * count);
+    chain.v.resize(3 * count);
+    chain.a.resize(3 * count);
+    const double *position[3] = {x, y, z}, *speed[3] = {vx, vy, vz};
+    for (size_t k = 0; k < count; k++)
+    {
+        chain.mass[k] = mass[order[k]];
+        if (k + 1 < count)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                chain.X[3 * k + c] = position[c][order[k + 1]] - position[c][order[k]];
+                chain.W[3 * k + c] = speed[c][order[k + 1]] - speed[c][order[k]];
+            }
+        }
+    }
+
+    const double potential = chain.potential();
+    if (!(potential > 0.0))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i] += vx[i] * dt; // massless, nothing to orbit
+            y[i] += vy[i] * dt;
+            z[i] += vz[i] * dt;
+        }
+        return dt;
+    }
+    chain.velocities();
+    chain.binding = potential - chain.kinetic();
+
+    double time = 0.0;
+    bool landed = false;
+    for (long steps = 0; steps < CHAIN_STEP_LIMIT && !landed; steps++)
+    {
+        const vector<double> savedX = chain.X, savedW = chain.W;
+        const double h = chain.naturalStep(dt - time);
+        const double taken = chain.fourthOrderStep(h);
+        if (time + taken < dt)
+        {
+            time += taken;
+            continue;
+        }
+
+        // the last step, its length in fictitious time found by the secant method so it ends on dt
+        const double remaining = dt - time;
+        double h0 = 0.0, t0 = 0.0, h1 = h, t1 = taken;
+        for (int iteration = 0; iteration < CHAIN_LAST_STEP_ITERATIONS && fabs(t1 - remaining) > 1e-15 * dt && t1 != t0; iteration++)
+        {
+            const double next = h1 + (remaining - t1) * (h1 - h0) / (t1 - t0);
+            chain.X = savedX;
+            chain.W = savedW;
+            h0 = h1;
+            t0 = t1;
+            h1 = next;
+            t1 = chain.fourthOrderStep(h1);
+        }
+        landed = true;
+    }
+
+    // past the limit, the rest in steps of the same share of the closest orbit, but never more than the limit again
+    const double reached = landed ? dt : time;
+    const double shortestStep = (dt - time) / CHAIN_STEP_LIMIT;
+    while (!landed && time < dt)
+    {
+        chain.positions();
+        const double tau = min(max(chain.orbitStep(), shortestStep), dt - time);
+        chain.physicalStep(tau);
+        time += tau;
+    }
+
+    chain.positions();
+    chain.velocities();
+    double *outPosition[3] = {x, y, z}, *outSpeed[3] = {vx, vy, vz};
+    for (size_t k = 0; k < count; k++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            outPosition[c][order[k]] = chain.q[3 * k + c];
+            outSpeed[c][order[k]] = chain.v[3 * k + c];
+        }
+    }
+    return reached;
+}
@@ -0,0 +1,21 @@
+#ifndef REGULARIZATION_H
+#define REGULARIZATION_H
+
+#include <cstddef>
+
+/*
+    Regularized few body motion, the internal orbits of the tight groups RegularizedIntegrator takes out of the global step,
+    positions and velocities relative to the group's centre of mass, no softening
+        ksDrift      a pair, Kustaanheimo-Stiefel: the relative orbit in four dimensional u with r = |u|^2 and the
+                     fictitious time s, dt = r ds, is the harmonic oscillator u'' = (h / 2) u, solved in closed form,
+                     t(s) solved for the s that ends on dt, regular through r = 0 and at any eccentricity
+        chainDrift   three or more bodies, algorithmic chain regularization: the separations along a chain of nearest
+                     neighbours are the variables, so close pairs keep their digits, stepped by the logarithmic
+                     Hamiltonian leapfrog of Mikkola and Tanikawa, whose time steps shrink with 1 / U through close
+                     approaches, and which follows two body encounters on their exact orbits, returns the time
+                     the regularized steps reached, short of dt when it ran out of steps and went on unregularized
+*/
+void ksDrift(double relative[3], double velocity[3], double mu, double dt);
+double chainDrift(std::size_t count, const double *mass, double gm, double *x, double *y, double *z, double *vx, double *vy, double *vz, double dt);
+
+#endif
@@ -0,0 +1,475 @@
+/**
+ * This file contains the implementation of the RegularizedIntegrator class, the regularized treatment of tight groups
+ *
+ * the groups are found by friends of friends over a hash of cells twice the radius wide, so only neighbouring cells
+ * are searched, the bodies without mass never join a group
+ *
+ * a member's tide is the pull of every other unit of the reduced store on it less the pull on its group's centre of mass,
+ * their mass weighted mean is the part of the outside pull the point composite misses, it kicks the composite as well
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include "Regularization.h"
+#include "RegularizedIntegrator.h"
+using namespace std;
+
+RegularizedIntegrator::RegularizedIntegrator(unique_ptr<SteppingIntegrator> scheme, double timestep, double radius)
+    : SteppingIntegrator(timestep), scheme(move(scheme)), radius(radius)
+{
+    if (!(radius > 0.0))
+    {
+        throw invalid_argument("RegularizationRadius must be positive");
+    }
+    label = string("regularized ") + this->scheme->name();
+}
+
+/**
+ * @brief finds the groups, builds the reduced store and starts the scheme on it
+ * @param store the bodies
+ * @param solver the force solver of the run, it only ever sees the reduced store
+ */
+void RegularizedIntegrator::start(BodyStore &store, ForceSolver &solver)
+{
+    #pragma omp single
+    {
+        groups.clear();
+        groupOf.assign(store.size(), -1);
+        regroup(store);
+        rebuild(store);
+    }
+    scheme->start(reduced, solver);
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.ax[i] = reduced.ax[unitOf[i]];
+        store.ay[i] = reduced.ay[unitOf[i]];
+        store.az[i] = reduced.az[unitOf[i]];
+    }
+}
+
+/**
+ * @brief one step: tidal half kick, the groups' internal drift, the scheme's step of the reduced store, tidal half kick
+ * @param store the bodies
+ * @param solver computes the accelerations of the reduced store
+ * @param dt the length of the step
+ */
+void RegularizedIntegrator::step(BodyStore &store, ForceSolver &solver, double dt)
+{
+    #pragma omp single
+    {
+        regrouped = regroup(store);
+        if (regrouped)
+        {
+            rebuild(store);
+        }
+        evaluations += 2 * members.size();
+    }
+    if (regrouped)
+    {
+        scheme->start(reduced, solver);
+    }
+
+    tidalKick(store, 0.5 * dt);
+    internalDrift(store, dt);
+
+    #pragma omp for schedule(static)
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        const size_t u = compositeOf[g];
+        centreX[g] = reduced.x[u];
+        centreY[g] = reduced.y[u];
+        centreZ[g] = reduced.z[u];
+        centreVX[g] = reduced.vx[u];
+        centreVY[g] = reduced.vy[u];
+        centreVZ[g] = reduced.vz[u];
+    }
+
+    scheme->step(reduced, solver, dt);
+
+    // the single bodies take their new state, the members move with their composite
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const size_t u = unitOf[i];
+        const int g = groupOf[i];
+        if (g < 0)
+        {
+            store.x[i] = reduced.x[u];
+            store.y[i] = reduced.y[u];
+            store.z[i] = reduced.z[u];
+            store.vx[i] = reduced.vx[u];
+            store.vy[i] = reduced.vy[u];
+            store.vz[i] = reduced.vz[u];
+        }
+        else
+        {
+            store.x[i] += reduced.x[u] - centreX[g];
+            store.y[i] += reduced.y[u] - centreY[g];
+            store.z[i] += reduced.z[u] - centreZ[g];
+            store.vx[i] += reduced.vx[u] - centreVX[g];
+            store.vy[i] += reduced.vy[u] - centreVY[g];
+            store.vz[i] += reduced.vz[u] - centreVZ[g];
+        }
+        store.ax[i] = reduced.ax[u];
+        store.ay[i] = reduced.ay[u];
+        store.az[i] = reduced.az[u];
+    }
+
+    tidalKick(store, 0.5 * dt);
+}
+
+/**
+ * @brief friends of friends over the bodies with mass, linked closer than the radius, or than twice the radius
+ * when they already share a group, the groups of 2 to MAX_REGULARIZED_MEMBERS bodies kept
+ * @return whether the groups changed
+ */
+bool RegularizedIntegrator::regroup(const BodyStore &store)
+{
+    const size_t n = store.size();
+    const double cell = 2.0 * radius, near2 = radius * radius, far2 = 4.0 * radius * radius;
+    auto cellOf = [&](double position)
+    {
+        return static_cast<int64_t>(floor(max(-1e15, min(1e15, position / cell))));
+    };
+    auto key = [](int64_t cx, int64_t cy, int64_t cz)
+    {
+        return static_cast<uint64_t>(cx) * 73856093u ^ static_cast<uint64_t>(cy) * 19349663u ^ static_cast<uint64_t>(cz) * 83492791u;
+    };
+
+    unordered_map<uint64_t, vector<uint32_t>> cells;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (store.mass[i] > 0.0)
+        {
+            cells[key(cellOf(store.x[i]), cellOf(store.y[i]), cellOf(store.z[i]))].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    vector<uint32_t> root(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        root[i] = static_cast<uint32_t>(i);
+    }
+    auto find = [&](uint32_t i)
+    {
+        while (root[i] != i)
+        {
+            root[i] = root[root[i]];
+            i = root[i];
+        }
+        return i;
+    };
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!(store.mass[i] > 0.0))
+        {
+            continue;
+        }
+        const int64_t cx = cellOf(store.x[i]), cy = cellOf(store.y[i]), cz = cellOf(store.z[i]);
+        for (int64_t ox = -1; ox <= 1; ox++)
+        {
+            for (int64_t oy = -1; oy <= 1; oy++)
+            {
+                for (int64_t oz = -1; oz <= 1; oz++)
+                {
+                    const auto found = cells.find(key(cx + ox, cy + oy, cz + oz));
+                    if (found == cells.end())
+                    {
+                        continue;
+                    }
+                    for (uint32_t j : found->second)
+                    {
+                        if (j <= i)
+                        {
+                            continue;
+                        }
+                        const double dx = store.x[j] - store.x[i], dy = store.y[j] - store.y[i], dz = store.z[j] - store.z[i];
+                        const double d2 = dx * dx + dy * dy + dz * dz;
+                        if (d2 < near2 || (d2 < far2 && groupOf[i] >= 0 && groupOf[i] == groupOf[j]))
+                        {
+                            root[find(j)] = find(static_cast<uint32_t>(i));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    vector<vector<uint32_t>> components(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        components[find(static_cast<uint32_t>(i))].push_back(static_cast<uint32_t>(i));
+    }
+    vector<vector<uint32_t>> found;
+    for (size_t i = 0; i < n; i++)
+    {
+        const vector<uint32_t> &component = components[find(static_cast<uint32_t>(i))];
+        if (component.front() == i && component.size() >= 2 && component.size() <= MAX_REGULARIZED_MEMBERS)
+        {
+            found.push_back(component);
+        }
+    }
+
+    const bool changed = found != groups;
+    groups = move(found);
+    groupOf.assign(n, -1);
+    members.clear();
+    firstMember.assign(1, 0);
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        for (uint32_t i : groups[g])
+        {
+            groupOf[i] = static_cast<int>(g);
+            members.push_back(i);
+        }
+        firstMember.push_back(static_cast<uint32_t>(members.size()));
+    }
+    return changed;
+}
+
+/**
+ * @brief the reduced store from the bodies, the single bodies and every group's composite in the order of their first body,
+ * a composite with the group's mass, centre of mass and the multiplier of its first member
+ */
+void RegularizedIntegrator::rebuild(const BodyStore &store)
+{
+    const size_t n = store.size();
+    unitOf.resize(n);
+    compositeOf.resize(groups.size());
+    size_t units = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const int g = groupOf[i];
+        if (g >= 0 && groups[g].front() != i)
+        {
+            unitOf[i] = compositeOf[g];
+            continue;
+        }
+        if (g >= 0)
+        {
+            compositeOf[g] = static_cast<uint32_t>(units);
+        }
+        unitOf[i] = static_cast<uint32_t>(units++);
+    }
+
+    reduced.resize(units);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (groupOf[i] < 0)
+        {
+            const size_t u = unitOf[i];
+            reduced.x[u] = store.x[i];
+            reduced.y[u] = store.y[i];
+            reduced.z[u] = store.z[i];
+            reduced.vx[u] = store.vx[i];
+            reduced.vy[u] = store.vy[i];
+            reduced.vz[u] = store.vz[i];
+            reduced.mass[u] = store.mass[i];
+            reduced.gravitationalMultiplier[u] = store.gravitationalMultiplier[i];
+        }
+    }
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        const size_t u = compositeOf[g];
+        double total = 0.0, centre[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        for (uint32_t i : groups[g])
+        {
+            const double m = store.mass[i];
+            total += m;
+            centre[0] += m * store.x[i];
+            centre[1] += m * store.y[i];
+            centre[2] += m * store.z[i];
+            centre[3] += m * store.vx[i];
+            centre[4] += m * store.vy[i];
+            centre[5] += m * store.vz[i];
+        }
+        reduced.x[u] = centre[0] / total;
+        reduced.y[u] = centre[1] / total;
+        reduced.z[u] = centre[2] / total;
+        reduced.vx[u] = centre[3] / total;
+        reduced.vy[u] = centre[4] / total;
+        reduced.vz[u] = centre[5] / total;
+        reduced.mass[u] = total;
+        reduced.gravitationalMultiplier[u] = store.gravitationalMultiplier[groups[g].front()];
+    }
+
+    for (vector<double> *perGroup : {&centreX, &centreY, &centreZ, &centreVX, &centreVY, &centreVZ})
+    {
+        perGroup->assign(groups.size(), 0.0);
+    }
+    for (vector<double> *perMember : {&tideX, &tideY, &tideZ})
+    {
+        perMember->assign(members.size(), 0.0);
+    }
+}
+
+/**
+ * @brief adds the pull of unit u of the reduced store at a point, the force law of DirectSolver without the multiplier
+ */
+static inline void addPull(const BodyStore &reduced, size_t u, double px, double py, double pz, double sign, double sum[3])
+{
+    const double dx = reduced.x[u] - px, dy = reduced.y[u] - py, dz = reduced.z[u] - pz;
+    const double r2 = dx * dx + dy * dy + dz * dz;
+    if (r2 == 0.0)
+    {
+        return;
+    }
+    const double r = sqrt(r2);
+    const double dist = r < SOFTENING_LENGTH ? SOFTENING_LENGTH : r;
+    const double pull = sign * reduced.mass[u] / ((dist * dist) + (SOFTENING_LENGTH * SOFTENING_LENGTH)) / r;
+    sum[0] += pull * dx;
+    sum[1] += pull * dy;
+    sum[2] += pull * dz;
+}
+
+/**
+ * @brief kicks every member by its tide, the pull of the other units on it less that on its group's centre of mass,
+ * and every composite by the mean tide of its members
+ */
+void RegularizedIntegrator::tidalKick(BodyStore &store, double time)
+{
+    const size_t units = reduced.size();
+    #pragma omp for schedule(dynamic, 4)
+    for (size_t k = 0; k < members.size(); k++)
+    {
+        const size_t i = members[k], own = unitOf[i];
+        double sum[3] = {0.0, 0.0, 0.0};
+        for (size_t u = 0; u < units; u++)
+        {
+            if (u != own)
+            {
+                addPull(reduced, u, store.x[i], store.y[i], store.z[i], 1.0, sum);
+                addPull(reduced, u, reduced.x[own], reduced.y[own], reduced.z[own], -1.0, sum);
+            }
+        }
+        const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+        tideX[k] = scale * sum[0];
+        tideY[k] = scale * sum[1];
+        tideZ[k] = scale * sum[2];
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        double total = 0.0, mean[3] = {0.0, 0.0, 0.0};
+        for (size_t k = firstMember[g]; k < firstMember[g + 1]; k++)
+        {
+            const double m = store.mass[members[k]];
+            total += m;
+            mean[0] += m * tideX[k];
+            mean[1] += m * tideY[k];
+            mean[2] += m * tideZ[k];
+        }
+        for (size_t k = firstMember[g]; k < firstMember[g + 1]; k++)
+        {
+            const size_t i = members[k];
+            store.vx[i] += tideX[k] * time;
+            store.vy[i] += tideY[k] * time;
+            store.vz[i] += tideZ[k] * time;
+        }
+        const size_t u = compositeOf[g];
+        reduced.vx[u] += mean[0] / total * time;
+        reduced.vy[u] += mean[1] / total * time;
+        reduced.vz[u] += mean[2] / total * time;
+    }
+}
+
+/**
+ * @brief moves every group's members around its centre of mass, a pair through KS, more through the chain
+ */
+void RegularizedIntegrator::internalDrift(BodyStore &store, double time)
+{
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        const vector<uint32_t> &group = groups[g];
+        const double gm = GRAVITY_CONSTANT * store.gravitationalMultiplier[group.front()];
+        if (group.size() == 2)
+        {
+            const size_t a = group[0], b = group[1];
+            const double total = store.mass[a] + store.mass[b];
+            double relative[3] = {store.x[b] - store.x[a], store.y[b] - store.y[a], store.z[b] - store.z[a]};
+            double velocity[3] = {store.vx[b] - store.vx[a], store.vy[b] - store.vy[a], store.vz[b] - store.vz[a]};
+            const double centre[6] = {(store.mass[a] * store.x[a] + store.mass[b] * store.x[b]) / total,
+                                      (store.mass[a] * store.y[a] + store.mass[b] * store.y[b]) / total,
+                                      (store.mass[a] * store.z[a] + store.mass[b] * store.z[b]) / total,
+                                      (store.mass[a] * store.vx[a] + store.mass[b] * store.vx[b]) / total,
+                                      (store.mass[a] * store.vy[a] + store.mass[b] * store.vy[b]) / total,
+                                      (store.mass[a] * store.vz[a] + store.mass[b] * store.vz[b]) / total};
+            ksDrift(relative, velocity, gm * total, time);
+            const double shareA = store.mass[b] / total, shareB = store.mass[a] / total;
+            store.x[a] = centre[0] - shareA * relative[0];
+            store.y[a] = centre[1] - shareA * relative[1];
+            store.z[a] = centre[2] - shareA * relative[2];
+            store.vx[a] = centre[3] - shareA * velocity[0];
+            store.vy[a] = centre[4] - shareA * velocity[1];
+            store.vz[a] = centre[5] - shareA * velocity[2];
+            store.x[b] = centre[0] + shareB * relative[0];
+            store.y[b] = centre[1] + shareB * relative[1];
+            store.z[b] = centre[2] + shareB * relative[2];
+            store.vx[b] = centre[3] + shareB * velocity[0];
+            store.vy[b] = centre[4] + shareB * velocity[1];
+            store.vz[b] = centre[5] + shareB * velocity[2];
+            continue;
+        }
+
+        const size_t count = group.size();
+        double mass[MAX_REGULARIZED_MEMBERS], x[MAX_REGULARIZED_MEMBERS], y[MAX_REGULARIZED_MEMBERS], z[MAX_REGULARIZED_MEMBERS];
+        double vx[MAX_REGULARIZED_MEMBERS], vy[MAX_REGULARIZED_MEMBERS], vz[MAX_REGULARIZED_MEMBERS];
+        double total = 0.0, centre[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        for (size_t k = 0; k < count; k++)
+        {
+            const size_t i = group[k];
+            mass[k] = store.mass[i];
+            total += mass[k];
+            centre[0] += mass[k] * store.x[i];
+            centre[1] += mass[k] * store.y[i];
+            centre[2] += mass[k] * store.z[i];
+            centre[3] += mass[k] * store.vx[i];
+            centre[4] += mass[k] * store.vy[i];
+            centre[5] += mass[k] * store.vz[i];
+        }
+        for (double &c : centre)
+        {
+            c /= total;
+        }
+        for (size_t k = 0; k < count; k++)
+        {
+            const size_t i = group[k];
+            x[k] = store.x[i] - centre[0];
+            y[k] = store.y[i] - centre[1];
+            z[k] = store.z[i] - centre[2];
+            vx[k] = store.vx[i] - centre[3];
+            vy[k] = store.vy[i] - centre[4];
+            vz[k] = store.vz[i] - centre[5];
+        }
+        const double reached = chainDrift(count, mass, gm, x, y, z, vx, vy, vz, time);
+        if (reached < time)
+        {
+            #pragma omp critical(chain_step_limit)
+            if (!warnedStepLimit)
+            {
+                warnedStepLimit = true;
+                cerr << "Warning: the chain of group " << g << " (" << count << " bodies, the first body " << store.id[group.front()] << ") reached "
+                     << reached << " of " << time << " seconds within its step limit, the rest of the drift is unregularized" << endl;
+            }
+        }
+        for (size_t k = 0; k < count; k++)
+        {
+            const size_t i = group[k];
+            store.x[i] = centre[0] + x[k];
+            store.y[i] = centre[1] + y[k];
+            store.z[i] = centre[2] + z[k];
+            store.vx[i] = centre[3] + vx[k];
+            store.vy[i] = centre[4] + vy[k];
+            store.vz[i] = centre[5] + vz[k];
+        }
+    }
+}
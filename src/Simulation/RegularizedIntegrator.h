@@ -0,0 +1,62 @@
+#ifndef REGULARIZED_INTEGRATOR_H
+#define REGULARIZED_INTEGRATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Integrator.h"
+
+const std::size_t MAX_REGULARIZED_MEMBERS = 6; // larger groups stay single bodies of the global step, the chain is O(n^2) per substep
+
+/*
+    RegularizedIntegrator class:
+        takes the tight groups out of the global step, the bodies with mass linked by separations under the
+        RegularizationRadius (friends of friends, a group holds together up to twice the radius), 2 to
+        MAX_REGULARIZED_MEMBERS of them, and hands the wrapped scheme a reduced store with one composite body per group,
+        at its centre of mass with its total mass, so the global step never resolves their orbits
+            tidal half kick   every member by the pull of the bodies outside its group less that on the group's centre of mass
+            internal drift    the members around their centre of mass, unperturbed: ksDrift for a pair, chainDrift for more
+            global step       the scheme's step of the reduced store, the members follow their composite
+            tidal half kick
+        the groups are found again before every step, the scheme is started again on the new reduced store when they change,
+        and the bodies' accelerations are those of their composites, the ones the adaptive criteria should see
+*/
+class RegularizedIntegrator : public SteppingIntegrator
+{
+public:
+        RegularizedIntegrator(std::unique_ptr<SteppingIntegrator> scheme, double timestep, double radius);
+
+        const char *name() const override { return label.c_str(); }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void step(BodyStore &store, ForceSolver &solver, double dt) override;
+        bool startsWithAccelerations() const override { return scheme->startsWithAccelerations(); }
+        std::uint64_t forceEvaluations() const override { return evaluations + scheme->forceEvaluations(); }
+
+        const std::vector<std::vector<std::uint32_t>> &currentGroups() const { return groups; }
+
+private:
+        std::unique_ptr<SteppingIntegrator> scheme;
+        std::string label;                              // "regularized " and the scheme's name
+        double radius;
+
+        BodyStore reduced;                              // the single bodies and one composite per group
+        std::vector<std::vector<std::uint32_t>> groups; // the members of every group, ascending
+        std::vector<std::uint32_t> members;             // every member of every group, group by group
+        std::vector<std::uint32_t> firstMember;         // the members of group g are members[firstMember[g] .. firstMember[g + 1])
+        std::vector<int> groupOf;                       // group of every body, -1 for the single ones
+        std::vector<std::uint32_t> unitOf;              // place of every body in the reduced store
+        std::vector<std::uint32_t> compositeOf;         // place of every group's composite in the reduced store
+        std::vector<double> centreX, centreY, centreZ, centreVX, centreVY, centreVZ; // composites before the global step
+        std::vector<double> tideX, tideY, tideZ;        // tidal acceleration of every member, by place in members
+        bool regrouped = false;
+        bool warnedStepLimit = false;                   // a chain has run out of regularized steps, reported once a run
+
+        bool regroup(const BodyStore &store);
+        void rebuild(const BodyStore &store);
+        void tidalKick(BodyStore &store, double time);
+        void internalDrift(BodyStore &store, double time);
+};
+
+#endif
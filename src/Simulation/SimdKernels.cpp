@@ -0,0 +1,842 @@
+/**
+ * This file contains the hand vectorized source kernels shared by the direct-sum solvers
+ *
+ * with the default clamped softening every kernel evaluates the same force law as Body::gravForce:
+ * a = G * multiplier * m2 / ((r*r) + (e*e)) along the unit distance vector, with r clamped to e
+ * written as  m2 * (1/r) * (1/(max(r*r, e*e) + e*e)) * (x2 - x1),  with both reciprocals from rsqrt
+ * Plummer and unsoftened runs need a single reciprocal square root, m2 * (1/d)^3 with d*d = r*r + e*e or r*r
+ *
+ * the kernels carry their own target attribute, so one binary holds all of them and the cpu picks at startup
+ * AVX-512 has a 14 bit double rsqrt estimate, SSE2 and AVX2 have none and start from the bit trick estimate instead
+ * every kernel is a template on the Softening, the pair term is chosen at compile time and the loop has no branch
+ *
+ * the mixed precision kernels do the pair terms in float, twice the lanes per instruction, on offsets that were
+ * rounded to float only after the large coordinates were subtracted in double, and hand the close pairs back to double
+ *
+ * the jerk kernels sum the clamped pull and its time derivative in the same pass, for the Hermite integrator
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include "SimdKernels.h"
+#include "ForceSolver.h"
+using namespace std;
+
+const double SOFTENING_SQUARED = SOFTENING_LENGTH * SOFTENING_LENGTH;
+const long long RSQRT_MAGIC = 0x5FE6EB50C7B537A9LL; // double precision version of the fast inverse square root constant
+const float NEAR_FRACTION = 1.0f / 1024.0f;          // mixed precision pairs closer than this share of the offsets' scale go to double
+
+/**
+ * @brief detects the widest instruction set both the cpu and the operating system support
+ * @return the SimdLevel to pick kernels for
+ */
+SimdLevel detectSimdLevel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE2:
+        return "sse2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+const char *softeningName(Softening softening)
+{
+    switch (softening)
+    {
+    case Softening::Plummer:
+        return "plummer";
+    case Softening::None:
+        return "none";
+    default:
+        return "clamped";
+    }
+}
+
+/**
+ * @brief scalar version of the pair term, also used for the sources left over after the last full vector
+ */
+template <Softening S>
+static inline void addPairScalar(double dx, double dy, double dz, double massJ, double &sumX, double &sumY, double &sumZ)
+{
+    const double s = pairScale<S>(dx * dx + dy * dy + dz * dz, massJ, SOFTENING_SQUARED);
+    sumX += s * dx;
+    sumY += s * dy;
+    sumZ += s * dz;
+}
+
+template <Softening S>
+static void sourcesScalar(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                          double targetX, double targetY, double targetZ, double &sumX, double &sumY, double &sumZ)
+{
+    for (size_t j = 0; j < count; j++)
+    {
+        addPairScalar<S>(x[j] - targetX, y[j] - targetY, z[j] - targetZ, mass[j], sumX, sumY, sumZ);
+    }
+}
+
+static void shortRangeScalar(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                             double targetX, double targetY, double targetZ, const double *table, double tableScale, double tableEnd,
+                             double &sumX, double &sumY, double &sumZ)
+{
+    for (size_t j = 0; j < count; j++)
+    {
+        const double dx = x[j] - targetX, dy = y[j] - targetY, dz = z[j] - targetZ;
+        const double r2 = dx * dx + dy * dy + dz * dz;
+        const double t = min(r2 * tableScale, tableEnd);
+        const size_t index = static_cast<size_t>(t);
+        const double factor = table[index] + (t - double(index)) * (table[index + 1] - table[index]);
+        if (factor != 0.0)
+        {
+            addPairScalar<Softening::Clamped>(dx, dy, dz, mass[j] * factor, sumX, sumY, sumZ);
+        }
+    }
+}
+
+/**
+ * @brief the target's float offset in the block's units, and the squared distance under which a pair is summed in double
+ */
+static inline void mixedTarget(const MixedBlock &block, double targetX, double targetY, double targetZ,
+                               float &offsetX, float &offsetY, float &offsetZ, float &near2, float &softening2)
+{
+    const double inverseLength = 1.0 / block.length;
+    offsetX = float((targetX - block.centerX) * inverseLength);
+    offsetY = float((targetY - block.centerY) * inverseLength);
+    offsetZ = float((targetZ - block.centerZ) * inverseLength);
+    // both offsets carry a rounding error of 2^-24 of their size, the target's and at most the block's radius, 1 in these units
+    const float reach = NEAR_FRACTION * (sqrtf(offsetX * offsetX + offsetY * offsetY + offsetZ * offsetZ) + 1.0f);
+    near2 = reach * reach;
+    softening2 = float(SOFTENING_SQUARED * inverseLength * inverseLength);
+}
+
+/**
+ * @brief the mixed precision pair terms of sources [first, count) one at a time, the tail of the vector kernels
+ */
+template <Softening S>
+static void mixedRange(const MixedBlock &block, size_t first, double targetX, double targetY, double targetZ,
+                       double &sumX, double &sumY, double &sumZ)
+{
+    float offsetX, offsetY, offsetZ, near2, softening2;
+    mixedTarget(block, targetX, targetY, targetZ, offsetX, offsetY, offsetZ, near2, softening2);
+    double accX = 0.0, accY = 0.0, accZ = 0.0;
+    for (size_t j = first; j < block.count; j++)
+    {
+        const float dx = block.x[j] - offsetX, dy = block.y[j] - offsetY, dz = block.z[j] - offsetZ;
+        const float r2 = dx * dx + dy * dy + dz * dz;
+        if (r2 < near2)
+        {
+            addPairScalar<S>(block.exactX[j] - targetX, block.exactY[j] - targetY, block.exactZ[j] - targetZ, block.exactMass[j], sumX, sumY, sumZ);
+            continue;
+        }
+        const float s = pairScale<S>(r2, block.mass[j], softening2);
+        accX += s * dx;
+        accY += s * dy;
+        accZ += s * dz;
+    }
+    const double scale = block.massUnit / (block.length * block.length);
+    sumX += scale * accX;
+    sumY += scale * accY;
+    sumZ += scale * accZ;
+}
+
+template <Softening S>
+static void mixedScalar(const MixedBlock &block, double targetX, double targetY, double targetZ, double &sumX, double &sumY, double &sumZ)
+{
+    mixedRange<S>(block, 0, targetX, targetY, targetZ, sumX, sumY, sumZ);
+}
+
+/**
+ * @brief scalar acceleration and jerk of one target, the clamped pair term and its time derivative
+ *
+ * d/dt of m d / ((r*r + e*e) r) is  m / ((r*r + e*e) r) * (v - (3 r*r + e*e) / (r*r (r*r + e*e)) (d.v) d)  beyond the
+ * softening length, and  m / (2 e*e r) * (v - (d.v) d / (r*r))  inside it, where the denominator is constant
+ */
+static void jerkScalar(const double *x, const double *y, const double *z, const double *vx, const double *vy, const double *vz,
+                       const double *mass, size_t count, double targetX, double targetY, double targetZ,
+                       double targetVx, double targetVy, double targetVz, double acceleration[3], double jerk[3])
+{
+    for (size_t j = 0; j < count; j++)
+    {
+        const double dx = x[j] - targetX, dy = y[j] - targetY, dz = z[j] - targetZ;
+        const double r2 = dx * dx + dy * dy + dz * dz;
+        if (!(r2 > 0.0))
+        {
+            continue;
+        }
+        const double dvx = vx[j] - targetVx, dvy = vy[j] - targetVy, dvz = vz[j] - targetVz;
+        const double denominator = max(r2, SOFTENING_SQUARED) + SOFTENING_SQUARED;
+        const double s = mass[j] / (denominator * sqrt(r2));
+        const double radial = (dx * dvx + dy * dvy + dz * dvz) / r2 * (r2 > SOFTENING_SQUARED ? (3.0 * r2 + SOFTENING_SQUARED) / denominator : 1.0);
+        acceleration[0] += s * dx;
+        acceleration[1] += s * dy;
+        acceleration[2] += s * dz;
+        jerk[0] += s * (dvx - radial * dx);
+        jerk[1] += s * (dvy - radial * dy);
+        jerk[2] += s * (dvz - radial * dz);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// GCC 12 reports the _mm512_undefined_pd placeholders inside its own AVX-512 intrinsics as uninitialized
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+/**
+ * SSE2: 2 sources per instruction, no fma
+ */
+__attribute__((target("sse2"))) static inline __m128d rsqrtSse2(__m128d value)
+{
+    const __m128d half = _mm_set1_pd(0.5), threeHalves = _mm_set1_pd(1.5);
+    const __m128i magic = _mm_set1_epi64x(RSQRT_MAGIC);
+    __m128d estimate = _mm_castsi128_pd(_mm_sub_epi64(magic, _mm_srli_epi64(_mm_castpd_si128(value), 1)));
+    const __m128d halfValue = _mm_mul_pd(half, value);
+    // the bit trick starts at ~3.4% error, each Newton step squares it
+    for (int k = 0; k < 4; k++)
+    {
+        estimate = _mm_mul_pd(estimate, _mm_sub_pd(threeHalves, _mm_mul_pd(halfValue, _mm_mul_pd(estimate, estimate))));
+    }
+    return estimate;
+}
+
+// the pair term's factor before the coincident lanes are masked, infinite for them without softening
+template <Softening S>
+__attribute__((target("sse2"))) static inline __m128d pairScaleSse2(__m128d r2, __m128d mass)
+{
+    const __m128d softening2 = _mm_set1_pd(SOFTENING_SQUARED);
+    if constexpr (S == Softening::Clamped)
+    {
+        const __m128d inverseR = rsqrtSse2(r2);
+        const __m128d inverseDenominator = rsqrtSse2(_mm_add_pd(_mm_max_pd(r2, softening2), softening2));
+        return _mm_mul_pd(_mm_mul_pd(mass, inverseR), _mm_mul_pd(inverseDenominator, inverseDenominator));
+    }
+    else
+    {
+        const __m128d inverse = rsqrtSse2(S == Softening::Plummer ? _mm_add_pd(r2, softening2) : r2);
+        return _mm_mul_pd(_mm_mul_pd(mass, inverse), _mm_mul_pd(inverse, inverse));
+    }
+}
+
+template <Softening S>
+__attribute__((target("sse2"))) static void sourcesSse2(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                                                       double targetX, double targetY, double targetZ, double &sumX, double &sumY, double &sumZ)
+{
+    const size_t vectorEnd = count - count % 2;
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d xi = _mm_set1_pd(targetX), yi = _mm_set1_pd(targetY), zi = _mm_set1_pd(targetZ);
+    __m128d accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < vectorEnd; j += 2)
+    {
+        const __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + j), xi);
+        const __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + j), yi);
+        const __m128d dz = _mm_sub_pd(_mm_loadu_pd(z + j), zi);
+        const __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+        __m128d s = pairScaleSse2<S>(r2, _mm_loadu_pd(mass + j));
+        s = _mm_and_pd(s, _mm_cmpgt_pd(r2, zero)); // itself and coincident bodies contribute nothing
+        accX = _mm_add_pd(accX, _mm_mul_pd(s, dx));
+        accY = _mm_add_pd(accY, _mm_mul_pd(s, dy));
+        accZ = _mm_add_pd(accZ, _mm_mul_pd(s, dz));
+    }
+
+    double lanesX[2], lanesY[2], lanesZ[2];
+    _mm_storeu_pd(lanesX, accX);
+    _mm_storeu_pd(lanesY, accY);
+    _mm_storeu_pd(lanesZ, accZ);
+    sumX += lanesX[0] + lanesX[1];
+    sumY += lanesY[0] + lanesY[1];
+    sumZ += lanesZ[0] + lanesZ[1];
+    sourcesScalar<S>(x + vectorEnd, y + vectorEnd, z + vectorEnd, mass + vectorEnd, count - vectorEnd, targetX, targetY, targetZ, sumX, sumY, sumZ);
+}
+
+/**
+ * AVX2: 4 sources per instruction, fused multiply-add
+ */
+__attribute__((target("avx2,fma"))) static inline __m256d rsqrtAvx2(__m256d value)
+{
+    const __m256d half = _mm256_set1_pd(0.5), threeHalves = _mm256_set1_pd(1.5);
+    const __m256i magic = _mm256_set1_epi64x(RSQRT_MAGIC);
+    __m256d estimate = _mm256_castsi256_pd(_mm256_sub_epi64(magic, _mm256_srli_epi64(_mm256_castpd_si256(value), 1)));
+    const __m256d halfValue = _mm256_mul_pd(half, value);
+    for (int k = 0; k < 4; k++)
+    {
+        estimate = _mm256_mul_pd(estimate, _mm256_fnmadd_pd(halfValue, _mm256_mul_pd(estimate, estimate), threeHalves));
+    }
+    return estimate;
+}
+
+template <Softening S>
+__attribute__((target("avx2,fma"))) static inline __m256d pairScaleAvx2(__m256d r2, __m256d mass)
+{
+    const __m256d softening2 = _mm256_set1_pd(SOFTENING_SQUARED);
+    if constexpr (S == Softening::Clamped)
+    {
+        const __m256d inverseR = rsqrtAvx2(r2);
+        const __m256d inverseDenominator = rsqrtAvx2(_mm256_add_pd(_mm256_max_pd(r2, softening2), softening2));
+        return _mm256_mul_pd(_mm256_mul_pd(mass, inverseR), _mm256_mul_pd(inverseDenominator, inverseDenominator));
+    }
+    else
+    {
+        const __m256d inverse = rsqrtAvx2(S == Softening::Plummer ? _mm256_add_pd(r2, softening2) : r2);
+        return _mm256_mul_pd(_mm256_mul_pd(mass, inverse), _mm256_mul_pd(inverse, inverse));
+    }
+}
+
+template <Softening S>
+__attribute__((target("avx2,fma"))) static void sourcesAvx2(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                                                           double targetX, double targetY, double targetZ, double &sumX, double &sumY, double &sumZ)
+{
+    const size_t vectorEnd = count - count % 4;
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d xi = _mm256_set1_pd(targetX), yi = _mm256_set1_pd(targetY), zi = _mm256_set1_pd(targetZ);
+    __m256d accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < vectorEnd; j += 4)
+    {
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), xi);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), yi);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + j), zi);
+        const __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        __m256d s = pairScaleAvx2<S>(r2, _mm256_loadu_pd(mass + j));
+        s = _mm256_and_pd(s, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ)); // itself and coincident bodies contribute nothing
+        accX = _mm256_fmadd_pd(s, dx, accX);
+        accY = _mm256_fmadd_pd(s, dy, accY);
+        accZ = _mm256_fmadd_pd(s, dz, accZ);
+    }
+
+    double lanesX[4], lanesY[4], lanesZ[4];
+    _mm256_storeu_pd(lanesX, accX);
+    _mm256_storeu_pd(lanesY, accY);
+    _mm256_storeu_pd(lanesZ, accZ);
+    sumX += (lanesX[0] + lanesX[1]) + (lanesX[2] + lanesX[3]);
+    sumY += (lanesY[0] + lanesY[1]) + (lanesY[2] + lanesY[3]);
+    sumZ += (lanesZ[0] + lanesZ[1]) + (lanesZ[2] + lanesZ[3]);
+    sourcesScalar<S>(x + vectorEnd, y + vectorEnd, z + vectorEnd, mass + vectorEnd, count - vectorEnd, targetX, targetY, targetZ, sumX, sumY, sumZ);
+}
+
+__attribute__((target("avx2,fma"))) static void shortRangeAvx2(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                                                              double targetX, double targetY, double targetZ,
+                                                              const double *table, double tableScale, double tableEnd,
+                                                              double &sumX, double &sumY, double &sumZ)
+{
+    const size_t vectorEnd = count - count % 4;
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d scale = _mm256_set1_pd(tableScale), end = _mm256_set1_pd(tableEnd);
+    const __m256d xi = _mm256_set1_pd(targetX), yi = _mm256_set1_pd(targetY), zi = _mm256_set1_pd(targetZ);
+    __m256d accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < vectorEnd; j += 4)
+    {
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), xi);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), yi);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + j), zi);
+        const __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        const __m256d t = _mm256_min_pd(_mm256_mul_pd(r2, scale), end);
+        const __m128i index = _mm256_cvttpd_epi32(t);
+        const __m256d low = _mm256_i32gather_pd(table, index, 8);
+        const __m256d high = _mm256_i32gather_pd(table + 1, index, 8);
+        const __m256d factor = _mm256_fmadd_pd(_mm256_sub_pd(t, _mm256_cvtepi32_pd(index)), _mm256_sub_pd(high, low), low);
+        __m256d s = pairScaleAvx2<Softening::Clamped>(r2, _mm256_mul_pd(_mm256_loadu_pd(mass + j), factor));
+        s = _mm256_and_pd(s, _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+        accX = _mm256_fmadd_pd(s, dx, accX);
+        accY = _mm256_fmadd_pd(s, dy, accY);
+        accZ = _mm256_fmadd_pd(s, dz, accZ);
+    }
+
+    double lanesX[4], lanesY[4], lanesZ[4];
+    _mm256_storeu_pd(lanesX, accX);
+    _mm256_storeu_pd(lanesY, accY);
+    _mm256_storeu_pd(lanesZ, accZ);
+    sumX += (lanesX[0] + lanesX[1]) + (lanesX[2] + lanesX[3]);
+    sumY += (lanesY[0] + lanesY[1]) + (lanesY[2] + lanesY[3]);
+    sumZ += (lanesZ[0] + lanesZ[1]) + (lanesZ[2] + lanesZ[3]);
+    shortRangeScalar(x + vectorEnd, y + vectorEnd, z + vectorEnd, mass + vectorEnd, count - vectorEnd, targetX, targetY, targetZ,
+                     table, tableScale, tableEnd, sumX, sumY, sumZ);
+}
+
+/**
+ * AVX2 mixed precision: 8 float sources per instruction, 12 bit rsqrt and rcp estimates refined once to float precision,
+ * the lanes sum in float over one block and the block's total in double
+ */
+template <Softening S>
+__attribute__((target("avx2,fma"))) static inline __m256 pairScaleMixedAvx2(__m256 r2, __m256 mass, __m256 softening2)
+{
+    const __m256 half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f), two = _mm256_set1_ps(2.0f);
+    const __m256 root = S == Softening::Plummer ? _mm256_add_ps(r2, softening2) : r2;
+    __m256 inverse = _mm256_rsqrt_ps(root);
+    inverse = _mm256_mul_ps(inverse, _mm256_fnmadd_ps(_mm256_mul_ps(half, root), _mm256_mul_ps(inverse, inverse), threeHalves));
+    if constexpr (S == Softening::Clamped)
+    {
+        const __m256 denominator = _mm256_add_ps(_mm256_max_ps(r2, softening2), softening2);
+        __m256 inverseDenominator = _mm256_rcp_ps(denominator);
+        inverseDenominator = _mm256_mul_ps(inverseDenominator, _mm256_fnmadd_ps(denominator, inverseDenominator, two));
+        return _mm256_mul_ps(_mm256_mul_ps(mass, inverse), inverseDenominator);
+    }
+    else
+    {
+        return _mm256_mul_ps(_mm256_mul_ps(mass, inverse), _mm256_mul_ps(inverse, inverse));
+    }
+}
+
+template <Softening S>
+__attribute__((target("avx2,fma"))) static void mixedAvx2(const MixedBlock &block, double targetX, double targetY, double targetZ,
+                                                         double &sumX, double &sumY, double &sumZ)
+{
+    float offsetX, offsetY, offsetZ, near2, softening2;
+    mixedTarget(block, targetX, targetY, targetZ, offsetX, offsetY, offsetZ, near2, softening2);
+    const size_t vectorEnd = block.count - block.count % 8;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 tx = _mm256_set1_ps(offsetX), ty = _mm256_set1_ps(offsetY), tz = _mm256_set1_ps(offsetZ);
+    const __m256 nearLimit = _mm256_set1_ps(near2), softening = _mm256_set1_ps(softening2);
+    __m256 accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < vectorEnd; j += 8)
+    {
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(block.x + j), tx);
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(block.y + j), ty);
+        const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(block.z + j), tz);
+        const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+        const __m256 far = _mm256_cmp_ps(r2, nearLimit, _CMP_GE_OQ);
+        const __m256 s = _mm256_and_ps(pairScaleMixedAvx2<S>(r2, _mm256_loadu_ps(block.mass + j), softening), far);
+        accX = _mm256_fmadd_ps(s, dx, accX);
+        accY = _mm256_fmadd_ps(s, dy, accY);
+        accZ = _mm256_fmadd_ps(s, dz, accZ);
+
+        for (unsigned close = ~_mm256_movemask_ps(far) & 0xFFu; close != 0; close &= close - 1)
+        {
+            const size_t k = j + __builtin_ctz(close);
+            addPairScalar<S>(block.exactX[k] - targetX, block.exactY[k] - targetY, block.exactZ[k] - targetZ, block.exactMass[k], sumX, sumY, sumZ);
+        }
+    }
+
+    float lanesX[8], lanesY[8], lanesZ[8];
+    _mm256_storeu_ps(lanesX, accX);
+    _mm256_storeu_ps(lanesY, accY);
+    _mm256_storeu_ps(lanesZ, accZ);
+    double totalX = 0.0, totalY = 0.0, totalZ = 0.0;
+    for (int k = 0; k < 8; k++)
+    {
+        totalX += lanesX[k];
+        totalY += lanesY[k];
+        totalZ += lanesZ[k];
+    }
+    const double scale = block.massUnit / (block.length * block.length);
+    sumX += scale * totalX;
+    sumY += scale * totalY;
+    sumZ += scale * totalZ;
+    mixedRange<S>(block, vectorEnd, targetX, targetY, targetZ, sumX, sumY, sumZ);
+}
+
+/**
+ * AVX-512: 8 sources per instruction, the last partial vector is handled with a load mask instead of a scalar tail
+ */
+__attribute__((target("avx512f"))) static inline __m512d rsqrtAvx512(__m512d value)
+{
+    const __m512d half = _mm512_set1_pd(0.5), threeHalves = _mm512_set1_pd(1.5);
+    __m512d estimate = _mm512_rsqrt14_pd(value);
+    const __m512d halfValue = _mm512_mul_pd(half, value);
+    // 14 bits -> 28 bits -> full double precision
+    for (int k = 0; k < 2; k++)
+    {
+        estimate = _mm512_mul_pd(estimate, _mm512_fnmadd_pd(halfValue, _mm512_mul_pd(estimate, estimate), threeHalves));
+    }
+    return estimate;
+}
+
+template <Softening S>
+__attribute__((target("avx512f"))) static inline __m512d pairScaleAvx512(__m512d r2, __m512d mass)
+{
+    const __m512d softening2 = _mm512_set1_pd(SOFTENING_SQUARED);
+    if constexpr (S == Softening::Clamped)
+    {
+        const __m512d inverseR = rsqrtAvx512(r2);
+        const __m512d inverseDenominator = rsqrtAvx512(_mm512_add_pd(_mm512_max_pd(r2, softening2), softening2));
+        return _mm512_mul_pd(_mm512_mul_pd(mass, inverseR), _mm512_mul_pd(inverseDenominator, inverseDenominator));
+    }
+    else
+    {
+        const __m512d inverse = rsqrtAvx512(S == Softening::Plummer ? _mm512_add_pd(r2, softening2) : r2);
+        return _mm512_mul_pd(_mm512_mul_pd(mass, inverse), _mm512_mul_pd(inverse, inverse));
+    }
+}
+
+template <Softening S>
+__attribute__((target("avx512f"))) static void sourcesAvx512(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                                                            double targetX, double targetY, double targetZ, double &sumX, double &sumY, double &sumZ)
+{
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d xi = _mm512_set1_pd(targetX), yi = _mm512_set1_pd(targetY), zi = _mm512_set1_pd(targetZ);
+    __m512d accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < count; j += 8)
+    {
+        const __mmask8 lanes = count - j >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (count - j)) - 1);
+        const __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, x + j), xi);
+        const __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, y + j), yi);
+        const __m512d dz = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, z + j), zi);
+        const __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        const __mmask8 valid = _mm512_mask_cmp_pd_mask(lanes, r2, zero, _CMP_GT_OQ); // itself and coincident bodies contribute nothing
+        const __m512d s = _mm512_maskz_mov_pd(valid, pairScaleAvx512<S>(r2, _mm512_maskz_loadu_pd(lanes, mass + j)));
+        accX = _mm512_fmadd_pd(s, dx, accX);
+        accY = _mm512_fmadd_pd(s, dy, accY);
+        accZ = _mm512_fmadd_pd(s, dz, accZ);
+    }
+
+    sumX += _mm512_reduce_add_pd(accX);
+    sumY += _mm512_reduce_add_pd(accY);
+    sumZ += _mm512_reduce_add_pd(accZ);
+}
+
+__attribute__((target("avx512f"))) static void shortRangeAvx512(const double *x, const double *y, const double *z, const double *mass, size_t count,
+                                                               double targetX, double targetY, double targetZ,
+                                                               const double *table, double tableScale, double tableEnd,
+                                                               double &sumX, double &sumY, double &sumZ)
+{
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d scale = _mm512_set1_pd(tableScale), end = _mm512_set1_pd(tableEnd);
+    const __m512d xi = _mm512_set1_pd(targetX), yi = _mm512_set1_pd(targetY), zi = _mm512_set1_pd(targetZ);
+    __m512d accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < count; j += 8)
+    {
+        const __mmask8 lanes = count - j >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (count - j)) - 1);
+        const __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, x + j), xi);
+        const __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, y + j), yi);
+        const __m512d dz = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, z + j), zi);
+        const __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        const __mmask8 valid = _mm512_mask_cmp_pd_mask(lanes, r2, zero, _CMP_GT_OQ);
+        const __m512d t = _mm512_min_pd(_mm512_mul_pd(r2, scale), end);
+        const __m256i index = _mm512_cvttpd_epi32(t);
+        const __m512d low = _mm512_i32gather_pd(index, table, 8);
+        const __m512d high = _mm512_i32gather_pd(index, table + 1, 8);
+        const __m512d factor = _mm512_fmadd_pd(_mm512_sub_pd(t, _mm512_cvtepi32_pd(index)), _mm512_sub_pd(high, low), low);
+        const __m512d s = _mm512_maskz_mov_pd(valid, pairScaleAvx512<Softening::Clamped>(r2, _mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, mass + j), factor)));
+        accX = _mm512_fmadd_pd(s, dx, accX);
+        accY = _mm512_fmadd_pd(s, dy, accY);
+        accZ = _mm512_fmadd_pd(s, dz, accZ);
+    }
+
+    sumX += _mm512_reduce_add_pd(accX);
+    sumY += _mm512_reduce_add_pd(accY);
+    sumZ += _mm512_reduce_add_pd(accZ);
+}
+
+/**
+ * @brief the 16 float lanes of a vector widened to double and added up
+ */
+__attribute__((target("avx512f"))) static inline double reduceAddWide(__m512 value)
+{
+    const __m512d low = _mm512_cvtps_pd(_mm512_castps512_ps256(value));
+    const __m512d high = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(value), 1)));
+    return _mm512_reduce_add_pd(_mm512_add_pd(low, high));
+}
+
+/**
+ * AVX-512 mixed precision: 16 float sources per instruction, 14 bit rsqrt and rcp estimates refined once,
+ * the last partial vector is masked
+ */
+template <Softening S>
+__attribute__((target("avx512f"))) static inline __m512 pairScaleMixedAvx512(__m512 r2, __m512 mass, __m512 softening2)
+{
+    const __m512 half = _mm512_set1_ps(0.5f), threeHalves = _mm512_set1_ps(1.5f), two = _mm512_set1_ps(2.0f);
+    const __m512 root = S == Softening::Plummer ? _mm512_add_ps(r2, softening2) : r2;
+    __m512 inverse = _mm512_rsqrt14_ps(root);
+    inverse = _mm512_mul_ps(inverse, _mm512_fnmadd_ps(_mm512_mul_ps(half, root), _mm512_mul_ps(inverse, inverse), threeHalves));
+    if constexpr (S == Softening::Clamped)
+    {
+        const __m512 denominator = _mm512_add_ps(_mm512_max_ps(r2, softening2), softening2);
+        __m512 inverseDenominator = _mm512_rcp14_ps(denominator);
+        inverseDenominator = _mm512_mul_ps(inverseDenominator, _mm512_fnmadd_ps(denominator, inverseDenominator, two));
+        return _mm512_mul_ps(_mm512_mul_ps(mass, inverse), inverseDenominator);
+    }
+    else
+    {
+        return _mm512_mul_ps(_mm512_mul_ps(mass, inverse), _mm512_mul_ps(inverse, inverse));
+    }
+}
+
+template <Softening S>
+__attribute__((target("avx512f"))) static void mixedAvx512(const MixedBlock &block, double targetX, double targetY, double targetZ,
+                                                          double &sumX, double &sumY, double &sumZ)
+{
+    float offsetX, offsetY, offsetZ, near2, softening2;
+    mixedTarget(block, targetX, targetY, targetZ, offsetX, offsetY, offsetZ, near2, softening2);
+    const size_t count = block.count;
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 tx = _mm512_set1_ps(offsetX), ty = _mm512_set1_ps(offsetY), tz = _mm512_set1_ps(offsetZ);
+    const __m512 nearLimit = _mm512_set1_ps(near2), softening = _mm512_set1_ps(softening2);
+    __m512 accX = zero, accY = zero, accZ = zero;
+
+    for (size_t j = 0; j < count; j += 16)
+    {
+        const __mmask16 lanes = count - j >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - j)) - 1);
+        const __m512 dx = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, block.x + j), tx);
+        const __m512 dy = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, block.y + j), ty);
+        const __m512 dz = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, block.z + j), tz);
+        const __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+        const __mmask16 far = _mm512_mask_cmp_ps_mask(lanes, r2, nearLimit, _CMP_GE_OQ);
+        const __m512 s = _mm512_maskz_mov_ps(far, pairScaleMixedAvx512<S>(r2, _mm512_maskz_loadu_ps(lanes, block.mass + j), softening));
+        accX = _mm512_fmadd_ps(s, dx, accX);
+        accY = _mm512_fmadd_ps(s, dy, accY);
+        accZ = _mm512_fmadd_ps(s, dz, accZ);
+
+        for (unsigned close = lanes & ~far; close != 0; close &= close - 1)
+        {
+            const size_t k = j + __builtin_ctz(close);
+            addPairScalar<S>(block.exactX[k] - targetX, block.exactY[k] - targetY, block.exactZ[k] - targetZ, block.exactMass[k], sumX, sumY, sumZ);
+        }
+    }
+
+    const double scale = block.massUnit / (block.length * block.length);
+    sumX += scale * reduceAddWide(accX);
+    sumY += scale * reduceAddWide(accY);
+    sumZ += scale * reduceAddWide(accZ);
+}
+
+__attribute__((target("avx2,fma"))) static void jerkAvx2(const double *x, const double *y, const double *z, const double *vx, const double *vy, const double *vz,
+                                                        const double *mass, size_t count, double targetX, double targetY, double targetZ,
+                                                        double targetVx, double targetVy, double targetVz, double acceleration[3], double jerk[3])
+{
+    const size_t vectorEnd = count - count % 4;
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), three = _mm256_set1_pd(3.0);
+    const __m256d softening2 = _mm256_set1_pd(SOFTENING_SQUARED);
+    const __m256d xi = _mm256_set1_pd(targetX), yi = _mm256_set1_pd(targetY), zi = _mm256_set1_pd(targetZ);
+    const __m256d vxi = _mm256_set1_pd(targetVx), vyi = _mm256_set1_pd(targetVy), vzi = _mm256_set1_pd(targetVz);
+    __m256d accX = zero, accY = zero, accZ = zero, jerkX = zero, jerkY = zero, jerkZ = zero;
+
+    for (size_t j = 0; j < vectorEnd; j += 4)
+    {
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), xi);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), yi);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + j), zi);
+        const __m256d dvx = _mm256_sub_pd(_mm256_loadu_pd(vx + j), vxi);
+        const __m256d dvy = _mm256_sub_pd(_mm256_loadu_pd(vy + j), vyi);
+        const __m256d dvz = _mm256_sub_pd(_mm256_loadu_pd(vz + j), vzi);
+        const __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        const __m256d valid = _mm256_cmp_pd(r2, zero, _CMP_GT_OQ); // itself and coincident bodies contribute nothing
+
+        const __m256d inverseR = rsqrtAvx2(r2);
+        const __m256d inverseDenominator = rsqrtAvx2(_mm256_add_pd(_mm256_max_pd(r2, softening2), softening2));
+        const __m256d inverseDenominator2 = _mm256_mul_pd(inverseDenominator, inverseDenominator);
+        const __m256d s = _mm256_and_pd(valid, _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(mass + j), inverseR), inverseDenominator2));
+        const __m256d outside = _mm256_cmp_pd(r2, softening2, _CMP_GT_OQ);
+        const __m256d factor = _mm256_blendv_pd(one, _mm256_mul_pd(_mm256_fmadd_pd(three, r2, softening2), inverseDenominator2), outside);
+        const __m256d rv = _mm256_fmadd_pd(dx, dvx, _mm256_fmadd_pd(dy, dvy, _mm256_mul_pd(dz, dvz)));
+        const __m256d radial = _mm256_and_pd(valid, _mm256_mul_pd(_mm256_mul_pd(rv, _mm256_mul_pd(inverseR, inverseR)), factor));
+
+        accX = _mm256_fmadd_pd(s, dx, accX);
+        accY = _mm256_fmadd_pd(s, dy, accY);
+        accZ = _mm256_fmadd_pd(s, dz, accZ);
+        jerkX = _mm256_fmadd_pd(s, _mm256_fnmadd_pd(radial, dx, dvx), jerkX);
+        jerkY = _mm256_fmadd_pd(s, _mm256_fnmadd_pd(radial, dy, dvy), jerkY);
+        jerkZ = _mm256_fmadd_pd(s, _mm256_fnmadd_pd(radial, dz, dvz), jerkZ);
+    }
+
+    const __m256d sums[6] = {accX, accY, accZ, jerkX, jerkY, jerkZ};
+    double *totals[6] = {&acceleration[0], &acceleration[1], &acceleration[2], &jerk[0], &jerk[1], &jerk[2]};
+    for (int k = 0; k < 6; k++)
+    {
+        double lanes[4];
+        _mm256_storeu_pd(lanes, sums[k]);
+        *totals[k] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+    jerkScalar(x + vectorEnd, y + vectorEnd, z + vectorEnd, vx + vectorEnd, vy + vectorEnd, vz + vectorEnd, mass + vectorEnd, count - vectorEnd,
+               targetX, targetY, targetZ, targetVx, targetVy, targetVz, acceleration, jerk);
+}
+
+__attribute__((target("avx512f"))) static void jerkAvx512(const double *x, const double *y, const double *z, const double *vx, const double *vy, const double *vz,
+                                                         const double *mass, size_t count, double targetX, double targetY, double targetZ,
+                                                         double targetVx, double targetVy, double targetVz, double acceleration[3], double jerk[3])
+{
+    const __m512d zero = _mm512_setzero_pd(), one = _mm512_set1_pd(1.0), three = _mm512_set1_pd(3.0);
+    const __m512d softening2 = _mm512_set1_pd(SOFTENING_SQUARED);
+    const __m512d xi = _mm512_set1_pd(targetX), yi = _mm512_set1_pd(targetY), zi = _mm512_set1_pd(targetZ);
+    const __m512d vxi = _mm512_set1_pd(targetVx), vyi = _mm512_set1_pd(targetVy), vzi = _mm512_set1_pd(targetVz);
+    __m512d accX = zero, accY = zero, accZ = zero, jerkX = zero, jerkY = zero, jerkZ = zero;
+
+    for (size_t j = 0; j < count; j += 8)
+    {
+        const __mmask8 lanes = count - j >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (count - j)) - 1);
+        const __m512d dx = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, x + j), xi);
+        const __m512d dy = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, y + j), yi);
+        const __m512d dz = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, z + j), zi);
+        const __m512d dvx = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, vx + j), vxi);
+        const __m512d dvy = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, vy + j), vyi);
+        const __m512d dvz = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, vz + j), vzi);
+        const __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        const __mmask8 valid = _mm512_mask_cmp_pd_mask(lanes, r2, zero, _CMP_GT_OQ); // itself and coincident bodies contribute nothing
+
+        const __m512d inverseR = rsqrtAvx512(r2);
+        const __m512d inverseDenominator = rsqrtAvx512(_mm512_add_pd(_mm512_max_pd(r2, softening2), softening2));
+        const __m512d inverseDenominator2 = _mm512_mul_pd(inverseDenominator, inverseDenominator);
+        const __m512d s = _mm512_maskz_mov_pd(valid, _mm512_mul_pd(_mm512_mul_pd(_mm512_maskz_loadu_pd(lanes, mass + j), inverseR), inverseDenominator2));
+        const __mmask8 outside = _mm512_cmp_pd_mask(r2, softening2, _CMP_GT_OQ);
+        const __m512d factor = _mm512_mask_mov_pd(one, outside, _mm512_mul_pd(_mm512_fmadd_pd(three, r2, softening2), inverseDenominator2));
+        const __m512d rv = _mm512_fmadd_pd(dx, dvx, _mm512_fmadd_pd(dy, dvy, _mm512_mul_pd(dz, dvz)));
+        const __m512d radial = _mm512_maskz_mov_pd(valid, _mm512_mul_pd(_mm512_mul_pd(rv, _mm512_mul_pd(inverseR, inverseR)), factor));
+
+        accX = _mm512_fmadd_pd(s, dx, accX);
+        accY = _mm512_fmadd_pd(s, dy, accY);
+        accZ = _mm512_fmadd_pd(s, dz, accZ);
+        jerkX = _mm512_fmadd_pd(s, _mm512_fnmadd_pd(radial, dx, dvx), jerkX);
+        jerkY = _mm512_fmadd_pd(s, _mm512_fnmadd_pd(radial, dy, dvy), jerkY);
+        jerkZ = _mm512_fmadd_pd(s, _mm512_fnmadd_pd(radial, dz, dvz), jerkZ);
+    }
+
+    acceleration[0] += _mm512_reduce_add_pd(accX);
+    acceleration[1] += _mm512_reduce_add_pd(accY);
+    acceleration[2] += _mm512_reduce_add_pd(accZ);
+    jerk[0] += _mm512_reduce_add_pd(jerkX);
+    jerk[1] += _mm512_reduce_add_pd(jerkY);
+    jerk[2] += _mm512_reduce_add_pd(jerkZ);
+}
+
+#endif
+
+/**
+ * @brief the instantiations of one softening, falls back to the scalar kernel off x86
+ */
+template <Softening S>
+static SourceKernel sourceKernelWith(SimdLevel level)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (level)
+    {
+    case SimdLevel::SSE2:
+        return sourcesSse2<S>;
+    case SimdLevel::AVX2:
+        return sourcesAvx2<S>;
+    case SimdLevel::AVX512:
+        return sourcesAvx512<S>;
+    default:
+        break;
+    }
+#endif
+    return sourcesScalar<S>;
+}
+
+/**
+ * @brief picks the kernel for an instruction set and softening
+ * @param level the instruction set, usually detectSimdLevel()
+ * @return the kernel
+ */
+SourceKernel sourceKernelFor(SimdLevel level, Softening softening)
+{
+    switch (softening)
+    {
+    case Softening::Plummer:
+        return sourceKernelWith<Softening::Plummer>(level);
+    case Softening::None:
+        return sourceKernelWith<Softening::None>(level);
+    default:
+        return sourceKernelWith<Softening::Clamped>(level);
+    }
+}
+
+/**
+ * @brief picks the short range kernel for an instruction set, SSE2 and anything off x86 get the scalar kernel
+ * @param level the instruction set, usually detectSimdLevel()
+ * @return the kernel
+ */
+ShortRangeKernel shortRangeKernelFor(SimdLevel level)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return shortRangeAvx2;
+    case SimdLevel::AVX512:
+        return shortRangeAvx512;
+    default:
+        break;
+    }
+#endif
+    return shortRangeScalar;
+}
+
+/**
+ * @brief the mixed precision instantiations of one softening, SSE2 and anything off x86 get the scalar kernel
+ */
+template <Softening S>
+static MixedKernel mixedKernelWith(SimdLevel level)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return mixedAvx2<S>;
+    case SimdLevel::AVX512:
+        return mixedAvx512<S>;
+    default:
+        break;
+    }
+#endif
+    return mixedScalar<S>;
+}
+
+/**
+ * @brief picks the mixed precision kernel for an instruction set and softening
+ * @param level the instruction set, usually detectSimdLevel()
+ * @return the kernel
+ */
+MixedKernel mixedKernelFor(SimdLevel level, Softening softening)
+{
+    switch (softening)
+    {
+    case Softening::Plummer:
+        return mixedKernelWith<Softening::Plummer>(level);
+    case Softening::None:
+        return mixedKernelWith<Softening::None>(level);
+    default:
+        return mixedKernelWith<Softening::Clamped>(level);
+    }
+}
+
+/**
+ * @brief picks the acceleration and jerk kernel for an instruction set, SSE2 and anything off x86 get the scalar kernel
+ * @param level the instruction set, usually detectSimdLevel()
+ * @return the kernel
+ */
+JerkKernel jerkKernelFor(SimdLevel level)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return jerkAvx2;
+    case SimdLevel::AVX512:
+        return jerkAvx512;
+    default:
+        break;
+    }
+#endif
+    return jerkScalar;
+}
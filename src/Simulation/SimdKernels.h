@@ -0,0 +1,85 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include "ForcePolicy.h"
+
+// instruction sets the hand vectorized kernels are written for, from narrowest to widest
+enum class SimdLevel
+{
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512
+};
+
+SimdLevel detectSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+/*
+    SourceKernel:
+        adds the pull of count sources on one target to sumX, sumY, sumZ, left unscaled:
+        sum of  m2 * (x2 - x1) / ((max(r*r, e*e) + e*e) * r)  over the sources with the default clamped softening,
+        the caller multiplies by G and the target's gravitationalMultiplier
+        sources sitting exactly on the target (itself, coincident bodies) contribute nothing
+*/
+typedef void (*SourceKernel)(const double *x, const double *y, const double *z, const double *mass, std::size_t count,
+                             double targetX, double targetY, double targetZ,
+                             double &sumX, double &sumY, double &sumZ);
+
+SourceKernel sourceKernelFor(SimdLevel level, Softening softening = Softening::Clamped);
+
+/*
+    ShortRangeKernel:
+        as SourceKernel with clamped softening, the pull of every source scaled by a factor read from a table against r*r:
+        t = min(r*r * tableScale, tableEnd), factor = table[t] interpolated linearly towards table[t + 1],
+        so table needs tableEnd + 2 entries, a table ending in zeros cuts the sum off without a branch
+        SSE2 has no gather and uses the scalar kernel
+*/
+typedef void (*ShortRangeKernel)(const double *x, const double *y, const double *z, const double *mass, std::size_t count,
+                                 double targetX, double targetY, double targetZ,
+                                 const double *table, double tableScale, double tableEnd,
+                                 double &sumX, double &sumY, double &sumZ);
+
+ShortRangeKernel shortRangeKernelFor(SimdLevel level);
+
+/*
+    MixedBlock:
+        a block of sources packed for the mixed precision kernel, positions as float offsets from the block's centre
+        in units of length, masses in units of massUnit, with the double arrays they were packed from
+        for the pairs too close for float
+*/
+struct MixedBlock
+{
+        const float *x, *y, *z, *mass;
+        std::size_t count;
+        double centerX, centerY, centerZ;
+        double length;                                   // at least the block's radius
+        double massUnit;                                 // the heaviest source's mass
+        const double *exactX, *exactY, *exactZ, *exactMass;
+};
+
+/*
+    MixedKernel:
+        as SourceKernel over a MixedBlock, the pair terms in float and the block's total added to the sums in double
+        a pair closer than 1/1024 of the target's distance from the centre plus the block's radius would lose more
+        than 2^-14 of its offset to float rounding, so it is summed in double from the exact arrays instead
+*/
+typedef void (*MixedKernel)(const MixedBlock &block, double targetX, double targetY, double targetZ,
+                            double &sumX, double &sumY, double &sumZ);
+
+MixedKernel mixedKernelFor(SimdLevel level, Softening softening = Softening::Clamped);
+
+/*
+    JerkKernel:
+        as SourceKernel with clamped softening, adding to jerk the time derivative of every pull as well,
+        from the sources' velocities relative to the target's, both left unscaled
+        SSE2 uses the scalar kernel
+*/
+typedef void (*JerkKernel)(const double *x, const double *y, const double *z, const double *vx, const double *vy, const double *vz,
+                           const double *mass, std::size_t count, double targetX, double targetY, double targetZ,
+                           double targetVx, double targetVy, double targetVz, double acceleration[3], double jerk[3]);
+
+JerkKernel jerkKernelFor(SimdLevel level);
+
+#endif
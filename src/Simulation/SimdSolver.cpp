@@ -0,0 +1,94 @@
+/**
+ * This file contains the implementation of the SimdSolver class, the vectorized per-target direct sum
+ *
+ * the kernels themselves live in SimdKernels.cpp so the tiled solver can run them over blocks of sources
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include "SimdSolver.h"
+using namespace std;
+
+SimdSolver::SimdSolver(SimdLevel level, Softening softening, bool replicated)
+    : simdLevel(level), kernel(sourceKernelFor(level, softening)), replicated(replicated)
+{
+}
+
+const char *SimdSolver::name() const
+{
+    switch (simdLevel)
+    {
+    case SimdLevel::SSE2:
+        return "simd (sse2)";
+    case SimdLevel::AVX2:
+        return "simd (avx2)";
+    case SimdLevel::AVX512:
+        return "simd (avx512)";
+    default:
+        return "simd (scalar)";
+    }
+}
+
+/**
+ * @brief computes the acceleration of every body against every source
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void SimdSolver::computeAccelerations(BodyStore &store)
+{
+    if (replicated)
+    {
+        replicas.refresh(store);
+    }
+    loop.run(store.size(), TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        const SourceReplicas::Sources from = sources(store);
+        for (size_t i = begin; i < end; i++)
+        {
+            accelerate(store, from, i);
+        }
+    });
+}
+
+/**
+ * @brief computes the acceleration of the listed bodies only
+ * @param store the bodies, ax/ay/az of the targets are overwritten
+ * @param targets indices of the bodies to accelerate
+ */
+void SimdSolver::computeAccelerationsOf(BodyStore &store, const vector<uint32_t> &targets)
+{
+    if (replicated)
+    {
+        replicas.refresh(store);
+    }
+    loop.run(targets.size(), TARGETS_PER_CHUNK, [&](size_t begin, size_t end) {
+        const SourceReplicas::Sources from = sources(store);
+        for (size_t k = begin; k < end; k++)
+        {
+            accelerate(store, from, targets[k]);
+        }
+    });
+}
+
+/**
+ * @brief the source arrays of the calling thread, its node's replica or the store itself
+ */
+SourceReplicas::Sources SimdSolver::sources(const BodyStore &store) const
+{
+    if (replicated)
+    {
+        return replicas.local();
+    }
+    return {store.x.data(), store.y.data(), store.z.data(), store.mass.data()};
+}
+
+/**
+ * @brief the pull of every source on body i
+ */
+void SimdSolver::accelerate(BodyStore &store, const SourceReplicas::Sources &from, size_t i) const
+{
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+    kernel(from.x, from.y, from.z, from.mass, store.size(), store.x[i], store.y[i], store.z[i], sumX, sumY, sumZ);
+    const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+    store.ax[i] = scale * sumX;
+    store.ay[i] = scale * sumY;
+    store.az[i] = scale * sumZ;
+}
@@ -0,0 +1,39 @@
+#ifndef SIMD_SOLVER_H
+#define SIMD_SOLVER_H
+
+#include "ForceSolver.h"
+#include "Numa.h"
+#include "SimdKernels.h"
+
+/*
+    SimdSolver class:
+        per-target O(N^2) sum with the source loop written in intrinsics, 2, 4 or 8 sources per instruction
+        1/r and 1/(r*r + e*e) come from a reciprocal square root estimate refined with Newton steps,
+        so the inner loop has no sqrt, no divide and no branch
+
+    the widest kernel the cpu supports is picked once at construction (cpuid),
+    DirectSolver stays the scalar reference the kernels are tested against
+    replicated reads the sources from a copy on the thread's own NUMA node, refreshed before every pass
+*/
+class SimdSolver : public ForceSolver
+{
+public:
+        explicit SimdSolver(SimdLevel level = detectSimdLevel(), Softening softening = Softening::Clamped, bool replicated = false);
+
+        const char *name() const override;
+        void computeAccelerations(BodyStore &store) override;
+        void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) override;
+
+        SimdLevel level() const { return simdLevel; }
+
+private:
+        SimdLevel simdLevel;
+        SourceKernel kernel;
+        bool replicated;
+        SourceReplicas replicas;
+
+        SourceReplicas::Sources sources(const BodyStore &store) const;
+        void accelerate(BodyStore &store, const SourceReplicas::Sources &from, std::size_t i) const;
+};
+
+#endif
@@ -8,23 +8,64 @@
  *
  * @author: Brandon Trama, Cole McGregor, Hawk Lindner
  * @requirements: FileManager class, which is used to parse the input file for the creation of bodies in the simulation, and the output of the bodies to a file
- * @dependencies: body.cpp, filemanager.cpp
+ * @dependencies: body.cpp, BodyStore.cpp, filemanager.cpp, SymmetricSolver.cpp, DirectSolver.cpp, SimdSolver.cpp, TiledSolver.cpp, Octree.cpp, BarnesHutSolver.cpp, FmmSolver.cpp, Fft.cpp, PmSolver.cpp, P3mSolver.cpp, MixedSolver.cpp, PairTileSolver.cpp, BlockStepper.cpp, LegacyIntegrator.cpp, SymplecticIntegrator.cpp, HermiteIntegrator.cpp, AdaptiveIntegrator.cpp, Kepler.cpp, WisdomHolmanIntegrator.cpp, Regularization.cpp, RegularizedIntegrator.cpp, CollisionDetector.cpp, Diagnostics.cpp, WorkStealing.cpp, NBody.cpp, Numa.cpp, MpiRingSolver.cpp (make mpi)
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 #include <omp.h>
-#include "vector.h"      // Include your Vector class header
+#include "vec3.h"        // Include your Vec3 math header
 #include "body.h"        // Include your Body class header
+#include "BodyStore.h"   // Include the structure-of-arrays store used by the step loop
 #include "FileManager.h" // Include your FileManager class header
+#include "ForceSolver.h"     // Include the force solver interface
+#include "ForcePolicy.h"     // Include the softening, scaling and precision the direct-sum kernels are compiled for
+#include "DirectSolver.h"    // Include the per-target direct-sum solver
+#include "SymmetricSolver.h" // Include the Newton's third law pairwise solver
+#include "SimdSolver.h"      // Include the vectorized direct-sum solver
+#include "TiledSolver.h"     // Include the cache blocked direct-sum solver
+#include "MixedSolver.h"     // Include the mixed precision direct-sum solver
+#include "PairTileSolver.h"  // Include the 2D tiled direct-sum solver for a few bodies per thread
+#include "BarnesHutSolver.h" // Include the octree solver
+#include "FmmSolver.h"       // Include the fast multipole solver
+#include "PmSolver.h"        // Include the particle mesh solver
+#include "P3mSolver.h"       // Include the mesh plus short range solver
+#include "Integrator.h"      // Include the time stepping interface
+#include "LegacyIntegrator.h" // Include the original Body::update step
+#include "SymplecticIntegrator.h" // Include the leapfrogs and their higher order compositions
+#include "BlockStepper.h"    // Include the individual block timestep integrator
+#include "HermiteIntegrator.h" // Include the fourth order Hermite predictor-corrector
+#include "AdaptiveIntegrator.h" // Include the shared adaptive step controller
+#include "WisdomHolmanIntegrator.h" // Include the hierarchical Kepler drift integrator
+#include "RegularizedIntegrator.h" // Include the KS and chain regularization of tight groups
+#include "CollisionDetector.h" // Include the collision and merging stage
+#include "Diagnostics.h"     // Include the energy and momentum time series
+#include "NBody.h"           // Include the compile-time N engine for tiny systems
+#include "Numa.h"            // Include the NUMA topology and placement of the body arrays
+#ifdef USE_MPI
+#include <mpi.h>
+#include "MpiRingSolver.h"   // Include the direct sum over MPI ranks
+#endif
 
 using namespace std;
 
+const size_t TILED_SOLVER_THRESHOLD = 4096; // from this many bodies on, the sources no longer fit in L2 and the direct sum is tiled
+const size_t PAIR_TILE_BODIES_PER_THREAD = 16; // below this many bodies per thread, rows are too short to share out and the pair matrix is tiled
+
 class Simulation
 {
 public:
     vector<Body> bodies;            // vector of bodies in the simulation
+    BodyStore store;                // contiguous copy of the bodies' hot state, owned by the step loop
+    unique_ptr<ForceSolver> solver; // computes the accelerations of every body each step
+    unique_ptr<Integrator> integrator; // advances the bodies by one Timestep each iteration
+    unique_ptr<CollisionDetector> collisions; // merges the bodies that touch after every step, null when Collisions is off
+    unique_ptr<Diagnostics> diagnostics; // records the energies and momenta every DiagnosticsInterval steps, null when it is 0
+    unique_ptr<FixedSizeEngine> engine; // runs the whole step loop for tiny N, null when the general loop is needed
     string inputFile;               // input file for the simulation
     string outputFile;              // output file for the simulation
     double timestep;                // timestep of the simulation
@@ -32,6 +73,9 @@ public:
     int iterations;                 // number of iterations of the simulation
     int bodyCount[5];               // information about the simulation bodies: 0: N, 1: NS, 2: NP, 3: NM, 4: NB, stored in the corresponding index of the array
     FileManager fileManager;        // file manager for the simulation
+    int rank = 0, ranks = 1;        // this MPI rank and the number of them, 0 and 1 without make mpi
+    size_t firstBody = 0, ownBodies = 0; // the block of bodies this rank steps, all of them on a single rank
+    SimulationConfig config;        // optional solver settings from the input file
 
   //Simulation(vector<Body> bodies, string outputFile, double timestep, double gravitationalMultiplier, int iterations, int bodyCount[5])
   //: bodies(bodies), outputFile(outputFile), timestep(timestep), gravitationalMultiplier(gravitationalMultiplier), iterations(iterations) {}
@@ -40,12 +84,346 @@ public:
         : inputFile(inputFile), outputFile(outputFile), fileManager(inputFile) {
             // load the configuration file
             try {
-                fileManager.loadConfig(inputFile, bodies, timestep, gravitationalMultiplier, iterations, bodyCount);
+                fileManager.loadConfig(inputFile, bodies, timestep, gravitationalMultiplier, iterations, bodyCount, config);
+                if (config.endTime > 0.0) {
+                    iterations = static_cast<int>(ceil(config.endTime / timestep)); // one output interval of Timestep each
+                }
             } catch (const exception &e) {
                 cout << "Error loading input file\n"
                         << e.what() << endl;
                 exit(1);
         }
+            store.load(bodies);
+            ownBodies = bodies.size();
+#ifdef USE_MPI
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+            if (ranks > 1) {
+                // every rank read the whole input, each keeps its own block in the store, the ids still index bodies
+                firstBody = rankBlockBegin(bodies.size(), rank, ranks);
+                ownBodies = rankBlockBegin(bodies.size(), rank + 1, ranks) - firstBody;
+                vector<bool> removed(bodies.size(), true);
+                fill(removed.begin() + firstBody, removed.begin() + firstBody + ownBodies, false);
+                store.compact(removed);
+            }
+#endif
+            try {
+                solver = createSolver();
+            } catch (const exception &e) {
+                cout << "Error creating force solver\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+            try {
+                integrator = createIntegrator();
+            } catch (const exception &e) {
+                cout << "Error creating integrator\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+            try {
+                collisions = createCollisionDetector();
+            } catch (const exception &e) {
+                cout << "Error creating collision detector\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+            try {
+                diagnostics = createDiagnostics();
+            } catch (const exception &e) {
+                cout << "Error creating diagnostics\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+            try {
+                checkDistributable();
+            } catch (const exception &e) {
+                cout << "Error distributing the run over MPI ranks\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+            try {
+                engine = createFixedSizeEngine();
+            } catch (const exception &e) {
+                cout << "Error creating fixed size engine\n"
+                        << e.what() << endl;
+                exit(1);
+            }
+    }
+
+    /**
+     * @brief creates the force solver named by the Solver keyword of the input file
+     * @return the solver, auto picks the vectorized direct sum, tiled from TILED_SOLVER_THRESHOLD bodies on,
+     * and pair tiles when more than one thread shares fewer than PAIR_TILE_BODIES_PER_THREAD bodies each, unless Deterministic is on
+     */
+    unique_ptr<ForceSolver> createSolver() const {
+        const string &name = config.solver;
+        const ForcePolicy policy = forcePolicy();
+        const bool mixed = policy.precision == Precision::Mixed;
+        const bool policyKernels = name == "auto" || name == "symmetric" || name == "simd" || name == "tiled" || name == "mixed" || name == "pairtiles";
+        if (config.deterministic != "on" && config.deterministic != "off") {
+            throw invalid_argument("Deterministic must be on or off, not " + config.deterministic);
+        }
+        const bool deterministic = config.deterministic == "on";
+        if (config.numaReplicas != "on" && config.numaReplicas != "off") {
+            throw invalid_argument("NumaReplicas must be on or off, not " + config.numaReplicas);
+        }
+        const bool replicated = config.numaReplicas == "on";
+        if (config.integrator == "hermite") {
+            return make_unique<NoForceSolver>(); // hermite sums its own accelerations and jerks, createIntegrator checks Solver
+        }
+#ifdef USE_MPI
+        if (name == "ring" || (name == "auto" && ranks > 1)) {
+            if (mixed) {
+                throw invalid_argument("The ring solver has no mixed precision kernel");
+            }
+            return make_unique<MpiRingSolver>(MPI_COMM_WORLD, bodies.size(), detectSimdLevel(), policy.softening);
+        }
+        if (ranks > 1) {
+            throw invalid_argument("Over more than one MPI rank the forces come from the ring solver, Solver must be auto or ring, not " + name);
+        }
+#endif
+        if (!policyKernels && (policy.softening != Softening::Clamped || mixed)) {
+            throw invalid_argument("Softening and Precision only apply to the symmetric, simd, tiled, mixed and pairtiles solvers, not " + name);
+        }
+        if (name == "auto") {
+            if (mixed) {
+                return make_unique<MixedSolver>(detectSimdLevel(), policy.softening);
+            }
+            // pair tiles split every sum at edges set by the thread count, the deterministic mode stays on simd
+            const size_t threads = omp_get_max_threads();
+            if (threads > 1 && !deterministic && store.size() < PAIR_TILE_BODIES_PER_THREAD * threads) {
+                return make_unique<PairTileSolver>(detectSimdLevel(), policy.softening);
+            }
+            if (store.size() >= TILED_SOLVER_THRESHOLD) {
+                return make_unique<TiledSolver>(config.tileTargets, config.tileSources, detectSimdLevel(), policy.softening, replicated);
+            }
+            return make_unique<SimdSolver>(detectSimdLevel(), policy.softening, replicated); // widest kernel the cpu supports
+        }
+        if (name == "direct") {
+            return make_unique<DirectSolver>();
+        }
+        if (name == "symmetric") {
+            if (mixed) {
+                throw invalid_argument("The symmetric solver has no mixed precision kernel");
+            }
+            return make_unique<SymmetricSolver>(policy.softening, policy.scaling, deterministic);
+        }
+        if (name == "simd") {
+            if (mixed) {
+                return make_unique<MixedSolver>(detectSimdLevel(), policy.softening);
+            }
+            return make_unique<SimdSolver>(detectSimdLevel(), policy.softening, replicated);
+        }
+        if (name == "tiled") {
+            if (mixed) {
+                return make_unique<MixedSolver>(detectSimdLevel(), policy.softening);
+            }
+            return make_unique<TiledSolver>(config.tileTargets, config.tileSources, detectSimdLevel(), policy.softening, replicated);
+        }
+        if (name == "mixed") {
+            return make_unique<MixedSolver>(detectSimdLevel(), policy.softening);
+        }
+        if (name == "pairtiles") {
+            if (mixed) {
+                throw invalid_argument("The pairtiles solver has no mixed precision kernel");
+            }
+            if (deterministic) {
+                throw invalid_argument("The pairtiles solver splits its sums by the thread count, Deterministic on needs another solver");
+            }
+            return make_unique<PairTileSolver>(detectSimdLevel(), policy.softening);
+        }
+        if (name == "barneshut") {
+            return make_unique<BarnesHutSolver>(config.theta);
+        }
+        if (name == "fmm") {
+            return make_unique<FmmSolver>(config.expansionOrder, config.theta);
+        }
+        if (name == "pm") {
+            return make_unique<PmSolver>(config.gridSize, massAssignment(), 0.0, deterministic);
+        }
+        if (name == "p3m") {
+            return make_unique<P3mSolver>(config.gridSize, massAssignment(), config.splitScale, config.cutoff, detectSimdLevel(), deterministic);
+        }
+        throw invalid_argument("Unknown solver: " + name);
+    }
+
+    /**
+     * @brief creates the integrator named by the Integrator keyword of the input file
+     * @return the integrator, legacy keeps the original step, and turns into block when BlockLevels is set
+     * and into kdk under AdaptiveTimestep
+     */
+    unique_ptr<Integrator> createIntegrator() const {
+        const string &name = config.integrator;
+        if (config.adaptiveTimestep != "off") {
+            StepCriterion criterion;
+            if (config.adaptiveTimestep == "aarseth") {
+                criterion = StepCriterion::Aarseth;
+            } else if (config.adaptiveTimestep == "freefall") {
+                criterion = StepCriterion::FreeFall;
+            } else {
+                throw invalid_argument("Unknown adaptive timestep criterion: " + config.adaptiveTimestep);
+            }
+            if (name == "block" || name == "hermite" || config.blockLevels > 0) {
+                throw invalid_argument("AdaptiveTimestep drives the kdk, dkd, yoshida4, yoshida6, forestruth and wisdomholman integrators, block and hermite size their own steps");
+            }
+            if (criterion == StepCriterion::FreeFall && config.regularizationRadius > 0.0) {
+                throw invalid_argument("The freefall criterion sizes the step from the tightest pair, which regularization takes out of the step, use aarseth");
+            }
+            return make_unique<AdaptiveIntegrator>(createSteppingIntegrator(name == "legacy" ? "kdk" : name), timestep, criterion, config.timestepAccuracy);
+        }
+        if (config.regularizationRadius > 0.0) {
+            if (name == "block" || name == "hermite" || config.blockLevels > 0) {
+                throw invalid_argument("RegularizationRadius wraps the kdk, dkd, yoshida4, yoshida6 and forestruth integrators, not " + name);
+            }
+            return createSteppingIntegrator(name == "legacy" ? "kdk" : name);
+        }
+        if (name == "block" || (name == "legacy" && config.blockLevels > 0)) {
+            return make_unique<BlockStepper>(timestep, config.blockLevels, config.timestepAccuracy);
+        }
+        if (config.blockLevels > 0) {
+            throw invalid_argument("BlockLevels only applies to the block integrator, not " + name);
+        }
+        if (name == "legacy") {
+            return make_unique<LegacyIntegrator>(timestep);
+        }
+        if (name == "hermite") {
+            const ForcePolicy policy = forcePolicy();
+            if (config.solver != "auto" || policy.softening != Softening::Clamped || policy.precision != Precision::Double) {
+                throw invalid_argument("The hermite integrator sums its own accelerations and jerks with the widest jerk kernel, Solver must be auto with the default Softening and Precision");
+            }
+            return make_unique<HermiteIntegrator>(timestep, config.timestepAccuracy);
+        }
+        return createSteppingIntegrator(name);
+    }
+
+    /**
+     * @brief the integrators that take a step of any length, the hierarchical one built from the bodies' children lists,
+     * wrapped in the regularization of tight groups when RegularizationRadius is set
+     */
+    unique_ptr<SteppingIntegrator> createSteppingIntegrator(const string &name) const {
+        if (name == "wisdomholman") {
+            if (config.regularizationRadius > 0.0) {
+                throw invalid_argument("The wisdomholman integrator follows the bodies' hierarchy, RegularizationRadius would replace them with composites");
+            }
+            return make_unique<WisdomHolmanIntegrator>(timestep, parentIndices(bodies));
+        }
+        if (config.regularizationRadius > 0.0) {
+            return make_unique<RegularizedIntegrator>(makeSymplecticIntegrator(name, timestep), timestep, config.regularizationRadius);
+        }
+        return makeSymplecticIntegrator(name, timestep);
+    }
+
+    /**
+     * @brief the collision stage named by the Collisions keyword of the input file, none when it is off
+     */
+    unique_ptr<CollisionDetector> createCollisionDetector() const {
+        if (config.collisions == "off") {
+            return nullptr;
+        }
+        if (config.collisions != "merge") {
+            throw invalid_argument("Unknown collisions mode: " + config.collisions);
+        }
+        if (config.integrator == "wisdomholman") {
+            throw invalid_argument("The wisdomholman integrator follows the bodies' hierarchy, which merging would break");
+        }
+        return make_unique<CollisionDetector>(bodies.size());
+    }
+
+    /**
+     * @brief the diagnostics time series of the DiagnosticsInterval and DiagnosticsFile keywords, none when the interval is 0
+     */
+    unique_ptr<Diagnostics> createDiagnostics() const {
+        if (config.diagnosticsInterval < 0) {
+            throw invalid_argument("DiagnosticsInterval must not be negative");
+        }
+        if (config.diagnosticsInterval == 0) {
+            return nullptr;
+        }
+        return make_unique<Diagnostics>(config.diagnosticsFile, config.diagnosticsInterval);
+    }
+
+    /**
+     * @brief the force evaluations of the integrator or the fixed size engine, summed over the MPI ranks, called by every rank
+     */
+    uint64_t forceEvaluations() const {
+        uint64_t count = engine ? engine->forceEvaluations() : integrator->forceEvaluations();
+#ifdef USE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &count, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+#endif
+        return count;
+    }
+
+    /**
+     * @brief over more than one MPI rank, every stage of the step has to work on the rank's own block alone:
+     * the legacy or a symplectic integrator on a fixed Timestep, no regularization, collisions or diagnostics,
+     * which all need bodies of other ranks or sums over all of them
+     */
+    void checkDistributable() const {
+        if (ranks == 1) {
+            return;
+        }
+        const string &name = config.integrator;
+        if (name != "legacy" && name != "kdk" && name != "dkd" && name != "yoshida4" && name != "yoshida6" && name != "forestruth") {
+            throw invalid_argument("The " + name + " integrator does not run over MPI ranks, use legacy, kdk, dkd, yoshida4, yoshida6 or forestruth");
+        }
+        if (config.blockLevels > 0 || config.adaptiveTimestep != "off" || config.regularizationRadius > 0.0 || collisions || diagnostics) {
+            throw invalid_argument("BlockLevels, AdaptiveTimestep, RegularizationRadius, Collisions and DiagnosticsInterval do not run over MPI ranks");
+        }
+    }
+
+    /**
+     * @brief the compile-time N engine when FixedSize is auto, there is one for N and the run only asks for what it does:
+     * Solver auto with the default Softening and Precision, the legacy or a symplectic integrator on a fixed Timestep,
+     * no regularization, collisions or diagnostics
+     */
+    unique_ptr<FixedSizeEngine> createFixedSizeEngine() const {
+        if (config.fixedSize != "auto" && config.fixedSize != "off") {
+            throw invalid_argument("FixedSize must be auto or off, not " + config.fixedSize);
+        }
+        const ForcePolicy policy = forcePolicy();
+        if (config.fixedSize == "off" || config.solver != "auto" || ranks > 1 || policy.softening != Softening::Clamped || policy.precision != Precision::Double ||
+            config.blockLevels > 0 || config.adaptiveTimestep != "off" || config.regularizationRadius > 0.0 || collisions || diagnostics) {
+            return nullptr;
+        }
+        return makeFixedSizeEngine(store.size(), config.integrator, timestep);
+    }
+
+    /**
+     * @brief the kernel policy from the Softening and Precision keywords, uniform scaling when every body shares its multiplier
+     */
+    ForcePolicy forcePolicy() const {
+        ForcePolicy policy;
+        if (config.softening == "plummer") {
+            policy.softening = Softening::Plummer;
+        } else if (config.softening == "none") {
+            policy.softening = Softening::None;
+        } else if (config.softening != "clamped") {
+            throw invalid_argument("Unknown softening: " + config.softening);
+        }
+        if (config.precision == "mixed") {
+            policy.precision = Precision::Mixed;
+        } else if (config.precision != "double") {
+            throw invalid_argument("Unknown precision: " + config.precision);
+        }
+        const vector<double> &multipliers = store.gravitationalMultiplier;
+        if (all_of(multipliers.begin(), multipliers.end(), [&](double m) { return m == multipliers.front(); })) {
+            policy.scaling = Scaling::Uniform;
+        }
+        return policy;
+    }
+
+    /**
+     * @brief the mesh assignment scheme named by the Assignment keyword of the input file
+     */
+    MassAssignment massAssignment() const {
+        if (config.assignment == "cic") {
+            return MassAssignment::CIC;
+        }
+        if (config.assignment == "tsc") {
+            return MassAssignment::TSC;
+        }
+        throw invalid_argument("Unknown mass assignment: " + config.assignment);
     }
 
     /**
@@ -59,60 +437,65 @@ public:
      *
      */
     void run(double timeStep, int iterations) {
-    double total_time = 0.0;
-
-    if (omp_get_max_threads() > bodies.size()) {
-        cerr << "Number of threads cannot exceed the number of bodies" << endl;
-        exit(1);
+    if (engine) {
+        runFixedSize(iterations);
+        return;
     }
-    int chunk_size = bodies.size() / omp_get_max_threads();
+    double total_time = 0.0;
+    const NumaTopology topology = detectNumaTopology();
+    vector<int> nodeOfThread; // the node every thread runs on, filled by the threads themselves
 
     #pragma omp parallel
     {
         #pragma omp single
         {
-            cout << "Using " << omp_get_num_threads() << " threads:" << endl << endl;
+            const HermiteIntegrator *hermite = dynamic_cast<const HermiteIntegrator *>(integrator.get());
+            const string forces = hermite ? string(hermite->kernelName()) + " jerk kernel" : string(solver->name()) + " force solver";
+            cout << "Using " << (ranks > 1 ? to_string(ranks) + " MPI ranks of " : "") << omp_get_num_threads() << " threads, " << forces << ", " << integrator->name() << " integrator:" << endl << endl;
         }
 
+        // the loops lay their runs out node by node, and each run's bodies are moved onto its thread's node
+        threadPlacement(topology, nodeOfThread);
+        #pragma omp single
+        {
+            reportPlacement(cout, topology, nodeOfThread, config.numaReplicas == "on");
+            WorkStealingLoop::placeThreads(nodeOfThread);
+        }
+        placeFirstTouch(store);
+
         double start_comp_time = omp_get_wtime();
 
+        integrator->start(store, *solver); // every thread takes part, the integrator and solver share out the work
+        if (diagnostics) {
+            diagnostics->record(store, 0, 0.0); // the reference the energy error is measured against
+        }
+
         for (int step = 0; step < iterations + 1; step++) {
-            // Step 1: Calculate forces and perform half-step velocity update
-            #pragma omp for schedule(dynamic, chunk_size)
-            for (size_t i = 0; i < bodies.size(); i++) {
-                Vector totalForce = bodies[i].sumForces(bodies); // Calculate total force
-                bodies[i].applyForce(totalForce);                // Apply force to compute acceleration
-                bodies[i].update(timeStep, true);                // Half-step velocity update
+            if (collisions) {
+                collisions->snapshot(store); // the start of every body's swept path
             }
-
-            // Step 2: Update positions and finalize velocities
-            #pragma omp for schedule(dynamic, chunk_size)
-            for (size_t i = 0; i < bodies.size(); i++) {
-                bodies[i].update(timeStep, false); // Update position and finalize velocity
+            integrator->advance(store, *solver);
+            // a merge restarts the integrator, which is synchronized first so start's opening half kick is the only one
+            if (collisions && collisions->resolve(store, [&](BodyStore &bodies) { integrator->synchronize(bodies); }) > 0) {
+                integrator->start(store, *solver); // the store shrank, the scheme starts afresh on the merged bodies
+            }
+            if (diagnostics && diagnostics->due(step + 1)) {
+                #pragma omp single
+                integrator->synchronize(store); // the energies need the velocities at the positions' time
+                diagnostics->record(store, step + 1, (step + 1) * timeStep);
+            }
+            #pragma omp for schedule(static)
+            for (size_t i = firstBody; i < firstBody + ownBodies; i++) {
+                store.recordTrajectory(collisions ? collisions->slotOf(i) : i - firstBody, bodies[i]); // update trajectory, merged bodies follow their survivor
             }
 
             // A single thread will handle output
             #pragma omp single
             {
-                if (step % 100000 == 0) {
-                    if (step == iterations) {
-                        double end_comp_time = omp_get_wtime();
-                        cout << "Simulation reached " << step << " iterations" << endl;
-                        cout << endl << "Computation time: " << end_comp_time - start_comp_time << " seconds" << endl;
-
-                        cout << endl << "Outputting to file..." << endl;
-                        double start_out_time = omp_get_wtime();
-                        fileManager.outputResults(outputFile, bodies, step);
-                        cout << "Done!" << endl;
-
-                        double end_out_time = omp_get_wtime();
-                        cout << endl << "Outputting took " << end_out_time - start_out_time << " seconds" << endl;
-                        cout << endl << "File Destination: " << outputFile << endl;
-
-                        total_time = (end_comp_time - start_comp_time) + (end_out_time - start_out_time);
-                    } else {
-                        cout << "Simulation reached " << step << " iterations" << endl;
-                    }
+                if (step == iterations) {
+                    total_time = finishRun(step, start_comp_time);
+                } else if (step % 100000 == 0) {
+                    cout << "Simulation reached " << step << " iterations" << endl;
                 }
             }
         }
@@ -120,6 +503,73 @@ public:
     cout << endl << "Elapsed time: " << total_time << " seconds" << endl;
 }
 
+    /**
+     * @brief the step loop of run on the compile-time N engine, one thread, the same steps, trajectories and output
+     * @param iterations the number of iterations of the simulation
+     */
+    void runFixedSize(int iterations) {
+    double total_time = 0.0;
+    cout << "Using 1 thread, fixed size engine for " << engine->size() << " bodies, " << integrator->name() << " integrator:" << endl << endl;
+
+    double start_comp_time = omp_get_wtime();
+    engine->start(store);
+
+    for (int step = 0; step < iterations + 1; step++) {
+        engine->advance(bodies); // steps and appends every body's position to its trajectory
+
+        if (step == iterations) {
+            total_time = finishRun(step, start_comp_time);
+        } else if (step % 100000 == 0) {
+            cout << "Simulation reached " << step << " iterations" << endl;
+        }
+    }
+    cout << endl << "Elapsed time: " << total_time << " seconds" << endl;
+}
+
+    /**
+     * @brief the end of run and runFixedSize: the last report, the velocities in step with the positions, the output
+     * @param step the step just taken, the last
+     * @param start_comp_time omp_get_wtime at the start of the step loop
+     * @return the computation and output time
+     */
+    double finishRun(int step, double start_comp_time) {
+        double end_comp_time = omp_get_wtime();
+        cout << "Simulation reached " << step << " iterations" << endl;
+        cout << endl << "Computation time: " << end_comp_time - start_comp_time << " seconds" << endl;
+        cout << "Force evaluations: " << forceEvaluations() << " (" << integrator->name() << " integrator)" << endl;
+        if (const AdaptiveIntegrator *adaptive = dynamic_cast<const AdaptiveIntegrator *>(integrator.get())) {
+            cout << "Adaptive steps: " << adaptive->stepsTaken() << ", the shortest " << adaptive->smallestStep() << " seconds" << endl;
+        }
+        if (collisions) {
+            cout << "Collisions: " << collisions->mergedBodies() << " bodies merged, " << store.size() << " left" << endl;
+        }
+        if (diagnostics) {
+            cout << "Energy error: " << diagnostics->energyError() << " (" << config.diagnosticsFile << ")" << endl;
+        }
+        if (engine) {
+            engine->save(store); // the engine keeps the bodies to itself until now
+        } else {
+            integrator->synchronize(store); // velocities back in step with the positions for output
+        }
+
+        cout << endl << "Outputting to file..." << endl;
+        double start_out_time = omp_get_wtime();
+        store.writeBack(bodies);
+#ifdef USE_MPI
+        gatherTrajectories(bodies, MPI_COMM_WORLD); // rank 0 writes every rank's bodies
+#endif
+        if (rank == 0) {
+            fileManager.outputResults(outputFile, bodies, step);
+        }
+        cout << "Done!" << endl;
+
+        double end_out_time = omp_get_wtime();
+        cout << endl << "Outputting took " << end_out_time - start_out_time << " seconds" << endl;
+        cout << endl << "File Destination: " << outputFile << endl;
+
+        return (end_comp_time - start_comp_time) + (end_out_time - start_out_time);
+    }
+
 };
 
 int main(int argc, char *argv[])
@@ -196,12 +646,29 @@ int main(int argc, char *argv[])
     // set the output file
     const string outputFile = "../output.txt";
 
+#ifdef USE_MPI
+    // the ring solver's MPI calls come from one thread of each rank at a time
+    int provided, rank;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    if (provided < MPI_THREAD_SERIALIZED) {
+        cerr << "The MPI library cannot be called from OpenMP threads" << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank != 0) {
+        cout.setstate(ios::failbit); // every rank runs the same steps, rank 0 reports for all of them
+    }
+#endif
+
     // create the simulation
     Simulation sim(inputFile, outputFile);
     // initiateHeavenscape(sim.bodies, sim.bodyCount);
     //  run the simulation
     sim.run(sim.timestep, sim.iterations);
 
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
     return 0;
 }
 
@@ -0,0 +1,39 @@
+#ifndef SIMULATION_CONFIG_H
+#define SIMULATION_CONFIG_H
+
+#include <cstddef>
+#include <string>
+
+/*
+    SimulationConfig struct:
+        the optional settings FileManager::loadConfig reads from the input file next to Timestep and Iterations,
+        every field has a default, so input files that do not mention them load unchanged
+*/
+struct SimulationConfig
+{
+        std::string solver = "auto"; // Solver: direct, symmetric, simd, tiled, mixed, pairtiles, barneshut, fmm, pm, p3m, ring (make mpi), auto picks simd, tiled or pairtiles from N and the thread count, ring over more than one MPI rank
+        double theta = 0.5;          // Theta: Barnes-Hut opening angle, for fmm the largest (r1 + r2) / d of a cell pair used whole
+        int expansionOrder = 4;      // ExpansionOrder: order of the fmm Taylor expansions, 1 to 12
+        std::size_t tileTargets = 0; // TileTargets: targets per tile of the tiled solver, 0 sizes it from the L1 cache
+        std::size_t tileSources = 0; // TileSources: sources per packed block of the tiled solver, 0 sizes it from the L1 cache
+        std::size_t gridSize = 64;   // GridSize: mesh points per axis of the pm and p3m solvers, a power of two
+        std::string assignment = "cic"; // Assignment: cic or tsc, how the pm and p3m solvers spread mass onto their mesh
+        double splitScale = 1.25;    // SplitScale: p3m split between mesh and direct sum, in mesh cells
+        double cutoff = 5.0;         // Cutoff: p3m short range cutoff, in units of the split scale
+        std::string softening = "clamped"; // Softening: clamped (as Body::gravForce), plummer or none, for the symmetric, simd, tiled, mixed and pairtiles solvers
+        std::string precision = "double";  // Precision: double, or mixed to run simd, tiled and auto on the mixed precision solver
+        std::string deterministic = "off"; // Deterministic: on sums the symmetric, pm and p3m forces in fixed blocks, so no result depends on the thread count, the other solvers never do, pairtiles is not allowed with it and auto skips it
+        std::string integrator = "legacy"; // Integrator: legacy (the original half kick step), kdk, dkd, yoshida4, yoshida6, forestruth, wisdomholman (Kepler drift around the parents of the children lists), hermite or block
+        int blockLevels = 0;         // BlockLevels: block integrator steps down to Timestep / 2^BlockLevels, setting it picks block over legacy
+        std::string adaptiveTimestep = "off"; // AdaptiveTimestep: off, aarseth or freefall, steps of the integrator sized every step, Timestep is then the longest step and the output interval, legacy runs as kdk
+        double endTime = 0.0;        // EndTime: simulated seconds to run, Iterations becomes EndTime / Timestep, 0 keeps Iterations
+        double regularizationRadius = 0.0; // RegularizationRadius: bodies closer than this move as a KS pair or chain around their centre of mass, 0 turns it off, legacy runs as kdk
+        std::string collisions = "off"; // Collisions: off, or merge, bodies whose radii touch during a step merge into one, conserving momentum
+        int diagnosticsInterval = 0; // DiagnosticsInterval: steps between two records of the energies, momenta and centre of mass, 0 records none
+        std::string diagnosticsFile = "../diagnostics.txt"; // DiagnosticsFile: the time series the records are appended to, one line each
+        std::string fixedSize = "auto"; // FixedSize: auto runs N from 2 to 16 on the compile-time NBody engine when nothing else asks for the general step loop, off never does
+        std::string numaReplicas = "off"; // NumaReplicas: on gives the simd and tiled solvers a copy of the sources on every NUMA node, off has every node read the one store
+        double timestepAccuracy = 0.02; // TimestepAccuracy: accuracy parameter of the block (eta |a| / |da/dt|) hermite (Aarseth) and adaptive step criteria
+};
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * This file contains the implementation of the SymmetricSolver class, the Newton's third law O(N^2) force sum
+ *
+ * the pair (i, j) is only visited from row i, so the rows get shorter as i grows,
+ * rows are handed out dynamically in small chunks to even out the triangle between the threads
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+#include "Reduction.h"
+#include "SymmetricSolver.h"
+using namespace std;
+
+const size_t DOUBLES_PER_CACHE_LINE = 8;
+const size_t ROWS_PER_CHUNK = 16;
+
+SymmetricSolver::SymmetricSolver(Softening softening, Scaling scaling, bool deterministic) : scaling(scaling), deterministic(deterministic)
+{
+    const bool uniform = scaling == Scaling::Uniform;
+    switch (softening)
+    {
+    case Softening::Plummer:
+        pairLoop = uniform ? &SymmetricSolver::sumPairs<Softening::Plummer, Scaling::Uniform> : &SymmetricSolver::sumPairs<Softening::Plummer, Scaling::PerBody>;
+        break;
+    case Softening::None:
+        pairLoop = uniform ? &SymmetricSolver::sumPairs<Softening::None, Scaling::Uniform> : &SymmetricSolver::sumPairs<Softening::None, Scaling::PerBody>;
+        break;
+    default:
+        pairLoop = uniform ? &SymmetricSolver::sumPairs<Softening::Clamped, Scaling::Uniform> : &SymmetricSolver::sumPairs<Softening::Clamped, Scaling::PerBody>;
+        break;
+    }
+}
+
+/**
+ * @brief computes the acceleration of every body from each pair evaluated once
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void SymmetricSolver::computeAccelerations(BodyStore &store)
+{
+    const size_t n = store.size();
+
+    #pragma omp single
+    {
+        threadCount = deterministic ? static_cast<int>(DETERMINISTIC_BLOCKS) : omp_get_num_threads();
+        stride = ((n + DOUBLES_PER_CACHE_LINE - 1) / DOUBLES_PER_CACHE_LINE + 1) * DOUBLES_PER_CACHE_LINE;
+        if (buffers.size() < 3 * stride * threadCount)
+        {
+            buffers.resize(3 * stride * threadCount);
+        }
+    }
+
+    if (deterministic)
+    {
+        // a block per fixed range of rows, whichever thread takes it fills it in the same order
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t b = 0; b < DETERMINISTIC_BLOCKS; b++)
+        {
+            double *bufX = &buffers[3 * stride * b];
+            fill(bufX, bufX + 3 * stride, 0.0);
+            (this->*pairLoop)(store, triangleBlockBegin(n, b, DETERMINISTIC_BLOCKS), triangleBlockBegin(n, b + 1, DETERMINISTIC_BLOCKS),
+                              bufX, bufX + stride, bufX + 2 * stride);
+        }
+    }
+    else
+    {
+        // every thread clears and fills only its own block, so no barrier is needed before the pair loop
+        double *bufX = &buffers[3 * stride * omp_get_thread_num()];
+        double *bufY = bufX + stride;
+        double *bufZ = bufY + stride;
+        fill(bufX, bufX + 3 * stride, 0.0);
+
+        // the rows get shorter as i grows, small chunks even out the triangle between the threads
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t first = 0; first < n; first += ROWS_PER_CHUNK)
+        {
+            (this->*pairLoop)(store, first, min(n, first + ROWS_PER_CHUNK), bufX, bufY, bufZ);
+        }
+    }
+    // implicit barrier: every block is complete before the reduction reads it
+
+    // uniform runs left G and the common multiplier out of the blocks
+    const double scale = scaling == Scaling::Uniform && n > 0 ? GRAVITY_CONSTANT * store.gravitationalMultiplier[0] : 1.0;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < n; i++)
+    {
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+        if (deterministic)
+        {
+            sumX = pairwiseSum(&buffers[i], threadCount, 3 * stride);
+            sumY = pairwiseSum(&buffers[stride + i], threadCount, 3 * stride);
+            sumZ = pairwiseSum(&buffers[2 * stride + i], threadCount, 3 * stride);
+        }
+        else
+        {
+            for (int t = 0; t < threadCount; t++)
+            {
+                const double *block = &buffers[3 * stride * t];
+                sumX += block[i];
+                sumY += block[stride + i];
+                sumZ += block[2 * stride + i];
+            }
+        }
+        store.ax[i] = scale * sumX;
+        store.ay[i] = scale * sumY;
+        store.az[i] = scale * sumZ;
+    }
+}
+
+/**
+ * @brief rows begin to end of the pair triangle, into one block
+ */
+template <Softening S, Scaling C>
+void SymmetricSolver::sumPairs(const BodyStore &store, size_t begin, size_t end, double *bufX, double *bufY, double *bufZ) const
+{
+    const size_t n = store.size();
+    const double softening2 = SOFTENING_LENGTH * SOFTENING_LENGTH;
+    const double *x = store.x.data(), *y = store.y.data(), *z = store.z.data();
+    const double *mass = store.mass.data();
+    const double *multiplier = store.gravitationalMultiplier.data();
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const double xi = x[i], yi = y[i], zi = z[i];
+        const double massI = mass[i];
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+        for (size_t j = i + 1; j < n; j++)
+        {
+            const double dx = x[j] - xi;
+            const double dy = y[j] - yi;
+            const double dz = z[j] - zi;
+            // coincident bodies have no direction to pull along, their pair contributes nothing
+            const double s = pairScale<S>(dx * dx + dy * dy + dz * dz, 1.0, softening2);
+
+            sumX += mass[j] * s * dx;
+            sumY += mass[j] * s * dy;
+            sumZ += mass[j] * s * dz;
+
+            const double reaction = C == Scaling::Uniform ? massI * s : GRAVITY_CONSTANT * multiplier[j] * massI * s;
+            bufX[j] -= reaction * dx;
+            bufY[j] -= reaction * dy;
+            bufZ[j] -= reaction * dz;
+        }
+
+        const double scale = C == Scaling::Uniform ? 1.0 : GRAVITY_CONSTANT * multiplier[i];
+        bufX[i] += scale * sumX;
+        bufY[i] += scale * sumY;
+        bufZ[i] += scale * sumZ;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef SYMMETRIC_SOLVER_H
+#define SYMMETRIC_SOLVER_H
+
+#include <cstddef>
+#include <vector>
+#include "ForcePolicy.h"
+#include "ForceSolver.h"
+
+/*
+    SymmetricSolver class:
+        O(N^2) sum that evaluates each unordered pair once and applies Newton's third law,
+        the equal and opposite contributions land in a private, cache line padded buffer per thread,
+        the buffers are then reduced across threads with one more worksharing loop over the bodies
+
+    deterministic runs fill one block per row range of Reduction.h instead of one per thread, and add the blocks pairwise,
+    so the accelerations do not depend on the thread count, at 64 blocks of 3N doubles
+
+    the reaction on the source reads the source's multiplier inside the pair loop, with uniform scaling
+    the loop is compiled without it and G times the common multiplier is applied once in the reduction
+*/
+class SymmetricSolver : public ForceSolver
+{
+public:
+        explicit SymmetricSolver(Softening softening = Softening::Clamped, Scaling scaling = Scaling::PerBody, bool deterministic = false);
+
+        const char *name() const override { return "symmetric"; }
+        void computeAccelerations(BodyStore &store) override;
+
+private:
+        typedef void (SymmetricSolver::*PairLoop)(const BodyStore &store, std::size_t begin, std::size_t end, double *bufX, double *bufY, double *bufZ) const;
+
+        Scaling scaling;
+        bool deterministic;
+        PairLoop pairLoop;           // the instantiation of sumPairs for the solver's policy
+        std::vector<double> buffers; // x, y, z partial accelerations of every thread, one block per thread
+        std::size_t stride = 0;      // doubles per component in a block, whole cache lines plus one line of padding
+        int threadCount = 0;         // number of blocks in use
+
+        template <Softening S, Scaling C>
+        void sumPairs(const BodyStore &store, std::size_t begin, std::size_t end, double *bufX, double *bufY, double *bufZ) const;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * This file contains the implementation of the SymplecticIntegrator class, the leapfrog and its compositions
+ *
+ * every stage is one pass over the bodies, the kick and the drift that follow each other without a force evaluation
+ * in between are done in the same pass, so a step is K passes, K force evaluations and one closing pass
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <stdexcept>
+#include "SymplecticIntegrator.h"
+using namespace std;
+
+static inline void kick(BodyStore &store, size_t i, double time)
+{
+    store.vx[i] += store.ax[i] * time;
+    store.vy[i] += store.ay[i] * time;
+    store.vz[i] += store.az[i] * time;
+}
+
+static inline void drift(BodyStore &store, size_t i, double time)
+{
+    store.x[i] += store.vx[i] * time;
+    store.y[i] += store.vy[i] * time;
+    store.z[i] += store.vz[i] * time;
+}
+
+/**
+ * @brief a kick first scheme needs the accelerations at the start of its first step
+ */
+template <class Scheme>
+void SymplecticIntegrator<Scheme>::start(BodyStore &store, ForceSolver &solver)
+{
+    if constexpr (Scheme::kickFirst)
+    {
+        solver.computeAccelerations(store);
+        #pragma omp single nowait
+        evaluations += store.size();
+    }
+}
+
+/**
+ * @brief one step of the scheme, every stage shared out between the threads
+ * @param store the bodies, positions and velocities at the same time before and after
+ * @param solver computes the accelerations between the stages
+ * @param dt the length of the step
+ */
+template <class Scheme>
+void SymplecticIntegrator<Scheme>::step(BodyStore &store, ForceSolver &solver, double dt)
+{
+    constexpr size_t K = Scheme::weights.size();
+    constexpr array<double, K + 1> outer = mergedHalves(Scheme::weights);
+    const size_t n = store.size();
+
+    for (size_t k = 0; k < K; k++)
+    {
+        const double inner = Scheme::weights[k] * dt;
+        if constexpr (Scheme::kickFirst)
+        {
+            const double first = outer[k] * dt;
+            loop.run(n, BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    kick(store, i, first);
+                    drift(store, i, inner);
+                }
+            });
+        }
+        else
+        {
+            // the first drift has no kick before it, the kick of the previous stage is merged into the pass otherwise
+            const double previous = k == 0 ? 0.0 : Scheme::weights[k - 1] * dt, first = outer[k] * dt;
+            loop.run(n, BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    kick(store, i, previous);
+                    drift(store, i, first);
+                }
+            });
+        }
+        solver.computeAccelerations(store);
+    }
+
+    const double closing = (Scheme::kickFirst ? outer[K] : Scheme::weights[K - 1]) * dt;
+    loop.run(n, BODIES_PER_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            kick(store, i, closing);
+            if constexpr (!Scheme::kickFirst)
+            {
+                drift(store, i, outer[K] * dt);
+            }
+        }
+    });
+
+    #pragma omp single nowait
+    evaluations += K * n;
+}
+
+template class SymplecticIntegrator<LeapfrogKdk>;
+template class SymplecticIntegrator<LeapfrogDkd>;
+template class SymplecticIntegrator<Yoshida4>;
+template class SymplecticIntegrator<Yoshida6>;
+template class SymplecticIntegrator<ForestRuth>;
+
+/**
+ * @brief the symplectic integrator named by the Integrator keyword of the input file
+ * @throws invalid_argument for a name that is not one of kdk, dkd, yoshida4, yoshida6 or forestruth
+ */
+unique_ptr<SteppingIntegrator> makeSymplecticIntegrator(const string &name, double timestep)
+{
+    if (name == LeapfrogKdk::name)
+    {
+        return make_unique<SymplecticIntegrator<LeapfrogKdk>>(timestep);
+    }
+    if (name == LeapfrogDkd::name)
+    {
+        return make_unique<SymplecticIntegrator<LeapfrogDkd>>(timestep);
+    }
+    if (name == Yoshida4::name)
+    {
+        return make_unique<SymplecticIntegrator<Yoshida4>>(timestep);
+    }
+    if (name == Yoshida6::name)
+    {
+        return make_unique<SymplecticIntegrator<Yoshida6>>(timestep);
+    }
+    if (name == ForestRuth::name)
+    {
+        return make_unique<SymplecticIntegrator<ForestRuth>>(timestep);
+    }
+    throw invalid_argument("Unknown integrator: " + name);
+}
@@ -0,0 +1,92 @@
+#ifndef SYMPLECTIC_INTEGRATOR_H
+#define SYMPLECTIC_INTEGRATOR_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "Integrator.h"
+
+/*
+    SymplecticIntegrator class:
+        a leapfrog, or a symmetric composition of leapfrogs of the weights w_1 ... w_K (summing to 1),
+        each a kick and a drift alternated, with the neighbouring half stages of two leapfrogs merged into one
+            kick first    kick w1/2, drift w1, kick (w1+w2)/2, drift w2, ... drift wK, kick wK/2
+            drift first   drift w1/2, kick w1, drift (w1+w2)/2, kick w2, ... kick wK, drift wK/2
+        the scheme is a template parameter, so the stage coefficients are constants of each instantiation
+
+    a step costs K force evaluations, a kick first scheme reuses the last kick's accelerations for the first kick
+    of the next step, both forms end every step with the positions and velocities at the same time
+*/
+template <class Scheme>
+class SymplecticIntegrator : public SteppingIntegrator
+{
+public:
+        explicit SymplecticIntegrator(double timestep) : SteppingIntegrator(timestep) {}
+
+        const char *name() const override { return Scheme::name; }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void step(BodyStore &store, ForceSolver &solver, double dt) override;
+        bool startsWithAccelerations() const override { return Scheme::kickFirst; }
+};
+
+// the second order leapfrog, velocities kicked around the drift
+struct LeapfrogKdk
+{
+        static constexpr const char *name = "kdk";
+        static constexpr bool kickFirst = true;
+        static constexpr std::array<double, 1> weights = {1.0};
+};
+
+// the second order leapfrog, positions drifted around the kick
+struct LeapfrogDkd
+{
+        static constexpr const char *name = "dkd";
+        static constexpr bool kickFirst = false;
+        static constexpr std::array<double, 1> weights = {1.0};
+};
+
+// Yoshida's fourth order triple jump, w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2 w1, of kick first leapfrogs
+struct Yoshida4
+{
+        static constexpr const char *name = "yoshida4";
+        static constexpr bool kickFirst = true;
+        static constexpr std::array<double, 3> weights = {1.3512071919596578, -1.7024143839193153, 1.3512071919596578};
+};
+
+// Yoshida's sixth order solution A, seven kick first leapfrogs
+struct Yoshida6
+{
+        static constexpr const char *name = "yoshida6";
+        static constexpr bool kickFirst = true;
+        static constexpr std::array<double, 7> weights = {0.784513610477560, 0.235573213359357, -1.17767998417887, 1.31518632068391,
+                                                          -1.17767998417887, 0.235573213359357, 0.784513610477560};
+};
+
+// Forest and Ruth's fourth order scheme, the triple jump taken position first
+struct ForestRuth
+{
+        static constexpr const char *name = "forestruth";
+        static constexpr bool kickFirst = false;
+        static constexpr std::array<double, 3> weights = {1.3512071919596578, -1.7024143839193153, 1.3512071919596578};
+};
+
+std::unique_ptr<SteppingIntegrator> makeSymplecticIntegrator(const std::string &name, double timestep);
+
+/**
+ * @brief the outer stage coefficients, the half weights at both ends and the merged halves of neighbouring leapfrogs between them
+ */
+template <std::size_t K>
+constexpr std::array<double, K + 1> mergedHalves(const std::array<double, K> &weights)
+{
+    std::array<double, K + 1> halves{};
+    halves[0] = 0.5 * weights[0];
+    for (std::size_t k = 1; k < K; k++)
+    {
+        halves[k] = 0.5 * (weights[k - 1] + weights[k]);
+    }
+    halves[K] = 0.5 * weights[K - 1];
+    return halves;
+}
+
+#endif
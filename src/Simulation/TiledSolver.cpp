@@ -0,0 +1,183 @@
+/**
+ * This file contains the implementation of the TiledSolver class, the cache blocked direct sum
+ *
+ * a packed source tile costs 4 doubles per body (x, y, z, mass) and gets half of L1,
+ * the target positions and running sums of a target tile cost 6 doubles per body and get a quarter,
+ * the rest is left for the stack and whatever else the kernel touches
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+#include "TiledSolver.h"
+using namespace std;
+
+const size_t DEFAULT_L1_BYTES = 32 * 1024;   // used when the cache size cannot be read
+const size_t TILE_GRANULARITY = 8;           // tiles are whole AVX-512 vectors / cache lines of doubles
+const size_t TILES_PER_THREAD = 4;           // target tiles are shrunk until every thread gets at least this many
+
+/**
+ * @brief reads the size of a data cache level, sysconf first, /sys as a fallback
+ * @param level 1, 2 or 3
+ * @return the size in bytes, 0 if it cannot be found
+ */
+size_t detectCacheSize(int level)
+{
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    long bytes = 0;
+    if (level == 1)
+    {
+        bytes = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    }
+    else if (level == 2)
+    {
+        bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    else if (level == 3)
+    {
+        bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    }
+    if (bytes > 0)
+    {
+        return static_cast<size_t>(bytes);
+    }
+#endif
+    // /sys/devices/system/cpu/cpu0/cache/indexN lists L1 instruction and data separately, so match on level and type
+    for (int index = 0; index < 8; index++)
+    {
+        const string path = "/sys/devices/system/cpu/cpu0/cache/index" + to_string(index) + "/";
+        ifstream levelFile(path + "level"), typeFile(path + "type"), sizeFile(path + "size");
+        int foundLevel = 0;
+        string type, size;
+        if (!(levelFile >> foundLevel) || !(typeFile >> type) || !(sizeFile >> size))
+        {
+            break;
+        }
+        if (foundLevel == level && type != "Instruction")
+        {
+            size_t value = stoul(size);
+            if (size.back() == 'K')
+            {
+                value *= 1024;
+            }
+            else if (size.back() == 'M')
+            {
+                value *= 1024 * 1024;
+            }
+            return value;
+        }
+    }
+    return 0;
+}
+
+static size_t roundToGranularity(size_t value)
+{
+    return max(TILE_GRANULARITY, value / TILE_GRANULARITY * TILE_GRANULARITY);
+}
+
+TiledSolver::TiledSolver(size_t targetTile, size_t sourceTile, SimdLevel level, Softening softening, bool replicated)
+    : targetTile(targetTile), sourceTile(sourceTile), kernel(sourceKernelFor(level, softening)), replicated(replicated)
+{
+    size_t l1Bytes = detectCacheSize(1);
+    if (l1Bytes == 0)
+    {
+        l1Bytes = DEFAULT_L1_BYTES;
+    }
+    if (this->sourceTile == 0)
+    {
+        this->sourceTile = l1Bytes / 2 / (4 * sizeof(double));
+    }
+    if (this->targetTile == 0)
+    {
+        this->targetTile = l1Bytes / 4 / (6 * sizeof(double));
+    }
+    this->sourceTile = roundToGranularity(this->sourceTile);
+    this->targetTile = roundToGranularity(this->targetTile);
+}
+
+/**
+ * @brief computes the acceleration of every body, one target tile at a time
+ * @param store the bodies, ax/ay/az are overwritten
+ */
+void TiledSolver::computeAccelerations(BodyStore &store)
+{
+    sumTiles(store, nullptr, store.size());
+}
+
+/**
+ * @brief computes the acceleration of the listed bodies only, every body is still a source
+ * @param store the bodies, ax/ay/az of the targets are overwritten
+ * @param targets indices of the bodies to accelerate
+ */
+void TiledSolver::computeAccelerationsOf(BodyStore &store, const vector<uint32_t> &targets)
+{
+    sumTiles(store, targets.data(), targets.size());
+}
+
+/**
+ * @brief the tiled sum over targetTotal targets, the first targetTotal bodies when targetList is null
+ */
+void TiledSolver::sumTiles(BodyStore &store, const uint32_t *targetList, size_t targetTotal)
+{
+    const size_t n = store.size();
+    const double *x = store.x.data(), *y = store.y.data(), *z = store.z.data(), *mass = store.mass.data();
+    if (replicated)
+    {
+        replicas.refresh(store);
+        const SourceReplicas::Sources local = replicas.local();
+        x = local.x, y = local.y, z = local.z, mass = local.mass;
+    }
+
+    // small runs would leave threads idle with full size target tiles
+    const size_t balancedTile = roundToGranularity(targetTotal / (omp_get_num_threads() * TILES_PER_THREAD));
+    const size_t targets = min(targetTile, balancedTile);
+
+    // private, cache line aligned source block and target sums for this thread
+    vector<double> buffer(4 * sourceTile + 3 * targets + TILE_GRANULARITY);
+    double *blockX = reinterpret_cast<double *>((reinterpret_cast<uintptr_t>(buffer.data()) + 63) & ~uintptr_t(63));
+    double *blockY = blockX + sourceTile;
+    double *blockZ = blockY + sourceTile;
+    double *blockMass = blockZ + sourceTile;
+    double *sumX = blockMass + sourceTile;
+    double *sumY = sumX + targets;
+    double *sumZ = sumY + targets;
+
+    loop.run((targetTotal + targets - 1) / targets, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            const size_t targetBegin = tile * targets;
+            const size_t targetCount = min(targets, targetTotal - targetBegin);
+            fill(sumX, sumX + 3 * targets, 0.0);
+
+            for (size_t sourceBegin = 0; sourceBegin < n; sourceBegin += sourceTile)
+            {
+                const size_t sourceCount = min(sourceTile, n - sourceBegin);
+                copy(x + sourceBegin, x + sourceBegin + sourceCount, blockX);
+                copy(y + sourceBegin, y + sourceBegin + sourceCount, blockY);
+                copy(z + sourceBegin, z + sourceBegin + sourceCount, blockZ);
+                copy(mass + sourceBegin, mass + sourceBegin + sourceCount, blockMass);
+
+                for (size_t t = 0; t < targetCount; t++)
+                {
+                    const size_t i = targetList ? targetList[targetBegin + t] : targetBegin + t;
+                    kernel(blockX, blockY, blockZ, blockMass, sourceCount, x[i], y[i], z[i], sumX[t], sumY[t], sumZ[t]);
+                }
+            }
+
+            for (size_t t = 0; t < targetCount; t++)
+            {
+                const size_t i = targetList ? targetList[targetBegin + t] : targetBegin + t;
+                const double scale = GRAVITY_CONSTANT * store.gravitationalMultiplier[i];
+                store.ax[i] = scale * sumX[t];
+                store.ay[i] = scale * sumY[t];
+                store.az[i] = scale * sumZ[t];
+            }
+        }
+    });
+}
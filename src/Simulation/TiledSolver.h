@@ -0,0 +1,46 @@
+#ifndef TILED_SOLVER_H
+#define TILED_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ForceSolver.h"
+#include "Numa.h"
+#include "SimdKernels.h"
+
+std::size_t detectCacheSize(int level);
+
+/*
+    TiledSolver class:
+        cache blocked O(N^2) sum for large N
+        the targets are split into tiles, and for each target tile the sources are streamed in tiles,
+        each source tile is packed into a cache line aligned block sized to stay in L1 while every target of the tile reads it,
+        so a source is fetched from memory once per target tile instead of once per target
+
+    tile sizes of 0 are sized from the L1 data cache at construction,
+    replicated packs the source blocks from a copy on the thread's own NUMA node, refreshed before every pass
+*/
+class TiledSolver : public ForceSolver
+{
+public:
+        explicit TiledSolver(std::size_t targetTile = 0, std::size_t sourceTile = 0, SimdLevel level = detectSimdLevel(),
+                             Softening softening = Softening::Clamped, bool replicated = false);
+
+        const char *name() const override { return "tiled"; }
+        void computeAccelerations(BodyStore &store) override;
+        void computeAccelerationsOf(BodyStore &store, const std::vector<std::uint32_t> &targets) override;
+
+        std::size_t targetTileSize() const { return targetTile; }
+        std::size_t sourceTileSize() const { return sourceTile; }
+
+private:
+        std::size_t targetTile; // targets sharing one pass over the sources
+        std::size_t sourceTile; // sources packed into one L1 block
+        SourceKernel kernel;
+        bool replicated;
+        SourceReplicas replicas;
+
+        void sumTiles(BodyStore &store, const std::uint32_t *targetList, std::size_t targetTotal);
+};
+
+#endif
@@ -0,0 +1,304 @@
+// How to compile:
+// clang++ ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../DirectSolver.cpp ../SymplecticIntegrator.cpp ../BlockStepper.cpp ../CollisionDetector.cpp CollisionUnitTest.cpp -o CollisionUnitTest -Wall -g -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../SymplecticIntegrator.h"
+#include "../BlockStepper.h"
+#include "../CollisionDetector.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+double norm(double x, double y, double z)
+{
+    return sqrt(x * x + y * y + z * z);
+}
+
+// n bodies at rest with the given radius, ids in order
+BodyStore make_store(size_t n, double radius)
+{
+    BodyStore store;
+    store.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        store.mass[i] = 1.0e24;
+        store.gravitationalMultiplier[i] = 1.0;
+        store.radius[i] = radius;
+        store.id[i] = static_cast<uint32_t>(i);
+    }
+    return store;
+}
+
+// moves every body along its velocity for dt, between the snapshot and the resolve
+size_t drift_and_resolve(CollisionDetector &detector, BodyStore &store, double dt, int threads)
+{
+    size_t absorbed = 0;
+    #pragma omp parallel num_threads(threads)
+    {
+        detector.snapshot(store);
+        #pragma omp for
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            store.x[i] += store.vx[i] * dt;
+            store.y[i] += store.vy[i] * dt;
+            store.z[i] += store.vz[i] * dt;
+        }
+        const size_t local = detector.resolve(store);
+        #pragma omp single
+        absorbed = local;
+    }
+    return absorbed;
+}
+
+// the pairs whose spheres come within the sum of their radii over dt, by the swept test of every pair
+size_t count_touching(const BodyStore &store, double dt)
+{
+    size_t touching = 0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        for (size_t j = i + 1; j < store.size(); j++)
+        {
+            const double px = store.x[j] - store.x[i], py = store.y[j] - store.y[i], pz = store.z[j] - store.z[i];
+            const double dx = (store.vx[j] - store.vx[i]) * dt, dy = (store.vy[j] - store.vy[i]) * dt, dz = (store.vz[j] - store.vz[i]) * dt;
+            const double t = max(0.0, min(1.0, -(px * dx + py * dy + pz * dz) / (dx * dx + dy * dy + dz * dz)));
+            touching += norm(px + t * dx, py + t * dy, pz + t * dz) < store.radius[i] + store.radius[j];
+        }
+    }
+    return touching;
+}
+
+void test_head_on()
+{
+    // two bodies that pass through each other within one step, a third that misses them by more than the radii
+    BodyStore store = make_store(3, 1.0e6);
+    store.mass[1] = 3.0e24;
+    store.x[0] = -1.0e8;
+    store.vx[0] = 2.0e4;
+    store.x[1] = 1.0e8;
+    store.vx[1] = -1.0e4;
+    store.x[2] = -1.0e8;
+    store.y[2] = 2.5e6;
+    store.vx[2] = 4.0e4;
+    CollisionDetector detector(3);
+    const double momentum = store.mass[0] * store.vx[0] + store.mass[1] * store.vx[1];
+    const double centre = (store.mass[0] * (store.x[0] + store.vx[0] * 1.0e4) + store.mass[1] * (store.x[1] + store.vx[1] * 1.0e4)) / 4.0e24;
+    const size_t absorbed = drift_and_resolve(detector, store, 1.0e4, 1);
+
+    assert_below(0.0, fabs(1.0 - absorbed) + fabs(2.0 - store.size()), "bodies passing through each other in one step merge, the one passing by does not");
+    assert_below(0.0, fabs(store.id[0] - 1.0) + fabs(store.id[1] - 2.0), "the heavier body survives and the store is compacted in order");
+    assert_below(1e-15, fabs(store.mass[0] * store.vx[0] - momentum) / fabs(momentum), "the merged body carries the momentum of both");
+    assert_below(1e-15, fabs(store.x[0] - centre) / fabs(centre), "the merged body sits at their centre of mass");
+    assert_below(1e-15, fabs(store.radius[0] - cbrt(2.0) * 1.0e6) / 1.0e6, "the merged body has the volume of both");
+    assert_below(0.0, fabs(detector.slotOf(0) - 0.0) + fabs(detector.slotOf(1) - 0.0) + fabs(detector.slotOf(2) - 1.0),
+                 "the absorbed body's record follows the survivor's slot");
+    assert_below(1e-12, fabs(detector.lastCollisions().front().time - (2.0e8 - 2.0e6) / 3.0e8), "the spheres touch when the gap closes");
+}
+
+void test_matches_brute_force()
+{
+    // a crowded cloud on random straight paths, every touching pair against the swept test of every pair
+    srand(17);
+    const size_t n = 3000;
+    BodyStore store = make_store(n, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        store.x[i] = 1.0e10 * random_unit();
+        store.y[i] = 1.0e10 * random_unit();
+        store.z[i] = 1.0e10 * random_unit();
+        store.vx[i] = 1.0e4 * (random_unit() - 0.5);
+        store.vy[i] = 1.0e4 * (random_unit() - 0.5);
+        store.vz[i] = 1.0e4 * (random_unit() - 0.5);
+        store.radius[i] = 1.0e8 * (0.2 + random_unit());
+        store.mass[i] = 1.0e24 * (0.5 + random_unit());
+    }
+    const double dt = 3.0e4;
+    const size_t expected = count_touching(store, dt);
+
+    double momentum[3] = {0.0, 0.0, 0.0}, mass = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        momentum[0] += store.mass[i] * store.vx[i], momentum[1] += store.mass[i] * store.vy[i], momentum[2] += store.mass[i] * store.vz[i];
+        mass += store.mass[i];
+    }
+    BodyStore parallel = store;
+    CollisionDetector detector(n), threaded(n);
+    const size_t absorbed = drift_and_resolve(detector, store, dt, 1);
+    drift_and_resolve(threaded, parallel, dt, 4);
+
+    assert_below(0.0, fabs(double(expected) - detector.lastCollisions().size()), "the spatial hash finds every touching pair the all pairs test finds");
+    assert_below(0.0, fabs(double(n - absorbed) - store.size()), "every absorbed body leaves the store");
+    double after[3] = {0.0, 0.0, 0.0}, massAfter = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        after[0] += store.mass[i] * store.vx[i], after[1] += store.mass[i] * store.vy[i], after[2] += store.mass[i] * store.vz[i];
+        massAfter += store.mass[i];
+    }
+    assert_below(1e-14, fabs(massAfter - mass) / mass, "merging keeps the total mass");
+    assert_below(1e-12, norm(after[0] - momentum[0], after[1] - momentum[1], after[2] - momentum[2]) / (mass * 1.0e4), "merging keeps the total momentum");
+
+    double difference = fabs(double(store.size()) - parallel.size());
+    for (size_t i = 0; i < min(store.size(), parallel.size()); i++)
+    {
+        difference += fabs(store.x[i] - parallel.x[i]) + fabs(store.vx[i] - parallel.vx[i]) + fabs(store.id[i] - double(parallel.id[i]));
+    }
+    assert_below(0.0, difference, "collisions resolved on 4 threads match the serial run exactly");
+}
+
+void test_oversized_boxes()
+{
+    // small planets with a star and a fast body among them, their boxes are left out of the cells and tested against every body
+    srand(29);
+    const size_t n = 2000;
+    BodyStore store = make_store(n, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        store.x[i] = 2.0e10 * random_unit();
+        store.y[i] = 2.0e10 * random_unit();
+        store.z[i] = 2.0e10 * random_unit();
+        store.vx[i] = 1.0e3 * (random_unit() - 0.5);
+        store.vy[i] = 1.0e3 * (random_unit() - 0.5);
+        store.vz[i] = 1.0e3 * (random_unit() - 0.5);
+        store.radius[i] = 1.0e7 * (0.5 + random_unit());
+    }
+    store.x[0] = store.y[0] = store.z[0] = 1.0e10;
+    store.radius[0] = 7.0e9; // a star wide enough to swallow a few hundred planets
+    store.x[1] = store.y[1] = store.z[1] = 0.0;
+    store.vx[1] = store.vy[1] = store.vz[1] = 5.0e5; // a body crossing the cloud within the step
+    store.radius[1] = 1.0e8;
+    const double dt = 2.0e4;
+    const size_t expected = count_touching(store, dt);
+
+    BodyStore parallel = store;
+    CollisionDetector detector(n), threaded(n);
+    drift_and_resolve(detector, store, dt, 1);
+    drift_and_resolve(threaded, parallel, dt, 4);
+
+    assert_below(0.0, fabs(double(expected) - detector.lastCollisions().size()), "the oversized boxes find every pair the all pairs test finds");
+    assert_below(0.0, fabs(double(store.size()) - parallel.size()), "the oversized boxes resolve the same on 4 threads");
+}
+
+void test_run_shrinks()
+{
+    // a planet falls onto a star, the leapfrog runs on with one body fewer and the same momentum
+    BodyStore store = make_store(3, 7.0e8);
+    store.mass[0] = 2.0e30;
+    store.mass[1] = 6.0e24;
+    store.radius[1] = 6.4e6;
+    store.x[1] = 5.0e9;
+    store.mass[2] = 1.0e25;
+    store.radius[2] = 6.4e6;
+    store.x[2] = 1.0e11;
+    store.vy[2] = sqrt(GRAVITY_CONSTANT * 2.0e30 / 1.0e11);
+    const double momentum = store.mass[2] * store.vy[2];
+
+    DirectSolver solver;
+    unique_ptr<SteppingIntegrator> kdk = makeSymplecticIntegrator("kdk", 600.0);
+    CollisionDetector detector(3);
+    size_t absorbed = 0;
+    #pragma omp parallel num_threads(2)
+    {
+        kdk->start(store, solver);
+        for (int step = 0; step < 200; step++)
+        {
+            detector.snapshot(store);
+            kdk->advance(store, solver);
+            if (detector.resolve(store) > 0)
+            {
+                kdk->start(store, solver);
+                #pragma omp single
+                absorbed++;
+            }
+        }
+    }
+    double after = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        after += store.mass[i] * store.vy[i];
+    }
+    assert_below(0.0, fabs(1.0 - absorbed) + fabs(2.0 - store.size()) + fabs(store.id[1] - 2.0), "the falling planet is absorbed by the star and the orbiting one runs on");
+    assert_below(1e-12, fabs(after - momentum) / momentum, "the run keeps its momentum through the merge");
+}
+
+void test_block_steps_merge()
+{
+    // two stars touching at the start merge after the first block step, a planet far off is only pulled by them,
+    // its velocity after the merge and restart must be the one of the same step without any merge
+    auto make = []() {
+        BodyStore store = make_store(3, 6.0e6);
+        store.mass[0] = store.mass[1] = 1.0e30;
+        store.x[1] = 1.0e7;
+        store.vx[0] = 1.0e4;
+        store.vx[1] = -1.0e4;
+        store.x[2] = 1.0e11;
+        store.vy[2] = sqrt(GRAVITY_CONSTANT * 2.0e30 / 1.0e11);
+        return store;
+    };
+    BodyStore merged = make(), reference = make();
+    DirectSolver solver;
+    BlockStepper mergedStepper(600.0, 8, 0.02), referenceStepper(600.0, 8, 0.02);
+    CollisionDetector detector(3);
+    size_t absorbed = 0;
+    #pragma omp parallel num_threads(2)
+    {
+        mergedStepper.start(merged, solver);
+        detector.snapshot(merged);
+        mergedStepper.advance(merged, solver);
+        if (detector.resolve(merged, [&](BodyStore &bodies) { mergedStepper.synchronize(bodies); }) > 0)
+        {
+            mergedStepper.start(merged, solver);
+            #pragma omp single
+            absorbed++;
+        }
+
+        referenceStepper.start(reference, solver);
+        referenceStepper.advance(reference, solver);
+    }
+    mergedStepper.synchronize(merged);
+    referenceStepper.synchronize(reference);
+
+    const size_t planet = merged.size() - 1;
+    const double speed = norm(reference.vx[2], reference.vy[2], reference.vz[2]);
+    const double change = norm(merged.vx[planet] - reference.vx[2], merged.vy[planet] - reference.vy[2], merged.vz[planet] - reference.vz[2]);
+    assert_below(0.0, fabs(1.0 - absorbed) + fabs(2.0 - merged.size()) + fabs(merged.id[planet] - 2.0), "the two stars merge under block steps");
+    assert_below(1e-12, change / speed, "the merge and restart under block steps leave the bystander's velocity alone");
+}
+
+int main()
+{
+    test_head_on();
+    test_matches_brute_force();
+    test_oversized_boxes();
+    test_run_shrinks();
+    test_block_steps_merge();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
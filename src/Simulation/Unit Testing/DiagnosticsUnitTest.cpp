@@ -0,0 +1,171 @@
+// How to compile:
+// clang++ ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../DirectSolver.cpp ../SymplecticIntegrator.cpp ../Octree.cpp ../Diagnostics.cpp DiagnosticsUnitTest.cpp -o DiagnosticsUnitTest -Wall -g -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../SymplecticIntegrator.h"
+#include "../Diagnostics.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+// n bodies of random mass in a cube of the given edge, moving at up to speed, unit multipliers
+BodyStore make_cloud(size_t n, double edge, double speed)
+{
+    BodyStore store;
+    store.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        store.x[i] = edge * random_unit();
+        store.y[i] = edge * random_unit();
+        store.z[i] = edge * random_unit();
+        store.vx[i] = speed * (random_unit() - 0.5);
+        store.vy[i] = speed * (random_unit() - 0.5);
+        store.vz[i] = speed * (random_unit() - 0.5);
+        store.mass[i] = 1.0e24 * (0.5 + random_unit());
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    return store;
+}
+
+DiagnosticsSample measure_on(Diagnostics &diagnostics, const BodyStore &store, int threads)
+{
+    #pragma omp parallel num_threads(threads)
+    diagnostics.measure(store);
+    return diagnostics.last();
+}
+
+void test_two_bodies()
+{
+    // a star and a planet on a circular orbit around their centre of mass, everything known in closed form
+    const double M = 2.0e30, m = 6.0e24, a = 1.5e11;
+    const double v = sqrt(GRAVITY_CONSTANT * (M + m) / a);
+    BodyStore store;
+    store.resize(2);
+    store.mass[0] = M;
+    store.mass[1] = m;
+    store.gravitationalMultiplier[0] = store.gravitationalMultiplier[1] = 1.0;
+    store.x[0] = -a * m / (M + m);
+    store.x[1] = a * M / (M + m);
+    store.vy[0] = -v * m / (M + m);
+    store.vy[1] = v * M / (M + m);
+
+    Diagnostics diagnostics;
+    const DiagnosticsSample s = measure_on(diagnostics, store, 2);
+    const double potential = -GRAVITY_CONSTANT * M * m / a;
+    assert_below(1e-14, fabs(s.potential - potential) / fabs(potential), "the potential energy of the pair is -G M m / a");
+    assert_below(1e-14, fabs(s.kinetic + 0.5 * potential) / fabs(potential), "a circular orbit has half the potential as kinetic energy");
+    assert_below(1e-14, fabs(s.angularMomentum[2] - M * m / (M + m) * a * v) / (m * a * v), "the angular momentum is that of the reduced mass");
+    assert_below(1e-6, fabs(s.momentum[1]) + fabs(s.centreOfMass[0]), "the centre of mass rests at the origin");
+    assert_below(0.0, fabs(diagnostics.energyError()), "the first sample is the reference of the energy error");
+}
+
+void test_tree_potential()
+{
+    // above the threshold the walk has to agree with the direct sum over every pair
+    srand(19);
+    const size_t n = TREE_POTENTIAL_THRESHOLD + 1000;
+    BodyStore store = make_cloud(n, 1.0e11, 1.0e3);
+    for (size_t i = 0; i < 100; i++)
+    {
+        store.x[i] = 5.0e10 + 1.0e8 * random_unit(); // a dense knot in the middle, so the tree goes deep
+        store.y[i] = 5.0e10 + 1.0e8 * random_unit();
+        store.z[i] = 5.0e10 + 1.0e8 * random_unit();
+    }
+    double direct = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t j = i + 1; j < n; j++)
+        {
+            const double dx = store.x[j] - store.x[i], dy = store.y[j] - store.y[i], dz = store.z[j] - store.z[i];
+            direct -= GRAVITY_CONSTANT * store.mass[i] * store.mass[j] / sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+
+    Diagnostics serial, threaded;
+    const DiagnosticsSample one = measure_on(serial, store, 1);
+    const DiagnosticsSample four = measure_on(threaded, store, 4);
+    assert_below(TREE_POTENTIAL_FLOOR, fabs(one.potential - direct) / fabs(direct), "the octree potential matches the direct sum to its stated floor");
+    assert_below(0.0, fabs(four.potential - one.potential), "the octree potential does not depend on the thread count");
+    assert_below(0.0, fabs(four.kinetic - one.kinetic), "the kinetic energy does not depend on the thread count");
+}
+
+void test_record_run()
+{
+    // a leapfrog run of a small cluster, recorded every 50 steps, keeps its energy and momenta
+    srand(23);
+    BodyStore store = make_cloud(64, 1.0e11, 2.0e3);
+    const string path = "diagnostics_test.txt";
+    unique_ptr<SteppingIntegrator> kdk = makeSymplecticIntegrator("kdk", 3600.0);
+    DirectSolver solver;
+    Diagnostics diagnostics(path, 50);
+    DiagnosticsSample first;
+    #pragma omp parallel num_threads(2)
+    {
+        kdk->start(store, solver);
+        diagnostics.record(store, 0, 0.0);
+        #pragma omp single
+        first = diagnostics.last();
+        for (int step = 1; step <= 500; step++)
+        {
+            kdk->advance(store, solver);
+            if (diagnostics.due(step))
+            {
+                diagnostics.record(store, step, step * 3600.0);
+            }
+        }
+    }
+    const DiagnosticsSample &last = diagnostics.last();
+    const double scale = first.mass * 2.0e3;
+    assert_below(1e-5, fabs(diagnostics.energyError()), "the leapfrog keeps the energy of the cluster");
+    assert_below(1e-12, fabs(last.momentum[0] - first.momentum[0]) / scale + fabs(last.momentum[1] - first.momentum[1]) / scale, "the momentum is kept");
+    assert_below(1e-10, fabs(last.angularMomentum[2] - first.angularMomentum[2]) / (scale * 1.0e11), "the angular momentum is kept");
+
+    ifstream file(path);
+    string line;
+    int lines = 0;
+    while (getline(file, line))
+    {
+        lines++;
+    }
+    assert_below(0.0, fabs(lines - 12.0), "the time series holds a header and one line per record");
+    remove(path.c_str());
+}
+
+int main()
+{
+    test_two_bodies();
+    test_tree_potential();
+    test_record_run();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
@@ -0,0 +1,488 @@
+// How to compile:
+// clang++ ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../Numa.cpp ../DirectSolver.cpp ../SymmetricSolver.cpp ../SimdKernels.cpp ../SimdSolver.cpp ../TiledSolver.cpp ../PairTileSolver.cpp ForceSolverUnitTest.cpp -o ForceSolverUnitTest -Wall -g -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "../vec3.h"
+#include "../body.h"
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../SymmetricSolver.h"
+#include "../SimdSolver.h"
+#include "../TiledSolver.h"
+#include "../PairTileSolver.h"
+#include "../WorkStealing.h"
+#include "../Numa.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+// a small random cluster with a coincident pair and a pair closer than the softening length
+vector<Body> make_bodies(int n)
+{
+    srand(42);
+    vector<Body> bodies;
+    vector<Vec3> trajectory;
+    for (int i = 0; i < n; i++)
+    {
+        Vec3 position(rand() % 2000 - 1000.0, rand() % 2000 - 1000.0, rand() % 2000 - 1000.0);
+        double mass = 1.0e10 + rand() % 1000 * 1.0e9;
+        bodies.emplace_back(position, Vec3(0, 0, 0), Vec3(0, 0, 0), Vec3(0, 0, 0), mass, 1.0, 1.0 + (i % 3), "planet", vector<int>{}, trajectory);
+    }
+    bodies[1].position = bodies[0].position;
+    bodies[3].position = bodies[2].position + Vec3(1e-6, 0, 0);
+    return bodies;
+}
+
+// largest component error of the store against the serial Body::sumForces reference, relative to the largest acceleration
+double max_error_against_reference(vector<Body> &bodies, const BodyStore &store)
+{
+    double maxAccel = 0.0, maxError = 0.0;
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        Vec3 expected(0, 0, 0);
+        for (size_t j = 0; j < bodies.size(); j++)
+        {
+            if (i != j && (bodies[j].position - bodies[i].position).magnitude() > 0.0)
+            {
+                expected += bodies[i].gravForce(bodies[j]) / bodies[i].mass;
+            }
+        }
+        Vec3 actual(store.ax[i], store.ay[i], store.az[i]);
+        maxAccel = max(maxAccel, expected.magnitude());
+        maxError = max(maxError, (expected - actual).magnitude());
+    }
+    return maxError / maxAccel;
+}
+
+void test_direct_solver()
+{
+    vector<Body> bodies = make_bodies(200);
+    BodyStore store(bodies);
+    DirectSolver solver;
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(1e-12, max_error_against_reference(bodies, store), "Direct solver matches Body::gravForce");
+}
+
+void test_symmetric_solver()
+{
+    vector<Body> bodies = make_bodies(200);
+    BodyStore store(bodies);
+    SymmetricSolver solver;
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(1e-12, max_error_against_reference(bodies, store), "Symmetric solver matches Body::gravForce");
+}
+
+void test_symmetric_solver_serial()
+{
+    vector<Body> bodies = make_bodies(57);
+    BodyStore store(bodies);
+    SymmetricSolver solver;
+    solver.computeAccelerations(store); // outside a parallel region
+
+    assert_below(1e-12, max_error_against_reference(bodies, store), "Symmetric solver runs outside a parallel region");
+}
+
+void test_momentum_conservation()
+{
+    vector<Body> bodies = make_bodies(100);
+    for (Body &body : bodies)
+    {
+        body.gravitationalMultiplier = 1.0;
+    }
+    BodyStore store(bodies);
+    SymmetricSolver solver;
+    #pragma omp parallel num_threads(3)
+    solver.computeAccelerations(store);
+
+    double netForce = 0.0, scale = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        netForce += store.mass[i] * store.ax[i];
+        scale += std::fabs(store.mass[i] * store.ax[i]);
+    }
+    assert_below(1e-12, std::fabs(netForce) / scale, "Symmetric solver forces sum to zero");
+}
+
+void test_symmetric_deterministic()
+{
+    // fixed row blocks reduced pairwise, the thread count must not change a single bit
+    vector<Body> bodies = make_bodies(300);
+    BodyStore serial(bodies), parallel(bodies), uneven(bodies);
+    SymmetricSolver serialSolver(Softening::Clamped, Scaling::PerBody, true), parallelSolver(Softening::Clamped, Scaling::PerBody, true),
+        unevenSolver(Softening::Clamped, Scaling::PerBody, true);
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(4)
+    parallelSolver.computeAccelerations(parallel);
+    #pragma omp parallel num_threads(7)
+    unevenSolver.computeAccelerations(uneven);
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference += fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]);
+        difference += fabs(serial.ax[i] - uneven.ax[i]) + fabs(serial.ay[i] - uneven.ay[i]) + fabs(serial.az[i] - uneven.az[i]);
+    }
+    assert_below(0.0, difference, "Deterministic symmetric solver gives the same bits on 1, 4 and 7 threads");
+    assert_below(1e-12, max_error_against_reference(bodies, serial), "Deterministic symmetric solver matches Body::gravForce");
+}
+
+void test_work_stealing_loop()
+{
+    // every index once and only once, with a few costly indices at the front of the first run so the others steal
+    WorkStealingLoop loop;
+    const size_t sizes[] = {0, 3, 20, 1000, 4099};
+    const int threads[] = {1, 4, 32};
+    double misses = 0.0;
+    for (size_t n : sizes)
+    {
+        for (int t : threads)
+        {
+            vector<int> visits(n, 0);
+            #pragma omp parallel num_threads(t)
+            loop.run(n, 4, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    volatile double work = 0.0;
+                    for (size_t k = 0; k < (i < 16 ? 100000 : 10); k++)
+                    {
+                        work = work + 1.0;
+                    }
+                    #pragma omp atomic
+                    visits[i]++;
+                }
+            });
+            for (size_t i = 0; i < n; i++)
+            {
+                misses += fabs(visits[i] - 1.0);
+            }
+        }
+    }
+    assert_below(0.0, misses, "Work stealing loop visits every index exactly once on 1, 4 and 32 threads");
+}
+
+void test_more_threads_than_bodies()
+{
+    // 32 threads on 20 bodies, most threads start with nothing and can only steal
+    vector<Body> bodies = make_bodies(20);
+    BodyStore serial(bodies), direct(bodies), simd(bodies);
+    DirectSolver serialSolver, directSolver;
+    SimdSolver simdSolver;
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(32)
+    {
+        directSolver.computeAccelerations(direct);
+        simdSolver.computeAccelerations(simd);
+    }
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference += fabs(serial.ax[i] - direct.ax[i]) + fabs(serial.ay[i] - direct.ay[i]) + fabs(serial.az[i] - direct.az[i]);
+    }
+    assert_below(0.0, difference, "Direct solver on 32 threads and 20 bodies gives the serial bits");
+    assert_below(1e-12, max_error_against_reference(bodies, simd), "SIMD solver on 32 threads and 20 bodies matches Body::gravForce");
+}
+
+void test_pair_tile_solver()
+{
+    // a square, a prime and a serial thread count, with fewer bodies than threads for the last tiles
+    vector<Body> bodies = make_bodies(32);
+    const int threads[] = {1, 4, 7, 32};
+    double maxError = 0.0;
+    for (int t : threads)
+    {
+        BodyStore store(bodies);
+        PairTileSolver solver;
+        #pragma omp parallel num_threads(t)
+        solver.computeAccelerations(store);
+        maxError = max(maxError, max_error_against_reference(bodies, store));
+    }
+    assert_below(1e-12, maxError, "Pair tile solver matches Body::gravForce on 1, 4, 7 and 32 threads");
+
+    // the layout follows the store when a merge shrinks it between two steps of one parallel region
+    vector<Body> fewer(bodies.begin(), bodies.begin() + 5);
+    BodyStore large(bodies), small(fewer);
+    PairTileSolver solver;
+    #pragma omp parallel num_threads(8)
+    {
+        solver.computeAccelerations(large);
+        solver.computeAccelerations(small);
+    }
+    assert_below(1e-12, max_error_against_reference(fewer, small), "Pair tile solver relays out for 5 bodies on 8 threads");
+
+    BodyStore serial(bodies);
+    PairTileSolver serialSolver;
+    serialSolver.computeAccelerations(serial); // outside a parallel region
+    assert_below(1e-12, max_error_against_reference(bodies, serial), "Pair tile solver runs outside a parallel region");
+}
+
+void test_numa_placement()
+{
+    NumaTopology topology = detectNumaTopology();
+    assert_below(0.0, topology.nodes.empty() || topology.nodes[0].cpus.empty(), "NUMA topology (" + topology.source + ") has a node with cpus");
+
+    // a made up placement, two nodes with their threads interleaved, so the runs are laid out out of thread order
+    WorkStealingLoop::placeThreads({0, 1, 1, 0, 1, 0});
+    WorkStealingLoop loop;
+    double misses = 0.0;
+    for (int t : {6, 4}) // 4 threads do not match the placement and go back to thread order
+    {
+        vector<int> visits(1000, 0);
+        #pragma omp parallel num_threads(t)
+        loop.run(visits.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                #pragma omp atomic
+                visits[i]++;
+            }
+        });
+        for (int v : visits)
+        {
+            misses += fabs(v - 1.0);
+        }
+    }
+    assert_below(0.0, misses, "Placed work stealing loop visits every index exactly once");
+
+    // first touch moves the pages, never the values
+    vector<Body> bodies = make_bodies(3001);
+    BodyStore original(bodies), placed(bodies);
+    #pragma omp parallel num_threads(6)
+    placeFirstTouch(placed);
+    double changed = 0.0;
+    for (size_t i = 0; i < original.size(); i++)
+    {
+        changed += (placed.x[i] != original.x[i]) + (placed.vz[i] != original.vz[i]) + (placed.mass[i] != original.mass[i]) +
+                   (placed.radius[i] != original.radius[i]) + (placed.id[i] != original.id[i]);
+    }
+    assert_below(0.0, changed, "First touch placement keeps every value of the store");
+
+    // the replicated solvers read the node copies, which follow the store when a merge shrinks it
+    vector<Body> small = make_bodies(203), fewer(small.begin(), small.begin() + 150);
+    BodyStore simd(small), tiled(small), shrunk(fewer);
+    SimdSolver simdSolver(detectSimdLevel(), Softening::Clamped, true);
+    TiledSolver tiledSolver(16, 32, detectSimdLevel(), Softening::Clamped, true);
+    #pragma omp parallel num_threads(6)
+    {
+        simdSolver.computeAccelerations(simd);
+        tiledSolver.computeAccelerations(tiled);
+        simdSolver.computeAccelerations(shrunk);
+    }
+    assert_below(1e-12, max_error_against_reference(small, simd), "SIMD solver on replicated sources matches Body::gravForce");
+    assert_below(1e-12, max_error_against_reference(small, tiled), "Tiled solver on replicated sources matches Body::gravForce");
+    assert_below(1e-12, max_error_against_reference(fewer, shrunk), "Replicated sources follow the store down to 150 bodies");
+    WorkStealingLoop::placeThreads({});
+}
+
+void test_small_run_deterministic()
+{
+    // the solver auto picks for few bodies per thread with Deterministic on, the thread count must not change a single bit
+    vector<Body> bodies = make_bodies(40);
+    BodyStore serial(bodies), parallel(bodies), uneven(bodies);
+    SimdSolver solver;
+    solver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(parallel);
+    #pragma omp parallel num_threads(6)
+    solver.computeAccelerations(uneven);
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference += fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]);
+        difference += fabs(serial.ax[i] - uneven.ax[i]) + fabs(serial.ay[i] - uneven.ay[i]) + fabs(serial.az[i] - uneven.az[i]);
+    }
+    assert_below(0.0, difference, "SIMD solver on 40 bodies gives the same bits on 1, 4 and 6 threads");
+}
+
+void test_simd_solvers()
+{
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        if (level > detectSimdLevel())
+        {
+            cout << "skipped | " << simdLevelName(level) << " is not supported by this cpu" << endl;
+            continue;
+        }
+        vector<Body> bodies = make_bodies(203); // not a multiple of any vector width
+        BodyStore store(bodies);
+        SimdSolver solver(level);
+        #pragma omp parallel num_threads(4)
+        solver.computeAccelerations(store);
+
+        assert_below(1e-12, max_error_against_reference(bodies, store), std::string("simd (") + simdLevelName(level) + ") solver matches Body::gravForce");
+    }
+}
+
+void test_simd_solver_far_field()
+{
+    // galaxy scale separations square past the float range, the estimate must still converge
+    vector<Body> bodies = make_bodies(20);
+    for (Body &body : bodies)
+    {
+        body.position = body.position * 1.0e19;
+    }
+    BodyStore store(bodies);
+    SimdSolver solver;
+    solver.computeAccelerations(store);
+
+    assert_below(1e-12, max_error_against_reference(bodies, store), "Detected simd solver handles separations beyond 1e19 m");
+}
+
+void test_tiled_solver()
+{
+    vector<Body> bodies = make_bodies(301);
+    BodyStore store(bodies);
+    TiledSolver solver(24, 40); // neither divides 301, so every tile edge is exercised
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(1e-12, max_error_against_reference(bodies, store), "Tiled solver matches Body::gravForce");
+}
+
+// largest component error of the store against a plain loop over the textbook softened force laws
+double max_error_against_softening(const BodyStore &reference, const BodyStore &store, Softening softening)
+{
+    double maxAccel = 0.0, maxError = 0.0;
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        Vec3 expected(0, 0, 0);
+        for (size_t j = 0; j < reference.size(); j++)
+        {
+            Vec3 d(reference.x[j] - reference.x[i], reference.y[j] - reference.y[i], reference.z[j] - reference.z[i]);
+            const double r = d.magnitude();
+            if (r == 0.0)
+            {
+                continue;
+            }
+            const double e2 = SOFTENING_LENGTH * SOFTENING_LENGTH;
+            const double cube = softening == Softening::Plummer ? pow(r * r + e2, 1.5) : r * r * r;
+            expected += d * (GRAVITY_CONSTANT * reference.gravitationalMultiplier[i] * reference.mass[j] / cube);
+        }
+        Vec3 actual(store.ax[i], store.ay[i], store.az[i]);
+        maxAccel = max(maxAccel, expected.magnitude());
+        maxError = max(maxError, (expected - actual).magnitude());
+    }
+    return maxError / maxAccel;
+}
+
+void test_softening_policies()
+{
+    // the far pairs of the cluster, with the near pairs moved apart as an unsoftened law would blow up on them
+    vector<Body> bodies = make_bodies(203);
+    bodies[3].position = bodies[2].position + Vec3(1e-3, 0, 0);
+    const BodyStore reference(bodies);
+    for (Softening softening : {Softening::Plummer, Softening::None})
+    {
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+        {
+            if (level > detectSimdLevel())
+            {
+                continue;
+            }
+            BodyStore store(bodies);
+            SimdSolver solver(level, softening);
+            #pragma omp parallel num_threads(4)
+            solver.computeAccelerations(store);
+            assert_below(1e-12, max_error_against_softening(reference, store, softening),
+                         std::string("simd (") + simdLevelName(level) + ") solver with " + softeningName(softening) + " softening");
+        }
+
+        BodyStore tiled(bodies), symmetric(bodies);
+        TiledSolver tiledSolver(24, 40, detectSimdLevel(), softening);
+        SymmetricSolver symmetricSolver(softening);
+        #pragma omp parallel num_threads(4)
+        {
+            tiledSolver.computeAccelerations(tiled);
+            symmetricSolver.computeAccelerations(symmetric);
+        }
+        assert_below(1e-12, max_error_against_softening(reference, tiled, softening), std::string("Tiled solver with ") + softeningName(softening) + " softening");
+        assert_below(1e-12, max_error_against_softening(reference, symmetric, softening), std::string("Symmetric solver with ") + softeningName(softening) + " softening");
+    }
+}
+
+void test_symmetric_uniform_scaling()
+{
+    vector<Body> bodies = make_bodies(200);
+    for (Body &body : bodies)
+    {
+        body.gravitationalMultiplier = 2.5;
+    }
+    BodyStore perBody(bodies), uniform(bodies);
+    SymmetricSolver perBodySolver(Softening::Clamped, Scaling::PerBody), uniformSolver(Softening::Clamped, Scaling::Uniform);
+    #pragma omp parallel num_threads(3)
+    {
+        perBodySolver.computeAccelerations(perBody);
+        uniformSolver.computeAccelerations(uniform);
+    }
+
+    assert_below(1e-12, max_error_against_reference(bodies, uniform), "Symmetric solver with uniform scaling matches Body::gravForce");
+    double difference = 0.0, largest = 0.0;
+    for (size_t i = 0; i < perBody.size(); i++)
+    {
+        difference = max(difference, fabs(perBody.ax[i] - uniform.ax[i]));
+        largest = max(largest, fabs(perBody.ax[i]));
+    }
+    assert_below(1e-12, difference / largest, "Symmetric solver gives the same forces with uniform and per body scaling");
+}
+
+void test_tiled_solver_cache_sizes()
+{
+    TiledSolver solver;
+    total_tests++;
+    if (solver.sourceTileSize() >= 8 && solver.sourceTileSize() % 8 == 0 && solver.targetTileSize() >= 8 && solver.targetTileSize() % 8 == 0)
+    {
+        passed_tests++;
+        cout << ":) | Tiled solver sizes its tiles from the cache (" << solver.targetTileSize() << " targets, " << solver.sourceTileSize() << " sources)" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | Tiled solver sizes its tiles from the cache" << endl;
+    }
+}
+
+int main()
+{
+    test_direct_solver();
+    test_symmetric_solver();
+    test_symmetric_solver_serial();
+    test_momentum_conservation();
+    test_symmetric_deterministic();
+    test_work_stealing_loop();
+    test_more_threads_than_bodies();
+    test_pair_tile_solver();
+    test_numa_placement();
+    test_small_run_deterministic();
+    test_simd_solvers();
+    test_simd_solver_far_field();
+    test_tiled_solver();
+    test_tiled_solver_cache_sizes();
+    test_softening_policies();
+    test_symmetric_uniform_scaling();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
@@ -0,0 +1,983 @@
+// How to compile:
+// clang++ ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../Numa.cpp ../DirectSolver.cpp ../SimdKernels.cpp ../SimdSolver.cpp ../TiledSolver.cpp ../MixedSolver.cpp ../BlockStepper.cpp ../SymplecticIntegrator.cpp ../HermiteIntegrator.cpp ../AdaptiveIntegrator.cpp ../Kepler.cpp ../WisdomHolmanIntegrator.cpp ../Regularization.cpp ../RegularizedIntegrator.cpp ../LegacyIntegrator.cpp ../NBody.cpp IntegratorUnitTest.cpp -o IntegratorUnitTest -Wall -O3 -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../SimdSolver.h"
+#include "../TiledSolver.h"
+#include "../MixedSolver.h"
+#include "../BlockStepper.h"
+#include "../SymplecticIntegrator.h"
+#include "../HermiteIntegrator.h"
+#include "../AdaptiveIntegrator.h"
+#include "../Kepler.h"
+#include "../WisdomHolmanIntegrator.h"
+#include "../Regularization.h"
+#include "../RegularizedIntegrator.h"
+#include "../LegacyIntegrator.h"
+#include "../NBody.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+const double STAR_MASS = 1.0e30;
+const double PERIAPSIS = 1.0e10;
+const double ECCENTRICITY = 0.9;
+
+// a planet on an e = 0.9 orbit starting at periapsis, and light bodies on wide circular orbits that never need a short step
+BodyStore make_eccentric_system(size_t outer)
+{
+    srand(5);
+    BodyStore store;
+    store.resize(2 + outer);
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    store.mass[0] = STAR_MASS;
+    store.mass[1] = 1.0e24;
+    store.x[1] = PERIAPSIS;
+    store.vy[1] = sqrt(GRAVITY_CONSTANT * STAR_MASS * (1.0 + ECCENTRICITY) / PERIAPSIS);
+    for (size_t i = 2; i < store.size(); i++)
+    {
+        const double radius = 1.0e12 * (1.0 + random_unit()), angle = 2.0 * M_PI * random_unit();
+        const double speed = sqrt(GRAVITY_CONSTANT * STAR_MASS / radius);
+        store.x[i] = radius * cos(angle);
+        store.y[i] = radius * sin(angle);
+        store.vx[i] = -speed * sin(angle);
+        store.vy[i] = speed * cos(angle);
+        store.mass[i] = 1.0e20;
+    }
+    return store;
+}
+
+double orbital_period()
+{
+    const double semiMajor = PERIAPSIS / (1.0 - ECCENTRICITY);
+    return 2.0 * M_PI * sqrt(semiMajor * semiMajor * semiMajor / (GRAVITY_CONSTANT * STAR_MASS));
+}
+
+double norm(double x, double y, double z)
+{
+    return sqrt(x * x + y * y + z * z);
+}
+
+double total_energy(const BodyStore &store)
+{
+    double energy = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        energy += 0.5 * store.mass[i] * (store.vx[i] * store.vx[i] + store.vy[i] * store.vy[i] + store.vz[i] * store.vz[i]);
+        for (size_t j = i + 1; j < store.size(); j++)
+        {
+            const double dx = store.x[j] - store.x[i], dy = store.y[j] - store.y[i], dz = store.z[j] - store.z[i];
+            energy -= GRAVITY_CONSTANT * store.mass[i] * store.mass[j] / sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+    return energy;
+}
+
+// plain kick-drift-kick with one shared step, the reference the block steps are measured against
+void run_uniform(BodyStore &store, double step, size_t steps)
+{
+    DirectSolver solver;
+    solver.computeAccelerations(store);
+    for (size_t s = 0; s < steps; s++)
+    {
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            store.vx[i] += 0.5 * step * store.ax[i];
+            store.vy[i] += 0.5 * step * store.ay[i];
+            store.vz[i] += 0.5 * step * store.az[i];
+            store.x[i] += step * store.vx[i];
+            store.y[i] += step * store.vy[i];
+            store.z[i] += step * store.vz[i];
+        }
+        solver.computeAccelerations(store);
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            store.vx[i] += 0.5 * step * store.ax[i];
+            store.vy[i] += 0.5 * step * store.ay[i];
+            store.vz[i] += 0.5 * step * store.az[i];
+        }
+    }
+}
+
+// runs the block stepper on the given number of threads, returns the accelerations it computed
+uint64_t run_blocks(BodyStore &store, double step, size_t steps, int levels, int threads, vector<int> *finalLevels = nullptr)
+{
+    DirectSolver solver;
+    BlockStepper stepper(step, levels, 0.02);
+    #pragma omp parallel num_threads(threads)
+    {
+        stepper.start(store, solver);
+        for (size_t s = 0; s < steps; s++)
+        {
+            stepper.advance(store, solver);
+        }
+    }
+    stepper.synchronize(store);
+    if (finalLevels)
+    {
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            finalLevels->push_back(stepper.levelOf(i));
+        }
+    }
+    return stepper.forceEvaluations();
+}
+
+void test_block_energy()
+{
+    // two periapsis passages, 200 coarse steps per orbit, far too coarse for the planet near the star
+    const size_t stepsPerOrbit = 200, orbits = 2, levels = 8;
+    const double step = orbital_period() / stepsPerOrbit;
+    const BodyStore initial = make_eccentric_system(30);
+    const double energy = total_energy(initial);
+
+    BodyStore coarse = initial, blocks = initial;
+    run_uniform(coarse, step, stepsPerOrbit * orbits);
+    const uint64_t evaluations = run_blocks(blocks, step, stepsPerOrbit * orbits, levels, 1);
+
+    const double coarseError = fabs(total_energy(coarse) - energy) / fabs(energy);
+    const double blockError = fabs(total_energy(blocks) - energy) / fabs(energy);
+    assert_below(1e-4, blockError, "block timesteps conserve energy through two periapsis passages at e = 0.9");
+    assert_below(0.01 * coarseError, blockError, "block timesteps are far closer than the shared coarse step");
+
+    const double uniformEvaluations = double(initial.size()) * ((stepsPerOrbit * orbits) << levels);
+    assert_below(0.1, evaluations / uniformEvaluations, "block timesteps compute a fraction of the accelerations of the shared finest step");
+
+    // the planet returns to periapsis, where its own step is the shortest
+    double dx = blocks.x[1] - blocks.x[0], dy = blocks.y[1] - blocks.y[0];
+    assert_below(1e-3, fabs(sqrt(dx * dx + dy * dy) - PERIAPSIS) / PERIAPSIS, "the eccentric planet is back at periapsis after two orbits");
+}
+
+void test_block_levels()
+{
+    const double step = orbital_period() / 200;
+    BodyStore store = make_eccentric_system(30);
+    vector<int> levels;
+    run_blocks(store, step, 200, 8, 1, &levels);
+
+    int outerDeepest = 0;
+    for (size_t i = 2; i < store.size(); i++)
+    {
+        outerDeepest = max(outerDeepest, levels[i]);
+    }
+    assert_below(0, outerDeepest, "bodies on wide orbits stay on the coarse step");
+    assert_below(2, 8 - levels[1], "the planet at periapsis is within two levels of the finest step");
+}
+
+void test_block_threads_agree()
+{
+    const double step = orbital_period() / 200;
+    BodyStore serial = make_eccentric_system(200), parallel = serial;
+    run_blocks(serial, step, 50, 8, 1);
+    run_blocks(parallel, step, 50, 8, 4);
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference = max(difference, fabs(serial.x[i] - parallel.x[i]) + fabs(serial.y[i] - parallel.y[i]) + fabs(serial.vx[i] - parallel.vx[i]));
+    }
+    assert_below(0.0, difference, "block timesteps on 4 threads match the serial run exactly");
+}
+
+// a light planet on an e = 0.5 orbit, one period later it is back where it started
+BodyStore make_kepler()
+{
+    BodyStore store;
+    store.resize(2);
+    store.mass[0] = STAR_MASS;
+    store.mass[1] = 1.0e20;
+    store.gravitationalMultiplier[0] = store.gravitationalMultiplier[1] = 1.0;
+    const double semiMajor = 1.0e11, eccentricity = 0.5, mu = GRAVITY_CONSTANT * (STAR_MASS + 1.0e20);
+    store.x[1] = semiMajor * (1.0 - eccentricity);
+    store.vy[1] = sqrt(mu * (1.0 + eccentricity) / store.x[1]);
+    return store;
+}
+
+double kepler_period()
+{
+    return 2.0 * M_PI * sqrt(1.0e33 / (GRAVITY_CONSTANT * (STAR_MASS + 1.0e20)));
+}
+
+// distance from the starting point after one period, relative to the periapsis, and the largest energy error on the way
+void run_symplectic(const string &name, size_t steps, double &phaseError, double &energyError)
+{
+    BodyStore store = make_kepler();
+    const double energy = total_energy(store), startX = store.x[1] - store.x[0];
+    DirectSolver solver;
+    unique_ptr<Integrator> integrator = makeSymplecticIntegrator(name, kepler_period() / steps);
+    energyError = 0.0;
+    integrator->start(store, solver);
+    for (size_t s = 0; s < steps; s++)
+    {
+        integrator->advance(store, solver);
+        energyError = max(energyError, fabs(total_energy(store) - energy) / fabs(energy));
+    }
+    const double dx = store.x[1] - store.x[0] - startX, dy = store.y[1] - store.y[0];
+    phaseError = sqrt(dx * dx + dy * dy) / startX;
+}
+
+void test_symplectic_orders()
+{
+    const vector<pair<string, int>> schemes = {{"kdk", 2}, {"dkd", 2}, {"yoshida4", 4}, {"forestruth", 4}, {"yoshida6", 6}};
+    for (const pair<string, int> &scheme : schemes)
+    {
+        double coarse, fine, energy;
+        const size_t steps = scheme.second == 6 ? 150 : 400;
+        run_symplectic(scheme.first, steps, coarse, energy);
+        run_symplectic(scheme.first, 2 * steps, fine, energy);
+        const double order = log2(coarse / fine);
+        assert_below(0.3, fabs(order - scheme.second), scheme.first + " converges at order " + to_string(scheme.second));
+    }
+
+    // the fourth order schemes at a five times longer step still beat the leapfrog on energy
+    double phase, leapfrogEnergy, yoshidaEnergy, forestEnergy;
+    run_symplectic("kdk", 2000, phase, leapfrogEnergy);
+    run_symplectic("yoshida4", 400, phase, yoshidaEnergy);
+    run_symplectic("forestruth", 400, phase, forestEnergy);
+    assert_below(leapfrogEnergy, yoshidaEnergy, "yoshida4 at 5x the step keeps energy better than kdk");
+    assert_below(leapfrogEnergy, forestEnergy, "forestruth at 5x the step keeps energy better than kdk");
+}
+
+void test_jerk_kernels()
+{
+    // a ball of bodies on random velocities, with a close pair inside the softening length
+    srand(13);
+    BodyStore store;
+    store.resize(1001);
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.x[i] = 1.0e12 * random_unit();
+        store.y[i] = 1.0e12 * random_unit();
+        store.z[i] = 1.0e12 * random_unit();
+        store.vx[i] = 3.0e4 * (random_unit() - 0.5);
+        store.vy[i] = 3.0e4 * (random_unit() - 0.5);
+        store.vz[i] = 3.0e4 * (random_unit() - 0.5);
+        store.mass[i] = 1.0e24 * (0.5 + random_unit());
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    store.x[1] = store.x[0] + 2.0e-6;
+
+    const size_t n = store.size();
+    vector<double> reference(6 * n);
+    JerkKernel scalar = jerkKernelFor(SimdLevel::Scalar);
+    for (size_t i = 0; i < n; i++)
+    {
+        scalar(store.x.data(), store.y.data(), store.z.data(), store.vx.data(), store.vy.data(), store.vz.data(), store.mass.data(), n,
+               store.x[i], store.y[i], store.z[i], store.vx[i], store.vy[i], store.vz[i], &reference[6 * i], &reference[6 * i + 3]);
+    }
+    for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if (detectSimdLevel() < level)
+        {
+            continue;
+        }
+        JerkKernel kernel = jerkKernelFor(level);
+        double difference = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            double sums[6] = {};
+            kernel(store.x.data(), store.y.data(), store.z.data(), store.vx.data(), store.vy.data(), store.vz.data(), store.mass.data(), n,
+                   store.x[i], store.y[i], store.z[i], store.vx[i], store.vy[i], store.vz[i], sums, sums + 3);
+            for (int k = 0; k < 6; k += 3)
+            {
+                const double size = fabs(reference[6 * i + k]) + fabs(reference[6 * i + k + 1]) + fabs(reference[6 * i + k + 2]);
+                difference = max(difference, (fabs(sums[k] - reference[6 * i + k]) + fabs(sums[k + 1] - reference[6 * i + k + 1]) + fabs(sums[k + 2] - reference[6 * i + k + 2])) / size);
+            }
+        }
+        assert_below(1e-12, difference, string("jerk kernel (") + simdLevelName(level) + ") matches the scalar kernel");
+    }
+
+    // the jerk is the time derivative of the accelerations the direct sum gives, checked by a central difference
+    const double h = 10.0;
+    BodyStore ahead = store, behind = store;
+    for (size_t i = 0; i < n; i++)
+    {
+        ahead.x[i] += h * store.vx[i], ahead.y[i] += h * store.vy[i], ahead.z[i] += h * store.vz[i];
+        behind.x[i] -= h * store.vx[i], behind.y[i] -= h * store.vy[i], behind.z[i] -= h * store.vz[i];
+    }
+    DirectSolver direct;
+    direct.computeAccelerations(ahead);
+    direct.computeAccelerations(behind);
+    double sum = 0.0;
+    for (size_t i = 2; i < n; i++)
+    {
+        const double ex = (ahead.ax[i] - behind.ax[i]) / (2.0 * h) - GRAVITY_CONSTANT * reference[6 * i + 3];
+        const double ey = (ahead.ay[i] - behind.ay[i]) / (2.0 * h) - GRAVITY_CONSTANT * reference[6 * i + 4];
+        const double ez = (ahead.az[i] - behind.az[i]) / (2.0 * h) - GRAVITY_CONSTANT * reference[6 * i + 5];
+        const double size = GRAVITY_CONSTANT * norm(reference[6 * i + 3], reference[6 * i + 4], reference[6 * i + 5]);
+        sum += (ex * ex + ey * ey + ez * ez) / (size * size);
+    }
+    assert_below(1e-6, sqrt(sum / (n - 2)), "jerk kernel matches the central difference of the direct sum's accelerations");
+}
+
+void run_hermite(BodyStore &store, double step, size_t steps, double accuracy, int threads, uint64_t &evaluations)
+{
+    DirectSolver unused;
+    HermiteIntegrator hermite(step, accuracy);
+    #pragma omp parallel num_threads(threads)
+    {
+        hermite.start(store, unused);
+        for (size_t s = 0; s < steps; s++)
+        {
+            hermite.advance(store, unused);
+        }
+    }
+    evaluations = hermite.forceEvaluations();
+}
+
+void test_hermite()
+{
+    // an accuracy this loose never cuts the step below the Timestep, which leaves the plain fourth order scheme
+    uint64_t evaluations;
+    double errors[2];
+    for (int k = 0; k < 2; k++)
+    {
+        BodyStore store = make_kepler();
+        const double startX = store.x[1] - store.x[0];
+        run_hermite(store, kepler_period() / (200 << k), 200 << k, 1.0e6, 1, evaluations);
+        const double dx = store.x[1] - store.x[0] - startX, dy = store.y[1] - store.y[0];
+        errors[k] = sqrt(dx * dx + dy * dy) / startX;
+    }
+    assert_below(0.3, fabs(log2(errors[0] / errors[1]) - 4.0), "hermite converges at order 4 on a fixed step");
+
+    // on the eccentric orbit the criterion shortens the steps around periapsis by itself
+    const size_t stepsPerOrbit = 200;
+    const double step = orbital_period() / stepsPerOrbit;
+    const BodyStore initial = make_eccentric_system(30);
+    const double energy = total_energy(initial);
+    BodyStore loose = initial, store = initial, parallel = initial;
+    uint64_t looseEvaluations;
+    run_hermite(loose, step, 2 * stepsPerOrbit, 0.02, 1, looseEvaluations);
+    run_hermite(store, step, 2 * stepsPerOrbit, 0.005, 1, evaluations);
+    const double looseError = fabs(total_energy(loose) - energy) / fabs(energy), error = fabs(total_energy(store) - energy) / fabs(energy);
+    assert_below(5e-6, error, "hermite with Aarseth steps conserves energy through two periapsis passages");
+    assert_below(0.1 * looseError, error, "a quarter of the accuracy parameter cuts the energy error more than tenfold");
+    assert_below(5.0 * 2 * stepsPerOrbit, double(evaluations) / initial.size(), "hermite takes a few substeps per Timestep on average");
+
+    uint64_t parallelEvaluations;
+    run_hermite(parallel, step, 2 * stepsPerOrbit, 0.005, 4, parallelEvaluations);
+    double difference = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        difference = max(difference, fabs(store.x[i] - parallel.x[i]) + fabs(store.vx[i] - parallel.vx[i]));
+    }
+    assert_below(0.0, difference, "hermite on 4 threads matches the serial run exactly");
+}
+
+// runs the shared adaptive step over a kick-drift-kick leapfrog, returns the number of steps it took
+uint64_t run_adaptive(BodyStore &store, double step, size_t steps, StepCriterion criterion, double accuracy, int threads, double *smallest = nullptr)
+{
+    DirectSolver solver;
+    AdaptiveIntegrator adaptive(makeSymplecticIntegrator("kdk", step), step, criterion, accuracy);
+    #pragma omp parallel num_threads(threads)
+    {
+        adaptive.start(store, solver);
+        for (size_t s = 0; s < steps; s++)
+        {
+            adaptive.advance(store, solver);
+        }
+    }
+    if (smallest)
+    {
+        *smallest = adaptive.smallestStep();
+    }
+    return adaptive.stepsTaken();
+}
+
+void test_adaptive()
+{
+    const size_t stepsPerOrbit = 200;
+    const double step = orbital_period() / stepsPerOrbit;
+    const BodyStore initial = make_eccentric_system(30);
+    const double energy = total_energy(initial);
+
+    // a criterion that never asks for less than the Timestep leaves the plain leapfrog, step for step
+    BodyStore plain = initial, unlimited = initial;
+    run_uniform(plain, step, stepsPerOrbit);
+    const uint64_t unlimitedSteps = run_adaptive(unlimited, step, stepsPerOrbit, StepCriterion::Aarseth, 1.0e6, 1);
+    double difference = 0.0;
+    for (size_t i = 0; i < plain.size(); i++)
+    {
+        difference = max(difference, fabs(plain.x[i] - unlimited.x[i]) / PERIAPSIS + fabs(plain.vx[i] - unlimited.vx[i]) / plain.vy[1]);
+    }
+    assert_below(0.0, double(unlimitedSteps) - stepsPerOrbit, "a loose criterion takes one step per Timestep");
+    assert_below(1e-12, difference, "a loose criterion matches the fixed step leapfrog");
+
+    // both criteria spend their steps around periapsis, a fixed step with as many steps does much worse there
+    const StepCriterion criteria[2] = {StepCriterion::Aarseth, StepCriterion::FreeFall};
+    const string names[2] = {"aarseth", "free-fall"};
+    for (int c = 0; c < 2; c++)
+    {
+        BodyStore adaptive = initial;
+        double smallest;
+        const uint64_t steps = run_adaptive(adaptive, step, 2 * stepsPerOrbit, criteria[c], 0.01, 1, &smallest);
+        BodyStore fixed = initial;
+        run_uniform(fixed, 2 * stepsPerOrbit * step / steps, steps);
+        const double adaptiveError = fabs(total_energy(adaptive) - energy) / fabs(energy), fixedError = fabs(total_energy(fixed) - energy) / fabs(energy);
+        assert_below(0.5 * step, smallest, names[c] + " steps shorten around periapsis");
+        assert_below(0.1 * fixedError, adaptiveError, names[c] + " steps beat a fixed step of the same cost tenfold");
+    }
+
+    BodyStore serial = initial, parallel = initial;
+    run_adaptive(serial, step, stepsPerOrbit, StepCriterion::Aarseth, 0.01, 1);
+    run_adaptive(parallel, step, stepsPerOrbit, StepCriterion::Aarseth, 0.01, 4);
+    difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference = max(difference, fabs(serial.x[i] - parallel.x[i]) + fabs(serial.vx[i] - parallel.vx[i]));
+    }
+    assert_below(0.0, difference, "adaptive steps on 4 threads match the serial run exactly");
+}
+
+void test_kepler_drift()
+{
+    // an e = 0.9 ellipse, a hyperbola, a radial escape and a state with no centre, in one partly filled block and the next
+    const size_t count = KEPLER_LANES + 3;
+    const double mu = GRAVITY_CONSTANT * STAR_MASS;
+    vector<double> x(count), y(count), z(count), vx(count), vy(count), vz(count), parameter(count, mu);
+    for (size_t k = 0; k < count; k++)
+    {
+        x[k] = PERIAPSIS * (1.0 + 0.1 * k);
+        z[k] = 1.0e8 * k;
+        const int kind = k % 4;
+        vy[k] = kind == 0 ? sqrt(mu * 1.9 / x[k]) : kind == 1 ? sqrt(mu * 3.0 / x[k]) : 0.0;
+        vx[k] = kind == 2 ? sqrt(2.0 * mu / x[k]) : kind == 3 ? 1.0e4 : 0.0;
+        vz[k] = kind == 1 ? 1.0e3 : 0.0;
+        parameter[k] = kind == 3 ? 0.0 : mu;
+    }
+    const vector<double> x0 = x, y0 = y, z0 = z, vx0 = vx, vy0 = vy, vz0 = vz;
+
+    // a whole period of the ellipse brings it back, however many periods the drift is long
+    const double semiMajor = PERIAPSIS / (1.0 - 0.9), period = 2.0 * M_PI * sqrt(semiMajor * semiMajor * semiMajor / mu);
+    keplerDrift(&x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], &parameter[0], 1, 3.0 * period);
+    assert_below(1e-9, norm(x[0] - x0[0], y[0] - y0[0], z[0] - z0[0]) / PERIAPSIS, "three periods of an e = 0.9 ellipse close the orbit");
+
+    // two drifts make one, and every orbit keeps its energy and angular momentum
+    x = x0, y = y0, z = z0, vx = vx0, vy = vy0, vz = vz0;
+    vector<double> xs = x0, ys = y0, zs = z0, vxs = vx0, vys = vy0, vzs = vz0;
+    const double first = 0.37 * period, second = 0.81 * period;
+    keplerDrift(x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(), parameter.data(), count, first);
+    keplerDrift(x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(), parameter.data(), count, second);
+    keplerDrift(xs.data(), ys.data(), zs.data(), vxs.data(), vys.data(), vzs.data(), parameter.data(), count, first + second);
+    double split = 0.0, energy = 0.0, momentum = 0.0, line = 0.0;
+    for (size_t k = 0; k < count; k++)
+    {
+        const double r0 = norm(x0[k], y0[k], z0[k]), r = norm(x[k], y[k], z[k]);
+        split = max(split, norm(x[k] - xs[k], y[k] - ys[k], z[k] - zs[k]) / r);
+        if (parameter[k] > 0.0)
+        {
+            const double e0 = 0.5 * (vx0[k] * vx0[k] + vy0[k] * vy0[k] + vz0[k] * vz0[k]) - mu / r0;
+            const double e1 = 0.5 * (vx[k] * vx[k] + vy[k] * vy[k] + vz[k] * vz[k]) - mu / r;
+            energy = max(energy, fabs(e1 - e0) / (mu / r0));
+            const double h0 = norm(y0[k] * vz0[k] - z0[k] * vy0[k], z0[k] * vx0[k] - x0[k] * vz0[k], x0[k] * vy0[k] - y0[k] * vx0[k]);
+            const double h1 = norm(y[k] * vz[k] - z[k] * vy[k], z[k] * vx[k] - x[k] * vz[k], x[k] * vy[k] - y[k] * vx[k]);
+            momentum = max(momentum, fabs(h1 - h0) / (r0 * sqrt(mu / r0)));
+        }
+        else
+        {
+            line = max(line, norm(x[k] - x0[k] - vx0[k] * (first + second), y[k] - y0[k], z[k] - z0[k]) / r0);
+        }
+    }
+    assert_below(1e-10, split, "two kepler drifts end where one of their combined length does");
+    assert_below(1e-12, energy, "kepler drifts keep the orbital energy of ellipses, hyperbolas and escapes");
+    assert_below(1e-12, momentum, "kepler drifts keep the angular momentum");
+    assert_below(1e-14, line, "a state without a centre drifts in a straight line");
+}
+
+// a star, three planets and three moons on circular orbits around their parents, and the matching parent list
+BodyStore make_hierarchy(vector<int> &parent)
+{
+    const double masses[7] = {STAR_MASS, 6.0e24, 1.0e25, 2.0e27, 7.0e22, 1.0e22, 1.0e22};
+    const double radii[7] = {0.0, 1.0e11, 1.6e11, 2.5e11, 4.0e8, 5.0e8, 1.0e9};
+    const double angles[7] = {0.0, 0.3, 2.1, 4.0, 1.0, 2.5, 5.5};
+    parent = {-1, 0, 0, 0, 1, 3, 3};
+    BodyStore store;
+    store.resize(7);
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.mass[i] = masses[i];
+        store.gravitationalMultiplier[i] = 1.0;
+        if (parent[i] < 0)
+        {
+            continue;
+        }
+        const size_t p = parent[i];
+        const double speed = sqrt(GRAVITY_CONSTANT * (masses[p] + masses[i]) / radii[i]);
+        store.x[i] = store.x[p] + radii[i] * cos(angles[i]);
+        store.y[i] = store.y[p] + radii[i] * sin(angles[i]);
+        store.z[i] = store.z[p] + 1.0e-3 * radii[i];
+        store.vx[i] = store.vx[p] - speed * sin(angles[i]);
+        store.vy[i] = store.vy[p] + speed * cos(angles[i]);
+    }
+    return store;
+}
+
+// the largest relative energy error of the integrator over the given steps
+double run_stepping(SteppingIntegrator &integrator, BodyStore &store, size_t steps, int threads)
+{
+    DirectSolver solver;
+    const double energy = total_energy(store);
+    double error = 0.0;
+    #pragma omp parallel num_threads(threads)
+    {
+        integrator.start(store, solver);
+        for (size_t s = 0; s < steps; s++)
+        {
+            integrator.advance(store, solver);
+            #pragma omp single
+            error = max(error, fabs(total_energy(store) - energy) / fabs(energy));
+        }
+    }
+    return error;
+}
+
+void test_wisdom_holman()
+{
+    // a lone star and planet only ever drift, seven steps go round the e = 0.5 orbit exactly
+    BodyStore pair = make_kepler();
+    const double startX = pair.x[1] - pair.x[0];
+    WisdomHolmanIntegrator lone(kepler_period() / 7, {-1, 0});
+    run_stepping(lone, pair, 7, 1);
+    assert_below(1e-9, norm(pair.x[1] - pair.x[0] - startX, pair.y[1] - pair.y[0], pair.z[1] - pair.z[0]) / startX,
+                 "wisdomholman follows a two body orbit exactly in seven steps");
+
+    // the closest moon goes round in about two days, steps of a fifth of that against the leapfrog,
+    // measured by every orbit's error against a sixth order run on a step of 200 seconds
+    vector<int> parent;
+    const BodyStore initial = make_hierarchy(parent);
+    const double step = 4.0e4;
+    const size_t steps = 500;
+    BodyStore wisdom = initial, leapfrog = initial, fine = initial, reference = initial, parallel = initial;
+    WisdomHolmanIntegrator integrator(step, parent), threaded(step, parent);
+    unique_ptr<SteppingIntegrator> kdk = makeSymplecticIntegrator("kdk", step), fineKdk = makeSymplecticIntegrator("kdk", step / 100);
+    unique_ptr<SteppingIntegrator> yoshida = makeSymplecticIntegrator("yoshida6", step / 200);
+    const double wisdomError = run_stepping(integrator, wisdom, steps, 1);
+    const double leapfrogError = run_stepping(*kdk, leapfrog, steps, 1);
+    run_stepping(*fineKdk, fine, 100 * steps, 1);
+    run_stepping(*yoshida, reference, 200 * steps, 1);
+    assert_below(1e-4 * leapfrogError, wisdomError, "wisdomholman keeps energy ten thousand times better than kdk on the same step");
+    double wisdomOrbit = 0.0, fineOrbit = 0.0;
+    for (size_t i = 1; i < initial.size(); i++)
+    {
+        const size_t p = parent[i];
+        const double rx = reference.x[i] - reference.x[p], ry = reference.y[i] - reference.y[p], rz = reference.z[i] - reference.z[p];
+        const double r = norm(rx, ry, rz);
+        wisdomOrbit = max(wisdomOrbit, norm(wisdom.x[i] - wisdom.x[p] - rx, wisdom.y[i] - wisdom.y[p] - ry, wisdom.z[i] - wisdom.z[p] - rz) / r);
+        fineOrbit = max(fineOrbit, norm(fine.x[i] - fine.x[p] - rx, fine.y[i] - fine.y[p] - ry, fine.z[i] - fine.z[p] - rz) / r);
+    }
+    assert_below(0.2 * fineOrbit, wisdomOrbit, "wisdomholman follows every orbit better than kdk on a hundred times shorter step");
+
+    run_stepping(threaded, parallel, steps, 4);
+    double difference = 0.0;
+    for (size_t i = 0; i < wisdom.size(); i++)
+    {
+        difference = max(difference, fabs(wisdom.x[i] - parallel.x[i]) + fabs(wisdom.vx[i] - parallel.vx[i]));
+    }
+    assert_below(0.0, difference, "wisdomholman on 4 threads matches the serial run exactly");
+
+    vector<Body> bodies;
+    vector<Vec3> trajectory;
+    const vector<int> children[3] = {{1, 2}, {2}, {}};
+    for (const vector<int> &list : children)
+    {
+        bodies.emplace_back(Vec3(), Vec3(), Vec3(), Vec3(), 1.0, 1.0, 1.0, "planet", list, trajectory);
+    }
+    int rejected = 0;
+    try
+    {
+        parentIndices(bodies);
+    }
+    catch (const invalid_argument &)
+    {
+        rejected++;
+    }
+    try
+    {
+        WisdomHolmanIntegrator cycle(step, {2, 0, 1});
+    }
+    catch (const invalid_argument &)
+    {
+        rejected++;
+    }
+    assert_below(0.0, 2.0 - rejected, "a body under two parents and a cycle of parents are rejected");
+}
+
+void test_regularized_drifts()
+{
+    // the KS pair drift lands where the universal variable drift does, on an e = 0.9 ellipse, a hyperbola and a radial escape
+    const double mu = GRAVITY_CONSTANT * STAR_MASS;
+    const double semiMajor = PERIAPSIS / (1.0 - 0.9), period = 2.0 * M_PI * sqrt(semiMajor * semiMajor * semiMajor / mu);
+    const double speeds[3] = {sqrt(mu * 1.9 / PERIAPSIS), sqrt(mu * 3.0 / PERIAPSIS), sqrt(2.0 * mu / PERIAPSIS)};
+    double difference = 0.0;
+    for (int kind = 0; kind < 3; kind++)
+    {
+        for (double time : {0.01 * period, 0.37 * period, 2.6 * period})
+        {
+            double relative[3] = {-PERIAPSIS, 1.0e8, 0.0}, velocity[3] = {kind == 2 ? -speeds[2] : 0.0, kind == 2 ? 0.0 : -speeds[kind], 1.0e2};
+            double x = relative[0], y = relative[1], z = relative[2], vx = velocity[0], vy = velocity[1], vz = velocity[2];
+            ksDrift(relative, velocity, mu, time);
+            keplerDrift(&x, &y, &z, &vx, &vy, &vz, &mu, 1, time);
+            difference = max(difference, norm(relative[0] - x, relative[1] - y, relative[2] - z) / norm(x, y, z));
+        }
+    }
+    assert_below(1e-9, difference, "ks drifts match the kepler drift on ellipses, hyperbolas and escapes");
+
+    // a pair falling straight together goes through the collision and back out, one period later it is where it started
+    const double apoapsis = 2.0 * PERIAPSIS, fallPeriod = 2.0 * M_PI * sqrt(PERIAPSIS * PERIAPSIS * PERIAPSIS / mu);
+    double radial[3] = {apoapsis, 0.0, 0.0}, rest[3] = {0.0, 0.0, 0.0};
+    ksDrift(radial, rest, mu, 3.0 * fallPeriod);
+    assert_below(1e-8, norm(radial[0] - apoapsis, radial[1], radial[2]) / apoapsis, "a radial orbit through the collision closes after three periods");
+
+    // the chain of two bodies follows the pair's exact orbit
+    const double masses[2] = {STAR_MASS, 3.0e29}, pairMu = GRAVITY_CONSTANT * (masses[0] + masses[1]);
+    double cx[2] = {-0.3 * PERIAPSIS / 1.3, PERIAPSIS / 1.3}, cy[2] = {0.0, 0.0}, cz[2] = {0.0, 0.0};
+    const double relativeSpeed = sqrt(pairMu * 1.9 / PERIAPSIS);
+    double cvx[2] = {0.0, 0.0}, cvy[2] = {-0.3 * relativeSpeed / 1.3, relativeSpeed / 1.3}, cvz[2] = {0.0, 0.0};
+    double pair[3] = {PERIAPSIS, 0.0, 0.0}, pairVelocity[3] = {0.0, relativeSpeed, 0.0};
+    chainDrift(2, masses, GRAVITY_CONSTANT, cx, cy, cz, cvx, cvy, cvz, 0.37 * period);
+    ksDrift(pair, pairVelocity, pairMu, 0.37 * period);
+    assert_below(1e-4, norm(cx[1] - cx[0] - pair[0], cy[1] - cy[0] - pair[1], cz[1] - cz[0] - pair[2]) / PERIAPSIS,
+                 "a chain of two follows the ks orbit of the pair");
+
+    // a triple with a close binary keeps its energy and angular momentum through the chain's fictitious time steps
+    const double triple[3] = {1.0e30, 6.0e29, 2.0e29};
+    double tx[3] = {0.0, 1.0e9, -5.0e9}, ty[3] = {0.0, 0.0, 1.0e9}, tz[3] = {0.0, 2.0e8, 0.0};
+    double tvx[3] = {0.0, 0.0, 1.0e4}, tvy[3] = {-1.5e5, 2.5e5, -4.0e4}, tvz[3] = {0.0, 0.0, 3.0e3};
+    auto energy = [&]()
+    {
+        double e = 0.0;
+        for (int i = 0; i < 3; i++)
+        {
+            e += 0.5 * triple[i] * (tvx[i] * tvx[i] + tvy[i] * tvy[i] + tvz[i] * tvz[i]);
+            for (int j = i + 1; j < 3; j++)
+            {
+                e -= GRAVITY_CONSTANT * triple[i] * triple[j] / norm(tx[j] - tx[i], ty[j] - ty[i], tz[j] - tz[i]);
+            }
+        }
+        return e;
+    };
+    auto momentum = [&]()
+    {
+        double h[3] = {0.0, 0.0, 0.0};
+        for (int i = 0; i < 3; i++)
+        {
+            h[0] += triple[i] * (ty[i] * tvz[i] - tz[i] * tvy[i]);
+            h[1] += triple[i] * (tz[i] * tvx[i] - tx[i] * tvz[i]);
+            h[2] += triple[i] * (tx[i] * tvy[i] - ty[i] * tvx[i]);
+        }
+        return norm(h[0], h[1], h[2]);
+    };
+    double *state[6] = {tx, ty, tz, tvx, tvy, tvz};
+    for (double *component : state)
+    {
+        const double centre = (triple[0] * component[0] + triple[1] * component[1] + triple[2] * component[2]) / (triple[0] + triple[1] + triple[2]);
+        for (int i = 0; i < 3; i++)
+        {
+            component[i] -= centre; // the chain works in the centre of mass frame
+        }
+    }
+    const double e0 = energy(), h0 = momentum();
+    chainDrift(3, triple, GRAVITY_CONSTANT, tx, ty, tz, tvx, tvy, tvz, 3.0e6);
+    assert_below(1e-5, fabs(energy() - e0) / fabs(e0), "the chain keeps the energy of a triple through its close approaches");
+    assert_below(1e-10, fabs(momentum() - h0) / h0, "the chain keeps the angular momentum of a triple");
+
+    // a loose group drifted for a minute barely moves from its straight lines, the chain must not step past the minute
+    const double loose[3] = {6.0e24, 5.9e24, 3.3e24};
+    double lx[3] = {-1.0e10, 0.0, 1.2e10}, ly[3] = {0.0, 1.0e9, -5.0e8}, lz[3] = {0.0, 0.0, 0.0};
+    double lvx[3] = {0.0, 0.0, 0.0}, lvy[3] = {-9.0e3, 1.6e4, -1.2e4}, lvz[3] = {1.0e2, -1.0e2, 0.0};
+    double *looseState[6] = {lx, ly, lz, lvx, lvy, lvz};
+    for (double *component : looseState)
+    {
+        const double centre = (loose[0] * component[0] + loose[1] * component[1] + loose[2] * component[2]) / (loose[0] + loose[1] + loose[2]);
+        for (int i = 0; i < 3; i++)
+        {
+            component[i] -= centre;
+        }
+    }
+    const double sx[3] = {lx[0], lx[1], lx[2]}, sy[3] = {ly[0], ly[1], ly[2]}, svy[3] = {lvy[0], lvy[1], lvy[2]};
+    chainDrift(3, loose, GRAVITY_CONSTANT, lx, ly, lz, lvx, lvy, lvz, 60.0);
+    double straight = 0.0;
+    for (int i = 0; i < 3; i++)
+    {
+        straight = max(straight, norm(lx[i] - sx[i], ly[i] - sy[i] - svy[i] * 60.0, 0.0));
+    }
+    assert_below(1.0, straight, "a loose triple drifted for a minute stays within a metre of its straight lines");
+
+    // sixty thousand orbits of a tight binary with a third star outside take more chain steps than the limit allows,
+    // the drift must still end on dt, the rest done by the plain leapfrog
+    const double wide[3] = {1.0e30, 1.0e30, 1.0e29};
+    double wx[3] = {-5.0e8, 5.0e8, 1.0e11}, wy[3] = {0.0, 0.0, 0.0}, wz[3] = {0.0, 0.0, 0.0};
+    double wvx[3] = {0.0, 0.0, 0.0}, wvy[3] = {-1.8265e5, 1.8265e5, 3.74e4}, wvz[3] = {0.0, 0.0, 0.0};
+    double *wideState[6] = {wx, wy, wz, wvx, wvy, wvz};
+    for (double *component : wideState)
+    {
+        const double centre = (wide[0] * component[0] + wide[1] * component[1] + wide[2] * component[2]) / (wide[0] + wide[1] + wide[2]);
+        for (int i = 0; i < 3; i++)
+        {
+            component[i] -= centre;
+        }
+    }
+    auto wideEnergy = [&]()
+    {
+        double e = 0.0;
+        for (int i = 0; i < 3; i++)
+        {
+            e += 0.5 * wide[i] * (wvx[i] * wvx[i] + wvy[i] * wvy[i] + wvz[i] * wvz[i]);
+            for (int j = i + 1; j < 3; j++)
+            {
+                e -= GRAVITY_CONSTANT * wide[i] * wide[j] / norm(wx[j] - wx[i], wy[j] - wy[i], wz[j] - wz[i]);
+            }
+        }
+        return e;
+    };
+    const double innerPeriod = 2.0 * M_PI * sqrt(1.0e27 / (GRAVITY_CONSTANT * 2.0e30)), longDrift = 6.0e4 * innerPeriod;
+    // the third star goes round the binary's centre on a near Kepler orbit, the binary's quadrupole turns it by a percent
+    // or so over sixty orbits, a drift stopped at the limit leaves it most of an orbit away
+    auto outerOrbit = [&](double out[6])
+    {
+        const double *component[6] = {wx, wy, wz, wvx, wvy, wvz};
+        for (int c = 0; c < 6; c++)
+        {
+            out[c] = component[c][2] - (wide[0] * component[c][0] + wide[1] * component[c][1]) / (wide[0] + wide[1]);
+        }
+    };
+    double expected[6], outer[6];
+    outerOrbit(expected);
+    const double outerMu = GRAVITY_CONSTANT * (wide[0] + wide[1] + wide[2]);
+    keplerDrift(&expected[0], &expected[1], &expected[2], &expected[3], &expected[4], &expected[5], &outerMu, 1, longDrift);
+    const double wideStart = wideEnergy();
+    const double reached = chainDrift(3, wide, GRAVITY_CONSTANT, wx, wy, wz, wvx, wvy, wvz, longDrift);
+    outerOrbit(outer);
+    assert_below(0.0, reached < longDrift ? 0.0 : 1.0, "a chain past its step limit reports the time it reached");
+    assert_below(5e-2, norm(outer[0] - expected[0], outer[1] - expected[1], outer[2] - expected[2]) / norm(expected[0], expected[1], expected[2]),
+                 "a chain past its step limit still drifts for the whole of dt");
+    assert_below(1e-4, fabs(wideEnergy() - wideStart) / fabs(wideStart), "the leapfrog past the step limit keeps the energy of the triple");
+}
+
+// a star with a planet, a hard binary orbiting it and a hierarchical triple further out
+BodyStore make_clustered()
+{
+    BodyStore store;
+    store.resize(7);
+    const double masses[7] = {STAR_MASS, 1.0e25, 1.0e29, 1.0e29, 1.0e28, 1.0e28, 1.0e28};
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.mass[i] = masses[i];
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    auto place = [&](size_t i, double x, double y, double vx, double vy)
+    {
+        store.x[i] = x;
+        store.y[i] = y;
+        store.z[i] = 1.0e-3 * x;
+        store.vx[i] = vx;
+        store.vy[i] = vy;
+    };
+    const double g = GRAVITY_CONSTANT;
+    place(1, 2.0e11, 0.0, 0.0, sqrt(g * STAR_MASS / 2.0e11));
+    const double binaryOrbit = sqrt(g * (STAR_MASS + 2.0e29) / 1.0e11), binarySpeed = sqrt(g * 2.0e29 / 1.0e9);
+    place(2, 0.0, 1.0e11 - 5.0e8, -binaryOrbit + 0.5 * binarySpeed, 0.0);
+    place(3, 0.0, 1.0e11 + 5.0e8, -binaryOrbit - 0.5 * binarySpeed, 0.0);
+    const double tripleOrbit = sqrt(g * (STAR_MASS + 3.0e28) / 3.0e11), innerSpeed = sqrt(g * 2.0e28 / 1.0e9);
+    const double outerSpeed = sqrt(g * 3.0e28 / 3.0e9);
+    place(4, -3.0e11 - 1.0e9, 0.0, 0.0, -tripleOrbit + 0.5 * innerSpeed - outerSpeed / 3.0);
+    place(5, -3.0e11, 0.0, 0.0, -tripleOrbit - 0.5 * innerSpeed - outerSpeed / 3.0);
+    place(6, -3.0e11 + 2.0e9, 0.0, 0.0, -tripleOrbit + 2.0 * outerSpeed / 3.0);
+    return store;
+}
+
+void test_regularized()
+{
+    // a step of two binary periods, the composites' orbits against a sixth order run that resolves the binary
+    const BodyStore initial = make_clustered();
+    const double step = 1.0e5, radius = 5.0e9;
+    const size_t steps = 50;
+    BodyStore regularized = initial, leapfrog = initial, reference = initial, parallel = initial;
+    RegularizedIntegrator integrator(makeSymplecticIntegrator("kdk", step), step, radius);
+    RegularizedIntegrator threaded(makeSymplecticIntegrator("kdk", step), step, radius);
+    unique_ptr<SteppingIntegrator> kdk = makeSymplecticIntegrator("kdk", step), yoshida = makeSymplecticIntegrator("yoshida6", step / 200);
+    const double regularizedError = run_stepping(integrator, regularized, steps, 1);
+    const double leapfrogError = run_stepping(*kdk, leapfrog, steps, 1);
+    run_stepping(*yoshida, reference, 200 * steps, 1);
+    const vector<vector<uint32_t>> expected = {{2, 3}, {4, 5, 6}};
+    assert_below(0.0, integrator.currentGroups() == expected ? 0.0 : 1.0, "the binary and the triple are found as groups");
+    assert_below(1e-3 * leapfrogError, regularizedError, "regularized kdk keeps energy a thousand times better than kdk on the same step");
+
+    double orbit = 0.0;
+    for (const vector<size_t> &unit : vector<vector<size_t>>{{1}, {2, 3}, {4, 5, 6}})
+    {
+        double centre[3] = {0.0, 0.0, 0.0}, exact[3] = {0.0, 0.0, 0.0}, mass = 0.0;
+        for (size_t i : unit)
+        {
+            mass += initial.mass[i];
+            centre[0] += initial.mass[i] * (regularized.x[i] - regularized.x[0]), exact[0] += initial.mass[i] * (reference.x[i] - reference.x[0]);
+            centre[1] += initial.mass[i] * (regularized.y[i] - regularized.y[0]), exact[1] += initial.mass[i] * (reference.y[i] - reference.y[0]);
+            centre[2] += initial.mass[i] * (regularized.z[i] - regularized.z[0]), exact[2] += initial.mass[i] * (reference.z[i] - reference.z[0]);
+        }
+        orbit = max(orbit, norm(centre[0] - exact[0], centre[1] - exact[1], centre[2] - exact[2]) / norm(exact[0], exact[1], exact[2]));
+    }
+    assert_below(1e-3, orbit, "the planet and the groups' centres of mass follow the resolved run");
+    const double separation = norm(regularized.x[3] - regularized.x[2], regularized.y[3] - regularized.y[2], regularized.z[3] - regularized.z[2]);
+    const double resolved = norm(reference.x[3] - reference.x[2], reference.y[3] - reference.y[2], reference.z[3] - reference.z[2]);
+    assert_below(1e-3, fabs(separation - resolved) / resolved, "the binary keeps its separation");
+
+    run_stepping(threaded, parallel, steps, 4);
+    double threads = 0.0;
+    for (size_t i = 0; i < regularized.size(); i++)
+    {
+        threads = max(threads, fabs(regularized.x[i] - parallel.x[i]) + fabs(regularized.vx[i] - parallel.vx[i]));
+    }
+    assert_below(0.0, threads, "regularized kdk on 4 threads matches the serial run exactly");
+}
+
+void test_active_subsets()
+{
+    srand(9);
+    BodyStore store;
+    store.resize(3000);
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.x[i] = 1.0e12 * random_unit();
+        store.y[i] = 1.0e12 * random_unit();
+        store.z[i] = 1.0e12 * random_unit();
+        store.mass[i] = 1.0e24 * (0.5 + random_unit());
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    vector<uint32_t> targets;
+    for (uint32_t i = 0; i < store.size(); i += 3)
+    {
+        targets.push_back(i);
+    }
+
+    vector<unique_ptr<ForceSolver>> solvers;
+    solvers.push_back(make_unique<DirectSolver>());
+    solvers.push_back(make_unique<SimdSolver>());
+    solvers.push_back(make_unique<TiledSolver>(64, 256));
+    solvers.push_back(make_unique<MixedSolver>());
+    for (unique_ptr<ForceSolver> &solver : solvers)
+    {
+        BodyStore full = store, subset = store;
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            subset.ax[i] = subset.ay[i] = subset.az[i] = -1.0;
+        }
+        #pragma omp parallel num_threads(3)
+        {
+            solver->computeAccelerations(full);
+            solver->computeAccelerationsOf(subset, targets);
+        }
+
+        double difference = 0.0, untouched = 0.0;
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            if (i % 3 == 0)
+            {
+                difference = max(difference, fabs(full.ax[i] - subset.ax[i]) + fabs(full.ay[i] - subset.ay[i]) + fabs(full.az[i] - subset.az[i]));
+            }
+            else
+            {
+                untouched = max(untouched, fabs(subset.ax[i] + 1.0) + fabs(subset.ay[i] + 1.0) + fabs(subset.az[i] + 1.0));
+            }
+        }
+        assert_below(0.0, difference, string(solver->name()) + " solver on a third of the bodies matches the full evaluation");
+        assert_below(0.0, untouched, string(solver->name()) + " solver leaves the other bodies alone");
+    }
+}
+
+void test_fixed_size_engine()
+{
+    // the unrolled engine takes the same steps as the integrators on a solver, only the pair sums round differently
+    const string schemes[] = {"legacy", "kdk", "dkd", "yoshida4", "forestruth"};
+    const double step = orbital_period() / 2000.0;
+    double worst = 0.0, trajectoryMisses = 0.0;
+    for (const string &name : schemes)
+    {
+        BodyStore reference = make_eccentric_system(7), fixed = reference;
+        unique_ptr<SteppingIntegrator> integrator;
+        if (name == "legacy")
+        {
+            integrator = make_unique<LegacyIntegrator>(step);
+        }
+        else
+        {
+            integrator = makeSymplecticIntegrator(name, step);
+        }
+        run_stepping(*integrator, reference, 2000, 1);
+
+        vector<int> children;
+        vector<Vec3> trajectory;
+        vector<Body> bodies(fixed.size(), Body(Vec3(0, 0, 0), Vec3(0, 0, 0), Vec3(0, 0, 0), Vec3(0, 0, 0), 1.0, 1.0, 1.0, "planet", children, trajectory));
+        unique_ptr<FixedSizeEngine> engine = makeFixedSizeEngine(fixed.size(), name, step);
+        engine->start(fixed);
+        for (int s = 0; s < 2000; s++)
+        {
+            engine->advance(bodies);
+        }
+        engine->save(fixed);
+
+        for (size_t i = 0; i < fixed.size(); i++)
+        {
+            const double scale = norm(reference.x[i], reference.y[i], reference.z[i]);
+            worst = max(worst, norm(fixed.x[i] - reference.x[i], fixed.y[i] - reference.y[i], fixed.z[i] - reference.z[i]) / scale);
+            trajectoryMisses += fabs(bodies[i].trajectory.size() - 2000.0);
+        }
+        trajectoryMisses += fabs(double(engine->forceEvaluations()) - double(integrator->forceEvaluations()));
+    }
+    assert_below(1e-9, worst, "Fixed size engine follows legacy, kdk, dkd, yoshida4 and forestruth over a periapsis passage");
+    assert_below(0.0, trajectoryMisses, "Fixed size engine records every step and counts the same force evaluations");
+
+    const bool none = !makeFixedSizeEngine(FIXED_SIZE_MAX + 1, "kdk", step) && !makeFixedSizeEngine(1, "kdk", step) && !makeFixedSizeEngine(9, "hermite", step);
+    assert_below(0.0, none ? 0.0 : 1.0, "No fixed size engine outside the compiled sizes or for other integrators");
+}
+
+int main()
+{
+    test_block_energy();
+    test_block_levels();
+    test_block_threads_agree();
+    test_active_subsets();
+    test_symplectic_orders();
+    test_jerk_kernels();
+    test_hermite();
+    test_adaptive();
+    test_kepler_drift();
+    test_wisdom_holman();
+    test_regularized_drifts();
+    test_regularized();
+    test_fixed_size_engine();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
@@ -0,0 +1,334 @@
+// How to compile:
+// clang++ ../BodyStore.cpp ../WorkStealing.cpp ../DirectSolver.cpp ../SimdKernels.cpp ../Fft.cpp ../PmSolver.cpp ../P3mSolver.cpp MeshSolverUnitTest.cpp -o MeshSolverUnitTest -Wall -g -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <vector>
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../Fft.h"
+#include "../PmSolver.h"
+#include "../P3mSolver.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+// n bodies spread evenly through a ball of the given radius around center
+void fill_ball(BodyStore &store, size_t first, size_t n, double centerX, double radius, double mass)
+{
+    for (size_t i = first; i < first + n; i++)
+    {
+        double x, y, z;
+        do
+        {
+            x = 2.0 * random_unit() - 1.0;
+            y = 2.0 * random_unit() - 1.0;
+            z = 2.0 * random_unit() - 1.0;
+        } while (x * x + y * y + z * z > 1.0);
+        store.x[i] = centerX + radius * x;
+        store.y[i] = radius * y;
+        store.z[i] = radius * z;
+        store.mass[i] = mass;
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+}
+
+BodyStore make_ball(size_t n)
+{
+    srand(11);
+    BodyStore store;
+    store.resize(n);
+    fill_ball(store, 0, n, 0.0, 1.0e12, 1.0e24);
+    return store;
+}
+
+void test_fft_matches_dft()
+{
+    const size_t n = 32;
+    Fft fft(n);
+    vector<complex<double>> line(n), expected(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        line[i] = complex<double>(random_unit(), random_unit());
+    }
+    const vector<complex<double>> original = line;
+    for (size_t k = 0; k < n; k++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            expected[k] += line[i] * polar(1.0, -2.0 * M_PI * double(i * k) / n);
+        }
+    }
+    fft.transform(line.data(), false);
+
+    double error = 0.0;
+    for (size_t k = 0; k < n; k++)
+    {
+        error = max(error, abs(line[k] - expected[k]));
+    }
+    assert_below(1e-12, error, "FFT matches the direct discrete Fourier transform");
+
+    fft.transform(line.data(), true);
+    double roundTrip = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        roundTrip = max(roundTrip, abs(line[i] / double(n) - original[i]));
+    }
+    assert_below(1e-12, roundTrip, "FFT followed by the inverse FFT gives back the data");
+}
+
+void test_fft_round_trip_3d()
+{
+    const size_t n = 16;
+    Fft fft(n);
+    vector<complex<double>> cube(n * n * n), original;
+    for (size_t k = 0; k < n / 2; k++)
+        for (size_t j = 0; j < n / 2; j++)
+            for (size_t i = 0; i < n / 2; i++)
+                cube[(k * n + j) * n + i] = random_unit();
+    original = cube;
+
+    vector<complex<double>> full = cube;
+    fft.transform3d(cube.data(), false, n / 2);
+    fft.transform3d(full.data(), false, n);
+    double pruned = 0.0;
+    for (size_t k = 0; k < cube.size(); k++)
+    {
+        pruned = max(pruned, abs(cube[k] - full[k]));
+    }
+    assert_below(1e-12, pruned, "3D FFT skipping the zero lines matches the full transform");
+
+    #pragma omp parallel num_threads(3)
+    fft.transform3d(cube.data(), true, n / 2);
+    double error = 0.0;
+    for (size_t k = 0; k < n / 2; k++)
+        for (size_t j = 0; j < n / 2; j++)
+            for (size_t i = 0; i < n / 2; i++)
+            {
+                const size_t index = (k * n + j) * n + i;
+                error = max(error, abs(cube[index] / double(n * n * n) - original[index]));
+            }
+    assert_below(1e-12, error, "3D FFT round trip on 3 threads gives back the data");
+}
+
+void test_pm_two_clumps()
+{
+    // two balls far apart pull on each other like two point masses
+    srand(3);
+    BodyStore store;
+    store.resize(2000);
+    fill_ball(store, 0, 1000, -5.0e12, 3.0e11, 1.0e24);
+    fill_ball(store, 1000, 1000, 5.0e12, 3.0e11, 2.0e24);
+    for (MassAssignment assignment : {MassAssignment::CIC, MassAssignment::TSC})
+    {
+        PmSolver solver(64, assignment);
+        #pragma omp parallel num_threads(4)
+        solver.computeAccelerations(store);
+
+        double meanAx = 0.0;
+        for (size_t i = 0; i < 1000; i++)
+        {
+            meanAx += store.ax[i] / 1000;
+        }
+        double separation = 1.0e13, otherMass = 1000 * 2.0e24;
+        const double expected = GRAVITY_CONSTANT * otherMass / (separation * separation);
+        assert_below(1e-2, fabs(meanAx - expected) / expected, string("PM (") + solver.name() + ") pull between two distant clumps");
+    }
+}
+
+void test_pm_momentum()
+{
+    BodyStore store = make_ball(5000);
+    PmSolver solver(32, MassAssignment::TSC);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    double px = 0.0, py = 0.0, pz = 0.0, total = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        px += store.mass[i] * store.ax[i];
+        py += store.mass[i] * store.ay[i];
+        pz += store.mass[i] * store.az[i];
+        total += store.mass[i] * sqrt(store.ax[i] * store.ax[i] + store.ay[i] * store.ay[i] + store.az[i] * store.az[i]);
+    }
+    assert_below(1e-10, sqrt(px * px + py * py + pz * pz) / total, "PM forces sum to zero, momentum is conserved");
+}
+
+void test_pm_smooth_ball()
+{
+    // inside a uniform ball the pull points inward and grows linearly with the radius, G M r / R^3,
+    // the mesh smooths away the bodies' graininess, which the direct sum would add on top
+    const size_t n = 20000;
+    const double radius = 1.0e12, mass = 1.0e24;
+    BodyStore store = make_ball(n);
+    PmSolver solver(64, MassAssignment::TSC);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const double r = sqrt(store.x[i] * store.x[i] + store.y[i] * store.y[i] + store.z[i] * store.z[i]);
+        if (r < 0.3 * radius || r > 0.9 * radius)
+        {
+            continue; // a couple of cells from the centre and the rim the smoothing dominates
+        }
+        const double expected = GRAVITY_CONSTANT * n * mass * r / (radius * radius * radius);
+        const double inward = -(store.ax[i] * store.x[i] + store.ay[i] * store.y[i] + store.az[i] * store.z[i]) / r;
+        sum += (inward - expected) * (inward - expected) / (expected * expected);
+        count++;
+    }
+    assert_below(5e-2, sqrt(sum / count), "PM on a 64^3 mesh gives the smooth pull inside a uniform ball");
+}
+
+void test_pm_serial_matches_parallel()
+{
+    BodyStore serial = make_ball(5000), parallel = serial;
+    PmSolver serialSolver(32, MassAssignment::CIC), parallelSolver(32, MassAssignment::CIC);
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(3)
+    parallelSolver.computeAccelerations(parallel);
+
+    double difference = 0.0, largest = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference = max(difference, fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]));
+        largest = max(largest, fabs(serial.ax[i]) + fabs(serial.ay[i]) + fabs(serial.az[i]));
+    }
+    assert_below(1e-12, difference / largest, "PM run by 3 threads matches the serial run");
+}
+
+void test_pm_deterministic()
+{
+    // the deposit by planes adds every mesh point's masses in one order, whatever the thread count
+    BodyStore serial = make_ball(5000), parallel = serial, atomic = serial;
+    PmSolver serialSolver(32, MassAssignment::TSC, 0.0, true), parallelSolver(32, MassAssignment::TSC, 0.0, true), atomicSolver(32, MassAssignment::TSC);
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(5)
+    parallelSolver.computeAccelerations(parallel);
+    #pragma omp parallel num_threads(5)
+    atomicSolver.computeAccelerations(atomic);
+
+    double difference = 0.0, change = 0.0, largest = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference += fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]);
+        change = max(change, fabs(serial.ax[i] - atomic.ax[i]) + fabs(serial.ay[i] - atomic.ay[i]) + fabs(serial.az[i] - atomic.az[i]));
+        largest = max(largest, fabs(serial.ax[i]) + fabs(serial.ay[i]) + fabs(serial.az[i]));
+    }
+    assert_below(0.0, difference, "Deterministic PM gives the same bits on 1 and 5 threads");
+    assert_below(1e-12, change / largest, "Deterministic PM matches the atomic deposit");
+}
+
+// root mean square of the per body relative error of the store against the direct sum
+double rms_relative_error(const BodyStore &store)
+{
+    BodyStore reference = store;
+    DirectSolver direct;
+    #pragma omp parallel num_threads(4)
+    direct.computeAccelerations(reference);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const double ex = store.ax[i] - reference.ax[i], ey = store.ay[i] - reference.ay[i], ez = store.az[i] - reference.az[i];
+        const double magnitude2 = reference.ax[i] * reference.ax[i] + reference.ay[i] * reference.ay[i] + reference.az[i] * reference.az[i];
+        sum += (ex * ex + ey * ey + ez * ez) / magnitude2;
+    }
+    return sqrt(sum / store.size());
+}
+
+void test_p3m_matches_direct()
+{
+    // a ball with tight pairs in it, moons closer to their planet than a mesh cell, which a plain mesh gets badly wrong
+    const size_t n = 20000;
+    BodyStore store = make_ball(n);
+    for (size_t i = 0; i < n; i += 10)
+    {
+        store.x[i + 1] = store.x[i] + 4.0e8;
+        store.y[i + 1] = store.y[i];
+        store.z[i + 1] = store.z[i];
+        store.mass[i + 1] = 1.0e22;
+    }
+
+    BodyStore mesh = store, wide = store;
+    PmSolver pm(64, MassAssignment::TSC);
+    P3mSolver p3m(64, MassAssignment::TSC), wideSplit(64, MassAssignment::TSC, 2.0);
+    #pragma omp parallel num_threads(4)
+    {
+        pm.computeAccelerations(mesh);
+        p3m.computeAccelerations(store);
+        wideSplit.computeAccelerations(wide);
+    }
+
+    const double meshError = rms_relative_error(mesh), p3mError = rms_relative_error(store), wideError = rms_relative_error(wide);
+    assert_below(1e-2, p3mError, "P3M follows the direct sum, close pairs included");
+    assert_below(0.1 * meshError, p3mError, "P3M is far closer to the direct sum than the mesh alone");
+    assert_below(0.6 * p3mError, wideError, "P3M with a wider split leaves less to the mesh and gets closer still");
+}
+
+void test_p3m_kernels_agree()
+{
+    BodyStore scalar = make_ball(5000);
+    P3mSolver reference(32, MassAssignment::TSC, 1.25, 5.0, SimdLevel::Scalar);
+    reference.computeAccelerations(scalar);
+
+    for (SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512})
+    {
+        if (detectSimdLevel() < level)
+        {
+            continue;
+        }
+        BodyStore store = make_ball(5000);
+        P3mSolver solver(32, MassAssignment::TSC, 1.25, 5.0, level);
+        solver.computeAccelerations(store);
+
+        double difference = 0.0, largest = 0.0;
+        for (size_t i = 0; i < store.size(); i++)
+        {
+            difference = max(difference, fabs(store.ax[i] - scalar.ax[i]) + fabs(store.ay[i] - scalar.ay[i]) + fabs(store.az[i] - scalar.az[i]));
+            largest = max(largest, fabs(scalar.ax[i]) + fabs(scalar.ay[i]) + fabs(scalar.az[i]));
+        }
+        assert_below(1e-12, difference / largest, string("P3M short range kernel (") + simdLevelName(level) + ") matches the scalar kernel");
+    }
+}
+
+int main()
+{
+    test_fft_matches_dft();
+    test_fft_round_trip_3d();
+    test_pm_two_clumps();
+    test_pm_momentum();
+    test_pm_smooth_ball();
+    test_pm_serial_matches_parallel();
+    test_pm_deterministic();
+    test_p3m_matches_direct();
+    test_p3m_kernels_agree();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
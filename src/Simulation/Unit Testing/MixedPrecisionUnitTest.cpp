@@ -0,0 +1,195 @@
+// How to compile:
+// clang++ ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../Numa.cpp ../SimdKernels.cpp ../SimdSolver.cpp ../MixedSolver.cpp MixedPrecisionUnitTest.cpp -o MixedPrecisionUnitTest -Wall -O3 -std=c++23 -fopenmp
+//
+// validation harness for the mixed precision solver, reports the error of the float pair terms against the
+// double precision Body::gravForce for a few kinds of system, and the speed against the double simd solver
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../vec3.h"
+#include "../body.h"
+#include "../BodyStore.h"
+#include "../SimdSolver.h"
+#include "../MixedSolver.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+Body make_body(const Vec3 &position, double mass)
+{
+    vector<Vec3> trajectory;
+    return Body(position, Vec3(0, 0, 0), Vec3(0, 0, 0), Vec3(0, 0, 0), mass, 1.0, 1.0, "planet", vector<int>{}, trajectory);
+}
+
+// a cluster a light year across, with a coincident pair and a pair closer than the softening length
+vector<Body> make_cluster(int n)
+{
+    srand(42);
+    vector<Body> bodies;
+    for (int i = 0; i < n; i++)
+    {
+        Vec3 position(random_unit() - 0.5, random_unit() - 0.5, random_unit() - 0.5);
+        bodies.push_back(make_body(position * 9.46e15, 1.0e30 * (0.1 + random_unit())));
+    }
+    bodies[1].position = bodies[0].position;
+    bodies[3].position = bodies[2].position + Vec3(1e-6, 0, 0);
+    return bodies;
+}
+
+// a star, planets out to 40 AU and a moon 4e8 m from every planet
+vector<Body> make_planetary_system(int planets)
+{
+    srand(7);
+    vector<Body> bodies;
+    bodies.push_back(make_body(Vec3(0, 0, 0), 2.0e30));
+    for (int p = 0; p < planets; p++)
+    {
+        const double radius = 5.0e10 + 6.0e12 * random_unit(), angle = 2.0 * M_PI * random_unit();
+        const Vec3 planet(radius * cos(angle), radius * sin(angle), 1.0e9 * (random_unit() - 0.5));
+        bodies.push_back(make_body(planet, 1.0e24 * (1.0 + 100.0 * random_unit())));
+        bodies.push_back(make_body(planet + Vec3(4.0e8, 0, 0), 7.0e22));
+    }
+    return bodies;
+}
+
+// bodies from asteroids to stars in a 1e13 m box
+vector<Body> make_mass_spread(int n)
+{
+    srand(5);
+    vector<Body> bodies;
+    for (int i = 0; i < n; i++)
+    {
+        Vec3 position(random_unit() - 0.5, random_unit() - 0.5, random_unit() - 0.5);
+        bodies.push_back(make_body(position * 1.0e13, pow(10.0, 15.0 + 15.0 * random_unit())));
+    }
+    return bodies;
+}
+
+// per body relative error of the store against the serial Body::gravForce sum, largest and root mean square
+void error_against_reference(vector<Body> &bodies, const BodyStore &store, double &largest, double &rms)
+{
+    largest = 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        Vec3 expected(0, 0, 0);
+        for (size_t j = 0; j < bodies.size(); j++)
+        {
+            if (i != j && (bodies[j].position - bodies[i].position).magnitude() > 0.0)
+            {
+                expected += bodies[i].gravForce(bodies[j]) / bodies[i].mass;
+            }
+        }
+        if (expected.magnitude() == 0.0)
+        {
+            continue;
+        }
+        const double error = (expected - Vec3(store.ax[i], store.ay[i], store.az[i])).magnitude() / expected.magnitude();
+        largest = max(largest, error);
+        sum += error * error;
+    }
+    rms = sqrt(sum / bodies.size());
+}
+
+void validate(const string &system, vector<Body> bodies, double largestBound, double rmsBound)
+{
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        if (level > detectSimdLevel())
+        {
+            cout << "skipped | " << simdLevelName(level) << " is not supported by this cpu" << endl;
+            continue;
+        }
+        BodyStore store(bodies);
+        MixedSolver solver(level);
+        #pragma omp parallel num_threads(4)
+        solver.computeAccelerations(store);
+
+        double largest, rms;
+        error_against_reference(bodies, store, largest, rms);
+        const string name = string("mixed (") + simdLevelName(level) + ") on " + system;
+        assert_below(largestBound, largest, name + ", largest error against Body::gravForce");
+        assert_below(rmsBound, rms, name + ", rms error against Body::gravForce");
+    }
+}
+
+void test_serial_matches_parallel()
+{
+    vector<Body> bodies = make_cluster(3001);
+    BodyStore serial(bodies), parallel(bodies);
+    MixedSolver serialSolver, parallelSolver;
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(3)
+    parallelSolver.computeAccelerations(parallel);
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference = max(difference, fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]));
+    }
+    assert_below(0.0, difference, "Mixed solver run by 3 threads matches the serial run");
+}
+
+// best of a few runs, in milliseconds
+double time_solver(ForceSolver &solver, BodyStore &store)
+{
+    double best = 1e300;
+    for (int run = 0; run < 3; run++)
+    {
+        const auto start = chrono::steady_clock::now();
+        #pragma omp parallel
+        solver.computeAccelerations(store);
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void report_throughput()
+{
+    vector<Body> bodies = make_cluster(20000);
+    BodyStore store(bodies);
+    SimdSolver simd;
+    MixedSolver mixed;
+    const double simdTime = time_solver(simd, store), mixedTime = time_solver(mixed, store);
+    cout << "\n20000 bodies: simd (" << simdLevelName(detectSimdLevel()) << ", double) " << simdTime << " ms, mixed "
+         << mixedTime << " ms, " << simdTime / mixedTime << "x" << endl;
+}
+
+int main()
+{
+    // a pair term is good to a few parts in 10^7, the largest per body errors are bodies whose pulls nearly cancel
+    validate("a star cluster", make_cluster(2003), 5e-5, 2e-6);
+    validate("a planetary system with moons", make_planetary_system(300), 5e-5, 2e-6);
+    validate("masses from 1e15 to 1e30 kg", make_mass_spread(2003), 5e-5, 2e-6);
+    test_serial_matches_parallel();
+    report_throughput();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
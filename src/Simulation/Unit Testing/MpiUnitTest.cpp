@@ -0,0 +1,185 @@
+// How to compile:
+// mpicxx -DUSE_MPI ../vector.cpp ../body.cpp ../BodyStore.cpp ../WorkStealing.cpp ../SimdKernels.cpp ../MpiRingSolver.cpp MpiUnitTest.cpp -o MpiUnitTest -Wall -g -std=c++23 -fopenmp
+// How to run, any number of ranks, 4 on one machine:
+// mpirun -np 4 ./MpiUnitTest
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <mpi.h>
+#include "../vec3.h"
+#include "../body.h"
+#include "../BodyStore.h"
+#include "../MpiRingSolver.h"
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+int myRank = 0, rankCount = 1;
+
+// every rank must pass for a test to pass, rank 0 reports
+void assert_below(double bound, double actual, const std::string &message)
+{
+    double worst = actual;
+    MPI_Allreduce(&actual, &worst, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    total_tests++;
+    if (worst <= bound)
+    {
+        passed_tests++;
+        if (myRank == 0)
+        {
+            cout << ":) | " << message << endl;
+        }
+    }
+    else if (myRank == 0)
+    {
+        cout << "Fuck you | " << message << " (got " << worst << ", allowed " << bound << ")" << endl;
+    }
+}
+
+// the same random cluster on every rank, with a coincident pair
+vector<Body> make_bodies(int n)
+{
+    srand(42);
+    vector<Body> bodies;
+    vector<Vec3> trajectory;
+    for (int i = 0; i < n; i++)
+    {
+        Vec3 position(rand() % 2000 - 1000.0, rand() % 2000 - 1000.0, rand() % 2000 - 1000.0);
+        double mass = 1.0e10 + rand() % 1000 * 1.0e9;
+        bodies.emplace_back(position, Vec3(0, 0, 0), Vec3(0, 0, 0), Vec3(0, 0, 0), mass, 1.0, 1.0 + (i % 3), "planet", vector<int>{}, trajectory);
+    }
+    bodies[1].position = bodies[0].position;
+    return bodies;
+}
+
+// this rank's block of the bodies, as Simulation keeps it
+BodyStore own_block(const vector<Body> &bodies)
+{
+    BodyStore store(bodies);
+    vector<bool> removed(bodies.size(), true);
+    fill(removed.begin() + rankBlockBegin(bodies.size(), myRank, rankCount), removed.begin() + rankBlockBegin(bodies.size(), myRank + 1, rankCount), false);
+    store.compact(removed);
+    return store;
+}
+
+// largest component error of this rank's block against the serial Body::gravForce reference, relative to the largest acceleration
+double max_error_against_reference(vector<Body> &bodies, const BodyStore &store, const vector<uint32_t> &targets)
+{
+    double maxAccel = 0.0, maxError = 0.0;
+    for (uint32_t k : targets)
+    {
+        Body &body = bodies[store.id[k]];
+        Vec3 expected(0, 0, 0);
+        for (const Body &source : bodies)
+        {
+            if ((source.position - body.position).magnitude() > 0.0)
+            {
+                expected += body.gravForce(source) / body.mass;
+            }
+        }
+        Vec3 actual(store.ax[k], store.ay[k], store.az[k]);
+        maxAccel = max(maxAccel, expected.magnitude());
+        maxError = max(maxError, (expected - actual).magnitude());
+    }
+    return maxAccel > 0.0 ? maxError / maxAccel : 0.0;
+}
+
+vector<uint32_t> every_slot(const BodyStore &store)
+{
+    vector<uint32_t> slots(store.size());
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        slots[i] = static_cast<uint32_t>(i);
+    }
+    return slots;
+}
+
+void test_ring_solver()
+{
+    // not a multiple of the rank count, so the blocks differ in size
+    vector<Body> bodies = make_bodies(203);
+    BodyStore serial = own_block(bodies), threaded = own_block(bodies);
+    MpiRingSolver solver(MPI_COMM_WORLD, bodies.size());
+    solver.computeAccelerations(serial); // outside a parallel region
+    #pragma omp parallel num_threads(3)
+    solver.computeAccelerations(threaded);
+    assert_below(1e-12, max_error_against_reference(bodies, serial, every_slot(serial)), "Ring solver matches Body::gravForce on every rank");
+    assert_below(1e-12, max_error_against_reference(bodies, threaded, every_slot(threaded)), "Ring solver on 3 threads a rank matches Body::gravForce");
+
+    // every other body of the block, the rest left as they were
+    BodyStore some = own_block(bodies);
+    vector<uint32_t> targets;
+    for (uint32_t i = 0; i < some.size(); i += 2)
+    {
+        targets.push_back(i);
+    }
+    #pragma omp parallel num_threads(2)
+    solver.computeAccelerationsOf(some, targets);
+    double untouched = 0.0;
+    for (uint32_t i = 1; i < some.size(); i += 2)
+    {
+        untouched += fabs(some.ax[i]) + fabs(some.ay[i]) + fabs(some.az[i]);
+    }
+    assert_below(1e-12, max_error_against_reference(bodies, some, targets), "Ring solver fills the listed targets");
+    assert_below(0.0, untouched, "Ring solver leaves the other targets alone");
+}
+
+void test_fewer_bodies_than_ranks()
+{
+    // the ranks past the bodies own empty blocks and only pass the others on
+    vector<Body> bodies = make_bodies(3);
+    BodyStore store = own_block(bodies);
+    MpiRingSolver solver(MPI_COMM_WORLD, bodies.size());
+    #pragma omp parallel num_threads(2)
+    solver.computeAccelerations(store);
+    assert_below(1e-12, max_error_against_reference(bodies, store, every_slot(store)), "Ring solver runs 3 bodies on any number of ranks");
+}
+
+void test_gather_trajectories()
+{
+    vector<Body> bodies = make_bodies(11);
+    for (size_t i = rankBlockBegin(bodies.size(), myRank, rankCount); i < rankBlockBegin(bodies.size(), myRank + 1, rankCount); i++)
+    {
+        for (int step = 0; step < 5; step++)
+        {
+            bodies[i].trajectory.push_back(Vec3(i, step, -1.0 * i));
+        }
+    }
+    gatherTrajectories(bodies, MPI_COMM_WORLD);
+    double misses = 0.0;
+    if (myRank == 0)
+    {
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            misses += fabs(bodies[i].trajectory.size() - 5.0);
+            for (size_t step = 0; step < bodies[i].trajectory.size(); step++)
+            {
+                const Vec3 &point = bodies[i].trajectory[step];
+                misses += fabs(point.x - i) + fabs(point.y - step) + fabs(point.z + i);
+            }
+        }
+    }
+    assert_below(0.0, misses, "Rank 0 holds every rank's trajectories");
+}
+
+int main(int argc, char *argv[])
+{
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &rankCount);
+
+    test_ring_solver();
+    test_fewer_bodies_than_ranks();
+    test_gather_trajectories();
+
+    if (myRank == 0)
+    {
+        std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed on " << rankCount << " ranks.\n";
+    }
+    MPI_Finalize();
+    return (total_tests == passed_tests) ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+// How to compile:
+// clang++ ../BodyStore.cpp ../WorkStealing.cpp ../DirectSolver.cpp ../SimdKernels.cpp ../Octree.cpp ../BarnesHutSolver.cpp ../FmmSolver.cpp TreeSolverUnitTest.cpp -o TreeSolverUnitTest -Wall -g -std=c++23 -fopenmp
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "../BodyStore.h"
+#include "../DirectSolver.h"
+#include "../Octree.h"
+#include "../BarnesHutSolver.h"
+#include "../FmmSolver.h"
+
+using namespace std;
+
+int passed_tests = 0;
+int total_tests = 0;
+
+void assert_true(bool condition, const std::string &message)
+{
+    total_tests++;
+    if (condition)
+    {
+        passed_tests++;
+        cout << ":) | " << message << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << endl;
+    }
+}
+
+void assert_below(double bound, double actual, const std::string &message)
+{
+    total_tests++;
+    if (actual <= bound)
+    {
+        passed_tests++;
+        cout << ":) | " << message << " (" << actual << ")" << endl;
+    }
+    else
+    {
+        cout << "Fuck you | " << message << " (got " << actual << ", allowed " << bound << ")" << endl;
+    }
+}
+
+double random_unit()
+{
+    return rand() / (double)RAND_MAX;
+}
+
+// a wide halo, a dense clump off to one side and a few coincident bodies, so the tree gets deep, lopsided cells
+BodyStore make_cluster(size_t n)
+{
+    srand(7);
+    BodyStore store;
+    store.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        const double spread = i % 4 == 0 ? 1.0e9 : 1.0e12;
+        const double offset = i % 4 == 0 ? 3.0e11 : 0.0;
+        store.x[i] = offset + spread * (2.0 * random_unit() - 1.0);
+        store.y[i] = spread * (2.0 * random_unit() - 1.0);
+        store.z[i] = 0.1 * spread * (2.0 * random_unit() - 1.0);
+        store.mass[i] = 1.0e24 * (0.5 + random_unit());
+        store.gravitationalMultiplier[i] = 1.0;
+    }
+    for (size_t i = 1; i < 40; i++)
+    {
+        store.x[i] = store.x[0];
+        store.y[i] = store.y[0];
+        store.z[i] = store.z[0];
+    }
+    return store;
+}
+
+// root mean square of the per body relative error of the store against the direct sum
+double rms_relative_error(const BodyStore &store)
+{
+    BodyStore reference = store;
+    DirectSolver direct;
+    #pragma omp parallel num_threads(4)
+    direct.computeAccelerations(reference);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        const double ex = store.ax[i] - reference.ax[i], ey = store.ay[i] - reference.ay[i], ez = store.az[i] - reference.az[i];
+        const double magnitude2 = reference.ax[i] * reference.ax[i] + reference.ay[i] * reference.ay[i] + reference.az[i] * reference.az[i];
+        sum += (ex * ex + ey * ey + ez * ez) / magnitude2;
+    }
+    return sqrt(sum / store.size());
+}
+
+void test_octree_structure()
+{
+    BodyStore store = make_cluster(20000);
+    Octree tree(8);
+    #pragma omp parallel num_threads(4)
+    tree.build(store);
+
+    vector<int> seen(store.size(), 0);
+    bool rangesNest = true;
+    double leafMass = 0.0;
+    for (size_t n = 0; n < tree.nodeCount(); n++)
+    {
+        const OctreeNode &node = tree.nodes[n];
+        if (node.firstChild < 0)
+        {
+            for (uint32_t k = node.begin; k < node.end; k++)
+            {
+                seen[tree.order[k]]++;
+                leafMass += tree.mass[k];
+            }
+            continue;
+        }
+        uint32_t next = node.begin;
+        for (int c = 0; c < node.childCount; c++)
+        {
+            const OctreeNode &child = tree.nodes[node.firstChild + c];
+            rangesNest = rangesNest && child.begin == next && child.size < node.size;
+            next = child.end;
+        }
+        rangesNest = rangesNest && next == node.end && node.childCount >= 2;
+    }
+    bool everyBodyOnce = true;
+    for (int count : seen)
+    {
+        everyBodyOnce = everyBodyOnce && count == 1;
+    }
+    double totalMass = 0.0;
+    for (double m : store.mass)
+    {
+        totalMass += m;
+    }
+
+    assert_true(everyBodyOnce, "Octree places every body in exactly one leaf");
+    assert_true(rangesNest, "Octree children split their parent's range and have at least two siblings");
+    assert_true(tree.nodeCount() < 2 * store.size(), "Octree holds fewer than 2N nodes");
+    assert_below(1e-12, fabs(tree.nodes[0].mass - totalMass) / totalMass, "Octree root holds the total mass");
+    assert_below(1e-12, fabs(leafMass - totalMass) / totalMass, "Octree leaves hold the total mass");
+}
+
+void test_octree_serial_matches_parallel()
+{
+    BodyStore store = make_cluster(15000);
+    Octree serial(16), parallel(16);
+    serial.build(store);
+    #pragma omp parallel num_threads(3)
+    parallel.build(store);
+
+    bool sameOrder = serial.order == parallel.order;
+    assert_true(sameOrder && serial.nodeCount() == parallel.nodeCount(), "Octree built by 3 threads matches the serial build");
+}
+
+void test_barnes_hut_theta_zero()
+{
+    BodyStore store = make_cluster(3000);
+    BarnesHutSolver solver(0.0);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(1e-12, rms_relative_error(store), "Barnes-Hut with theta 0 reproduces the direct sum");
+}
+
+void test_barnes_hut_accuracy()
+{
+    BodyStore store = make_cluster(20000);
+    BarnesHutSolver solver(0.5);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(5e-3, rms_relative_error(store), "Barnes-Hut with theta 0.5 stays within 0.5% of the direct sum");
+}
+
+void test_fmm_order_convergence()
+{
+    BodyStore store = make_cluster(8000);
+    double previous = 1.0;
+    bool decreasing = true;
+    for (int order : {2, 4, 6, 8})
+    {
+        FmmSolver solver(order, 0.5);
+        #pragma omp parallel num_threads(4)
+        solver.computeAccelerations(store);
+        const double error = rms_relative_error(store);
+        decreasing = decreasing && error < previous;
+        previous = error;
+    }
+    assert_true(decreasing, "FMM error falls as the expansion order rises");
+    assert_below(5e-4, previous, "FMM of order 8 with theta 0.5 stays within 0.05% of the direct sum");
+}
+
+void test_fmm_accuracy()
+{
+    BodyStore store = make_cluster(20000);
+    FmmSolver solver(4, 0.5);
+    #pragma omp parallel num_threads(4)
+    solver.computeAccelerations(store);
+
+    assert_below(5e-3, rms_relative_error(store), "FMM of order 4 with theta 0.5 stays within 0.5% of the direct sum");
+}
+
+void test_fmm_serial_matches_parallel()
+{
+    BodyStore serial = make_cluster(15000), parallel = serial;
+    FmmSolver serialSolver(4, 0.5), parallelSolver(4, 0.5);
+    serialSolver.computeAccelerations(serial);
+    #pragma omp parallel num_threads(3)
+    parallelSolver.computeAccelerations(parallel);
+
+    double difference = 0.0;
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        difference = max(difference, fabs(serial.ax[i] - parallel.ax[i]) + fabs(serial.ay[i] - parallel.ay[i]) + fabs(serial.az[i] - parallel.az[i]));
+    }
+    assert_below(0.0, difference, "FMM run by 3 threads matches the serial run exactly");
+}
+
+int main()
+{
+    test_octree_structure();
+    test_octree_serial_matches_parallel();
+    test_barnes_hut_theta_zero();
+    test_barnes_hut_accuracy();
+    test_fmm_order_convergence();
+    test_fmm_accuracy();
+    test_fmm_serial_matches_parallel();
+
+    std::cout << "\nSummary: " << passed_tests << "/" << total_tests << " tests passed.\n";
+    return (total_tests == passed_tests) ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+ * This file contains the implementation of the WisdomHolmanIntegrator class, the hierarchical Kepler drift integrator
+ *
+ * with X_i the centre of mass of body i's family and M_i its mass, the children c1 ... cm of a body p give
+ *      C_0 = x_p,  r_j = X_cj - C_(j-1),  C_j = C_(j-1) + share_j r_j,  share_j = M_cj / (m_p + M_c1 + ... + M_cj)
+ * and C_m = X_p, so the coordinates are built from the leaves up and the bodies put back from the roots down,
+ * each generation of the hierarchy in parallel, the children of one body in turn
+ *
+ * the drift acceleration of the bodies is the same map applied to -mu r / |r|^3 on every orbit and nothing on the roots,
+ * the kick takes the solver's acceleration less that, for a lone star and planet both get the acceleration of
+ * their centre of mass and their relative orbit is left to the drift alone
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "Kepler.h"
+#include "WisdomHolmanIntegrator.h"
+using namespace std;
+
+WisdomHolmanIntegrator::WisdomHolmanIntegrator(double timestep, const vector<int> &parent) : SteppingIntegrator(timestep), parent(parent)
+{
+    const size_t n = parent.size();
+    vector<size_t> depth(n, 0);
+    vector<uint32_t> childCount(n + 1, 0);
+    generations.resize(1);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (parent[i] < -1 || parent[i] >= static_cast<int>(n) || parent[i] == static_cast<int>(i))
+        {
+            throw invalid_argument("Body " + to_string(i) + " has no valid parent " + to_string(parent[i]));
+        }
+        for (int ancestor = parent[i]; ancestor != -1; ancestor = parent[ancestor])
+        {
+            if (++depth[i] > n)
+            {
+                throw invalid_argument("The children lists form a cycle through body " + to_string(i));
+            }
+        }
+        if (generations.size() <= depth[i])
+        {
+            generations.resize(depth[i] + 1);
+        }
+        generations[depth[i]].push_back(static_cast<uint32_t>(i));
+        if (parent[i] != -1)
+        {
+            childCount[parent[i]]++;
+        }
+    }
+
+    firstChild.assign(n + 1, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        firstChild[i + 1] = firstChild[i] + childCount[i];
+    }
+    orbiting.resize(firstChild[n]);
+    vector<uint32_t> next(firstChild.begin(), firstChild.end() - 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (parent[i] != -1)
+        {
+            orbiting[next[parent[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+/**
+ * @brief the masses and Kepler parameters of every orbit, and the accelerations the first kick needs
+ * @param store the bodies, the same ones the hierarchy was built from
+ * @param solver the force solver of the run
+ */
+void WisdomHolmanIntegrator::start(BodyStore &store, ForceSolver &solver)
+{
+    const size_t n = store.size(), orbits = orbiting.size();
+    #pragma omp single
+    {
+        for (vector<double> *perBody : {&fx, &fy, &fz, &fvx, &fvy, &fvz, &keplerX, &keplerY, &keplerZ})
+        {
+            perBody->assign(n, 0.0);
+        }
+        for (vector<double> *perOrbit : {&share, &mu, &rx, &ry, &rz, &rvx, &rvy, &rvz})
+        {
+            perOrbit->assign(orbits, 0.0);
+        }
+
+        bodyMass = store.mass;
+        familyMass = store.mass;
+        for (size_t g = generations.size(); g-- > 1;)
+        {
+            for (uint32_t i : generations[g])
+            {
+                familyMass[parent[i]] += familyMass[i];
+            }
+        }
+        for (size_t p = 0; p < n; p++)
+        {
+            double centreMass = store.mass[p];
+            for (size_t k = firstChild[p]; k < firstChild[p + 1]; k++)
+            {
+                const size_t c = orbiting[k];
+                const double total = centreMass + familyMass[c];
+                share[k] = total > 0.0 ? familyMass[c] / total : 0.0;
+                mu[k] = GRAVITY_CONSTANT * store.gravitationalMultiplier[c] * total;
+                centreMass = total;
+            }
+        }
+        evaluations += n;
+    }
+
+    solver.computeAccelerations(store);
+    keplerAccelerations(store);
+}
+
+/**
+ * @brief one kick-drift-kick step, the drift along the Kepler orbits of the hierarchy
+ * @param store the bodies
+ * @param solver computes the accelerations after the drift
+ * @param dt the length of the step
+ */
+void WisdomHolmanIntegrator::step(BodyStore &store, ForceSolver &solver, double dt)
+{
+    kick(store, 0.5 * dt);
+    drift(store, dt);
+    solver.computeAccelerations(store);
+    keplerAccelerations(store);
+    kick(store, 0.5 * dt);
+
+    #pragma omp single nowait
+    evaluations += store.size();
+}
+
+/**
+ * @brief the Jacobi coordinates of some components of the bodies, the families' centres of mass from the leaves up,
+ * then the orbits of every body's children in turn
+ */
+void WisdomHolmanIntegrator::toJacobi(const vector<double> *body[], vector<double> *family[], vector<double> *relative[], size_t components)
+{
+    for (size_t g = generations.size(); g-- > 0;)
+    {
+        const vector<uint32_t> &generation = generations[g];
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < generation.size(); b++)
+        {
+            const size_t i = generation[b];
+            for (size_t d = 0; d < components; d++)
+            {
+                double weighted = bodyMass[i] * (*body[d])[i];
+                for (size_t k = firstChild[i]; k < firstChild[i + 1]; k++)
+                {
+                    weighted += familyMass[orbiting[k]] * (*family[d])[orbiting[k]];
+                }
+                (*family[d])[i] = familyMass[i] > 0.0 ? weighted / familyMass[i] : (*body[d])[i];
+            }
+        }
+    }
+
+    #pragma omp for schedule(static)
+    for (size_t p = 0; p < parent.size(); p++)
+    {
+        for (size_t d = 0; d < components; d++)
+        {
+            double centre = (*body[d])[p];
+            for (size_t k = firstChild[p]; k < firstChild[p + 1]; k++)
+            {
+                (*relative[d])[k] = (*family[d])[orbiting[k]] - centre;
+                centre += share[k] * (*relative[d])[k];
+            }
+        }
+    }
+}
+
+/**
+ * @brief the bodies back from Jacobi coordinates, from the roots' family values down, every body's children in reverse
+ *
+ * family and body may be the same arrays, a body's family value is read before its own value is written
+ */
+void WisdomHolmanIntegrator::fromJacobi(vector<double> *family[], const vector<double> *relative[], vector<double> *body[], size_t components)
+{
+    for (size_t g = 0; g < generations.size(); g++)
+    {
+        const vector<uint32_t> &generation = generations[g];
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < generation.size(); b++)
+        {
+            const size_t i = generation[b];
+            for (size_t d = 0; d < components; d++)
+            {
+                double centre = (*family[d])[i];
+                for (size_t k = firstChild[i + 1]; k-- > firstChild[i];)
+                {
+                    centre -= share[k] * (*relative[d])[k];
+                    (*family[d])[orbiting[k]] = centre + (*relative[d])[k];
+                }
+                (*body[d])[i] = centre;
+            }
+        }
+    }
+}
+
+/**
+ * @brief every body's acceleration in the drift, the Kepler pull on every orbit taken back to the bodies
+ */
+void WisdomHolmanIntegrator::keplerAccelerations(const BodyStore &store)
+{
+    const vector<double> *positions[3] = {&store.x, &store.y, &store.z};
+    vector<double> *families[3] = {&fx, &fy, &fz}, *orbits[3] = {&rx, &ry, &rz};
+    toJacobi(positions, families, orbits, 3);
+
+    // the orbits' velocities are not needed until the next drift, their arrays hold the orbits' accelerations meanwhile
+    #pragma omp for schedule(static)
+    for (size_t k = 0; k < orbiting.size(); k++)
+    {
+        const double r2 = rx[k] * rx[k] + ry[k] * ry[k] + rz[k] * rz[k];
+        const double pull = r2 > 0.0 ? mu[k] / (r2 * sqrt(r2)) : 0.0;
+        rvx[k] = -pull * rx[k];
+        rvy[k] = -pull * ry[k];
+        rvz[k] = -pull * rz[k];
+    }
+
+    const vector<uint32_t> &roots = generations[0];
+    #pragma omp for schedule(static)
+    for (size_t r = 0; r < roots.size(); r++)
+    {
+        keplerX[roots[r]] = keplerY[roots[r]] = keplerZ[roots[r]] = 0.0;
+    }
+
+    vector<double> *accelerations[3] = {&keplerX, &keplerY, &keplerZ};
+    const vector<double> *pulls[3] = {&rvx, &rvy, &rvz};
+    fromJacobi(accelerations, pulls, accelerations, 3);
+}
+
+/**
+ * @brief the interaction kick, every body by its acceleration less its acceleration in the drift
+ */
+void WisdomHolmanIntegrator::kick(BodyStore &store, double time)
+{
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < store.size(); i++)
+    {
+        store.vx[i] += (store.ax[i] - keplerX[i]) * time;
+        store.vy[i] += (store.ay[i] - keplerY[i]) * time;
+        store.vz[i] += (store.az[i] - keplerZ[i]) * time;
+    }
+}
+
+/**
+ * @brief the Kepler drift, every orbit moved along its Kepler orbit and every root family in a straight line
+ */
+void WisdomHolmanIntegrator::drift(BodyStore &store, double time)
+{
+    const vector<double> *state[6] = {&store.x, &store.y, &store.z, &store.vx, &store.vy, &store.vz};
+    vector<double> *families[6] = {&fx, &fy, &fz, &fvx, &fvy, &fvz}, *orbits[6] = {&rx, &ry, &rz, &rvx, &rvy, &rvz};
+    toJacobi(state, families, orbits, 6);
+
+    const size_t count = orbiting.size(), blocks = (count + KEPLER_LANES - 1) / KEPLER_LANES;
+    #pragma omp for schedule(dynamic, 4)
+    for (size_t b = 0; b < blocks; b++)
+    {
+        const size_t first = b * KEPLER_LANES;
+        keplerDrift(&rx[first], &ry[first], &rz[first], &rvx[first], &rvy[first], &rvz[first], &mu[first], min(KEPLER_LANES, count - first), time);
+    }
+
+    const vector<uint32_t> &roots = generations[0];
+    #pragma omp for schedule(static)
+    for (size_t r = 0; r < roots.size(); r++)
+    {
+        const size_t i = roots[r];
+        fx[i] += fvx[i] * time;
+        fy[i] += fvy[i] * time;
+        fz[i] += fvz[i] * time;
+    }
+
+    vector<double> *bodies[6] = {&store.x, &store.y, &store.z, &store.vx, &store.vy, &store.vz};
+    const vector<double> *drifted[6] = {&rx, &ry, &rz, &rvx, &rvy, &rvz};
+    fromJacobi(families, drifted, bodies, 6);
+}
+
+/**
+ * @brief the parent of every body from the children lists of the input file
+ * @throws invalid_argument for a child that does not exist or is listed under two parents
+ */
+vector<int> parentIndices(const vector<Body> &bodies)
+{
+    vector<int> parent(bodies.size(), -1);
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        for (int child : bodies[i].childrenIndices)
+        {
+            if (child < 0 || child >= static_cast<int>(bodies.size()))
+            {
+                throw invalid_argument("Body " + to_string(i) + " lists child " + to_string(child) + ", which does not exist");
+            }
+            if (parent[child] != -1)
+            {
+                throw invalid_argument("Body " + to_string(child) + " is listed as a child of both bodies " + to_string(parent[child]) + " and " + to_string(i));
+            }
+            parent[child] = static_cast<int>(i);
+        }
+    }
+    return parent;
+}
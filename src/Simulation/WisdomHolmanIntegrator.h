@@ -0,0 +1,58 @@
+#ifndef WISDOM_HOLMAN_INTEGRATOR_H
+#define WISDOM_HOLMAN_INTEGRATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "body.h"
+#include "Integrator.h"
+
+/*
+    WisdomHolmanIntegrator class:
+        mixed variable kick-drift-kick in hierarchical Jacobi coordinates built from the children lists of the input file
+            coordinates   the centre of mass of every root body's family, and for the children c1 ... cm of a body p in turn
+                          the centre of mass of c_j's family relative to that of p with the families of c1 ... c(j-1),
+                          so a moon orbits its planet, and the planet and its moons together orbit the star
+            drift         every relative coordinate along its Kepler orbit, G (M_centre + M_family), every root family
+                          in a straight line
+            kick          every body by the solver's acceleration less its acceleration in the drift,
+                          that is by the perturbations of the Kepler orbits only
+        the drift is exact, for an unperturbed hierarchy the scheme follows every orbit exactly whatever the step,
+        the error scales with the perturbations, so the step can be a fraction of the shortest orbit rather than
+        a small fraction of it, and with one gravitational multiplier for every body the scheme is symplectic
+
+    the coordinates are linear in the positions, the same maps take velocities and accelerations across,
+    the relative states are gathered into contiguous arrays and drifted KEPLER_LANES at a time by keplerDrift
+*/
+class WisdomHolmanIntegrator : public SteppingIntegrator
+{
+public:
+        WisdomHolmanIntegrator(double timestep, const std::vector<int> &parent);
+
+        const char *name() const override { return "wisdomholman"; }
+        void start(BodyStore &store, ForceSolver &solver) override;
+        void step(BodyStore &store, ForceSolver &solver, double dt) override;
+        bool startsWithAccelerations() const override { return true; }
+
+private:
+        std::vector<int> parent;                           // parent of every body, -1 for the roots
+        std::vector<std::vector<std::uint32_t>> generations; // the bodies by depth in the hierarchy, roots first
+        std::vector<std::uint32_t> firstChild;             // children of body i are orbiting[firstChild[i] .. firstChild[i + 1])
+        std::vector<std::uint32_t> orbiting;               // every body with a parent, grouped by parent, one Jacobi orbit each
+
+        std::vector<double> bodyMass, familyMass;          // mass of every body, and of it with all its descendants
+        std::vector<double> share, mu;                     // of every orbit, M_family / (M_centre + M_family) and the Kepler parameter
+        std::vector<double> fx, fy, fz, fvx, fvy, fvz;     // centre of mass of every body's family, and its velocity
+        std::vector<double> rx, ry, rz, rvx, rvy, rvz;     // Jacobi coordinates of every orbit, by place in orbiting
+        std::vector<double> keplerX, keplerY, keplerZ;     // acceleration of every body in the drift
+
+        void toJacobi(const std::vector<double> *body[], std::vector<double> *family[], std::vector<double> *relative[], std::size_t components);
+        void fromJacobi(std::vector<double> *family[], const std::vector<double> *relative[], std::vector<double> *body[], std::size_t components);
+        void keplerAccelerations(const BodyStore &store);
+        void kick(BodyStore &store, double time);
+        void drift(BodyStore &store, double time);
+};
+
+std::vector<int> parentIndices(const std::vector<Body> &bodies);
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * This file contains the implementation of the WorkStealingLoop class, the work stealing loop of the force, kick and drift passes
+ *
+ * a run is a single 64 bit word, so the owner popping a chunk and a thief splitting the run are both one compare and swap
+ * on it, and whichever comes second sees the other's change and tries again, a run only ever shrinks while a loop goes on,
+ * and the indices it holds are handed out once, so a stale (begin, end) never compares equal to a later one
+ *
+ * every loop ends with every run empty, its owner only leaves it that way, so the owners store the runs of the next loop
+ * without waiting for each other, a thief that reads a run before its owner has stored it finds nothing to split
+ *
+ * @author: Cole McGregor, Hawk Lindner, Brandon Trama
+ */
+
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include "WorkStealing.h"
+using namespace std;
+
+static inline uint64_t pack(uint64_t begin, uint64_t end)
+{
+    return begin << 32 | end;
+}
+
+static inline uint64_t first(uint64_t range)
+{
+    return range >> 32;
+}
+
+static inline uint64_t last(uint64_t range)
+{
+    return range & 0xffffffffu;
+}
+
+// the placement of placeThreads, every thread's node, its position when the threads are ordered node by node,
+// and the order it visits victims in, its own node first
+static vector<int> threadNode, threadRank;
+static vector<vector<int>> victimOrder;
+
+/**
+ * @brief records the node of every thread of the parallel region, the runs follow it from the next loop on
+ * @param nodeOfThread the node of thread t at index t, empty to go back to runs in thread order
+ */
+void WorkStealingLoop::placeThreads(const vector<int> &nodeOfThread)
+{
+    const int threads = static_cast<int>(nodeOfThread.size());
+    vector<int> order(threads);
+    for (int t = 0; t < threads; t++)
+    {
+        order[t] = t;
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return nodeOfThread[a] < nodeOfThread[b]; });
+
+    threadNode = nodeOfThread;
+    threadRank.assign(threads, 0);
+    for (int r = 0; r < threads; r++)
+    {
+        threadRank[order[r]] = r;
+    }
+    victimOrder.assign(threads, vector<int>());
+    for (int self = 0; self < threads; self++)
+    {
+        // the next ranks around the ring, those on the same node first
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int step = 1; step < threads; step++)
+            {
+                const int victim = order[(threadRank[self] + step) % threads];
+                if ((nodeOfThread[victim] == nodeOfThread[self]) == (pass == 0))
+                {
+                    victimOrder[self].push_back(victim);
+                }
+            }
+        }
+    }
+}
+
+// the position of thread among threads, the placement's when it was made for this many threads
+static size_t rankOf(int thread, int threads)
+{
+    return static_cast<int>(threadRank.size()) == threads ? threadRank[thread] : thread;
+}
+
+/**
+ * @brief the run thread starts a loop over n indices with, the runs follow the ranks of the placement
+ */
+void WorkStealingLoop::share(size_t n, int thread, int threads, size_t &begin, size_t &end)
+{
+    const size_t rank = rankOf(thread, threads);
+    begin = n * rank / threads;
+    end = n * (rank + 1) / threads;
+}
+
+int WorkStealingLoop::nodeOf(int thread)
+{
+    return thread < static_cast<int>(threadNode.size()) ? threadNode[thread] : 0;
+}
+
+/**
+ * @brief stores the calling thread's own run of the indices, the runs are only allocated, behind a barrier,
+ * the first time a region has more threads than there are runs
+ */
+void WorkStealingLoop::start(size_t n, int threads)
+{
+    // every thread compares before any writes, so all of them take the same branch
+    if (capacity < threads)
+    {
+        #pragma omp barrier
+        #pragma omp single
+        {
+            deques.reset(new Deque[threads]);
+            capacity = threads;
+        }
+    }
+
+    size_t begin, end;
+    share(n, omp_get_thread_num(), threads, begin, end);
+    deques[omp_get_thread_num()].range.store(pack(begin, end));
+}
+
+/**
+ * @brief the next chunk of the calling thread, from its own run or, once that is empty, from the back half of another's
+ * @return false when no run has more than a chunk left to give
+ */
+bool WorkStealingLoop::next(size_t &begin, size_t &end, size_t chunk, int threads)
+{
+    const int self = omp_get_thread_num();
+    atomic<uint64_t> &own = deques[self].range;
+    for (;;)
+    {
+        uint64_t range = own.load();
+        while (first(range) < last(range))
+        {
+            const uint64_t taken = min<uint64_t>(chunk, last(range) - first(range));
+            if (own.compare_exchange_weak(range, pack(first(range) + taken, last(range))))
+            {
+                begin = first(range);
+                end = first(range) + taken;
+                return true;
+            }
+        }
+
+        const bool placed = static_cast<int>(victimOrder.size()) == threads;
+        bool stolen = false;
+        for (int attempt = 1; attempt < threads && !stolen; attempt++)
+        {
+            atomic<uint64_t> &victim = deques[placed ? victimOrder[self][attempt - 1] : (self + attempt) % threads].range;
+            uint64_t theirs = victim.load();
+            while (last(theirs) > first(theirs) + chunk)
+            {
+                const uint64_t middle = first(theirs) + (last(theirs) - first(theirs)) / 2;
+                if (victim.compare_exchange_weak(theirs, pack(first(theirs), middle)))
+                {
+                    own.store(pack(middle, last(theirs))); // thieves of our own can split it from here on
+                    stolen = true;
+                    break;
+                }
+            }
+        }
+        if (!stolen)
+        {
+            return false;
+        }
+    }
+}
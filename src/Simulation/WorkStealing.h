@@ -0,0 +1,74 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <omp.h>
+
+/*
+    WorkStealingLoop class:
+        a parallel loop over [0, n) balanced by work stealing instead of a fixed schedule
+            deques      every thread starts with its own contiguous run of the indices, n t / T to n (t + 1) / T,
+                        held as one atomic (begin, end) pair, the owner pops grain sized chunks off the front
+            stealing    a thread whose run is empty splits the run of another, taking its back half,
+                        and goes on popping chunks off that, so a thread stuck on costly targets (deep tree walks,
+                        the bodies of a fine block level) hands over what it has not started yet
+        the loop ends for a thread once its own run is empty and no other run has more than a chunk left
+
+    run is called by every thread of the parallel region, like ForceSolver::computeAccelerations, and ends with
+    a barrier like omp for, and with no other, every thread stores its own run as it enters, a thief that looks before
+    the owner has is left with the empty run the last loop ended on and moves on, any thread count works with any n,
+    threads without a share of the indices simply steal, and outside a parallel region it runs the whole range on
+    the calling thread, only a region with more threads than any before it waits once more, while the runs are allocated
+
+    placeThreads hands the loops the NUMA node of every thread, the runs are then laid out node by node, so the
+    targets of one socket are one contiguous block, and a thief empties the runs of its own node before it
+    crosses to another, share gives the same layout to whoever first touches the arrays
+*/
+class WorkStealingLoop
+{
+public:
+        template <class Body>
+        void run(std::size_t n, std::size_t grain, Body &&body); // body(begin, end) for every chunk
+
+        static void placeThreads(const std::vector<int> &nodeOfThread);      // one thread, between loops, empty for no placement
+        static void share(std::size_t n, int thread, int threads, std::size_t &begin, std::size_t &end); // a thread's run
+        static int nodeOf(int thread);                                        // 0 without a placement
+
+private:
+        struct alignas(64) Deque
+        {
+                std::atomic<std::uint64_t> range{0}; // begin in the high 32 bits, end in the low 32 bits
+        };
+
+        std::unique_ptr<Deque[]> deques; // one per thread, a cache line each, empty between loops
+        int capacity = 0;                // deques allocated
+
+        void start(std::size_t n, int threads);
+        bool next(std::size_t &begin, std::size_t &end, std::size_t chunk, int threads);
+};
+
+/**
+ * @brief the loop itself, chunks popped from the thread's own run and then stolen from the others
+ * @param n the number of indices
+ * @param grain the indices popped at a time, a run with no more than this left is not split
+ * @param body called as body(begin, end) for every chunk, by whichever thread took it
+ */
+template <class Body>
+void WorkStealingLoop::run(std::size_t n, std::size_t grain, Body &&body)
+{
+    const int threads = omp_get_num_threads();
+    const std::size_t chunk = grain > 0 ? grain : 1;
+    start(n, threads);
+    std::size_t begin, end;
+    while (next(begin, end, chunk, threads))
+    {
+        body(begin, end);
+    }
+    #pragma omp barrier
+}
+
+#endif
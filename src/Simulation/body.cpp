@@ -19,23 +19,23 @@ using namespace std;
             double gravitationalMultiplier
             String type (Include moon, planet, star, blackhole maybe)
             int[] childrenIndices
-            std::vector<Vector> trajectory
+            std::vector<Vec3> trajectory
 
 */
 /*
     Constructor for the Body class
 */
 Body::Body(
-    const Vector &pos,                          // Position
-    const Vector &vel,                          // Velocity
-    const Vector &accel,                        // Acceleration
-    const Vector &net_force,                    // Net force
+    const Vec3 &pos,                          // Position
+    const Vec3 &vel,                          // Velocity
+    const Vec3 &accel,                        // Acceleration
+    const Vec3 &net_force,                    // Net force
     const double mass,                    // Mass
     const double radius,                  // Radius
     const double gravitationalMultiplier, // Gravitational multiplier
     const string &type,                   // Type of body
     const vector<int> &childrenIndices,   // Vector of indices of children
-    vector<Vector> &trajectory            // Trajectory of body
+    vector<Vec3> &trajectory            // Trajectory of body
     )
     : position(pos),
       velocity(vel),
@@ -57,26 +57,26 @@ Body::Body(
     F = G( (m1*m2) / ((r*r) + (e*e)))
     Return : Vectored Force
 */
-Vector Body::gravForce(const Body &p2) const
+Vec3 Body::gravForce(const Body &p2) const
 {
     const double G = 6.67430e-11; // Predefined and recognized Gravitational constant
     const double epsilon = 1e-5;  // Softening parameter to limit the force at very close distances (0.00001)
 
     // Compute the distance vector
-    Vector r(p2.position.x - position.x, p2.position.y - position.y, p2.position.z - position.z); // the vectored distance between the two bodies
+    Vec3 r(p2.position.x - position.x, p2.position.y - position.y, p2.position.z - position.z); // the vectored distance between the two bodies
     double dist = r.magnitude();                                                                   // the magnitude of the distance between the two bodies
     if (dist < epsilon)
     {
         dist = epsilon; // Prevent divide-by-zero or extremely large forces
     }
 
-    Vector r_normalized = r.normalize();
+    Vec3 r_normalized = r.normalize();
 
     // Compute gravitational force magnitude
     double forceMag = (G * gravitationalMultiplier) * (mass * p2.mass) / ((dist * dist) + (epsilon * epsilon));
 
     // Normalize r(distance from one body to the other, ignoring dimensions) and scale by force magnitude
-    return r_normalized * forceMag; // the vectored force between the two bodies, using the normalized distance vector and Vector Scalar Multiplication
+    return r_normalized * forceMag; // the vectored force between the two bodies, using the normalized distance vector and Vec3 Scalar Multiplication
 }
 
 /**
@@ -88,10 +88,10 @@ Vector Body::gravForce(const Body &p2) const
  * @param force the force to apply
  * @return void
  */
-void Body::applyForce(const Vector &force)
+void Body::applyForce(const Vec3 &force)
 {
     // calculate acceleration change
-    Vector accelChange = force / this->mass;
+    Vec3 accelChange = force / this->mass;
     // update acceleration
     this->acceleration = this->acceleration + accelChange;
 }
@@ -109,7 +109,7 @@ void Body::update(double timestep, bool isHalfStep)
     if (isHalfStep) {
         // Half-step: Update velocity using acceleration
         this->velocity = this->velocity + (this->acceleration * (timestep * 0.5));
-        this->acceleration = Vector(0, 0, 0); // Reset acceleration after use
+        this->acceleration = Vec3(0, 0, 0); // Reset acceleration after use
     } else {
         // Full-step: Update position and finalize velocity
         this->position = this->position + this->velocity * timestep; // Update position
@@ -128,18 +128,18 @@ void Body::update(double timestep, bool isHalfStep)
 
       Return : Vectored Sum of all Forces acting on body n, between body n and all other bodys
 */
-Vector Body::sumForces(const vector<Body> &bodies)
+Vec3 Body::sumForces(const vector<Body> &bodies)
 {
     // always reset the net force before each calculation
-  Vector net_force(0, 0, 0);
+  Vec3 net_force(0, 0, 0);
 
-#pragma omp parallel for reduction(vector_reduction: net_force) schedule(dynamic)
+    // serial reference sum, the simulation itself runs on the ForceSolver classes
     // loop through all bodies and calculate the force between this body and the other bodies
     for (size_t i = 0; i < bodies.size(); i++) {
       // avoid calculating force with itself
       if (this != &bodies[i]) {
 	// accumulate forces
-	Vector force = gravForce(bodies[i]);
+	Vec3 force = gravForce(bodies[i]);
 	net_force = net_force + force;
       }
     }
@@ -3,22 +3,33 @@
 #SBATCH --output=job-output/sim_output.txt # Output file
 #SBATCH --error=job-output/sim_error.txt   # Error file
 #SBATCH --partition=skx-dev                # Partition name (specifically the skylake development partition)
-#SBATCH --nodes=1                          # Total number of nodes
-#SBATCH --ntasks=1                         # Total number of tasks
+#SBATCH --nodes=1                          # Total number of nodes, more than 1 runs one MPI rank per node (make mpi)
+#SBATCH --ntasks-per-node=1                # One rank per node, its threads take the node's cores
 #SBATCH --cpus-per-task=16                 # Number of cores per task
 #SBATCH --time=01:00:00                    # Maximum run time for script
 
 module load gcc
 
-# ensures threads are bound to a specific core
-export OMP_PROC_BIND=true
+# binds every thread to its own core, packed socket by socket, so the threads of one socket
+# get consecutive numbers and the body arrays they first touch stay on that socket's memory
+export OMP_PLACES=cores
+export OMP_PROC_BIND=close
 # set num threads 
 export OMP_NUM_THREADS=$SLURM_CPUS_PER_TASK
 # # check num threads
 # echo $OMP_NUM_THREADS
 
-# compile simulation program
-make
+if [ "${SLURM_NNODES:-1}" -gt 1 ]; then
+    # compile with MPI, the bodies are split over the nodes and the direct sum passes them around a ring
+    module load impi
+    make mpi
 
-# run
-./Simulation 32-bodies.txt
+    # run, ibrun starts one rank per task
+    ibrun ./Simulation_mpi 32-bodies.txt
+else
+    # compile simulation program
+    make
+
+    # run
+    ./Simulation 32-bodies.txt
+fi
@@ -0,0 +1,84 @@
+#ifndef VEC3_H
+#define VEC3_H
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+    Vec3 struct for holding x,y,z coordinates,
+    has a magnitude function, and a constructor that defaults to 0
+    has operator overloading for +, -, *, and / to allow for vector math
+
+    Vec3 is used to represent position, velocity, acceleration, and force
+    as they are all vectored quantities
+
+    it is a plain 32 byte aligned value type: no members beyond the three doubles, every operator
+    is constexpr and inline, so temporaries in the force math stay in registers and never touch the heap
+    Vec3 v; is the zero vector like the Vector it replaced, so it is trivially copyable but not trivial
+*/
+struct alignas(32) Vec3
+{
+    double x, y, z;
+
+    constexpr Vec3() : x(0), y(0), z(0) {}
+    constexpr Vec3(double x_, double y_, double z_ = 0.0) : x(x_), y(y_), z(z_) {}
+
+    constexpr Vec3 operator+(const Vec3 &other) const { return Vec3(x + other.x, y + other.y, z + other.z); }
+    constexpr Vec3 operator-(const Vec3 &other) const { return Vec3(x - other.x, y - other.y, z - other.z); }
+    constexpr Vec3 operator-() const { return Vec3(-x, -y, -z); }
+    constexpr Vec3 operator*(double scalar) const { return Vec3(x * scalar, y * scalar, z * scalar); }
+    constexpr Vec3 operator/(double scalar) const { return Vec3(x / scalar, y / scalar, z / scalar); }
+
+    constexpr Vec3 &operator+=(const Vec3 &other)
+    {
+        x += other.x;
+        y += other.y;
+        z += other.z;
+        return *this;
+    }
+    constexpr Vec3 &operator-=(const Vec3 &other)
+    {
+        x -= other.x;
+        y -= other.y;
+        z -= other.z;
+        return *this;
+    }
+
+    constexpr double dot(const Vec3 &other) const { return (x * other.x) + (y * other.y) + (z * other.z); }
+    constexpr double magnitudeSquared() const { return dot(*this); }
+
+    // Calculate magnitude (length of the vector)
+    double magnitude() const { return std::sqrt(magnitudeSquared()); }
+
+    Vec3 normalize() const
+    {
+        double mag = magnitude(); // Calculate magnitude
+        if (mag == 0)
+        {
+            throw std::runtime_error("Cannot normalize a zero vector");
+        }
+        return Vec3(x / mag, y / mag, z / mag); // Divide components by magnitude
+    }
+
+    // Reset the vector to (0, 0, 0)
+    constexpr void reset()
+    {
+        x = 0;
+        y = 0;
+        z = 0;
+    }
+
+    // Print the vector (x, y, z)
+    void print() const { std::cout << x << "," << y << "," << z << std::endl; }
+};
+
+constexpr Vec3 operator*(double scalar, const Vec3 &vec) { return vec * scalar; }
+
+static_assert(std::is_trivially_copyable<Vec3>::value && std::is_standard_layout<Vec3>::value, "Vec3 must stay a plain value");
+static_assert(sizeof(Vec3) == 32 && alignof(Vec3) == 32, "Vec3 must fill exactly one 32 byte slot");
+
+#pragma omp declare reduction(vector_reduction : Vec3 : omp_out = omp_out + omp_in) initializer(omp_priv = Vec3(0, 0, 0))
+
+#endif
@@ -1,41 +1,19 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
-#include <cmath>
-#include <iostream>
-#include <string>
-#include <vector>
 #include <fstream>
-
-class Body;
+#include <sstream>
+#include "vec3.h"
 
 /*
-    Vector struct for holding x,y,z coordinates,
-    has a magnitude function, and a constructor that defaults to 0
-    has operator overloading for +, -, *, and / to allow for vector math
-
-    Vector is used to represent position, velocity, acceleration, and force
-    as they are all vectored quantities
-
+    Vector is the name the simulation used before Vec3,
+    kept as an alias so older code and the unit tests keep compiling
 
+    the file stream operators live here, the math lives in vec3.h
 */
-struct Vector
-{
-    double x, y, z;
-    std::vector<Body> relatedBodies;
-    Vector(double x_ = 0.0, double y_ = 0.0, double z_ = 0.0);
-    double magnitude() const;
-    Vector normalize() const;
-    Vector operator+(const Vector &other) const;
-    Vector operator-(const Vector &other) const;
-    Vector operator*(double scalar) const;
-    Vector operator/(double scalar) const;
-    friend std::ofstream& operator<<(std::ofstream& file, const Vector& vec);
-    friend std::ostringstream& operator<<(std::ostringstream& file, const Vector& vec);
-    void reset(); 
-    void print() const;
-};
+using Vector = Vec3;
 
-#pragma omp declare reduction(vector_reduction : Vector : omp_out = omp_out + omp_in) initializer(omp_priv = Vector(0, 0, 0))
+std::ofstream& operator<<(std::ofstream& file, const Vec3& vec);
+std::ostringstream& operator<<(std::ostringstream& stream, const Vec3& vec);
 
 #endif